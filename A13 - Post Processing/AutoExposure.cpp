@@ -0,0 +1,86 @@
+#include "AutoExposure.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+float AutoExposure::Luminance(const float* rgb)
+{
+	return rgb[0] * 0.2126f + rgb[1] * 0.7152f + rgb[2] * 0.0722f;
+}
+
+unsigned int AutoExposure::Bin(float luminance, const AutoExposureSettings& settings)
+{
+	if (luminance < exp2f(settings.MinLogLuminance))
+		return 0;
+
+	float t = (log2f(luminance) - settings.MinLogLuminance) / settings.LogLuminanceRange;
+	t = min(max(t, 0.0f), 1.0f);
+	return (unsigned int)(t * (BinCount - 2) + 1.0f);
+}
+
+vector<unsigned int> AutoExposure::BuildHistogram(const float* pixels, size_t pixelCount, const AutoExposureSettings& settings)
+{
+	vector<unsigned int> bins(BinCount);
+	for (size_t i = 0; i < pixelCount; i++)
+		bins[Bin(Luminance(pixels + i * 4), settings)]++;
+	return bins;
+}
+
+float AutoExposure::AverageLuminance(const vector<unsigned int>& bins, const AutoExposureSettings& settings)
+{
+	// Bin 0 is too dark to count, so it's left out of the average entirely
+	double weighted = 0;
+	double counted = 0;
+	for (unsigned int i = 1; i < BinCount && i < bins.size(); i++)
+	{
+		weighted += (double)bins[i] * (i - 1);
+		counted += bins[i];
+	}
+	if (counted == 0)
+		return 0;
+
+	float t = (float)(weighted / counted) / (BinCount - 2);
+	return exp2f(t * settings.LogLuminanceRange + settings.MinLogLuminance);
+}
+
+float AutoExposure::Adapt(float adaptedLuminance, float targetLuminance, float deltaTime, const AutoExposureSettings& settings)
+{
+	if (targetLuminance <= 0)
+		return adaptedLuminance;
+	if (adaptedLuminance <= 0)
+		return targetLuminance;
+
+	// In stops, so a change of exposure looks the same speed whichever way it goes
+	float rate = targetLuminance > adaptedLuminance ? settings.AdaptToBright : settings.AdaptToDark;
+	float adaptedLog = log2f(adaptedLuminance);
+	adaptedLog += (log2f(targetLuminance) - adaptedLog) * (1.0f - expf(-deltaTime * rate));
+	return exp2f(adaptedLog);
+}
+
+float AutoExposure::Exposure(float adaptedLuminance, const AutoExposureSettings& settings)
+{
+	return settings.KeyValue / max(adaptedLuminance, 0.0001f);
+}
+
+AutoExposureReplay AutoExposure::Replay(const vector<AutoExposureFrame>& frames, const AutoExposureSettings& settings)
+{
+	AutoExposureReplay replay;
+	if (frames.empty())
+		return replay;
+
+	float chain = frames[0].PreviousLuminance;
+	for (auto& frame : frames)
+	{
+		float target = AverageLuminance(frame.Bins, settings);
+		float single = Adapt(frame.PreviousLuminance, target, frame.DeltaTime, settings);
+		chain = Adapt(chain, target, frame.DeltaTime, settings);
+
+		float reference = max(frame.AdaptedLuminance, 1e-6f);
+		replay.MaxFrameError = max(replay.MaxFrameError, fabsf(single - frame.AdaptedLuminance) / reference);
+		replay.MaxChainError = max(replay.MaxChainError, fabsf(chain - frame.AdaptedLuminance) / reference);
+		replay.Frames++;
+	}
+	return replay;
+}
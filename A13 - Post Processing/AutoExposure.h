@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct AutoExposureSettings
+{
+	float MinLogLuminance = -8.0f;		// log2 of the darkest luminance binned - anything darker is ignored
+	float LogLuminanceRange = 16.0f;	// Stops covered above that
+	float KeyValue = 0.18f;				// What the average luminance is exposed to (middle grey)
+	float AdaptToBright = 3.0f;			// Adaptation rates, per second - eyes adjust to
+	float AdaptToDark = 1.0f;			// the light faster than to the dark
+};
+
+// One frame of the GPU's adaptation, read back for replaying on the CPU
+struct AutoExposureFrame
+{
+	float DeltaTime = 0;
+	std::vector<unsigned int> Bins;		// The histogram the exposure pass read
+	float PreviousLuminance = 0;		// Adapted luminance going in
+	float AdaptedLuminance = 0;			// And coming out
+};
+
+struct AutoExposureReplay
+{
+	int Frames = 0;
+	float MaxFrameError = 0;	// Worst relative error of one frame, from the GPU's starting point
+	float MaxChainError = 0;	// Worst relative error running the CPU alone from the first frame
+};
+
+// --------------------------------------------------------
+// The math behind the auto exposure, as the two compute
+// passes run it.  ComputeShaderLuminanceHistogram bins the
+// HDR scene's pixels by log2 luminance; bin 0 takes pixels
+// too dark to count, the rest split the range evenly.
+// ComputeShaderExposure then averages the histogram (in
+// log space, so a few bright pixels don't dominate), moves
+// the adapted luminance toward it exponentially - rate per
+// second, so it adapts the same at any frame rate - and
+// works out the exposure that maps it to the key value.
+//
+// Everything here mirrors the shaders step for step, so a
+// recorded frame can be replayed and compared, and the
+// adaptation can be checked on luminance sequences without
+// a GPU.
+// --------------------------------------------------------
+namespace AutoExposure
+{
+	const unsigned int BinCount = 256;	// Must match BIN_COUNT in both shaders
+
+	float Luminance(const float* rgb);
+
+	// The bin a luminance lands in
+	unsigned int Bin(float luminance, const AutoExposureSettings& settings);
+
+	// Counts RGBA pixels into BinCount bins
+	std::vector<unsigned int> BuildHistogram(const float* pixels, size_t pixelCount, const AutoExposureSettings& settings);
+
+	// Log-average luminance of the counted bins - 0 if every pixel was too dark to count
+	float AverageLuminance(const std::vector<unsigned int>& bins, const AutoExposureSettings& settings);
+
+	// One step toward the target - a target of 0 (nothing counted) holds where it is
+	float Adapt(float adaptedLuminance, float targetLuminance, float deltaTime, const AutoExposureSettings& settings);
+
+	// Exposure that brings the adapted luminance to the key value
+	float Exposure(float adaptedLuminance, const AutoExposureSettings& settings);
+
+	// Re-runs recorded GPU frames on the CPU
+	AutoExposureReplay Replay(const std::vector<AutoExposureFrame>& frames, const AutoExposureSettings& settings);
+}
@@ -0,0 +1,72 @@
+#include "BindingTable.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+namespace
+{
+	// Matches names against reflected resources, then walks the registers
+	// in order and starts a new range at any register the material doesn't own
+	void BuildRanges(const vector<ReflectedResource>& resources, const vector<string>& names, vector<BindingRange>& ranges, vector<string>& unused)
+	{
+		// Register -> owner (material index, or -1 for someone else's resource)
+		map<unsigned int, int> registers;
+		for (auto& resource : resources)
+			registers[resource.BindIndex] = -1;
+
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			auto it = find_if(resources.begin(), resources.end(), [&](const ReflectedResource& r) { return r.Name == names[i]; });
+			if (it == resources.end())
+				unused.push_back(names[i]);
+			else
+				registers[it->BindIndex] = (int)i;
+		}
+
+		BindingRange* current = 0;
+		unsigned int nextSlot = 0;
+		for (auto& reg : registers)
+		{
+			if (reg.second < 0)
+			{
+				current = 0;
+				continue;
+			}
+
+			// Registers the shader never declared can't hold anything of
+			// anyone's, so small holes are filled with null rather than split
+			if (current)
+			{
+				while (nextSlot < reg.first)
+				{
+					current->Sources.push_back(-1);
+					nextSlot++;
+				}
+			}
+			else
+			{
+				ranges.push_back(BindingRange());
+				current = &ranges.back();
+				current->FirstSlot = reg.first;
+			}
+
+			current->Sources.push_back(reg.second);
+			nextSlot = reg.first + 1;
+		}
+	}
+}
+
+BindingTable BindingTables::Build(const ShaderReflectionData& reflection, const vector<string>& textureNames, const vector<string>& samplerNames)
+{
+	BindingTable table;
+	BuildRanges(reflection.ShaderResourceViews, textureNames, table.TextureRanges, table.UnusedTextures);
+	BuildRanges(reflection.Samplers, samplerNames, table.SamplerRanges, table.UnusedSamplers);
+	return table;
+}
+
+size_t BindingTables::CallCount(const BindingTable& table)
+{
+	return table.TextureRanges.size() + table.SamplerRanges.size();
+}
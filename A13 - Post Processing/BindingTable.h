@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ShaderReflectionCache.h"
+
+#include <string>
+#include <vector>
+
+// A run of consecutive shader registers, bound with one call
+struct BindingRange
+{
+	unsigned int FirstSlot = 0;
+	std::vector<int> Sources;	// Per register: index into the material's list, or -1 to bind null
+};
+
+// --------------------------------------------------------
+// Where a material's named textures and samplers land in a
+// shader, worked out once so binding is just filling arrays
+// and calling PSSetShaderResources/PSSetSamplers per range.
+//
+// Built purely from ShaderReflectionData, so it can be tested
+// against hand-made reflection without a device.
+// --------------------------------------------------------
+struct BindingTable
+{
+	std::vector<BindingRange> TextureRanges;
+	std::vector<BindingRange> SamplerRanges;
+
+	// Material resources the shader doesn't declare (set but never bound)
+	std::vector<std::string> UnusedTextures;
+	std::vector<std::string> UnusedSamplers;
+};
+
+namespace BindingTables
+{
+	// Registers the shader uses for something the material doesn't own
+	// (shadow maps, etc.) are never covered by a range, so binding a
+	// material can't clobber them - a gap splits the range instead.
+	// Unused registers between material resources are bound as null.
+	BindingTable Build(const ShaderReflectionData& reflection, const std::vector<std::string>& textureNames, const std::vector<std::string>& samplerNames);
+
+	// Total number of bind calls the table needs
+	size_t CallCount(const BindingTable& table);
+}
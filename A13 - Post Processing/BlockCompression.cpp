@@ -0,0 +1,761 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Shared fitting helpers
+	// --------------------------------------------------------
+
+	// Principal axis of up to 4 dimensional points, by power
+	// iteration seeded with the bounding box diagonal
+	template <int N>
+	void PrincipalAxis(const float points[16][4], float mean[N], float axis[N])
+	{
+		float minimum[N], maximum[N];
+		for (int c = 0; c < N; c++)
+		{
+			mean[c] = 0;
+			minimum[c] = points[0][c];
+			maximum[c] = points[0][c];
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < N; c++)
+			{
+				mean[c] += points[i][c] / 16.0f;
+				minimum[c] = min(minimum[c], points[i][c]);
+				maximum[c] = max(maximum[c], points[i][c]);
+			}
+		}
+
+		float covariance[N][N] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			for (int a = 0; a < N; a++)
+				for (int b = 0; b < N; b++)
+					covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+		}
+
+		for (int c = 0; c < N; c++)
+			axis[c] = maximum[c] - minimum[c];
+
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[N] = {};
+			for (int a = 0; a < N; a++)
+				for (int b = 0; b < N; b++)
+					next[a] += covariance[a][b] * axis[b];
+
+			float length = 0;
+			for (int c = 0; c < N; c++)
+				length += next[c] * next[c];
+			length = sqrtf(length);
+			if (length < 1e-6f) break;
+
+			for (int c = 0; c < N; c++)
+				axis[c] = next[c] / length;
+		}
+	}
+
+	// Endpoints at the extremes of the points' projection onto the axis
+	template <int N>
+	void FitEndpoints(const float points[16][4], float low[N], float high[N])
+	{
+		float mean[N], axis[N];
+		PrincipalAxis<N>(points, mean, axis);
+
+		float minT = 0, maxT = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = 0;
+			for (int c = 0; c < N; c++)
+				t += (points[i][c] - mean[c]) * axis[c];
+			minT = min(minT, t);
+			maxT = max(maxT, t);
+		}
+
+		for (int c = 0; c < N; c++)
+		{
+			low[c] = max(0.0f, min(255.0f, mean[c] + axis[c] * minT));
+			high[c] = max(0.0f, min(255.0f, mean[c] + axis[c] * maxT));
+		}
+	}
+
+	// --------------------------------------------------------
+	// Least squares endpoints for fixed per-pixel weights:
+	// minimizes the sum of |w * first + (1 - w) * second - p|^2.
+	// Returns false if the weights don't constrain both ends.
+	// --------------------------------------------------------
+	template <int N>
+	bool LeastSquares(const float points[16][4], const float weights[16], float first[N], float second[N])
+	{
+		float aa = 0, ab = 0, bb = 0;
+		float ap[N] = {}, bp[N] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float a = weights[i];
+			float b = 1.0f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < N; c++)
+			{
+				ap[c] += a * points[i][c];
+				bp[c] += b * points[i][c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (fabsf(determinant) < 1e-6f)
+			return false;
+
+		for (int c = 0; c < N; c++)
+		{
+			first[c] = max(0.0f, min(255.0f, (bb * ap[c] - ab * bp[c]) / determinant));
+			second[c] = max(0.0f, min(255.0f, (aa * bp[c] - ab * ap[c]) / determinant));
+		}
+		return true;
+	}
+
+	void LoadBlock(const unsigned char rgba[64], float points[16][4])
+	{
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 4; c++)
+				points[i][c] = rgba[i * 4 + c];
+	}
+
+	// --------------------------------------------------------
+	// BC1
+	// --------------------------------------------------------
+	struct BC1Attempt
+	{
+		unsigned short color0 = 0;
+		unsigned short color1 = 0;
+		unsigned char indices[16] = {};
+		float error = 0;
+	};
+
+	unsigned short To565(const float color[3])
+	{
+		int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+		int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+		int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (unsigned short)((r << 11) | (g << 5) | b);
+	}
+
+	void From565(unsigned short c, int rgb[3])
+	{
+		int r = (c >> 11) & 31;
+		int g = (c >> 5) & 63;
+		int b = c & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	// The four colors of an opaque (color0 > color1) block, in index order
+	void BC1Palette(unsigned short color0, unsigned short color1, int palette[4][3])
+	{
+		From565(color0, palette[0]);
+		From565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+		}
+	}
+
+	BC1Attempt EncodeBC1(const float points[16][4], const float first[3], const float second[3])
+	{
+		BC1Attempt attempt;
+		attempt.color0 = To565(first);
+		attempt.color1 = To565(second);
+
+		// Four color mode needs color0 > color1.  Equal colors can't be
+		// ordered, but then every index can simply point at color0
+		if (attempt.color0 < attempt.color1)
+			swap(attempt.color0, attempt.color1);
+
+		int palette[4][3];
+		BC1Palette(attempt.color0, attempt.color1, palette);
+		int options = attempt.color0 == attempt.color1 ? 1 : 4;
+
+		for (int i = 0; i < 16; i++)
+		{
+			float bestError = 1e30f;
+			for (int p = 0; p < options; p++)
+			{
+				float error = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					float d = points[i][c] - palette[p][c];
+					error += d * d;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					attempt.indices[i] = (unsigned char)p;
+				}
+			}
+			attempt.error += bestError;
+		}
+		return attempt;
+	}
+
+	// --------------------------------------------------------
+	// BC4 (one channel of a block)
+	// --------------------------------------------------------
+	struct BC4Attempt
+	{
+		unsigned char red0 = 0;
+		unsigned char red1 = 0;
+		unsigned char indices[16] = {};
+		float error = 0;
+	};
+
+	// The eight values of an 8 value (red0 > red1) block, in index order
+	void BC4Palette(int red0, int red1, int palette[8])
+	{
+		palette[0] = red0;
+		palette[1] = red1;
+		if (red0 > red1)
+		{
+			for (int k = 2; k < 8; k++)
+				palette[k] = ((8 - k) * red0 + (k - 1) * red1 + 3) / 7;
+		}
+		else
+		{
+			for (int k = 2; k < 6; k++)
+				palette[k] = ((6 - k) * red0 + (k - 1) * red1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	BC4Attempt EncodeBC4(const float values[16], float first, float second)
+	{
+		BC4Attempt attempt;
+		attempt.red0 = (unsigned char)(max(first, second) + 0.5f);
+		attempt.red1 = (unsigned char)(min(first, second) + 0.5f);
+
+		// Equal ends only give one useful value, which index 0 already is
+		int palette[8];
+		BC4Palette(attempt.red0, attempt.red1, palette);
+		int options = attempt.red0 == attempt.red1 ? 1 : 8;
+
+		for (int i = 0; i < 16; i++)
+		{
+			float bestError = 1e30f;
+			for (int p = 0; p < options; p++)
+			{
+				float d = values[i] - palette[p];
+				if (d * d < bestError)
+				{
+					bestError = d * d;
+					attempt.indices[i] = (unsigned char)p;
+				}
+			}
+			attempt.error += bestError;
+		}
+		return attempt;
+	}
+
+	// Weight of red0 for each 8 value mode index
+	const float BC4Weights[8] = { 1.0f, 0.0f, 6 / 7.0f, 5 / 7.0f, 4 / 7.0f, 3 / 7.0f, 2 / 7.0f, 1 / 7.0f };
+
+	// --------------------------------------------------------
+	// BC7 mode 6
+	// --------------------------------------------------------
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Attempt
+	{
+		unsigned char endpoint[2][4] = {};	// 7 bit values
+		unsigned char pbit[2] = {};
+		unsigned char indices[16] = {};
+		float error = 1e30f;
+	};
+
+	// Picks indices by projecting onto the endpoint line, then measures the result
+	void BC7Indices(const float points[16][4], BC7Attempt& attempt)
+	{
+		int decoded[2][4];
+		for (int e = 0; e < 2; e++)
+			for (int c = 0; c < 4; c++)
+				decoded[e][c] = (attempt.endpoint[e][c] << 1) | attempt.pbit[e];
+
+		float direction[4];
+		float length2 = 0;
+		for (int c = 0; c < 4; c++)
+		{
+			direction[c] = (float)(decoded[1][c] - decoded[0][c]);
+			length2 += direction[c] * direction[c];
+		}
+
+		attempt.error = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			int index = 0;
+			if (length2 > 0)
+			{
+				float t = 0;
+				for (int c = 0; c < 4; c++)
+					t += (points[i][c] - decoded[0][c]) * direction[c];
+				t = max(0.0f, min(1.0f, t / length2)) * 64.0f;
+
+				// Weights aren't evenly spaced, so check the neighbors of the guess
+				int guess = min(15, (int)(t * 15.0f / 64.0f + 0.5f));
+				index = guess;
+				for (int n = max(0, guess - 1); n <= min(15, guess + 1); n++)
+					if (fabsf(BC7Weights[n] - t) < fabsf(BC7Weights[index] - t)) index = n;
+			}
+			attempt.indices[i] = (unsigned char)index;
+
+			for (int c = 0; c < 4; c++)
+			{
+				int value = ((64 - BC7Weights[index]) * decoded[0][c] + BC7Weights[index] * decoded[1][c] + 32) >> 6;
+				float d = points[i][c] - value;
+				attempt.error += d * d;
+			}
+		}
+	}
+
+	// Tries all four p-bit combinations for a pair of float endpoints
+	BC7Attempt EncodeBC7(const float points[16][4], const float first[4], const float second[4])
+	{
+		BC7Attempt best;
+		for (int combination = 0; combination < 4; combination++)
+		{
+			BC7Attempt attempt;
+			attempt.pbit[0] = combination & 1;
+			attempt.pbit[1] = (combination >> 1) & 1;
+			for (int c = 0; c < 4; c++)
+			{
+				attempt.endpoint[0][c] = (unsigned char)max(0, min(127, (int)floorf((first[c] - attempt.pbit[0]) / 2.0f + 0.5f)));
+				attempt.endpoint[1][c] = (unsigned char)max(0, min(127, (int)floorf((second[c] - attempt.pbit[1]) / 2.0f + 0.5f)));
+			}
+			BC7Indices(points, attempt);
+			if (attempt.error < best.error)
+				best = attempt;
+		}
+		return best;
+	}
+
+	// LSB-first bit packing for 128-bit blocks
+	struct BlockWriter
+	{
+		unsigned char* block;
+		int position = 0;
+
+		void Write(unsigned int value, int bits)
+		{
+			for (int b = 0; b < bits; b++, position++)
+			{
+				if ((value >> b) & 1)
+					block[position >> 3] |= (unsigned char)(1 << (position & 7));
+			}
+		}
+	};
+
+	struct BlockReader
+	{
+		const unsigned char* block;
+		int position = 0;
+
+		unsigned int Read(int bits)
+		{
+			unsigned int value = 0;
+			for (int b = 0; b < bits; b++, position++)
+				value |= (unsigned int)((block[position >> 3] >> (position & 7)) & 1) << b;
+			return value;
+		}
+	};
+
+	// Gathers a 4x4 block, repeating the last row/column past the image's edge
+	void GatherBlock(const DecodedImage& image, unsigned int bx, unsigned int by, unsigned char rgba[64])
+	{
+		for (unsigned int y = 0; y < 4; y++)
+		{
+			unsigned int sy = min(by * 4 + y, image.Height - 1);
+			for (unsigned int x = 0; x < 4; x++)
+			{
+				unsigned int sx = min(bx * 4 + x, image.Width - 1);
+				memcpy(rgba + (y * 4 + x) * 4, &image.Pixels[((size_t)sy * image.Width + sx) * 4], 4);
+			}
+		}
+	}
+}
+
+DXGI_FORMAT BlockCompression::GetDxgiFormat(BlockFormat format)
+{
+	// UNORM rather than SRGB on purpose - the shaders linearize color themselves
+	switch (format)
+	{
+	case BlockFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+	case BlockFormat::BC4: return DXGI_FORMAT_BC4_UNORM;
+	case BlockFormat::BC5: return DXGI_FORMAT_BC5_UNORM;
+	case BlockFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+	default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+unsigned int BlockCompression::BlockBytes(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+	case BlockFormat::BC4:
+		return 8;
+	case BlockFormat::BC5:
+	case BlockFormat::BC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+int BlockCompression::ChannelCount(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1: return 3;
+	case BlockFormat::BC4: return 1;
+	case BlockFormat::BC5: return 2;
+	default: return 4;
+	}
+}
+
+void BlockCompression::CompressBC1Block(const unsigned char rgba[64], unsigned char block[8])
+{
+	float points[16][4];
+	LoadBlock(rgba, points);
+
+	float first[3], second[3];
+	FitEndpoints<3>(points, second, first);
+	BC1Attempt best = EncodeBC1(points, first, second);
+
+	// Refit the endpoints to the chosen indices and keep whichever is better
+	for (int iteration = 0; iteration < 2 && best.color0 != best.color1; iteration++)
+	{
+		static const float weights[4] = { 1.0f, 0.0f, 2 / 3.0f, 1 / 3.0f };
+		float w[16];
+		for (int i = 0; i < 16; i++)
+			w[i] = weights[best.indices[i]];
+
+		if (!LeastSquares<3>(points, w, first, second)) break;
+		BC1Attempt attempt = EncodeBC1(points, first, second);
+		if (attempt.error >= best.error) break;
+		best = attempt;
+	}
+
+	unsigned int indices = 0;
+	for (int i = 0; i < 16; i++)
+		indices |= (unsigned int)best.indices[i] << (i * 2);
+
+	block[0] = (unsigned char)(best.color0 & 0xFF);
+	block[1] = (unsigned char)(best.color0 >> 8);
+	block[2] = (unsigned char)(best.color1 & 0xFF);
+	block[3] = (unsigned char)(best.color1 >> 8);
+	for (int b = 0; b < 4; b++)
+		block[4 + b] = (unsigned char)(indices >> (b * 8));
+}
+
+void BlockCompression::CompressBC4Block(const unsigned char rgba[64], int channel, unsigned char block[8])
+{
+	float values[16];
+	float low = 255, high = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		values[i] = rgba[i * 4 + channel];
+		low = min(low, values[i]);
+		high = max(high, values[i]);
+	}
+
+	BC4Attempt best = EncodeBC4(values, high, low);
+	for (int iteration = 0; iteration < 2 && best.red0 != best.red1; iteration++)
+	{
+		float points[16][4] = {};
+		float w[16];
+		for (int i = 0; i < 16; i++)
+		{
+			points[i][0] = values[i];
+			w[i] = BC4Weights[best.indices[i]];
+		}
+
+		float first[1], second[1];
+		if (!LeastSquares<1>(points, w, first, second)) break;
+		BC4Attempt attempt = EncodeBC4(values, first[0], second[0]);
+		if (attempt.error >= best.error) break;
+		best = attempt;
+	}
+
+	unsigned long long indices = 0;
+	for (int i = 0; i < 16; i++)
+		indices |= (unsigned long long)best.indices[i] << (i * 3);
+
+	block[0] = best.red0;
+	block[1] = best.red1;
+	for (int b = 0; b < 6; b++)
+		block[2 + b] = (unsigned char)(indices >> (b * 8));
+}
+
+void BlockCompression::CompressBC5Block(const unsigned char rgba[64], unsigned char block[16])
+{
+	CompressBC4Block(rgba, 0, block);
+	CompressBC4Block(rgba, 1, block + 8);
+}
+
+void BlockCompression::CompressBC7Block(const unsigned char rgba[64], unsigned char block[16])
+{
+	float points[16][4];
+	LoadBlock(rgba, points);
+
+	float first[4], second[4];
+	FitEndpoints<4>(points, first, second);
+	BC7Attempt best = EncodeBC7(points, first, second);
+
+	for (int iteration = 0; iteration < 2; iteration++)
+	{
+		// Weight of the first endpoint for each pixel
+		float w[16];
+		for (int i = 0; i < 16; i++)
+			w[i] = (64 - BC7Weights[best.indices[i]]) / 64.0f;
+
+		if (!LeastSquares<4>(points, w, first, second)) break;
+		BC7Attempt attempt = EncodeBC7(points, first, second);
+		if (attempt.error >= best.error) break;
+		best = attempt;
+	}
+
+	// The first pixel's index is stored with an implied 0 high bit,
+	// so flip the endpoints (and every index) if it needs that bit
+	if (best.indices[0] >= 8)
+	{
+		for (int c = 0; c < 4; c++)
+			swap(best.endpoint[0][c], best.endpoint[1][c]);
+		swap(best.pbit[0], best.pbit[1]);
+		for (int i = 0; i < 16; i++)
+			best.indices[i] = (unsigned char)(15 - best.indices[i]);
+	}
+
+	memset(block, 0, 16);
+	BlockWriter writer = { block };
+	writer.Write(1 << 6, 7); // Mode 6
+	for (int c = 0; c < 4; c++)
+	{
+		writer.Write(best.endpoint[0][c], 7);
+		writer.Write(best.endpoint[1][c], 7);
+	}
+	writer.Write(best.pbit[0], 1);
+	writer.Write(best.pbit[1], 1);
+	writer.Write(best.indices[0], 3);
+	for (int i = 1; i < 16; i++)
+		writer.Write(best.indices[i], 4);
+}
+
+void BlockCompression::DecompressBC1Block(const unsigned char block[8], unsigned char rgba[64])
+{
+	unsigned short color0 = (unsigned short)(block[0] | (block[1] << 8));
+	unsigned short color1 = (unsigned short)(block[2] | (block[3] << 8));
+	unsigned int indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+
+	int palette[4][3];
+	BC1Palette(color0, color1, palette);
+	int alpha[4] = { 255, 255, 255, 255 };
+	if (color0 <= color1)
+	{
+		// Three color mode, with transparent black as the fourth entry
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+		alpha[3] = 0;
+	}
+
+	for (int i = 0; i < 16; i++)
+	{
+		int index = (indices >> (i * 2)) & 3;
+		for (int c = 0; c < 3; c++)
+			rgba[i * 4 + c] = (unsigned char)palette[index][c];
+		rgba[i * 4 + 3] = (unsigned char)alpha[index];
+	}
+}
+
+void BlockCompression::DecompressBC4Block(const unsigned char block[8], int channel, unsigned char rgba[64])
+{
+	int palette[8];
+	BC4Palette(block[0], block[1], palette);
+
+	unsigned long long indices = 0;
+	for (int b = 0; b < 6; b++)
+		indices |= (unsigned long long)block[2 + b] << (b * 8);
+
+	for (int i = 0; i < 16; i++)
+		rgba[i * 4 + channel] = (unsigned char)palette[(indices >> (i * 3)) & 7];
+}
+
+void BlockCompression::DecompressBC5Block(const unsigned char block[16], unsigned char rgba[64])
+{
+	DecompressBC4Block(block, 0, rgba);
+	DecompressBC4Block(block + 8, 1, rgba);
+	for (int i = 0; i < 16; i++)
+	{
+		rgba[i * 4 + 2] = 0;
+		rgba[i * 4 + 3] = 255;
+	}
+}
+
+bool BlockCompression::DecompressBC7Block(const unsigned char block[16], unsigned char rgba[64])
+{
+	BlockReader reader = { block };
+	if (reader.Read(7) != (1 << 6))
+		return false;
+
+	int endpoint[2][4];
+	for (int c = 0; c < 4; c++)
+	{
+		endpoint[0][c] = reader.Read(7) << 1;
+		endpoint[1][c] = reader.Read(7) << 1;
+	}
+	int pbit0 = reader.Read(1);
+	int pbit1 = reader.Read(1);
+	for (int c = 0; c < 4; c++)
+	{
+		endpoint[0][c] |= pbit0;
+		endpoint[1][c] |= pbit1;
+	}
+
+	for (int i = 0; i < 16; i++)
+	{
+		int w = BC7Weights[reader.Read(i == 0 ? 3 : 4)];
+		for (int c = 0; c < 4; c++)
+			rgba[i * 4 + c] = (unsigned char)(((64 - w) * endpoint[0][c] + w * endpoint[1][c] + 32) >> 6);
+	}
+	return true;
+}
+
+TextureLevel BlockCompression::Compress(const DecodedImage& image, BlockFormat format)
+{
+	TextureLevel level;
+	level.Width = image.Width;
+	level.Height = image.Height;
+
+	if (format == BlockFormat::None)
+	{
+		level.RowPitch = image.Width * 4;
+		level.Bytes = image.Pixels;
+		return level;
+	}
+
+	unsigned int blocksWide = max(1u, (image.Width + 3) / 4);
+	unsigned int blocksHigh = max(1u, (image.Height + 3) / 4);
+	unsigned int blockBytes = BlockBytes(format);
+	level.RowPitch = blocksWide * blockBytes;
+	level.Bytes.resize((size_t)level.RowPitch * blocksHigh);
+
+	unsigned char rgba[64];
+	for (unsigned int by = 0; by < blocksHigh; by++)
+	{
+		for (unsigned int bx = 0; bx < blocksWide; bx++)
+		{
+			GatherBlock(image, bx, by, rgba);
+			unsigned char* block = &level.Bytes[(size_t)by * level.RowPitch + (size_t)bx * blockBytes];
+			switch (format)
+			{
+			case BlockFormat::BC1: CompressBC1Block(rgba, block); break;
+			case BlockFormat::BC4: CompressBC4Block(rgba, 0, block); break;
+			case BlockFormat::BC5: CompressBC5Block(rgba, block); break;
+			case BlockFormat::BC7: CompressBC7Block(rgba, block); break;
+			default: break;
+			}
+		}
+	}
+	return level;
+}
+
+DecodedImage BlockCompression::Decompress(const TextureLevel& level, BlockFormat format)
+{
+	DecodedImage image;
+	image.Width = level.Width;
+	image.Height = level.Height;
+
+	if (format == BlockFormat::None)
+	{
+		image.Pixels = level.Bytes;
+		return image;
+	}
+
+	image.Pixels.assign((size_t)level.Width * level.Height * 4, 0);
+	unsigned int blocksWide = max(1u, (level.Width + 3) / 4);
+	unsigned int blocksHigh = max(1u, (level.Height + 3) / 4);
+	unsigned int blockBytes = BlockBytes(format);
+
+	for (unsigned int by = 0; by < blocksHigh; by++)
+	{
+		for (unsigned int bx = 0; bx < blocksWide; bx++)
+		{
+			const unsigned char* block = &level.Bytes[(size_t)by * level.RowPitch + (size_t)bx * blockBytes];
+			unsigned char rgba[64] = {};
+			switch (format)
+			{
+			case BlockFormat::BC1: DecompressBC1Block(block, rgba); break;
+			case BlockFormat::BC4: DecompressBC4Block(block, 0, rgba); break;
+			case BlockFormat::BC5: DecompressBC5Block(block, rgba); break;
+			case BlockFormat::BC7: DecompressBC7Block(block, rgba); break;
+			default: break;
+			}
+
+			// Drop the parts of edge blocks that hang off the image
+			for (unsigned int y = 0; y < 4 && by * 4 + y < level.Height; y++)
+			{
+				for (unsigned int x = 0; x < 4 && bx * 4 + x < level.Width; x++)
+					memcpy(&image.Pixels[((size_t)(by * 4 + y) * level.Width + bx * 4 + x) * 4], rgba + (y * 4 + x) * 4, 4);
+			}
+		}
+	}
+	return image;
+}
+
+double BlockCompression::Psnr(const DecodedImage& a, const DecodedImage& b, int channelCount)
+{
+	if (a.Width != b.Width || a.Height != b.Height || a.Pixels.size() != b.Pixels.size())
+		return 0;
+
+	double squaredError = 0;
+	size_t pixels = (size_t)a.Width * a.Height;
+	for (size_t i = 0; i < pixels; i++)
+	{
+		for (int c = 0; c < channelCount; c++)
+		{
+			double d = (double)a.Pixels[i * 4 + c] - b.Pixels[i * 4 + c];
+			squaredError += d * d;
+		}
+	}
+
+	double mse = squaredError / ((double)pixels * channelCount);
+	if (mse <= 0)
+		return 99.0; // Lossless - report a large finite value instead of infinity
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+CompressionResult BlockCompression::Measure(const DecodedImage& image, BlockFormat format)
+{
+	CompressionResult result;
+	result.Format = format;
+
+	auto start = chrono::steady_clock::now();
+	TextureLevel level = Compress(image, format);
+	result.Milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	result.MegapixelsPerSecond = (double)image.Width * image.Height / 1000.0 / max(result.Milliseconds, 0.001);
+
+	result.Psnr = Psnr(image, Decompress(level, format), ChannelCount(format));
+	return result;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "PngDecoder.h"
+
+#include <dxgiformat.h>
+#include <vector>
+
+enum class BlockFormat
+{
+	None,	// Uncompressed RGBA8
+	BC1,	// RGB, 4 bits per pixel - cheap color
+	BC4,	// Single channel, 4 bits per pixel - roughness, metalness, etc.
+	BC5,	// Two channels, 8 bits per pixel - tangent space normals (XY)
+	BC7		// RGBA, 8 bits per pixel - high quality color
+};
+
+// One mip level of a texture, in whatever format it's stored in
+struct TextureLevel
+{
+	unsigned int Width = 0;
+	unsigned int Height = 0;
+	unsigned int RowPitch = 0;	// Bytes per row of pixels, or per row of 4x4 blocks
+	std::vector<unsigned char> Bytes;
+};
+
+// A whole mip chain, ready to hand to CreateTexture2D as initial data
+struct TextureData
+{
+	DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+	std::vector<TextureLevel> Levels;
+};
+
+// Round trip quality and speed of one format on one image
+struct CompressionResult
+{
+	BlockFormat Format = BlockFormat::None;
+	double Psnr = 0;				// Over the channels the format keeps, in dB
+	double Milliseconds = 0;
+	double MegapixelsPerSecond = 0;
+};
+
+// --------------------------------------------------------
+// CPU encoders (and matching decoders) for the BC formats
+// D3D11 samples natively.  Every block function works on a
+// 4x4 block of RGBA8 pixels, row by row.
+//
+//  - BC1 fits endpoints along the block's principal axis,
+//    then refines them with a least squares pass
+//  - BC4/BC5 use the 8 value mode from the block's range,
+//    also refined with least squares
+//  - BC7 only emits mode 6 (one subset, RGBA endpoints with
+//    p-bits, 4-bit indices), which is a good all-round mode
+//    for opaque and smooth alpha content.  The decoder only
+//    understands mode 6 as well.
+// --------------------------------------------------------
+namespace BlockCompression
+{
+	DXGI_FORMAT GetDxgiFormat(BlockFormat format);
+	unsigned int BlockBytes(BlockFormat format);
+
+	// Single 4x4 blocks
+	void CompressBC1Block(const unsigned char rgba[64], unsigned char block[8]);
+	void CompressBC4Block(const unsigned char rgba[64], int channel, unsigned char block[8]);
+	void CompressBC5Block(const unsigned char rgba[64], unsigned char block[16]);
+	void CompressBC7Block(const unsigned char rgba[64], unsigned char block[16]);
+
+	void DecompressBC1Block(const unsigned char block[8], unsigned char rgba[64]);
+	void DecompressBC4Block(const unsigned char block[8], int channel, unsigned char rgba[64]);
+	void DecompressBC5Block(const unsigned char block[16], unsigned char rgba[64]);
+	bool DecompressBC7Block(const unsigned char block[16], unsigned char rgba[64]);
+
+	// Whole images (edges of partial blocks are replicated)
+	TextureLevel Compress(const DecodedImage& image, BlockFormat format);
+	DecodedImage Decompress(const TextureLevel& level, BlockFormat format);
+
+	// Peak signal to noise ratio over the first channelCount channels
+	double Psnr(const DecodedImage& a, const DecodedImage& b, int channelCount);
+	int ChannelCount(BlockFormat format);
+
+	// Compresses, decompresses and compares a single image
+	CompressionResult Measure(const DecodedImage& image, BlockFormat format);
+}
@@ -56,6 +56,13 @@ Transform Camera::GetTransform() {
 float Camera::GetFov() {
 	return fovRadians;
 }
+
+/// <summary>
+/// Returns true if the camera uses an orthographic projection.
+/// </summary>
+bool Camera::IsOrthographic() {
+	return isOrthographic;
+}
  
 /// <summary>
 /// Uses the transform to update the view matrix.
@@ -11,6 +11,7 @@ public:
 	DirectX::XMFLOAT4X4 GetProjectionMatrix();
 	Transform GetTransform();
 	float GetFov();
+	bool IsOrthographic();
 
 	void UpdateViewMatrix();
 	void UpdateProjectionMatrix(float aspectRatio);
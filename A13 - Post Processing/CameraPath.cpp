@@ -0,0 +1,72 @@
+#include "CameraPath.h"
+#include "Transform.h"
+
+#include <cmath>
+
+using namespace std;
+using namespace DirectX;
+
+namespace
+{
+	XMFLOAT3 Lerp(const XMFLOAT3& a, const XMFLOAT3& b, float t)
+	{
+		return XMFLOAT3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+	}
+}
+
+vector<CameraKey> CameraPath::SceneCameras()
+{
+	vector<CameraKey> keys(3);
+	keys[0].Position = XMFLOAT3(0, -5, -30);
+	keys[0].Rotation = XMFLOAT3(0.02f, 0, 0);
+	keys[0].Fov = 0.4f;
+
+	keys[1].Position = XMFLOAT3(-20.4f, 0, -20);
+	keys[1].Rotation = XMFLOAT3(0.145f, XM_PIDIV4, 0);
+	keys[1].Fov = 0.4f;
+
+	keys[2].Position = XMFLOAT3(0, -0.8f, -1);
+	keys[2].Rotation = XMFLOAT3(-XM_PIDIV4, 0, 0);
+	keys[2].Fov = 1.2f;
+	keys[2].IsOrthographic = true;
+	return keys;
+}
+
+CameraKey CameraPath::Sample(const vector<CameraKey>& keys, float seconds, float secondsPerKey)
+{
+	if (keys.empty())
+		return CameraKey();
+	if (keys.size() == 1 || secondsPerKey <= 0)
+		return keys[0];
+
+	float position = fmodf(seconds / secondsPerKey, (float)keys.size());
+	if (position < 0)
+		position += (float)keys.size();
+	size_t index = (size_t)position % keys.size();
+	float t = position - floorf(position);
+
+	const CameraKey& from = keys[index];
+	const CameraKey& to = keys[(index + 1) % keys.size()];
+
+	CameraKey key;
+	key.Position = Lerp(from.Position, to.Position, t);
+	key.Rotation = Lerp(from.Rotation, to.Rotation, t);
+	key.Fov = from.Fov + (to.Fov - from.Fov) * t;
+	key.IsOrthographic = t < 0.5f ? from.IsOrthographic : to.IsOrthographic;
+	return key;
+}
+
+void CameraPath::GetMatrices(const CameraKey& key, float aspectRatio, XMFLOAT4X4& view, XMFLOAT4X4& projection)
+{
+	// Same as Camera::UpdateViewMatrix and UpdateProjectionMatrix
+	Transform transform;
+	transform.SetPosition(key.Position);
+	transform.SetRotation(key.Rotation);
+	XMFLOAT3 position = transform.GetPosition();
+	XMFLOAT3 forward = transform.GetForward();
+
+	XMStoreFloat4x4(&view, XMMatrixLookToLH(XMLoadFloat3(&position), XMLoadFloat3(&forward), XMVectorSet(0, 1, 0, 0)));
+	XMStoreFloat4x4(&projection, key.IsOrthographic ?
+		XMMatrixOrthographicLH(aspectRatio, 1, 0.1f, 100) :
+		XMMatrixPerspectiveFovLH(key.Fov, aspectRatio, 0.1f, 100));
+}
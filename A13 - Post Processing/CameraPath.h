@@ -0,0 +1,33 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+// Where a camera starts, in the same terms Camera's constructor takes
+struct CameraKey
+{
+	DirectX::XMFLOAT3 Position = { 0, 0, 0 };
+	DirectX::XMFLOAT3 Rotation = { 0, 0, 0 };	// Pitch, yaw, roll
+	float Fov = 0.4f;
+	bool IsOrthographic = false;
+};
+
+// --------------------------------------------------------
+// The scene's camera placements, and a looping path through
+// them for runs that need the same camera motion every time
+// (benchmarks, captures).  Matrices are built exactly the way
+// Camera builds them, without needing Input or a window.
+// --------------------------------------------------------
+namespace CameraPath
+{
+	// The cameras Game::Initialize creates, in order
+	std::vector<CameraKey> SceneCameras();
+
+	// Position on the path at a given time: each key is held for
+	// secondsPerKey, blending into the next one (wrapping back to the
+	// first).  Projection type switches halfway through a blend.
+	CameraKey Sample(const std::vector<CameraKey>& keys, float seconds, float secondsPerKey);
+
+	void GetMatrices(const CameraKey& key, float aspectRatio, DirectX::XMFLOAT4X4& view, DirectX::XMFLOAT4X4& projection);
+}
@@ -0,0 +1,241 @@
+#include "CascadedShadows.h"
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	// Rebuilds a cascade's projection around a box in the light's view space
+	void SetBox(ShadowCascade& cascade, XMFLOAT3 boxMin, XMFLOAT3 boxMax)
+	{
+		cascade.LightMin = boxMin;
+		cascade.LightMax = boxMax;
+		XMMATRIX projection = XMMatrixOrthographicOffCenterLH(boxMin.x, boxMax.x, boxMin.y, boxMax.y, boxMin.z, boxMax.z);
+		XMStoreFloat4x4(&cascade.Projection, projection);
+		XMStoreFloat4x4(&cascade.ViewProjection, XMMatrixMultiply(XMLoadFloat4x4(&cascade.View), projection));
+	}
+}
+
+vector<float> CascadedShadows::SplitDistances(float nearPlane, float farPlane, unsigned int count, float lambda)
+{
+	vector<float> splits(count + 1);
+	for (unsigned int i = 0; i <= count; i++)
+	{
+		float t = (float)i / count;
+		float uniform = nearPlane + (farPlane - nearPlane) * t;
+		float logarithmic = nearPlane * powf(farPlane / nearPlane, t);
+		splits[i] = logarithmic * lambda + uniform * (1.0f - lambda);
+	}
+
+	// Exactly the planes at the ends, whatever the rounding in between
+	splits[0] = nearPlane;
+	splits[count] = farPlane;
+	return splits;
+}
+
+void CascadedShadows::DepthRange(const XMFLOAT4X4& projection, float& nearPlane, float& farPlane)
+{
+	XMMATRIX inverse = XMMatrixInverse(0, XMLoadFloat4x4(&projection));
+	nearPlane = XMVectorGetZ(XMVector3TransformCoord(XMVectorSet(0, 0, 0, 1), inverse));
+	farPlane = XMVectorGetZ(XMVector3TransformCoord(XMVectorSet(0, 0, 1, 1), inverse));
+}
+
+void CascadedShadows::SliceCorners(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, float nearDepth, float farDepth, XMFLOAT3* corners)
+{
+	XMMATRIX inverseProjection = XMMatrixInverse(0, XMLoadFloat4x4(&projection));
+	XMMATRIX inverseView = XMMatrixInverse(0, XMLoadFloat4x4(&view));
+
+	const float xs[4] = { -1, 1, 1, -1 };
+	const float ys[4] = { 1, 1, -1, -1 };
+	for (int i = 0; i < 4; i++)
+	{
+		// The frustum's edge through this corner, in view space - points along it
+		// are linear in view depth for both perspective and orthographic cameras
+		XMVECTOR edgeNear = XMVector3TransformCoord(XMVectorSet(xs[i], ys[i], 0, 1), inverseProjection);
+		XMVECTOR edgeFar = XMVector3TransformCoord(XMVectorSet(xs[i], ys[i], 1, 1), inverseProjection);
+		float edgeNearZ = XMVectorGetZ(edgeNear);
+		float edgeLength = XMVectorGetZ(edgeFar) - edgeNearZ;
+
+		XMVECTOR sliceNear = XMVectorLerp(edgeNear, edgeFar, (nearDepth - edgeNearZ) / edgeLength);
+		XMVECTOR sliceFar = XMVectorLerp(edgeNear, edgeFar, (farDepth - edgeNearZ) / edgeLength);
+		XMStoreFloat3(&corners[i], XMVector3TransformCoord(sliceNear, inverseView));
+		XMStoreFloat3(&corners[i + 4], XMVector3TransformCoord(sliceFar, inverseView));
+	}
+}
+
+XMFLOAT4X4 CascadedShadows::LightView(XMFLOAT3 lightDirection)
+{
+	XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+	XMVECTOR up = fabsf(XMVectorGetY(direction)) > 0.99f ? XMVectorSet(0, 0, 1, 0) : XMVectorSet(0, 1, 0, 0);
+
+	XMFLOAT4X4 view;
+	XMStoreFloat4x4(&view, XMMatrixLookToLH(XMVectorSet(0, 0, 0, 1), direction, up));
+	return view;
+}
+
+ShadowCascade CascadedShadows::Fit(const XMFLOAT3* corners, XMFLOAT3 lightDirection, const CascadeSettings& settings)
+{
+	ShadowCascade cascade;
+
+	// Bounding sphere: the corners' centroid, out to the farthest one
+	XMVECTOR center = XMVectorZero();
+	for (int i = 0; i < 8; i++)
+		center += XMLoadFloat3(&corners[i]);
+	center /= 8.0f;
+
+	float radius = 0;
+	for (int i = 0; i < 8; i++)
+		radius = max(radius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&corners[i]) - center)));
+
+	// Rounded up, so rounding error as the camera turns can't change the texel size
+	radius = ceilf(radius * 16.0f) / 16.0f;
+	XMStoreFloat3(&cascade.Center, center);
+	cascade.Radius = radius;
+
+	// A texel of margin each side, so snapping can't push the sphere out of the map
+	float halfExtent = radius * settings.Resolution / (settings.Resolution - 2.0f);
+	cascade.TexelSize = halfExtent * 2.0f / settings.Resolution;
+
+	// Snap the center to whole texels across the light's view - then a world point
+	// always lands at the same spot within its texel as the camera moves
+	cascade.View = LightView(lightDirection);
+	XMMATRIX lightView = XMLoadFloat4x4(&cascade.View);
+	XMFLOAT3 lightCenter;
+	XMStoreFloat3(&lightCenter, XMVector3TransformCoord(center, lightView));
+	lightCenter.x = floorf(lightCenter.x / cascade.TexelSize + 0.5f) * cascade.TexelSize;
+	lightCenter.y = floorf(lightCenter.y / cascade.TexelSize + 0.5f) * cascade.TexelSize;
+
+	// Depth reaches back toward the light to catch casters outside the slice
+	SetBox(cascade,
+		XMFLOAT3(lightCenter.x - halfExtent, lightCenter.y - halfExtent, lightCenter.z - halfExtent - settings.CasterDistance),
+		XMFLOAT3(lightCenter.x + halfExtent, lightCenter.y + halfExtent, lightCenter.z + halfExtent));
+	return cascade;
+}
+
+vector<ShadowCascade> CascadedShadows::Build(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, XMFLOAT3 lightDirection, const CascadeSettings& settings)
+{
+	float nearPlane, farPlane;
+	DepthRange(projection, nearPlane, farPlane);
+	farPlane = min(farPlane, max(settings.ShadowDistance, nearPlane * 2.0f));
+
+	unsigned int count = min(max(settings.Count, 1u), MaxCascades);
+	vector<float> splits = SplitDistances(nearPlane, farPlane, count, settings.Lambda);
+
+	vector<ShadowCascade> cascades;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		XMFLOAT3 corners[8];
+		SliceCorners(view, projection, splits[i], splits[i + 1], corners);
+
+		ShadowCascade cascade = Fit(corners, lightDirection, settings);
+		cascade.Near = splits[i];
+		cascade.Far = splits[i + 1];
+		cascades.push_back(cascade);
+	}
+	return cascades;
+}
+
+void CascadedShadows::Cull(vector<ShadowCascade>& cascades, const XMFLOAT4X4& view, const XMFLOAT4X4& projection, const vector<ShadowCaster>& casters)
+{
+	if (cascades.empty())
+		return;
+
+	// Every cascade shares the light's view, so each sphere only needs moving into it once
+	Frustum frustum = Frustum::FromViewProjection(view, projection);
+	XMMATRIX cameraView = XMLoadFloat4x4(&view);
+	XMMATRIX lightView = XMLoadFloat4x4(&cascades[0].View);
+	vector<XMFLOAT3> lightCenters(casters.size());
+	vector<float> viewDepths(casters.size());
+	vector<bool> visible(casters.size());
+	for (size_t i = 0; i < casters.size(); i++)
+	{
+		XMVECTOR center = XMLoadFloat3(&casters[i].Center);
+		XMStoreFloat3(&lightCenters[i], XMVector3TransformCoord(center, lightView));
+		viewDepths[i] = XMVectorGetZ(XMVector3TransformCoord(center, cameraView));
+		visible[i] = frustum.IntersectsSphere(casters[i].Center, casters[i].Radius);
+	}
+
+	for (ShadowCascade& cascade : cascades)
+	{
+		cascade.Casters.clear();
+		cascade.Receivers = 0;
+
+		// Receivers: seen by the camera, in this slice's depths and inside the map
+		XMFLOAT3 receiverMin(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 receiverMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (size_t i = 0; i < casters.size(); i++)
+		{
+			XMFLOAT3 c = lightCenters[i];
+			float r = casters[i].Radius;
+			if (!visible[i] || viewDepths[i] + r < cascade.Near || viewDepths[i] - r > cascade.Far ||
+				c.x + r < cascade.LightMin.x || c.x - r > cascade.LightMax.x || c.y + r < cascade.LightMin.y || c.y - r > cascade.LightMax.y)
+				continue;
+
+			receiverMin = XMFLOAT3(min(receiverMin.x, c.x - r), min(receiverMin.y, c.y - r), min(receiverMin.z, c.z - r));
+			receiverMax = XMFLOAT3(max(receiverMax.x, c.x + r), max(receiverMax.y, c.y + r), max(receiverMax.z, c.z + r));
+			cascade.Receivers++;
+		}
+
+		// Nothing to shadow, so nothing needs drawing
+		if (cascade.Receivers == 0)
+			continue;
+		receiverMin.x = max(receiverMin.x, cascade.LightMin.x);
+		receiverMin.y = max(receiverMin.y, cascade.LightMin.y);
+		receiverMax.x = min(receiverMax.x, cascade.LightMax.x);
+		receiverMax.y = min(receiverMax.y, cascade.LightMax.y);
+
+		// Casters: over the receivers (looking down the light), and not wholly behind all of them
+		float casterNear = receiverMin.z;
+		for (size_t i = 0; i < casters.size(); i++)
+		{
+			XMFLOAT3 c = lightCenters[i];
+			float r = casters[i].Radius;
+			if (c.x + r < receiverMin.x || c.x - r > receiverMax.x || c.y + r < receiverMin.y || c.y - r > receiverMax.y || c.z - r > receiverMax.z)
+				continue;
+
+			cascade.Casters.push_back((unsigned int)i);
+			casterNear = min(casterNear, c.z - r);
+		}
+
+		// Across the light the box stays snapped - only the depth range is fit to the scene
+		SetBox(cascade,
+			XMFLOAT3(cascade.LightMin.x, cascade.LightMin.y, casterNear),
+			XMFLOAT3(cascade.LightMax.x, cascade.LightMax.y, receiverMax.z));
+	}
+}
+
+bool CascadedShadows::NeedsRedraw(const ShadowCascade& drawn, const ShadowCascade& current, const vector<bool>& moved)
+{
+	if (memcmp(&drawn.ViewProjection, &current.ViewProjection, sizeof(current.ViewProjection)) != 0 || drawn.Casters != current.Casters)
+		return true;
+
+	// The same casters, so if one has moved it's in both lists
+	for (unsigned int caster : current.Casters)
+	{
+		if (caster >= moved.size() || moved[caster])
+			return true;
+	}
+	return false;
+}
+
+ShadowCascadeData CascadedShadows::Pack(const vector<ShadowCascade>& cascades)
+{
+	ShadowCascadeData data = {};
+	float ends[MaxCascades] = {};
+	for (unsigned int i = 0; i < MaxCascades; i++)
+	{
+		// Unused slots repeat the last cascade, so nothing reads garbage
+		const ShadowCascade& cascade = cascades[min((size_t)i, cascades.size() - 1)];
+		data.ViewProjections[i] = cascade.ViewProjection;
+		ends[i] = cascade.Far;
+	}
+	data.Ends = XMFLOAT4(ends[0], ends[1], ends[2], ends[3]);
+	data.Count = (int)cascades.size();
+	return data;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+struct CascadeSettings
+{
+	unsigned int Count = 4;
+	float Lambda = 0.75f;			// Practical split blend: 0 = uniform, 1 = logarithmic
+	float ShadowDistance = 60.0f;	// Cascades stop here, or at the camera's far plane if that's nearer
+	unsigned int Resolution = 1024;	// Each cascade's map is this square
+	float CasterDistance = 50.0f;	// How far toward the light, past a cascade's bounds, casters are still drawn (until Cull fits it to the scene)
+};
+
+// An entity's world bounding sphere - everything casts and receives
+struct ShadowCaster
+{
+	DirectX::XMFLOAT3 Center;
+	float Radius = 0;
+};
+
+// One slice of the camera's frustum and the light projection that covers it
+struct ShadowCascade
+{
+	float Near = 0;					// View depths of the slice
+	float Far = 0;
+	DirectX::XMFLOAT3 Center;		// Bounding sphere of the slice, in world space
+	float Radius = 0;
+	float TexelSize = 0;			// World units per shadow map texel
+	DirectX::XMFLOAT3 LightMin;		// The projection's box, in the light's view space
+	DirectX::XMFLOAT3 LightMax;
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	DirectX::XMFLOAT4X4 ViewProjection;
+
+	// Filled in by Cull
+	std::vector<unsigned int> Casters;	// Indices of the casters that can shadow what's visible in the slice
+	unsigned int Receivers = 0;			// How many visible casters (as receivers) the slice holds
+};
+
+// Same layout as ShadowCascades in PixelShader.hlsl
+struct ShadowCascadeData
+{
+	DirectX::XMFLOAT4X4 ViewProjections[4];
+	DirectX::XMFLOAT4 Ends;			// Far view depth of each cascade
+	int Count;
+};
+
+// --------------------------------------------------------
+// Fits a directional light's shadow cascades to the camera.
+// The frustum is split at practical split distances (a
+// blend of uniform and logarithmic), and each slice gets
+// an orthographic projection around its bounding sphere.
+//
+// A sphere keeps its size however the camera turns, so the
+// texel size never changes.  Snapping the sphere's center
+// to whole texels in light space then means that as the
+// camera moves, the map slides by whole texels and the
+// shadow edges don't shimmer.
+//
+// Cull then narrows each cascade to the scene: receivers
+// are the bounding spheres the camera sees in the slice,
+// casters are whatever lies between them and the light,
+// and the depth range runs from the nearest caster to the
+// farthest receiver.  That range comes from the spheres
+// alone, so while nothing moves (and the camera stays
+// within a texel) a cascade comes out exactly the same, and
+// NeedsRedraw can keep last frame's map.
+//
+// Nothing here touches D3D, so the fitting and the caster
+// selection are checked headlessly (Tests/CascadedShadowsTests.cpp).
+// --------------------------------------------------------
+namespace CascadedShadows
+{
+	const unsigned int MaxCascades = 4;	// Must match MAX_CASCADES in PixelShader.hlsl
+
+	// Count + 1 view depths, from the near plane to the far one
+	std::vector<float> SplitDistances(float nearPlane, float farPlane, unsigned int count, float lambda);
+
+	// Near and far view depths of a perspective or orthographic projection
+	void DepthRange(const DirectX::XMFLOAT4X4& projection, float& nearPlane, float& farPlane);
+
+	// World space corners of the frustum between two view depths - near four, then far four
+	void SliceCorners(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, float nearDepth, float farDepth, DirectX::XMFLOAT3* corners);
+
+	// Looks along the light from the origin (only its orientation matters)
+	DirectX::XMFLOAT4X4 LightView(DirectX::XMFLOAT3 lightDirection);
+
+	// A snapped projection around the slice's corners
+	ShadowCascade Fit(const DirectX::XMFLOAT3* corners, DirectX::XMFLOAT3 lightDirection, const CascadeSettings& settings);
+
+	// Every cascade for the camera's view and projection
+	std::vector<ShadowCascade> Build(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, DirectX::XMFLOAT3 lightDirection, const CascadeSettings& settings);
+
+	// Picks each cascade's casters and fits its depth range to them and its receivers
+	void Cull(std::vector<ShadowCascade>& cascades, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, const std::vector<ShadowCaster>& casters);
+
+	// False if the cascade was drawn with the same projection and casters, none of which have moved since
+	bool NeedsRedraw(const ShadowCascade& drawn, const ShadowCascade& current, const std::vector<bool>& moved);
+
+	// What the pixel shader needs to pick and sample a cascade
+	ShadowCascadeData Pack(const std::vector<ShadowCascade>& cascades);
+}
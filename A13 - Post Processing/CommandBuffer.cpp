@@ -0,0 +1,121 @@
+#include "CommandBuffer.h"
+
+#include <cstring>
+
+using namespace std;
+
+void CommandBuffer::Clear()
+{
+	commands.clear();
+	data.clear();
+}
+
+void CommandBuffer::Add(CommandType type, unsigned int handle, unsigned int offset, unsigned int count)
+{
+	Command command;
+	command.Type = type;
+	command.Handle = handle;
+	command.Offset = offset;
+	command.Count = count;
+	commands.push_back(command);
+}
+
+void CommandBuffer::BindPipeline(unsigned int pipeline)
+{
+	Add(CommandType::BindPipeline, pipeline);
+}
+
+void CommandBuffer::BindMaterial(unsigned int material)
+{
+	Add(CommandType::BindMaterial, material);
+}
+
+void CommandBuffer::BindMesh(unsigned int mesh)
+{
+	Add(CommandType::BindMesh, mesh);
+}
+
+void CommandBuffer::DrawIndexed(unsigned int indexCount, unsigned int firstIndex)
+{
+	Add(CommandType::DrawIndexed, 0, firstIndex, indexCount);
+}
+
+void CommandBuffer::SetConstants(ShaderStage stage, unsigned int bufferIndex, const void* data, unsigned int size)
+{
+	memcpy(AllocateConstants(stage, bufferIndex, size), data, size);
+}
+
+unsigned char* CommandBuffer::AllocateConstants(ShaderStage stage, unsigned int bufferIndex, unsigned int size)
+{
+	unsigned int offset = (unsigned int)data.size();
+	data.resize(data.size() + size);
+
+	Add(CommandType::SetConstants, bufferIndex, offset, size);
+	commands.back().Stage = stage;
+	return data.data() + offset;
+}
+
+void NullCommandExecutor::Execute(const CommandBuffer& buffer)
+{
+	bool pipelineBound = false;
+	bool meshBound = false;
+
+	for (const Command& command : buffer.GetCommands())
+	{
+		stats.Commands++;
+		switch (command.Type)
+		{
+		case CommandType::BindPipeline:
+			stats.PipelineBinds++;
+			pipelineBound = true;
+			break;
+
+		case CommandType::BindMaterial:
+			stats.MaterialBinds++;
+			break;
+
+		case CommandType::BindMesh:
+			stats.MeshBinds++;
+			meshBound = true;
+			break;
+
+		case CommandType::SetConstants:
+		{
+			stats.ConstantUpdates++;
+			stats.ConstantBytes += command.Count;
+			if (!pipelineBound) stats.Errors++;
+
+			// Stands in for the copy a real backend would make - read
+			// a word at a time, so it costs about what a memcpy would
+			const unsigned char* bytes = buffer.GetData(command);
+			unsigned long long checksum = stats.Checksum;
+			unsigned int i = 0;
+			for (; i + 8 <= command.Count; i += 8)
+			{
+				unsigned long long word;
+				memcpy(&word, bytes + i, 8);
+				checksum += word;
+			}
+			for (; i < command.Count; i++)
+				checksum += bytes[i];
+			stats.Checksum = checksum;
+			break;
+		}
+
+		case CommandType::DrawIndexed:
+			stats.Draws++;
+			stats.Indices += command.Count;
+			if (!pipelineBound || !meshBound) stats.Errors++;
+			break;
+		}
+	}
+
+	if (recording)
+		recorded.insert(recorded.end(), buffer.GetCommands().begin(), buffer.GetCommands().end());
+}
+
+void NullCommandExecutor::ResetStats()
+{
+	stats = NullExecutorStats();
+	recorded.clear();
+}
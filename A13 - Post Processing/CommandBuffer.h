@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+
+// --------------------------------------------------------
+// What a command buffer can say.  Pipelines, materials and
+// meshes are small handles the executor resolves to real
+// objects, so building a buffer never touches the API.
+// --------------------------------------------------------
+enum class CommandType : unsigned char
+{
+	BindPipeline,	// Handle: pipeline (vertex + pixel shader)
+	BindMaterial,	// Handle: material (textures and samplers)
+	BindMesh,		// Handle: mesh (vertex and index buffers)
+	SetConstants,	// Handle: constant buffer index in the bound pipeline's shader; Offset/Count: bytes in the buffer's data
+	DrawIndexed		// Offset: first index, Count: index count
+};
+
+enum class ShaderStage : unsigned char
+{
+	Vertex,
+	Pixel
+};
+
+struct Command
+{
+	CommandType Type = CommandType::DrawIndexed;
+	ShaderStage Stage = ShaderStage::Vertex;	// SetConstants only
+	unsigned int Handle = 0;
+	unsigned int Offset = 0;
+	unsigned int Count = 0;
+};
+
+// --------------------------------------------------------
+// A flat list of commands plus the constant data they
+// refer to.  Cleared and refilled every frame; the vectors
+// keep their capacity, so steady-state frames don't allocate.
+// --------------------------------------------------------
+class CommandBuffer
+{
+public:
+	void Clear();
+
+	void BindPipeline(unsigned int pipeline);
+	void BindMaterial(unsigned int material);
+	void BindMesh(unsigned int mesh);
+	void DrawIndexed(unsigned int indexCount, unsigned int firstIndex = 0);
+
+	// Copies the data in
+	void SetConstants(ShaderStage stage, unsigned int bufferIndex, const void* data, unsigned int size);
+
+	// Reserves room for the data and returns it to be written in place.
+	// Only valid until the next command is added.
+	unsigned char* AllocateConstants(ShaderStage stage, unsigned int bufferIndex, unsigned int size);
+
+	const std::vector<Command>& GetCommands() const { return commands; }
+	const std::vector<unsigned char>& GetData() const { return data; }
+	const unsigned char* GetData(const Command& command) const { return data.data() + command.Offset; }
+
+private:
+	std::vector<Command> commands;
+	std::vector<unsigned char> data;
+
+	void Add(CommandType type, unsigned int handle, unsigned int offset = 0, unsigned int count = 0);
+};
+
+// --------------------------------------------------------
+// Carries out a command buffer against some backend
+// --------------------------------------------------------
+class ICommandExecutor
+{
+public:
+	virtual ~ICommandExecutor() = default;
+	virtual void Execute(const CommandBuffer& buffer) = 0;
+};
+
+struct NullExecutorStats
+{
+	unsigned int Commands = 0;
+	unsigned int PipelineBinds = 0;
+	unsigned int MaterialBinds = 0;
+	unsigned int MeshBinds = 0;
+	unsigned int ConstantUpdates = 0;
+	unsigned int Draws = 0;
+	unsigned long long ConstantBytes = 0;
+	unsigned long long Indices = 0;
+	unsigned int Errors = 0;			// Draws with nothing bound, constants with no pipeline
+	unsigned long long Checksum = 0;	// Over every constant byte, so the data really is read
+};
+
+// --------------------------------------------------------
+// Executes by walking the commands and doing no rendering,
+// so the CPU side of a frame can be run and measured
+// anywhere.  Keeps a copy of every command when recording.
+// --------------------------------------------------------
+class NullCommandExecutor : public ICommandExecutor
+{
+public:
+	void Execute(const CommandBuffer& buffer) override;
+
+	void SetRecording(bool recording) { this->recording = recording; }
+	const std::vector<Command>& GetRecorded() const { return recorded; }
+
+	// Totals since the last reset
+	const NullExecutorStats& GetStats() const { return stats; }
+	void ResetStats();
+
+private:
+	bool recording = false;
+	std::vector<Command> recorded;
+	NullExecutorStats stats;
+};
@@ -0,0 +1,131 @@
+#include "CommandListSubmitter.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+ParallelSubmitter::ParallelSubmitter(unsigned int threadCount)
+{
+	recordedOn.resize(threadCount + 1);
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.push_back(thread(&ParallelSubmitter::WorkerLoop, this, i));
+}
+
+ParallelSubmitter::~ParallelSubmitter()
+{
+	{
+		lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+vector<SubmissionChunk> ParallelSubmitter::Partition(unsigned int drawCount, unsigned int maxLists, unsigned int minDrawsPerList)
+{
+	vector<SubmissionChunk> chunks;
+	if (drawCount == 0 || maxLists == 0)
+		return chunks;
+
+	unsigned int lists = drawCount / max(minDrawsPerList, 1u);
+	lists = min(max(lists, 1u), maxLists);
+
+	// The remainder goes one apiece to the first chunks
+	unsigned int size = drawCount / lists;
+	unsigned int remainder = drawCount % lists;
+	unsigned int first = 0;
+	for (unsigned int i = 0; i < lists; i++)
+	{
+		SubmissionChunk chunk;
+		chunk.First = first;
+		chunk.Count = size + (i < remainder ? 1 : 0);
+		chunks.push_back(chunk);
+		first += chunk.Count;
+	}
+	return chunks;
+}
+
+// --------------------------------------------------------
+// Takes chunks until there are none left.  The lock is held
+// only to claim a chunk and to report it finished.
+// --------------------------------------------------------
+void ParallelSubmitter::RunChunks(unique_lock<std::mutex>& lock, unsigned int worker)
+{
+	while (nextChunk < chunkCount)
+	{
+		unsigned int chunk = nextChunk++;
+		recordedOn[worker] = 1;
+
+		lock.unlock();
+		job(chunk);
+		lock.lock();
+
+		if (++chunksDone == chunkCount)
+			workDone.notify_all();
+	}
+}
+
+void ParallelSubmitter::WorkerLoop(unsigned int worker)
+{
+	Profiler::SetThreadName(("Submission Worker " + to_string(worker)).c_str());
+
+	unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		workAvailable.wait(lock, [this] { return stopping || nextChunk < chunkCount; });
+		if (stopping) return;
+
+		RunChunks(lock, worker);
+	}
+}
+
+SubmissionStats ParallelSubmitter::Submit(ICommandListBackend& backend, unsigned int drawCount, const function<void(unsigned int, unsigned int)>& record, unsigned int minDrawsPerList)
+{
+	SubmissionStats stats;
+	stats.Draws = drawCount;
+
+	vector<SubmissionChunk> chunks = Partition(drawCount, backend.GetContextCount(), minDrawsPerList);
+	stats.Lists = (unsigned int)chunks.size();
+	if (chunks.empty())
+		return stats;
+
+	auto start = chrono::high_resolution_clock::now();
+	{
+		unique_lock<std::mutex> lock(mutex);
+		job = [&](unsigned int chunk) {
+			PROFILE_ZONE("Record Command List");
+			backend.BeginList(chunk);
+			for (unsigned int i = 0; i < chunks[chunk].Count; i++)
+				record(chunk, chunks[chunk].First + i);
+			backend.EndList(chunk);
+		};
+		fill(recordedOn.begin(), recordedOn.end(), 0);
+		chunkCount = (unsigned int)chunks.size();
+		nextChunk = 0;
+		chunksDone = 0;
+		workAvailable.notify_all();
+
+		// Help out rather than sit idle, then wait for the stragglers
+		RunChunks(lock, (unsigned int)workers.size());
+		workDone.wait(lock, [this] { return chunksDone == chunkCount; });
+
+		job = nullptr;
+		for (char used : recordedOn)
+			stats.Threads += used;
+	}
+	auto recorded = chrono::high_resolution_clock::now();
+
+	// Every list is closed, so they can go in order
+	for (unsigned int i = 0; i < chunks.size(); i++)
+		backend.ExecuteList(i);
+	auto executed = chrono::high_resolution_clock::now();
+
+	stats.RecordMilliseconds = chrono::duration<double, milli>(recorded - start).count();
+	stats.ExecuteMilliseconds = chrono::duration<double, milli>(executed - recorded).count();
+	return stats;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A contiguous run of draws, recorded into one command list
+struct SubmissionChunk
+{
+	unsigned int First = 0;
+	unsigned int Count = 0;
+};
+
+struct SubmissionStats
+{
+	unsigned int Draws = 0;
+	unsigned int Lists = 0;
+	unsigned int Threads = 0;			// Threads that recorded (including the calling one)
+	double RecordMilliseconds = 0;		// Wall time until every list was closed
+	double ExecuteMilliseconds = 0;		// Replaying the lists on the calling thread
+};
+
+// --------------------------------------------------------
+// Something that can record commands on several contexts at
+// once and replay them later, in an order of our choosing.
+// Each context holds at most one finished list at a time.
+//
+// D3D11CommandListBackend maps this onto deferred contexts;
+// a test can implement it by just recording what happened.
+// --------------------------------------------------------
+class ICommandListBackend
+{
+public:
+	virtual ~ICommandListBackend() = default;
+
+	virtual unsigned int GetContextCount() = 0;
+
+	// Called on whichever thread records the context's chunk
+	virtual void BeginList(unsigned int context) = 0;
+	virtual void EndList(unsigned int context) = 0;
+
+	// Called on the submitting thread, in chunk order
+	virtual void ExecuteList(unsigned int context) = 0;
+};
+
+// --------------------------------------------------------
+// Splits a list of draws into contiguous chunks, records
+// each chunk into its own command list on a pool of worker
+// threads (the calling thread records too), then executes
+// the lists in chunk order, so the GPU sees the draws in
+// exactly the order they were given.
+// --------------------------------------------------------
+class ParallelSubmitter
+{
+public:
+	// 0 threads records everything on the calling thread
+	ParallelSubmitter(unsigned int threadCount);
+	~ParallelSubmitter();
+
+	ParallelSubmitter(const ParallelSubmitter&) = delete;
+	ParallelSubmitter& operator=(const ParallelSubmitter&) = delete;
+
+	unsigned int GetThreadCount() const { return (unsigned int)workers.size(); }
+
+	// Calls record(context, draw) once for every draw below drawCount.
+	// Draws within a chunk are recorded in order on one context;
+	// chunk i always uses context i.
+	SubmissionStats Submit(ICommandListBackend& backend, unsigned int drawCount, const std::function<void(unsigned int, unsigned int)>& record, unsigned int minDrawsPerList = 1);
+
+	// At most maxLists chunks of at least minDrawsPerList draws each (unless
+	// there are fewer draws than that), sized within one draw of each other
+	static std::vector<SubmissionChunk> Partition(unsigned int drawCount, unsigned int maxLists, unsigned int minDrawsPerList);
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workDone;
+	bool stopping = false;
+
+	// The submission in flight - only replaced once every chunk is done
+	std::function<void(unsigned int)> job;
+	unsigned int chunkCount = 0;
+	unsigned int nextChunk = 0;
+	unsigned int chunksDone = 0;
+	std::vector<char> recordedOn;	// Per worker (plus the caller, last), whether it took a chunk
+
+	void WorkerLoop(unsigned int worker);
+	void RunChunks(std::unique_lock<std::mutex>& lock, unsigned int worker);
+};
@@ -0,0 +1,67 @@
+// Must match AutoExposure::BinCount
+#define BIN_COUNT 256
+
+// Averages the luminance histogram and adapts the exposure toward
+// it - one group, one thread per bin.  Clears the histogram for
+// the next frame on the way.  Must match AutoExposure on the CPU.
+cbuffer externalData : register(b0)
+{
+    float minLogLuminance;
+    float logRange;         // Stops covered above the minimum
+    float deltaTime;
+    float adaptToBright;    // Rates per second
+    float adaptToDark;
+    float keyValue;
+}
+
+RWByteAddressBuffer Histogram : register(u0);
+RWStructuredBuffer<float> AdaptedExposure : register(u1);   // [0] = adapted luminance, [1] = exposure
+
+groupshared float weighted[BIN_COUNT];
+groupshared float counted[BIN_COUNT];
+
+[numthreads(BIN_COUNT, 1, 1)]
+void main(uint index : SV_GroupIndex)
+{
+    // Bin 0 is too dark to count
+    float count = index > 0 ? (float)Histogram.Load(index * 4) : 0.0f;
+    weighted[index] = count * (index - 1.0f);
+    counted[index] = count;
+    Histogram.Store(index * 4, 0);
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint stride = BIN_COUNT / 2; stride > 0; stride >>= 1)
+    {
+        if (index < stride)
+        {
+            weighted[index] += weighted[index + stride];
+            counted[index] += counted[index + stride];
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (index != 0)
+        return;
+
+    // Nothing counted (a black frame) holds the exposure where it is
+    float adapted = AdaptedExposure[0];
+    if (counted[0] > 0)
+    {
+        float t = weighted[0] / counted[0] / (BIN_COUNT - 2);
+        float targetLog = t * logRange + minLogLuminance;
+        if (adapted <= 0)
+        {
+            adapted = exp2(targetLog);
+        }
+        else
+        {
+            // In stops, at a rate per second - the same at any frame rate
+            float adaptedLog = log2(adapted);
+            float rate = targetLog > adaptedLog ? adaptToBright : adaptToDark;
+            adapted = exp2(adaptedLog + (targetLog - adaptedLog) * (1 - exp(-deltaTime * rate)));
+        }
+    }
+
+    AdaptedExposure[0] = adapted;
+    AdaptedExposure[1] = keyValue / max(adapted, 0.0001f);
+}
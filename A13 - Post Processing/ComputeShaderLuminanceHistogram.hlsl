@@ -0,0 +1,46 @@
+// Must match AutoExposure::BinCount
+#define BIN_COUNT 256
+
+// Counts the HDR scene's pixels by log2 luminance, for the
+// auto exposure (ComputeShaderExposure averages the result).
+// Bin 0 takes pixels too dark to count.  Must match
+// AutoExposure::Bin on the CPU.
+cbuffer externalData : register(b0)
+{
+    float minLogLuminance;
+    float inverseLogRange;  // 1 / stops covered
+}
+
+Texture2D Pixels : register(t0);
+RWByteAddressBuffer Histogram : register(u0);
+
+// Each group counts into its own bins first, so the buffer only
+// sees one atomic per bin per group rather than one per pixel
+groupshared uint bins[BIN_COUNT];
+
+uint LuminanceBin(float3 color)
+{
+    float luminance = dot(color, float3(0.2126f, 0.7152f, 0.0722f));
+    if (luminance < exp2(minLogLuminance))
+        return 0;
+
+    float t = saturate((log2(luminance) - minLogLuminance) * inverseLogRange);
+    return (uint)(t * (BIN_COUNT - 2) + 1.0f);
+}
+
+[numthreads(16, 16, 1)]
+void main(uint3 id : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
+{
+    bins[groupIndex] = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    uint width, height;
+    Pixels.GetDimensions(width, height);
+    if (id.x < width && id.y < height)
+        InterlockedAdd(bins[LuminanceBin(Pixels.Load(int3(id.xy, 0)).rgb)], 1);
+    GroupMemoryBarrierWithGroupSync();
+
+    // 256 threads, 256 bins - one each
+    if (bins[groupIndex] > 0)
+        Histogram.InterlockedAdd(groupIndex * 4, bins[groupIndex]);
+}
@@ -0,0 +1,90 @@
+// Must match TiledPostProcess on the CPU
+#define TILE_SIZE 16
+#define MAX_APRON 30
+#define MAX_SIDE (TILE_SIZE + 2 * MAX_APRON)
+
+// Compiled once per set of post effects, like the pixel passes
+// (the POST_* defines come from PostPermutations)
+#include "PostEffects.hlsli"
+
+// The whole post process in one dispatch: the separable Gaussian
+// from PixelShaderBlur, then the pointwise effects from
+// PostEffects.hlsli.  Each group blurs a 16x16 tile out of
+// groupshared memory, so the blur reads the scene once and
+// never writes between directions.
+cbuffer externalData : register(b0)
+{
+    int apron;          // Kernel extent - texels needed past each edge of the tile
+    float4 weights[8];  // GaussianBlur::Weights, four to a float4
+}
+
+Texture2D Pixels : register(t0);
+RWTexture2D<unorm float4> Output : register(u0);
+
+// The scene is HDR, so texels are packed as R11G11B10 floats (the
+// halves, cut down to 6, 6 and 5 bits of mantissa) - still one uint
+// each, so 28 KB at the widest apron, under the 32 KB limit.  Alpha
+// isn't kept; it's always 1 in the scene.
+groupshared uint tile[MAX_SIDE * MAX_SIDE];
+groupshared uint rows[MAX_SIDE * TILE_SIZE];
+
+uint Pack(float4 color)
+{
+    uint3 halves = f32tof16(max(color.rgb, 0));
+    return (halves.r >> 4) | ((halves.g >> 4) << 11) | ((halves.b >> 5) << 22);
+}
+
+float4 Unpack(uint packed)
+{
+    uint3 halves = uint3((packed & 0x7FF) << 4, ((packed >> 11) & 0x7FF) << 4, (packed >> 22) << 5);
+    return float4(f16tof32(halves), 1);
+}
+
+float Weight(int i)
+{
+    return weights[i / 4][i % 4];
+}
+
+// Anything that only looks at one pixel belongs here
+float4 Pointwise(float4 color, float2 uv)
+{
+    return ApplyPostEffects(color, uv);
+}
+
+[numthreads(TILE_SIZE, TILE_SIZE, 1)]
+void main(uint3 groupId : SV_GroupID, uint3 threadId : SV_GroupThreadID, uint groupIndex : SV_GroupIndex)
+{
+    uint width, height;
+    Pixels.GetDimensions(width, height);
+    int side = TILE_SIZE + 2 * apron;
+    int2 origin = int2(groupId.xy) * TILE_SIZE - apron;
+
+    // Every thread loads every 256th texel until the tile and its apron are in
+    for (int i = groupIndex; i < side * side; i += TILE_SIZE * TILE_SIZE)
+    {
+        int2 texel = clamp(origin + int2(i % side, i / side), 0, int2(width, height) - 1);
+        tile[i] = Pack(Pixels.Load(int3(texel, 0)));
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // Horizontal, for the tile's own columns on every loaded row
+    for (int j = groupIndex; j < side * TILE_SIZE; j += TILE_SIZE * TILE_SIZE)
+    {
+        int start = (j / TILE_SIZE) * side + j % TILE_SIZE + apron;
+        float4 total = Unpack(tile[start]) * Weight(0);
+        for (int k = 1; k <= apron; k++)
+            total += (Unpack(tile[start - k]) + Unpack(tile[start + k])) * Weight(k);
+        rows[j] = Pack(total);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // Vertical, one pixel per thread, then straight out through the pointwise effects
+    int center = (threadId.y + apron) * TILE_SIZE + threadId.x;
+    float4 color = Unpack(rows[center]) * Weight(0);
+    for (int k = 1; k <= apron; k++)
+        color += (Unpack(rows[center - k * TILE_SIZE]) + Unpack(rows[center + k * TILE_SIZE])) * Weight(k);
+
+    uint2 pixel = groupId.xy * TILE_SIZE + threadId.xy;
+    if (pixel.x < width && pixel.y < height)
+        Output[pixel] = Pointwise(color, (pixel + 0.5f) / float2(width, height));
+}
@@ -0,0 +1,77 @@
+#include "D3D11CommandExecutor.h"
+#include "Graphics.h"
+#include "Material.h"
+#include "Mesh.h"
+
+using namespace std;
+
+namespace
+{
+	template<typename T>
+	void Store(vector<T>& table, unsigned int handle, const T& value)
+	{
+		if (handle >= table.size())
+			table.resize(handle + 1);
+		table[handle] = value;
+	}
+}
+
+void D3D11CommandExecutor::SetPipeline(unsigned int handle, shared_ptr<SimpleVertexShader> vertexShader, shared_ptr<SimplePixelShader> pixelShader)
+{
+	Store(pipelines, handle, Pipeline{ vertexShader, pixelShader });
+}
+
+void D3D11CommandExecutor::SetMaterial(unsigned int handle, shared_ptr<Material> material)
+{
+	Store(materials, handle, material);
+}
+
+void D3D11CommandExecutor::SetMesh(unsigned int handle, shared_ptr<Mesh> mesh)
+{
+	Store(meshes, handle, mesh);
+}
+
+void D3D11CommandExecutor::Execute(const CommandBuffer& buffer)
+{
+	const Pipeline* pipeline = 0;
+	Mesh* mesh = 0;
+
+	for (const Command& command : buffer.GetCommands())
+	{
+		switch (command.Type)
+		{
+		case CommandType::BindPipeline:
+			pipeline = &pipelines[command.Handle];
+			pipeline->VertexShader->SetShader();
+			if (pipeline->PixelShader)
+				pipeline->PixelShader->SetShader();
+			else
+				Graphics::State->SetPixelShader(0);
+			break;
+
+		case CommandType::BindMaterial:
+			materials[command.Handle]->BindResources();
+			break;
+
+		case CommandType::BindMesh:
+			mesh = meshes[command.Handle].get();
+			mesh->Bind(Graphics::Context.Get());
+			break;
+
+		case CommandType::SetConstants:
+		{
+			ISimpleShader* shader = command.Stage == ShaderStage::Vertex ?
+				(ISimpleShader*)pipeline->VertexShader.get() :
+				(ISimpleShader*)pipeline->PixelShader.get();
+			const SimpleConstantBuffer* constants = shader ? shader->GetBufferInfo(command.Handle) : 0;
+			if (constants)
+				Graphics::Context->UpdateSubresource(constants->ConstantBuffer.Get(), 0, 0, buffer.GetData(command), 0, 0);
+			break;
+		}
+
+		case CommandType::DrawIndexed:
+			Graphics::Context->DrawIndexed(command.Count, command.Offset, 0);
+			break;
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "CommandBuffer.h"
+#include "SimpleShader.h"
+
+#include <memory>
+#include <vector>
+
+class Material;
+class Mesh;
+
+// --------------------------------------------------------
+// Executes command buffers on the immediate context.  The
+// handles in the buffer index the tables filled in here;
+// shader and resource binds go through the same paths as
+// the rest of the frame (so through the state cache).
+// --------------------------------------------------------
+class D3D11CommandExecutor : public ICommandExecutor
+{
+public:
+	// A null pixel shader makes a depth-only pipeline
+	void SetPipeline(unsigned int handle, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader);
+	void SetMaterial(unsigned int handle, std::shared_ptr<Material> material);
+	void SetMesh(unsigned int handle, std::shared_ptr<Mesh> mesh);
+
+	void Execute(const CommandBuffer& buffer) override;
+
+private:
+	struct Pipeline
+	{
+		std::shared_ptr<SimpleVertexShader> VertexShader;
+		std::shared_ptr<SimplePixelShader> PixelShader;
+	};
+
+	std::vector<Pipeline> pipelines;
+	std::vector<std::shared_ptr<Material>> materials;
+	std::vector<std::shared_ptr<Mesh>> meshes;
+};
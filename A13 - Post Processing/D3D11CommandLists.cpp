@@ -0,0 +1,110 @@
+#include "D3D11CommandLists.h"
+#include "Material.h"
+#include "Mesh.h"
+
+using namespace std;
+
+D3D11CommandListBackend::D3D11CommandListBackend(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> immediate, unsigned int contextCount) :
+	immediate(immediate),
+	driverCommandLists(false)
+{
+	contexts.resize(contextCount);
+	lists.resize(contextCount);
+	for (auto& context : contexts)
+		device->CreateDeferredContext(0, context.GetAddressOf());
+
+	D3D11_FEATURE_DATA_THREADING threading = {};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading))))
+		driverCommandLists = threading.DriverCommandLists != FALSE;
+}
+
+void D3D11CommandListBackend::BeginList(unsigned int context)
+{
+	// Closing the previous list already reset the deferred context's state
+	if (listSetup)
+		listSetup(contexts[context].Get());
+}
+
+void D3D11CommandListBackend::EndList(unsigned int context)
+{
+	contexts[context]->FinishCommandList(FALSE, lists[context].ReleaseAndGetAddressOf());
+}
+
+void D3D11CommandListBackend::ExecuteList(unsigned int context)
+{
+	immediate->ExecuteCommandList(lists[context].Get(), FALSE);
+	lists[context].Reset();
+}
+
+namespace
+{
+	void AppendConstants(ISimpleShader* shader, vector<unsigned char>& constants)
+	{
+		for (unsigned int i = 0; i < shader->GetBufferCount(); i++)
+		{
+			const SimpleConstantBuffer* buffer = shader->GetBufferInfo(i);
+			constants.insert(constants.end(), buffer->LocalDataBuffer, buffer->LocalDataBuffer + buffer->Size);
+		}
+	}
+
+	// Mirrors CopyAllBufferData() and SetShaderAndCBs(): every buffer is
+	// updated, but only true constant buffers are bound.  Returns where
+	// the next shader's constants start.
+	template<typename SetBuffers>
+	size_t RecordConstants(ID3D11DeviceContext* context, ISimpleShader* shader, const unsigned char* data, size_t offset, SetBuffers setBuffers)
+	{
+		for (unsigned int i = 0; i < shader->GetBufferCount(); i++)
+		{
+			const SimpleConstantBuffer* buffer = shader->GetBufferInfo(i);
+			context->UpdateSubresource(buffer->ConstantBuffer.Get(), 0, 0, data + offset, 0, 0);
+			offset += buffer->Size;
+
+			if (buffer->Type == D3D11_CT_CBUFFER)
+				setBuffers(buffer->BindIndex, buffer->ConstantBuffer.GetAddressOf());
+		}
+		return offset;
+	}
+}
+
+DrawPacket DrawPackets::Capture(SimpleVertexShader* vertexShader, SimplePixelShader* pixelShader, Material* material, Mesh* mesh, vector<unsigned char>& constants)
+{
+	DrawPacket packet;
+	packet.VertexShader = vertexShader;
+	packet.PixelShader = pixelShader;
+	packet.SourceMaterial = material;
+	packet.SourceMesh = mesh;
+	packet.Constants = constants.size();
+
+	AppendConstants(vertexShader, constants);
+	if (pixelShader)
+		AppendConstants(pixelShader, constants);
+	if (material)
+		material->PrepareBindings();
+	return packet;
+}
+
+void DrawPackets::Record(ID3D11DeviceContext* context, const DrawPacket& packet, const vector<unsigned char>& constants)
+{
+	size_t offset = packet.Constants;
+
+	context->IASetInputLayout(packet.VertexShader->GetInputLayout().Get());
+	context->VSSetShader(packet.VertexShader->GetDirectXShader().Get(), 0, 0);
+	offset = RecordConstants(context, packet.VertexShader, constants.data(), offset,
+		[&](UINT slot, ID3D11Buffer* const* buffer) { context->VSSetConstantBuffers(slot, 1, buffer); });
+
+	if (packet.PixelShader)
+	{
+		context->PSSetShader(packet.PixelShader->GetDirectXShader().Get(), 0, 0);
+		RecordConstants(context, packet.PixelShader, constants.data(), offset,
+			[&](UINT slot, ID3D11Buffer* const* buffer) { context->PSSetConstantBuffers(slot, 1, buffer); });
+	}
+	else
+	{
+		context->PSSetShader(0, 0, 0);
+	}
+
+	if (packet.SourceMaterial)
+		packet.SourceMaterial->BindResources(context);
+
+	packet.SourceMesh->Draw(context);
+}
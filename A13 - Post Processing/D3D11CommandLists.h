@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CommandListSubmitter.h"
+#include "SimpleShader.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <functional>
+#include <vector>
+
+class Material;
+class Mesh;
+
+// --------------------------------------------------------
+// ICommandListBackend on D3D11: one deferred context per
+// list, replayed on the immediate context.
+//
+// Deferred contexts start every list from default state, so
+// a pass's shared state (targets, viewport, etc.) is set by
+// a setup function at the start of each list.  Lists are
+// executed without restoring the immediate context's state,
+// which D3D resets to defaults instead - re-set anything
+// needed afterwards (and invalidate any state cache
+// shadowing the immediate context).
+// --------------------------------------------------------
+class D3D11CommandListBackend : public ICommandListBackend
+{
+public:
+	D3D11CommandListBackend(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> immediate, unsigned int contextCount);
+
+	unsigned int GetContextCount() override { return (unsigned int)contexts.size(); }
+	void BeginList(unsigned int context) override;
+	void EndList(unsigned int context) override;
+	void ExecuteList(unsigned int context) override;
+
+	ID3D11DeviceContext* GetContext(unsigned int context) { return contexts[context].Get(); }
+
+	// Called at the start of every list, on the recording thread
+	void SetListSetup(std::function<void(ID3D11DeviceContext*)> setup) { listSetup = setup; }
+
+	// False means the runtime emulates command lists, so recording
+	// in parallel saves less (but still works)
+	bool HasDriverCommandLists() const { return driverCommandLists; }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> immediate;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11DeviceContext>> contexts;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11CommandList>> lists;
+	std::function<void(ID3D11DeviceContext*)> listSetup;
+	bool driverCommandLists;
+};
+
+// --------------------------------------------------------
+// Everything needed to record one draw from another thread.
+// SimpleShaders keep a single copy of their constants, so the
+// main thread fills them in as usual and snapshots the bytes
+// into a per-frame array; recording only reads the snapshot.
+// --------------------------------------------------------
+struct DrawPacket
+{
+	SimpleVertexShader* VertexShader = 0;
+	SimplePixelShader* PixelShader = 0;		// Null for depth-only draws
+	const Material* SourceMaterial = 0;		// Null to leave textures alone
+	Mesh* SourceMesh = 0;
+	size_t Constants = 0;					// Offset of this draw's constants in the frame's array
+};
+
+namespace DrawPackets
+{
+	// Main thread - snapshots the shaders' current constants (so set them first)
+	// and prepares the material's bindings
+	DrawPacket Capture(SimpleVertexShader* vertexShader, SimplePixelShader* pixelShader, Material* material, Mesh* mesh, std::vector<unsigned char>& constants);
+
+	// Any thread - binds and draws everything in the packet
+	void Record(ID3D11DeviceContext* context, const DrawPacket& packet, const std::vector<unsigned char>& constants);
+}
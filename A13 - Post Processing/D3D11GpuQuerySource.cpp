@@ -0,0 +1,59 @@
+#include "D3D11GpuQuerySource.h"
+
+#include <algorithm>
+
+using namespace std;
+
+D3D11GpuQuerySource::D3D11GpuQuerySource(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int slotCount, unsigned int timestampsPerSlot) :
+	context(context)
+{
+	D3D11_QUERY_DESC disjointDesc = {};
+	disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	D3D11_QUERY_DESC timestampDesc = {};
+	timestampDesc.Query = D3D11_QUERY_TIMESTAMP;
+
+	slots.resize(slotCount);
+	for (auto& slot : slots)
+	{
+		device->CreateQuery(&disjointDesc, slot.Disjoint.GetAddressOf());
+		slot.Timestamps.resize(timestampsPerSlot);
+		for (auto& timestamp : slot.Timestamps)
+			device->CreateQuery(&timestampDesc, timestamp.GetAddressOf());
+	}
+}
+
+void D3D11GpuQuerySource::BeginFrame(unsigned int slot)
+{
+	context->Begin(slots[slot].Disjoint.Get());
+}
+
+void D3D11GpuQuerySource::Timestamp(unsigned int slot, unsigned int index)
+{
+	if (index < slots[slot].Timestamps.size())
+		context->End(slots[slot].Timestamps[index].Get());
+}
+
+void D3D11GpuQuerySource::EndFrame(unsigned int slot)
+{
+	context->End(slots[slot].Disjoint.Get());
+}
+
+bool D3D11GpuQuerySource::Read(unsigned int slot, unsigned int timestampCount, GpuQueryFrame& frame)
+{
+	// S_FALSE means "not yet" - DONOTFLUSH keeps GetData from kicking the GPU
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint = {};
+	if (context->GetData(slots[slot].Disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return false;
+
+	frame.Disjoint = disjoint.Disjoint != FALSE;
+	frame.Frequency = disjoint.Frequency;
+	frame.Timestamps.resize(min(timestampCount, (unsigned int)slots[slot].Timestamps.size()));
+	for (unsigned int i = 0; i < frame.Timestamps.size(); i++)
+	{
+		UINT64 timestamp = 0;
+		if (context->GetData(slots[slot].Timestamps[i].Get(), &timestamp, sizeof(timestamp), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return false;
+		frame.Timestamps[i] = timestamp;
+	}
+	return true;
+}
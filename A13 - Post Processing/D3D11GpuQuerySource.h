@@ -0,0 +1,34 @@
+#pragma once
+
+#include "GpuTimerRing.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <vector>
+
+// --------------------------------------------------------
+// IGpuQuerySource on D3D11: per slot, one timestamp-disjoint
+// query bracketing the frame and a fixed set of timestamp
+// queries.  Reads never flush or wait.
+// --------------------------------------------------------
+class D3D11GpuQuerySource : public IGpuQuerySource
+{
+public:
+	D3D11GpuQuerySource(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int slotCount, unsigned int timestampsPerSlot);
+
+	void BeginFrame(unsigned int slot) override;
+	void Timestamp(unsigned int slot, unsigned int index) override;
+	void EndFrame(unsigned int slot) override;
+	bool Read(unsigned int slot, unsigned int timestampCount, GpuQueryFrame& frame) override;
+
+private:
+	struct QuerySet
+	{
+		Microsoft::WRL::ComPtr<ID3D11Query> Disjoint;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> Timestamps;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	std::vector<QuerySet> slots;
+};
@@ -0,0 +1,48 @@
+#include "D3D11PostTargetPool.h"
+
+using namespace std;
+
+D3D11PostTargetPool::D3D11PostTargetPool(Microsoft::WRL::ComPtr<ID3D11Device> device) :
+	device(device)
+{
+}
+
+void D3D11PostTargetPool::Allocate(const vector<PostTargetSize>& targets)
+{
+	// Slots past the end are released; the rest are only recreated if they no longer fit
+	slots.resize(targets.size());
+	for (size_t i = 0; i < targets.size(); i++)
+	{
+		Slot& slot = slots[i];
+		if (slot.RTV && slot.Size == targets[i])
+			continue;
+
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = targets[i].Width;
+		desc.Height = targets[i].Height;
+		desc.ArraySize = 1;
+		desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+		desc.Format = (DXGI_FORMAT)targets[i].Format;
+		desc.MipLevels = 1;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+
+		// The views keep the texture alive, so it isn't tracked itself
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+		device->CreateTexture2D(&desc, 0, texture.GetAddressOf());
+		device->CreateRenderTargetView(texture.Get(), 0, slot.RTV.ReleaseAndGetAddressOf());
+		device->CreateShaderResourceView(texture.Get(), 0, slot.SRV.ReleaseAndGetAddressOf());
+		slot.Size = targets[i];
+		created++;
+	}
+}
+
+ID3D11RenderTargetView* D3D11PostTargetPool::GetRenderTarget(int slot)
+{
+	return slots[slot].RTV.Get();
+}
+
+ID3D11ShaderResourceView* D3D11PostTargetPool::GetShaderResource(int slot)
+{
+	return slots[slot].SRV.Get();
+}
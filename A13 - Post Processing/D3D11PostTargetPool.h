@@ -0,0 +1,39 @@
+#pragma once
+
+#include "PostProcessGraph.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <vector>
+
+// --------------------------------------------------------
+// IPostTargetPool on D3D11: one texture per slot, bindable
+// as both a render target and a shader resource.  Slots
+// that already match are left alone, so a resize or a new
+// graph only pays for the textures that actually change.
+// --------------------------------------------------------
+class D3D11PostTargetPool : public IPostTargetPool
+{
+public:
+	D3D11PostTargetPool(Microsoft::WRL::ComPtr<ID3D11Device> device);
+
+	void Allocate(const std::vector<PostTargetSize>& targets) override;
+	ID3D11RenderTargetView* GetRenderTarget(int slot) override;
+	ID3D11ShaderResourceView* GetShaderResource(int slot) override;
+
+	size_t GetSlotCount() const { return slots.size(); }
+	unsigned int GetCreatedCount() const { return created; }	// Textures created over the pool's life
+
+private:
+	struct Slot
+	{
+		PostTargetSize Size;
+		Microsoft::WRL::ComPtr<ID3D11RenderTargetView> RTV;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> SRV;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	std::vector<Slot> slots;
+	unsigned int created = 0;
+};
@@ -0,0 +1,67 @@
+#include "D3D11RenderContext.h"
+
+#include <cstddef>
+
+// Viewports are handed straight through, so the layouts must match
+static_assert(sizeof(RenderViewport) == sizeof(D3D11_VIEWPORT), "RenderViewport must match D3D11_VIEWPORT");
+static_assert(offsetof(RenderViewport, MinDepth) == offsetof(D3D11_VIEWPORT, MinDepth), "RenderViewport must match D3D11_VIEWPORT");
+
+D3D11RenderContext::D3D11RenderContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context) :
+	context(context)
+{
+}
+
+void D3D11RenderContext::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	context->IASetInputLayout(layout);
+}
+
+void D3D11RenderContext::VSSetShader(ID3D11VertexShader* shader)
+{
+	context->VSSetShader(shader, 0, 0);
+}
+
+void D3D11RenderContext::PSSetShader(ID3D11PixelShader* shader)
+{
+	context->PSSetShader(shader, 0, 0);
+}
+
+void D3D11RenderContext::VSSetConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	context->VSSetConstantBuffers(startSlot, count, buffers);
+}
+
+void D3D11RenderContext::PSSetConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	context->PSSetConstantBuffers(startSlot, count, buffers);
+}
+
+void D3D11RenderContext::PSSetShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views)
+{
+	context->PSSetShaderResources(startSlot, count, views);
+}
+
+void D3D11RenderContext::PSSetSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers)
+{
+	context->PSSetSamplers(startSlot, count, samplers);
+}
+
+void D3D11RenderContext::OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthView)
+{
+	context->OMSetRenderTargets(count, views, depthView);
+}
+
+void D3D11RenderContext::RSSetState(ID3D11RasterizerState* state)
+{
+	context->RSSetState(state);
+}
+
+void D3D11RenderContext::OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef)
+{
+	context->OMSetDepthStencilState(state, stencilRef);
+}
+
+void D3D11RenderContext::RSSetViewports(unsigned int count, const RenderViewport* viewports)
+{
+	context->RSSetViewports(count, (const D3D11_VIEWPORT*)viewports);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "RenderStateCache.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+// --------------------------------------------------------
+// Forwards IRenderContext calls to a D3D11 device context
+// --------------------------------------------------------
+class D3D11RenderContext : public IRenderContext
+{
+public:
+	D3D11RenderContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+
+	void IASetInputLayout(ID3D11InputLayout* layout) override;
+	void VSSetShader(ID3D11VertexShader* shader) override;
+	void PSSetShader(ID3D11PixelShader* shader) override;
+	void VSSetConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers) override;
+	void PSSetConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers) override;
+	void PSSetShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views) override;
+	void PSSetSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers) override;
+	void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthView) override;
+	void RSSetState(ID3D11RasterizerState* state) override;
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) override;
+	void RSSetViewports(unsigned int count, const RenderViewport* viewports) override;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+};
@@ -0,0 +1,186 @@
+#include "DdsFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+using namespace std;
+
+namespace
+{
+	// On-disk layout, see the DDS_HEADER and DDS_HEADER_DXT10 docs
+	struct DdsPixelFormat
+	{
+		unsigned int size;
+		unsigned int flags;
+		unsigned int fourCC;
+		unsigned int rgbBitCount;
+		unsigned int masks[4];
+	};
+
+	struct DdsHeader
+	{
+		unsigned int size;
+		unsigned int flags;
+		unsigned int height;
+		unsigned int width;
+		unsigned int pitchOrLinearSize;
+		unsigned int depth;
+		unsigned int mipMapCount;
+		unsigned int reserved1[11];
+		DdsPixelFormat pixelFormat;
+		unsigned int caps;
+		unsigned int caps2;
+		unsigned int caps3;
+		unsigned int caps4;
+		unsigned int reserved2;
+	};
+
+	struct DdsHeaderDX10
+	{
+		unsigned int dxgiFormat;
+		unsigned int resourceDimension;
+		unsigned int miscFlag;
+		unsigned int arraySize;
+		unsigned int miscFlags2;
+	};
+
+	static_assert(sizeof(DdsHeader) == 124, "DDS header must be 124 bytes");
+	static_assert(sizeof(DdsHeaderDX10) == 20, "DX10 header must be 20 bytes");
+
+	const unsigned int Magic = 0x20534444; // "DDS "
+	const unsigned int FourCCDX10 = 0x30315844; // "DX10"
+
+	const unsigned int FlagCaps = 0x1;
+	const unsigned int FlagHeight = 0x2;
+	const unsigned int FlagWidth = 0x4;
+	const unsigned int FlagPixelFormat = 0x1000;
+	const unsigned int FlagMipMapCount = 0x20000;
+	const unsigned int FlagLinearSize = 0x80000;
+	const unsigned int PixelFormatFourCC = 0x4;
+	const unsigned int CapsComplex = 0x8;
+	const unsigned int CapsTexture = 0x1000;
+	const unsigned int CapsMipMap = 0x400000;
+	const unsigned int DimensionTexture2D = 3;
+}
+
+bool DdsFile::GetLevelLayout(DXGI_FORMAT format, unsigned int width, unsigned int height, unsigned int& rowPitch, size_t& size)
+{
+	unsigned int blockBytes = 0;
+	switch (format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+		rowPitch = width * 4;
+		size = (size_t)rowPitch * height;
+		return true;
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC4_UNORM:
+		blockBytes = 8;
+		break;
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC7_UNORM:
+		blockBytes = 16;
+		break;
+	default:
+		return false;
+	}
+
+	rowPitch = max(1u, (width + 3) / 4) * blockBytes;
+	size = (size_t)rowPitch * max(1u, (height + 3) / 4);
+	return true;
+}
+
+bool DdsFile::Save(const wstring& path, const TextureData& texture)
+{
+	if (texture.Levels.empty())
+		return false;
+
+	DdsHeader header = {};
+	header.size = sizeof(DdsHeader);
+	header.flags = FlagCaps | FlagHeight | FlagWidth | FlagPixelFormat | FlagMipMapCount | FlagLinearSize;
+	header.width = texture.Levels[0].Width;
+	header.height = texture.Levels[0].Height;
+	header.pitchOrLinearSize = (unsigned int)texture.Levels[0].Bytes.size();
+	header.mipMapCount = (unsigned int)texture.Levels.size();
+	header.pixelFormat.size = sizeof(DdsPixelFormat);
+	header.pixelFormat.flags = PixelFormatFourCC;
+	header.pixelFormat.fourCC = FourCCDX10;
+	header.caps = CapsTexture | (texture.Levels.size() > 1 ? CapsComplex | CapsMipMap : 0);
+
+	DdsHeaderDX10 extended = {};
+	extended.dxgiFormat = (unsigned int)texture.Format;
+	extended.resourceDimension = DimensionTexture2D;
+	extended.arraySize = 1;
+
+	// Write to a temporary name first so a half written file is never picked up
+	wstring temporary = path + L".tmp";
+	{
+		ofstream file(filesystem::path(temporary), ios::binary | ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		file.write((const char*)&Magic, sizeof(Magic));
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)&extended, sizeof(extended));
+		for (auto& level : texture.Levels)
+			file.write((const char*)level.Bytes.data(), level.Bytes.size());
+		if (!file.good())
+			return false;
+	}
+
+	error_code error;
+	filesystem::rename(temporary, path, error);
+	return !error;
+}
+
+bool DdsFile::Load(const wstring& path, TextureData& texture)
+{
+	ifstream file(filesystem::path(path), ios::binary);
+	if (!file.is_open())
+		return false;
+
+	vector<unsigned char> bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	size_t headerBytes = sizeof(Magic) + sizeof(DdsHeader) + sizeof(DdsHeaderDX10);
+	if (bytes.size() < headerBytes)
+		return false;
+
+	unsigned int magic;
+	DdsHeader header;
+	DdsHeaderDX10 extended;
+	memcpy(&magic, bytes.data(), sizeof(magic));
+	memcpy(&header, bytes.data() + sizeof(magic), sizeof(header));
+	memcpy(&extended, bytes.data() + sizeof(magic) + sizeof(header), sizeof(extended));
+
+	if (magic != Magic || header.size != sizeof(DdsHeader) ||
+		!(header.pixelFormat.flags & PixelFormatFourCC) || header.pixelFormat.fourCC != FourCCDX10 ||
+		extended.resourceDimension != DimensionTexture2D || extended.arraySize != 1 ||
+		header.width == 0 || header.height == 0)
+		return false;
+
+	texture.Format = (DXGI_FORMAT)extended.dxgiFormat;
+	texture.Levels.clear();
+
+	unsigned int mips = max(1u, header.mipMapCount);
+	unsigned int width = header.width;
+	unsigned int height = header.height;
+	size_t offset = headerBytes;
+	for (unsigned int mip = 0; mip < mips; mip++)
+	{
+		TextureLevel level;
+		size_t size;
+		if (!GetLevelLayout(texture.Format, width, height, level.RowPitch, size) || offset + size > bytes.size())
+			return false;
+
+		level.Width = width;
+		level.Height = height;
+		level.Bytes.assign(bytes.begin() + offset, bytes.begin() + offset + size);
+		texture.Levels.push_back(move(level));
+
+		offset += size;
+		width = max(1u, width / 2);
+		height = max(1u, height / 2);
+	}
+	return true;
+}
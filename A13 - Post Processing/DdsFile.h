@@ -0,0 +1,20 @@
+#pragma once
+
+#include "BlockCompression.h"
+
+#include <string>
+
+// --------------------------------------------------------
+// Minimal DDS reading and writing for 2D mip chains, using
+// the DX10 extended header so any DXGI format can be stored.
+// Only the formats this project produces are understood:
+// R8G8B8A8_UNORM, BC1, BC4, BC5 and BC7.
+// --------------------------------------------------------
+namespace DdsFile
+{
+	bool Save(const std::wstring& path, const TextureData& texture);
+	bool Load(const std::wstring& path, TextureData& texture);
+
+	// Row pitch and total size of one level, false for unsupported formats
+	bool GetLevelLayout(DXGI_FORMAT format, unsigned int width, unsigned int height, unsigned int& rowPitch, size_t& size);
+}
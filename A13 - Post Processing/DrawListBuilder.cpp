@@ -0,0 +1,163 @@
+#include "DrawListBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+	// Same lookup SimpleShader does: the first buffer that declares the name
+	void Find(const ShaderReflectionData& reflection, const char* name, int& buffer, unsigned int& offset, unsigned int& size)
+	{
+		for (size_t b = 0; b < reflection.ConstantBuffers.size(); b++)
+		{
+			for (auto& variable : reflection.ConstantBuffers[b].Variables)
+			{
+				if (variable.Name == name)
+				{
+					buffer = (int)b;
+					offset = variable.ByteOffset;
+					size = variable.Size;
+					return;
+				}
+			}
+		}
+	}
+}
+
+void DrawListBuilder::StageLayout::Build(const ShaderReflectionData& reflection)
+{
+	BufferSizes.clear();
+	BufferStarts.clear();
+	unsigned int total = 0;
+	for (auto& buffer : reflection.ConstantBuffers)
+	{
+		BufferStarts.push_back(total);
+		BufferSizes.push_back(buffer.Size);
+		total += buffer.Size;
+	}
+	Template.assign(total, 0);
+
+	struct { Variable* variable; const char* name; } names[] = {
+		{ &World, "world" }, { &WorldInverseTranspose, "worldInverseTranspose" },
+		{ &View, "view" }, { &Projection, "projection" },
+		{ &ColorTint, "colorTint" }, { &CameraPosition, "cameraPos" },
+		{ &TotalTime, "totalTime" }, { &Roughness, "roughness" }, { &Lights, "lights" },
+		{ &ShadowCascades, "shadowCascades" }, { &LocalShadows, "localShadows" },
+	};
+	for (auto& entry : names)
+	{
+		*entry.variable = Variable();
+		Find(reflection, entry.name, entry.variable->Buffer, entry.variable->Offset, entry.variable->Size);
+	}
+}
+
+void DrawListBuilder::StageLayout::Write(const Variable& variable, const void* data, unsigned int size)
+{
+	if (variable.Buffer < 0) return;
+	memcpy(Template.data() + BufferStarts[variable.Buffer] + variable.Offset, data, min(size, variable.Size));
+}
+
+void DrawListBuilder::SetPipelineLayout(unsigned int pipeline, const ShaderReflectionData& vertexShader, const ShaderReflectionData& pixelShader)
+{
+	if (pipeline >= pipelines.size())
+		pipelines.resize(pipeline + 1);
+
+	pipelines[pipeline].Vertex.Build(vertexShader);
+	pipelines[pipeline].Pixel.Build(pixelShader);
+	pipelines[pipeline].Valid = true;
+}
+
+// --------------------------------------------------------
+// Copies the stage's template (per-pass values) straight
+// into the command buffer, then patches in this object's
+// own values - one copy per buffer, no name lookups
+// --------------------------------------------------------
+void DrawListBuilder::WriteConstants(CommandBuffer& buffer, ShaderStage stage, const StageLayout& layout, const DrawObject& object)
+{
+	const Variable* objectVariables[] = { &layout.World, &layout.WorldInverseTranspose, &layout.ColorTint, &layout.Roughness };
+	const void* objectValues[] = { &object.World, &object.WorldInverseTranspose, &object.ColorTint, &object.Roughness };
+	const unsigned int objectSizes[] = { sizeof(object.World), sizeof(object.WorldInverseTranspose), sizeof(object.ColorTint), sizeof(object.Roughness) };
+
+	for (unsigned int b = 0; b < layout.BufferSizes.size(); b++)
+	{
+		unsigned char* data = buffer.AllocateConstants(stage, b, layout.BufferSizes[b]);
+		memcpy(data, layout.Template.data() + layout.BufferStarts[b], layout.BufferSizes[b]);
+
+		for (int i = 0; i < 4; i++)
+		{
+			if (objectVariables[i]->Buffer == (int)b)
+				memcpy(data + objectVariables[i]->Offset, objectValues[i], min(objectSizes[i], objectVariables[i]->Size));
+		}
+	}
+}
+
+MaterialBatchStats DrawListBuilder::Build(const vector<DrawObject>& objects, const DrawFrameConstants& frame, CommandBuffer& buffer, bool sortByMaterial)
+{
+	// Per-pass values only need writing once, into each layout's template
+	for (auto& pipeline : pipelines)
+	{
+		for (StageLayout* stage : { &pipeline.Vertex, &pipeline.Pixel })
+		{
+			stage->Write(stage->View, &frame.View, sizeof(frame.View));
+			stage->Write(stage->Projection, &frame.Projection, sizeof(frame.Projection));
+			stage->Write(stage->CameraPosition, &frame.CameraPosition, sizeof(frame.CameraPosition));
+			stage->Write(stage->TotalTime, &frame.TotalTime, sizeof(frame.TotalTime));
+			if (frame.Lights)
+				stage->Write(stage->Lights, frame.Lights, frame.LightBytes);
+			if (frame.ShadowCascades)
+				stage->Write(stage->ShadowCascades, frame.ShadowCascades, frame.ShadowCascadeBytes);
+			if (frame.LocalShadows)
+				stage->Write(stage->LocalShadows, frame.LocalShadows, frame.LocalShadowBytes);
+		}
+	}
+
+	order.resize(objects.size());
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		order[i].MaterialId = objects[i].Material;
+		order[i].Index = (int)i;
+	}
+
+	MaterialBatchStats stats;
+	if (sortByMaterial)
+		stats = MaterialBatching::Sort(order);
+	else
+	{
+		stats.Draws = (int)order.size();
+		stats.Transitions = stats.UnsortedTransitions = MaterialBatching::CountTransitions(order);
+	}
+
+	// Nothing is bound at the start of a buffer (NoMaterial doubles as "nothing")
+	unsigned int pipeline = DrawObject::NoMaterial, material = DrawObject::NoMaterial, mesh = DrawObject::NoMaterial;
+	for (auto& item : order)
+	{
+		const DrawObject& object = objects[item.Index];
+		if (object.Pipeline >= pipelines.size() || !pipelines[object.Pipeline].Valid)
+			continue;
+
+		if (object.Pipeline != pipeline)
+		{
+			buffer.BindPipeline(object.Pipeline);
+			pipeline = object.Pipeline;
+		}
+		if (object.Material != material)
+		{
+			if (object.Material != DrawObject::NoMaterial)
+				buffer.BindMaterial(object.Material);
+			material = object.Material;
+		}
+		if (object.Mesh != mesh)
+		{
+			buffer.BindMesh(object.Mesh);
+			mesh = object.Mesh;
+		}
+
+		WriteConstants(buffer, ShaderStage::Vertex, pipelines[pipeline].Vertex, object);
+		WriteConstants(buffer, ShaderStage::Pixel, pipelines[pipeline].Pixel, object);
+		buffer.DrawIndexed(object.IndexCount);
+	}
+	return stats;
+}
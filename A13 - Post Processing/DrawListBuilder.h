@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CommandBuffer.h"
+#include "MaterialRegistry.h"
+#include "ShaderReflectionCache.h"
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+// One object to draw, reduced to handles and its own constants
+struct DrawObject
+{
+	static const unsigned int NoMaterial = 0xFFFFFFFF;	// Depth-only draws
+
+	DirectX::XMFLOAT4X4 World;
+	DirectX::XMFLOAT4X4 WorldInverseTranspose;
+	DirectX::XMFLOAT4 ColorTint = { 1, 1, 1, 1 };
+	float Roughness = 0;
+
+	unsigned int Pipeline = 0;
+	unsigned int Material = 0;		// Also the sort key - use material IDs (or NoMaterial)
+	unsigned int Mesh = 0;
+	unsigned int IndexCount = 0;
+};
+
+// Constants shared by every draw in a pass
+struct DrawFrameConstants
+{
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	DirectX::XMFLOAT3 CameraPosition = { 0, 0, 0 };
+	float TotalTime = 0;
+	const void* Lights = 0;
+	unsigned int LightBytes = 0;
+	const void* ShadowCascades = 0;
+	unsigned int ShadowCascadeBytes = 0;
+	const void* LocalShadows = 0;
+	unsigned int LocalShadowBytes = 0;
+};
+
+// --------------------------------------------------------
+// Turns a list of objects into a command buffer: sorted by
+// material, with pipeline/material/mesh binds only where
+// they change, and each draw's constant buffers written out
+// in full.  Variables are placed by name using reflection,
+// exactly as SimpleShader's Set*() calls would place them,
+// and any the shader doesn't declare are skipped.
+//
+// Nothing here touches D3D, so a frame's draw list can be
+// built (and timed) without a device.
+// --------------------------------------------------------
+class DrawListBuilder
+{
+public:
+	// Pipeline handles index a table, so keep them small
+	void SetPipelineLayout(unsigned int pipeline, const ShaderReflectionData& vertexShader, const ShaderReflectionData& pixelShader);
+
+	MaterialBatchStats Build(const std::vector<DrawObject>& objects, const DrawFrameConstants& frame, CommandBuffer& buffer, bool sortByMaterial = true);
+
+private:
+	struct Variable
+	{
+		int Buffer = -1;
+		unsigned int Offset = 0;
+		unsigned int Size = 0;
+	};
+
+	// Buffer sizes plus where each known variable lives, for one shader
+	struct StageLayout
+	{
+		std::vector<unsigned int> BufferSizes;
+		std::vector<unsigned int> BufferStarts;	// Into the stage's frame template
+		std::vector<unsigned char> Template;	// Every buffer back to back, per-pass values already written
+		Variable World, WorldInverseTranspose, View, Projection;
+		Variable ColorTint, CameraPosition, TotalTime, Roughness, Lights, ShadowCascades, LocalShadows;
+
+		void Build(const ShaderReflectionData& reflection);
+		void Write(const Variable& variable, const void* data, unsigned int size);
+	};
+
+	struct PipelineLayout
+	{
+		bool Valid = false;
+		StageLayout Vertex;
+		StageLayout Pixel;
+	};
+
+	std::vector<PipelineLayout> pipelines;
+	std::vector<MaterialDrawItem> order;
+
+	void WriteConstants(CommandBuffer& buffer, ShaderStage stage, const StageLayout& layout, const DrawObject& object);
+};
@@ -0,0 +1,149 @@
+#include "DualFilterBlur.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace
+{
+	// What a clamp-addressed, linear-filtered Sample() returns at a UV
+	void SampleBilinear(const float* src, unsigned int width, unsigned int height, float u, float v, float* out)
+	{
+		float x = u * width - 0.5f;
+		float y = v * height - 0.5f;
+		int x0 = (int)floorf(x);
+		int y0 = (int)floorf(y);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		auto texel = [&](int tx, int ty) {
+			tx = min(max(tx, 0), (int)width - 1);
+			ty = min(max(ty, 0), (int)height - 1);
+			return src + ((size_t)ty * width + tx) * 4;
+		};
+		const float* a = texel(x0, y0);
+		const float* b = texel(x0 + 1, y0);
+		const float* c = texel(x0, y0 + 1);
+		const float* d = texel(x0 + 1, y0 + 1);
+		for (int i = 0; i < 4; i++)
+		{
+			float top = a[i] + (b[i] - a[i]) * fx;
+			float bottom = c[i] + (d[i] - c[i]) * fx;
+			out[i] = top + (bottom - top) * fy;
+		}
+	}
+
+	// Runs a kernel of weighted taps (offsets in half texels of the source) over every destination pixel
+	struct Tap { float X, Y, Weight; };
+	void Filter(const float* src, unsigned int srcWidth, unsigned int srcHeight, float* dst, unsigned int dstWidth, unsigned int dstHeight,
+		float offset, const Tap* taps, int tapCount, float scale)
+	{
+		float halfX = offset * 0.5f / srcWidth;
+		float halfY = offset * 0.5f / srcHeight;
+		for (unsigned int y = 0; y < dstHeight; y++)
+		{
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				float u = (x + 0.5f) / dstWidth;
+				float v = (y + 0.5f) / dstHeight;
+				float total[4] = {};
+				for (int t = 0; t < tapCount; t++)
+				{
+					float sample[4];
+					SampleBilinear(src, srcWidth, srcHeight, u + taps[t].X * halfX, v + taps[t].Y * halfY, sample);
+					for (int c = 0; c < 4; c++)
+						total[c] += sample[c] * taps[t].Weight;
+				}
+
+				float* out = dst + ((size_t)y * dstWidth + x) * 4;
+				for (int c = 0; c < 4; c++)
+					out[c] = total[c] * scale;
+			}
+		}
+	}
+}
+
+DualFilterSettings DualFilterBlur::SettingsForRadius(float radius)
+{
+	// Spread of the whole chain's impulse response, measured at each level:
+	// close enough to linear in the offset to solve for the Gaussian's sigma
+	const float slope[MaxLevels] = { 1.10f, 2.48f, 5.10f };
+	const float base[MaxLevels] = { 0.41f, 0.90f, 1.84f };
+
+	// Fewest levels that get there without spreading the taps so far they alias
+	radius = max(radius, 1.0f);
+	float sigma = sqrtf(radius * (radius + 1) / 3.0f);
+	DualFilterSettings settings;
+	for (unsigned int level = 1; level <= MaxLevels; level++)
+	{
+		settings.Levels = level;
+		settings.Offset = max((sigma - base[level - 1]) / slope[level - 1], 0.5f);
+		if (settings.Offset <= 1.5f)
+			break;
+	}
+	return settings;
+}
+
+unsigned int DualFilterBlur::LevelSize(unsigned int size, unsigned int level)
+{
+	return max(size >> level, 1u);
+}
+
+void DualFilterBlur::Downsample(const float* src, unsigned int srcWidth, unsigned int srcHeight, float* dst, unsigned int dstWidth, unsigned int dstHeight, float offset)
+{
+	// Center, plus the four diagonals
+	const Tap taps[] = { { 0, 0, 4 }, { -1, -1, 1 }, { 1, 1, 1 }, { 1, -1, 1 }, { -1, 1, 1 } };
+	Filter(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, offset, taps, 5, 1.0f / 8.0f);
+}
+
+void DualFilterBlur::Upsample(const float* src, unsigned int srcWidth, unsigned int srcHeight, float* dst, unsigned int dstWidth, unsigned int dstHeight, float offset)
+{
+	// The four axes a full texel out, and the four diagonals (twice the weight) half a texel out
+	const Tap taps[] = {
+		{ -2, 0, 1 }, { 2, 0, 1 }, { 0, -2, 1 }, { 0, 2, 1 },
+		{ -1, 1, 2 }, { 1, 1, 2 }, { 1, -1, 2 }, { -1, -1, 2 } };
+	Filter(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, offset, taps, 8, 1.0f / 12.0f);
+}
+
+void DualFilterBlur::Blur(const float* src, unsigned int width, unsigned int height, float* dst, const DualFilterSettings& settings)
+{
+	unsigned int levels = min(max(settings.Levels, 1u), MaxLevels);
+	vector<vector<float>> chain(levels + 1);
+	for (unsigned int level = 1; level <= levels; level++)
+		chain[level].resize((size_t)LevelSize(width, level) * LevelSize(height, level) * 4);
+
+	// Down the chain, each level from the one above it
+	for (unsigned int level = 1; level <= levels; level++)
+	{
+		const float* from = level == 1 ? src : chain[level - 1].data();
+		Downsample(from, LevelSize(width, level - 1), LevelSize(height, level - 1),
+			chain[level].data(), LevelSize(width, level), LevelSize(height, level), settings.Offset);
+	}
+
+	// Back up, overwriting each level (its downsampled contents aren't needed again)
+	for (unsigned int level = levels; level >= 1; level--)
+	{
+		float* to = level == 1 ? dst : chain[level - 1].data();
+		Upsample(chain[level].data(), LevelSize(width, level), LevelSize(height, level),
+			to, LevelSize(width, level - 1), LevelSize(height, level - 1), settings.Offset);
+	}
+}
+
+ImageDifference DualFilterBlur::Compare(const float* a, const float* b, size_t count)
+{
+	ImageDifference difference;
+	double squares = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		float d = fabsf(a[i] - b[i]);
+		difference.MaxDifference = max(difference.MaxDifference, d);
+		squares += (double)d * d;
+	}
+
+	double meanSquare = count > 0 ? squares / count : 0;
+	difference.RootMeanSquare = (float)sqrt(meanSquare);
+	difference.PeakSignalToNoise = meanSquare > 0 ? (float)(10.0 * log10(1.0 / meanSquare)) : numeric_limits<float>::infinity();
+	return difference;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// How far down the chain goes and how wide each pass reaches
+struct DualFilterSettings
+{
+	unsigned int Levels = 1;	// Halvings: 1 = half resolution, 3 = eighth
+	float Offset = 1.0f;		// Tap spread, in half texels of the pass's source
+};
+
+// How closely one image matches another
+struct ImageDifference
+{
+	float MaxDifference = 0;
+	float RootMeanSquare = 0;
+	float PeakSignalToNoise = 0;	// dB, for values in 0-1 (infinite if identical)
+};
+
+// --------------------------------------------------------
+// Dual filtering (dual Kawase): blur by halving resolution a
+// few times with a 5 tap kernel, then doubling back up with
+// an 8 tap one.  Every pass after the first runs at a
+// quarter of the pixels of the one before, so a wide blur
+// costs about the same as a narrow one.
+//
+// These are the CPU versions of PixelShaderDualFilterDown
+// and PixelShaderDualFilterUp - bilinear, clamped, on float
+// RGBA - for checking the shaders' output without a GPU.
+// --------------------------------------------------------
+namespace DualFilterBlur
+{
+	const unsigned int MaxLevels = 3;
+
+	// Settings whose blur spreads about as far as GaussianBlur's at this radius
+	DualFilterSettings SettingsForRadius(float radius);
+
+	// Size of the target at a level of the chain (level 0 is full size)
+	unsigned int LevelSize(unsigned int size, unsigned int level);
+
+	// One pass each way - dst is the destination's size
+	void Downsample(const float* src, unsigned int srcWidth, unsigned int srcHeight, float* dst, unsigned int dstWidth, unsigned int dstHeight, float offset);
+	void Upsample(const float* src, unsigned int srcWidth, unsigned int srcHeight, float* dst, unsigned int dstWidth, unsigned int dstHeight, float offset);
+
+	// The whole chain, down and back up to the source's size
+	void Blur(const float* src, unsigned int width, unsigned int height, float* dst, const DualFilterSettings& settings);
+
+	ImageDifference Compare(const float* a, const float* b, size_t count);
+}
@@ -1,11 +1,15 @@
 #include "Entity.h"
 
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
 using namespace std;
 
-Entity::Entity(const char* name, Mesh mesh, Material material) {
+Entity::Entity(const char* name, Mesh mesh, shared_ptr<Material> material) {
 	transform = Transform();
 	this->mesh = make_shared<Mesh>(mesh);
-	this->material = make_shared<Material>(material);
+	this->material = material;
 }
 
 void Entity::Draw() {
@@ -25,4 +29,28 @@ shared_ptr<Mesh> Entity::GetMesh() {
 
 std::shared_ptr<Material> Entity::GetMaterial() {
 	return material;
-}
\ No newline at end of file
+}
+
+//Bounding sphere in world space - the radius grows with the largest scale axis
+void Entity::GetWorldBounds(XMFLOAT3& center, float& radius) {
+	XMFLOAT4X4 world = transform.GetWorldMatrix();
+	XMFLOAT3 localCenter = mesh->GetBoundsCenter();
+	XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat3(&localCenter), XMLoadFloat4x4(&world)));
+
+	XMFLOAT3 scale = transform.GetScale();
+	radius = mesh->GetBoundsRadius() * max(fabsf(scale.x), max(fabsf(scale.y), fabsf(scale.z)));
+}
+
+//Also uses the largest scale axis, which suits stretched floors and walls
+float Entity::GetWorldUnitsPerUv() {
+	XMFLOAT3 scale = transform.GetScale();
+	return mesh->GetWorldUnitsPerUv() * max(fabsf(scale.x), max(fabsf(scale.y), fabsf(scale.z)));
+}
+
+bool Entity::IsDynamic() {
+	return dynamic;
+}
+
+void Entity::SetDynamic(bool dynamic) {
+	this->dynamic = dynamic;
+}
@@ -7,12 +7,16 @@
 class Entity
 {
 public:
-	Entity(const char* name, Mesh mesh, Material material);
+	Entity(const char* name, Mesh mesh, std::shared_ptr<Material> material);
 	~Entity();
 
 	Transform* GetTransform();
 	std::shared_ptr<Mesh> GetMesh();
 	std::shared_ptr<Material> GetMaterial();
+	void GetWorldBounds(DirectX::XMFLOAT3& center, float& radius);
+	float GetWorldUnitsPerUv();
+	bool IsDynamic();
+	void SetDynamic(bool dynamic);
 	const char* name;
 
 	void Draw();
@@ -20,5 +24,6 @@ private:
 	Transform transform;
 	std::shared_ptr<Mesh> mesh;
 	std::shared_ptr<Material> material;
+	bool dynamic = false;	// Moves by itself, so its shadow is redrawn over the static cache every frame
 };
 
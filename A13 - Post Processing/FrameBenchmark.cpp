@@ -0,0 +1,243 @@
+#include "FrameBenchmark.h"
+#include "CascadedShadows.h"
+#include "Frustum.h"
+#include "GaussianBlur.h"
+#include "LocalShadows.h"
+#include "HeadlessScene.h"
+#include "PngDecoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace DirectX;
+
+namespace
+{
+	double Milliseconds(chrono::high_resolution_clock::time_point from, chrono::high_resolution_clock::time_point to)
+	{
+		return chrono::duration<double, milli>(to - from).count();
+	}
+
+	void WriteStats(ostringstream& out, const string& name, const BenchmarkStats& stats, bool last)
+	{
+		out << "    \"" << name << "\": { \"mean\": " << stats.Mean << ", \"p50\": " << stats.P50 << ", \"p95\": " << stats.P95
+			<< ", \"p99\": " << stats.P99 << ", \"max\": " << stats.Max << " }" << (last ? "\n" : ",\n");
+	}
+}
+
+BenchmarkReport FrameBenchmark::Run(const BenchmarkSettings& settings, const ShaderReflectionData& vertexShader, const ShaderReflectionData& pixelShader)
+{
+	BenchmarkReport report;
+	report.Settings = settings;
+	if (report.Settings.Path.empty())
+		report.Settings.Path = CameraPath::SceneCameras();
+
+	HeadlessScene scene(settings.EntityCount, vertexShader, pixelShader);
+	NullCommandExecutor executor;
+	CommandBuffer buffer;
+
+	DrawFrameConstants frame = {};
+	frame.Lights = scene.GetLights().data();
+	frame.LightBytes = (unsigned int)(sizeof(Light) * scene.GetLights().size());
+	ShadowCascadeData cascades;
+	frame.ShadowCascades = &cascades;
+	frame.ShadowCascadeBytes = sizeof(cascades);
+	ShadowAtlas atlas;
+	LocalShadowData localShadows;
+	frame.LocalShadows = &localShadows;
+	frame.LocalShadowBytes = sizeof(localShadows);
+
+	report.Frames.resize(settings.Frames);
+	for (unsigned int i = 0; i < settings.Frames; i++)
+	{
+		// Time comes from the frame number alone, never the clock
+		float totalTime = settings.DeltaTime * (i + 1);
+		CameraKey camera = CameraPath::Sample(report.Settings.Path, totalTime, settings.SecondsPerKey);
+		BenchmarkFrame& timing = report.Frames[i];
+
+		auto start = chrono::high_resolution_clock::now();
+		scene.Update(settings.DeltaTime);
+		auto updated = chrono::high_resolution_clock::now();
+
+		CameraPath::GetMatrices(camera, settings.AspectRatio, frame.View, frame.Projection);
+		frame.CameraPosition = camera.Position;
+		frame.TotalTime = totalTime;
+		Frustum frustum = Frustum::FromViewProjection(frame.View, frame.Projection);
+		timing.Visible = scene.Cull(&frustum);
+		auto culled = chrono::high_resolution_clock::now();
+
+		// Cascades follow the camera, as they do in Game
+		cascades = CascadedShadows::Pack(CascadedShadows::Build(frame.View, frame.Projection, scene.GetLights()[0].direction, CascadeSettings()));
+		// So do the atlas tiles, but there are no casters to cull here - only the sizing and packing are counted
+		vector<ShadowRequest> requests = LocalShadows::Requests(scene.GetLights(), frame.View, frame.Projection);
+		localShadows = LocalShadows::Pack(LocalShadows::Faces(scene.GetLights(), requests, atlas.Allocate(requests), {}), atlas.GetSettings().Size);
+		scene.BuildDrawList(frame, buffer);
+		auto built = chrono::high_resolution_clock::now();
+
+		executor.ResetStats();
+		executor.Execute(buffer);
+		auto executed = chrono::high_resolution_clock::now();
+
+		timing.Update = Milliseconds(start, updated);
+		timing.Cull = Milliseconds(updated, culled);
+		timing.Build = Milliseconds(culled, built);
+		timing.Execute = Milliseconds(built, executed);
+		timing.Total = Milliseconds(start, executed);
+	}
+
+	vector<double> values(report.Frames.size());
+	auto summarize = [&](double BenchmarkFrame::* field) {
+		for (size_t i = 0; i < report.Frames.size(); i++)
+			values[i] = report.Frames[i].*field;
+		return Summarize(values);
+	};
+	report.Update = summarize(&BenchmarkFrame::Update);
+	report.Cull = summarize(&BenchmarkFrame::Cull);
+	report.Build = summarize(&BenchmarkFrame::Build);
+	report.Execute = summarize(&BenchmarkFrame::Execute);
+	report.Total = summarize(&BenchmarkFrame::Total);
+	return report;
+}
+
+BenchmarkStats FrameBenchmark::Summarize(vector<double> values)
+{
+	BenchmarkStats stats;
+	if (values.empty())
+		return stats;
+
+	sort(values.begin(), values.end());
+	auto percentile = [&](double p) {
+		size_t rank = (size_t)ceil(p / 100.0 * values.size());
+		return values[max(rank, (size_t)1) - 1];
+	};
+
+	double sum = 0;
+	for (double value : values)
+		sum += value;
+	stats.Mean = sum / values.size();
+	stats.P50 = percentile(50);
+	stats.P95 = percentile(95);
+	stats.P99 = percentile(99);
+	stats.Max = values.back();
+	return stats;
+}
+
+string FrameBenchmark::ToJson(const BenchmarkReport& report)
+{
+	ostringstream out;
+	out << "{\n";
+	out << "  \"entities\": " << report.Settings.EntityCount << ",\n";
+	out << "  \"frames\": " << report.Frames.size() << ",\n";
+	out << "  \"deltaTime\": " << report.Settings.DeltaTime << ",\n";
+	out << "  \"cameraKeys\": " << report.Settings.Path.size() << ",\n";
+	out << "  \"secondsPerKey\": " << report.Settings.SecondsPerKey << ",\n";
+	out << "  \"milliseconds\": {\n";
+	WriteStats(out, "update", report.Update, false);
+	WriteStats(out, "cull", report.Cull, false);
+	WriteStats(out, "build", report.Build, false);
+	WriteStats(out, "execute", report.Execute, false);
+	WriteStats(out, "total", report.Total, true);
+	out << (report.GpuPasses.empty() ? "  }\n" : "  },\n");
+	if (!report.GpuPasses.empty())
+	{
+		out << "  \"gpuMilliseconds\": {\n";
+		for (size_t i = 0; i < report.GpuPasses.size(); i++)
+			WriteStats(out, report.GpuPasses[i].first, report.GpuPasses[i].second, i + 1 == report.GpuPasses.size());
+		out << "  }\n";
+	}
+	out << "}\n";
+	return out.str();
+}
+
+string FrameBenchmark::ToCsv(const BenchmarkReport& report)
+{
+	ostringstream out;
+	out << "frame,visible,update_ms,cull_ms,build_ms,execute_ms,total_ms\n";
+	for (size_t i = 0; i < report.Frames.size(); i++)
+	{
+		const BenchmarkFrame& frame = report.Frames[i];
+		out << i << ',' << frame.Visible << ',' << frame.Update << ',' << frame.Cull << ',' << frame.Build << ',' << frame.Execute << ',' << frame.Total << '\n';
+	}
+	return out.str();
+}
+
+bool FrameBenchmark::Save(const BenchmarkReport& report, const string& basePath)
+{
+	ofstream json(basePath + ".json", ios::trunc);
+	json << ToJson(report);
+	ofstream csv(basePath + ".csv", ios::trunc);
+	csv << ToCsv(report);
+	return json.good() && csv.good();
+}
+
+int FrameBenchmark::RunFromCommandLine(const string& commandLine)
+{
+	istringstream args(commandLine);
+	vector<string> tokens;
+	for (string token; args >> token; )
+		tokens.push_back(token);
+	if (find(tokens.begin(), tokens.end(), "--benchmark") == tokens.end())
+		return -1;
+
+	auto decode = find(tokens.begin(), tokens.end(), "--decode");
+	if (decode != tokens.end())
+	{
+		string directory = decode + 1 != tokens.end() && (decode + 1)->rfind("--", 0) != 0 ? *(decode + 1) : "Assets/Textures";
+		DecodeBenchmarkResult result = PngDecoder::Benchmark(wstring(directory.begin(), directory.end()));
+		if (result.FileCount == 0)
+		{
+			printf("Decode benchmark: no PNGs under %s\n", directory.c_str());
+			return 1;
+		}
+		printf("Decode benchmark: %d files, %.1f megapixels - serial %.1f ms, %d threads %.1f ms (%.2fx)\n", result.FileCount, result.Megapixels,
+			result.SerialMilliseconds, result.ThreadCount, result.ParallelMilliseconds, result.SerialMilliseconds / max(result.ParallelMilliseconds, 0.001));
+		return 0;
+	}
+
+	auto blur = find(tokens.begin(), tokens.end(), "--blur");
+	if (blur != tokens.end())
+	{
+		// The same image and kernels as the game's Benchmark Blur button
+		float radius = blur + 1 != tokens.end() && (blur + 1)->rfind("--", 0) != 0 ? strtof((blur + 1)->c_str(), 0) : 5.0f;
+		DecodedImage image;
+		if (!PngDecoder::DecodeFile(L"Assets/Textures/cobblestone/albedo.png", image))
+		{
+			printf("Blur benchmark: couldn't decode Assets/Textures/cobblestone/albedo.png\n");
+			return 1;
+		}
+		BlurBenchmarkResult result = GaussianBlur::Benchmark(image, radius);
+		printf("Blur benchmark: %ux%u, radius %.1f - box %d fetches %.1f ms, Gaussian %d fetches %.1f ms, merged taps %d fetches %.1f ms, max difference %g\n",
+			result.Width, result.Height, result.Radius, result.BoxFetches, result.BoxMilliseconds, result.GaussianFetches, result.GaussianMilliseconds,
+			result.LinearFetches, result.LinearMilliseconds, result.MaxDifference);
+		return result.MaxDifference < 1e-3f ? 0 : 1;
+	}
+
+	BenchmarkSettings settings;
+	string outPath = "benchmark";
+	for (size_t i = 0; i + 1 < tokens.size(); i++)
+	{
+		if (tokens[i] == "--entities")
+			settings.EntityCount = (unsigned int)strtoul(tokens[++i].c_str(), 0, 10);
+		else if (tokens[i] == "--frames")
+			settings.Frames = (unsigned int)strtoul(tokens[++i].c_str(), 0, 10);
+		else if (tokens[i] == "--out")
+			outPath = tokens[++i];
+	}
+
+	BenchmarkReport report = Run(settings, HeadlessScene::DefaultVertexReflection(), HeadlessScene::DefaultPixelReflection());
+	printf("Benchmark: %u entities, %u frames - total ms p50 %.3f, p95 %.3f, p99 %.3f, max %.3f\n", settings.EntityCount, settings.Frames,
+		report.Total.P50, report.Total.P95, report.Total.P99, report.Total.Max);
+
+	if (!Save(report, outPath))
+	{
+		printf("Benchmark: couldn't write %s.json / %s.csv\n", outPath.c_str(), outPath.c_str());
+		return 1;
+	}
+	return 0;
+}
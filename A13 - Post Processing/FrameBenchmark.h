@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CameraPath.h"
+#include "ShaderReflectionCache.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BenchmarkSettings
+{
+	unsigned int EntityCount = 10000;
+	unsigned int Frames = 600;
+	float DeltaTime = 1.0f / 60.0f;		// Fixed, so every run simulates the same frames
+	float AspectRatio = 16.0f / 9.0f;
+	float SecondsPerKey = 2.0f;
+	std::vector<CameraKey> Path;		// Empty uses CameraPath::SceneCameras()
+};
+
+// CPU milliseconds spent on one frame
+struct BenchmarkFrame
+{
+	double Update = 0;
+	double Cull = 0;
+	double Build = 0;
+	double Execute = 0;
+	double Total = 0;
+	unsigned int Visible = 0;
+};
+
+struct BenchmarkStats
+{
+	double Mean = 0;
+	double P50 = 0;
+	double P95 = 0;
+	double P99 = 0;
+	double Max = 0;
+};
+
+struct BenchmarkReport
+{
+	BenchmarkSettings Settings;
+	std::vector<BenchmarkFrame> Frames;
+	BenchmarkStats Update, Cull, Build, Execute, Total;
+
+	// Filled in by the caller from live frames - a headless run has no GPU to time
+	std::vector<std::pair<std::string, BenchmarkStats>> GpuPasses;
+};
+
+// --------------------------------------------------------
+// Repeatable CPU frame timing: a HeadlessScene driven at a
+// fixed time step, with the camera following CameraPath
+// through the scene's cameras, drawn to the null executor.
+// Nothing here needs a window or a device, so it runs the
+// same on a build machine as it does in the game.
+// --------------------------------------------------------
+namespace FrameBenchmark
+{
+	BenchmarkReport Run(const BenchmarkSettings& settings, const ShaderReflectionData& vertexShader, const ShaderReflectionData& pixelShader);
+
+	// Nearest-rank percentiles (the values are copied, not reordered)
+	BenchmarkStats Summarize(std::vector<double> values);
+
+	std::string ToJson(const BenchmarkReport& report);
+	std::string ToCsv(const BenchmarkReport& report);
+
+	// Writes basePath + ".json" and basePath + ".csv"
+	bool Save(const BenchmarkReport& report, const std::string& basePath);
+
+	// Handles "--benchmark [--entities N] [--frames N] [--out path]".
+	// Returns -1 if the command line doesn't ask for a benchmark,
+	// otherwise runs it, saves the report and returns an exit code.
+	// With "--decode [directory]" it times PngDecoder::Benchmark on
+	// every PNG under the directory (Assets/Textures by default)
+	// instead.  With "--blur [radius]" it times GaussianBlur's
+	// kernels on the cobblestone albedo (radius 5 by default).
+	// Both resolve paths against the working directory.
+	int RunFromCommandLine(const std::string& commandLine);
+}
@@ -0,0 +1,48 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+Frustum Frustum::FromViewProjection(const XMFLOAT4X4& view, const XMFLOAT4X4& projection)
+{
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection)));
+
+	// Row vectors, so clip = (x, y, z, 1) * m and each clip coordinate is a
+	// column of m.  D3D clips to -w <= x, y <= w and 0 <= z <= w.
+	auto column = [&](int c) { return XMFLOAT4(m.m[0][c], m.m[1][c], m.m[2][c], m.m[3][c]); };
+	auto add = [](XMFLOAT4 a, XMFLOAT4 b, float sign) { return XMFLOAT4(a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z, a.w + sign * b.w); };
+	XMFLOAT4 x = column(0), y = column(1), z = column(2), w = column(3);
+
+	Frustum frustum;
+	frustum.Planes[0] = add(w, x, 1);
+	frustum.Planes[1] = add(w, x, -1);
+	frustum.Planes[2] = add(w, y, 1);
+	frustum.Planes[3] = add(w, y, -1);
+	frustum.Planes[4] = z;
+	frustum.Planes[5] = add(w, z, -1);
+
+	for (XMFLOAT4& plane : frustum.Planes)
+	{
+		float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		if (length > 0)
+		{
+			plane.x /= length;
+			plane.y /= length;
+			plane.z /= length;
+			plane.w /= length;
+		}
+	}
+	return frustum;
+}
+
+bool Frustum::IntersectsSphere(const XMFLOAT3& center, float radius) const
+{
+	for (const XMFLOAT4& plane : Planes)
+	{
+		if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+			return false;
+	}
+	return true;
+}
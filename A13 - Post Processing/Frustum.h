@@ -0,0 +1,20 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// The six planes of a view-projection's clip volume, in
+// world space (or whatever space the view starts from).
+// Planes are normalized and face inward, so a point is
+// inside when its signed distance to all six is positive.
+// --------------------------------------------------------
+struct Frustum
+{
+	// Left, right, bottom, top, near, far - (a, b, c, d) with ax + by + cz + d = distance
+	DirectX::XMFLOAT4 Planes[6];
+
+	static Frustum FromViewProjection(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
+
+	// Conservative: spheres near a corner can pass without touching the volume
+	bool IntersectsSphere(const DirectX::XMFLOAT3& center, float radius) const;
+};
@@ -6,10 +6,16 @@
 #include "Window.h"
 #include "Mesh.h"
 #include "Material.h"
+#include "ShaderLibrary.h"
+#include "ShaderReflectionCache.h"
+#include "Profiler.h"
 
 #include <DirectXMath.h>
+#include <cstring>
 #include <memory>
+#include <map>
 #include <math.h>
+#include <thread>
 
 // This code assumes files are in "ImGui" subfolder!
 // Adjust as necessary for your own folder structure and project setup
@@ -34,8 +40,31 @@ void Game::Initialize()
 	// Helper methods for loading shaders, creating some basic
 	// geometry to draw and some simple camera matrices.
 	//  - You'll be expanding and/or replacing these later
+	ShaderReflectionCache::Load(FixPath(L"ShaderReflection.cache"));
+
+	//Textures decode (and build their mips) on worker threads and show a flat placeholder until they're uploaded in Update
+	//Compressed chains are cached as DDS files, so only the first run pays for compression
+	//Only the low mips go to the GPU at first, the streamer adds the rest as the camera needs them
+	TextureLoader::Initialize();
+	TextureStreamer::Initialize((size_t)(streamingBudgetMegabytes * 1024 * 1024));
+	TextureLoader::SetCacheDirectory(FixPath(L"TextureCache/"));
+
+	//Shader binds go through the state cache, so rebinding what's already bound costs nothing
+	ISimpleShader::StateCache = Graphics::State.get();
+
 	LoadShaders();
 	CreateGeometry();
+
+	//Draws can also be recorded on worker threads into deferred contexts (toggled in the UI)
+	//The main thread records a list too, so there's one context more than there are workers
+	unsigned int cores = thread::hardware_concurrency();
+	submitter = make_unique<ParallelSubmitter>(min(3u, cores > 1 ? cores - 1 : 1u));
+	commandLists = make_unique<D3D11CommandListBackend>(Graphics::Device, Graphics::Context, submitter->GetThreadCount() + 1);
+	RegisterDrawResources();
+
+	//GPU pass timings are read back a few frames late, so the CPU never waits on them
+	gpuQueries = make_unique<D3D11GpuQuerySource>(Graphics::Device, Graphics::Context, 5, GpuTimerRing::TimestampsPerSlot(16));
+	gpuTimers = make_unique<GpuTimerRing>(gpuQueries.get(), 5, 16);
 	
 
 	// Set initial graphics API state
@@ -55,39 +84,14 @@ void Game::Initialize()
 	ImGui_ImplWin32_Init(Window::Handle());
 	ImGui_ImplDX11_Init(Graphics::Device.Get(), Graphics::Context.Get());
 	ImGui::StyleColorsClassic();
-	
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(), FixPath(L"../../Assets/Textures/cobblestone/albedo.png").c_str(), 0, &albedo);
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(), FixPath(L"../../Assets/Textures/cobblestone/normas.png").c_str(), 0, &normalMap);
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(), FixPath(L"../../Assets/Textures/cobblestone/roughness.png").c_str(), 0, &roughnessMap);
-	CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(), FixPath(L"../../Assets/Textures/cobblestone/metal.png").c_str(), 0, &metalnessMap);
-
-	textures.insert({ "Albedo", albedo });
-	textures.insert({ "NormalMap", normalMap });
-	textures.insert({ "RoughnessMap", roughnessMap});
-	textures.insert({ "MetalnessMap", metalnessMap });
-
-	D3D11_SAMPLER_DESC samplerDesc = {};
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;								//Lerp
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
 
-	Graphics::Device->CreateSamplerState(&samplerDesc, &samplerState);
-	samplers.insert({ "LerpSampler", samplerState });
-
-	cameras.push_back(make_shared<Camera>(Camera(
-		Window::AspectRatio(),
-		XMFLOAT3(0, -5, -30), XMFLOAT3(0.02f, 0, 0),										//Starting position and rotation vectors
-		0.4f, false)));
-	cameras.push_back(make_shared<Camera>(Camera(
-		Window::AspectRatio(),
-		XMFLOAT3(-20.4f, 0, -20), XMFLOAT3(0.145f, XM_PIDIV4, 0),
-		0.4f, false)));
-	cameras.push_back(make_shared<Camera>(Camera(
-		Window::AspectRatio(),
-		XMFLOAT3(0, -0.8f, -1), XMFLOAT3(-XM_PIDIV4, 0, 0),							//Starting position and rotation vectors
-		1.2f, true)));
+	//Camera placements are shared with the benchmark's camera path
+	for (const CameraKey& key : CameraPath::SceneCameras()) {
+		cameras.push_back(make_shared<Camera>(Camera(
+			Window::AspectRatio(),
+			key.Position, key.Rotation,												//Starting position and rotation vectors
+			key.Fov, key.IsOrthographic)));
+	}
 
 	activeCamera = 0;
 
@@ -99,6 +103,15 @@ void Game::Initialize()
 	
 	ConstructShadowMap();
 	SetupPostProcesses();
+
+#if defined(DEBUG) || defined(_DEBUG)
+	//Watch the shader sources (two folders up from the exe, same as the assets) and recompile on save
+	shaderHotReload = make_unique<ShaderHotReload>(FixPath(L"../../"));
+	shaderHotReload->Start();
+#endif
+
+	//Only rewrite the reflection cache if a shader was actually reflected this run
+	if (ShaderReflectionCache::IsDirty()) ShaderReflectionCache::Save(FixPath(L"ShaderReflection.cache"));
 };
 
 
@@ -114,6 +127,15 @@ Game::~Game()
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
 	ImGui::DestroyContext();
+
+	//Release shared shaders and stop the texture workers before the device goes away
+	shaderHotReload.reset();
+	ShaderLibrary::Clear();
+	TextureLoader::ShutDown();
+	TextureStreamer::ShutDown();
+	submitter.reset();
+	commandLists.reset();
+	ISimpleShader::StateCache = 0;
 }
 
 // --------------------------------------------------------
@@ -126,13 +148,16 @@ Game::~Game()
 // --------------------------------------------------------
 void Game::LoadShaders()
 {
-	vertexShader = make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VertexShader.cso").c_str());
-	postProcessShader = make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VertexShaderPostProcess.cso").c_str());
-	pixelShader = make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PixelShader.cso").c_str());
-	blurPixelShader = make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PixelShaderBlur.cso").c_str());
-	invertPixelShader = make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FixPath(L"PixelShaderInvert.cso").c_str());
-
-	shadowVS = make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"VertexShaderShadow.cso").c_str());
+	vertexShader = ShaderLibrary::GetVertexShader(FixPath(L"VertexShader.cso"));
+	postProcessShader = ShaderLibrary::GetVertexShader(FixPath(L"VertexShaderPostProcess.cso"));
+	pixelShader = ShaderLibrary::GetPixelShader(FixPath(L"PixelShader.cso"));
+	blurPixelShader = ShaderLibrary::GetPixelShader(FixPath(L"PixelShaderBlur.cso"));
+	dualFilterDownShader = ShaderLibrary::GetPixelShader(FixPath(L"PixelShaderDualFilterDown.cso"));
+	dualFilterUpShader = ShaderLibrary::GetPixelShader(FixPath(L"PixelShaderDualFilterUp.cso"));
+	luminanceHistogramShader = ShaderLibrary::GetComputeShader(FixPath(L"ComputeShaderLuminanceHistogram.cso"));
+	exposureShader = ShaderLibrary::GetComputeShader(FixPath(L"ComputeShaderExposure.cso"));
+
+	shadowVS = ShaderLibrary::GetVertexShader(FixPath(L"VertexShaderShadow.cso"));
 }
 
 // --------------------------------------------------------
@@ -140,14 +165,39 @@ void Game::LoadShaders()
 // --------------------------------------------------------
 void Game::CreateGeometry()
 {
-	//Create the materials to pass into the entities
-	Material lightFilter = Material(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), vertexShader, pixelShader, 0.1f);
+	//The cobblestone set
+	shared_ptr<AsyncTexture> albedo = TextureLoader::LoadTexture(FixPath(L"../../Assets/Textures/cobblestone/albedo.png"), MipColorSpace::SRGB, BlockFormat::BC7, TextureLoader::PlaceholderGrey);
+	shared_ptr<AsyncTexture> normalMap = TextureLoader::LoadTexture(FixPath(L"../../Assets/Textures/cobblestone/normas.png"), MipColorSpace::Normal, BlockFormat::BC5, TextureLoader::PlaceholderFlatNormal);
+	//Roughness and metalness are baked into one ORM texture (the set has no occlusion map)
+	shared_ptr<AsyncTexture> ormMap = TextureLoader::LoadOrmTexture(L"",
+		FixPath(L"../../Assets/Textures/cobblestone/roughness.png"),
+		FixPath(L"../../Assets/Textures/cobblestone/metal.png"), BlockFormat::BC7);
+
+	D3D11_SAMPLER_DESC samplerDesc = {};
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;								//Lerp
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+	Graphics::Device->CreateSamplerState(&samplerDesc, &samplerState);
 
-	entities.push_back(Entity("Fancy Donut", Mesh(FixPath(L"../../Assets/Models/torus.obj").c_str()), lightFilter));
-	entities.push_back(Entity("Fancy Cube", Mesh(FixPath(L"../../Assets/Models/cube.obj").c_str()), lightFilter));
-	entities.push_back(Entity("Red-Green Sphere", Mesh(FixPath(L"../../Assets/Models/sphere.obj").c_str()), lightFilter));
-	entities.push_back(Entity("Red-Green Helix", Mesh(FixPath(L"../../Assets/Models/helix.obj").c_str()), lightFilter));
-	entities.push_back(Entity("Floor Cube", Mesh(FixPath(L"../../Assets/Models/cube.obj").c_str()), lightFilter));
+	//Create the materials to pass into the entities
+	//Each entity builds its own, and the registry hands back one shared instance (and ID) per distinct material
+	auto lightFilter = [&]() {
+		shared_ptr<Material> material = make_shared<Material>(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), vertexShader, pixelShader, 0.1f);
+		material->SetTexture("Albedo", albedo);
+		material->SetTexture("NormalMap", normalMap);
+		material->SetTexture("OrmMap", ormMap);
+		material->SetSampler("LerpSampler", samplerState);
+		return materialRegistry.Intern(material);
+	};
+
+	entities.push_back(Entity("Fancy Donut", Mesh(FixPath(L"../../Assets/Models/torus.obj").c_str()), lightFilter()));
+	entities.push_back(Entity("Fancy Cube", Mesh(FixPath(L"../../Assets/Models/cube.obj").c_str()), lightFilter()));
+	entities.push_back(Entity("Red-Green Sphere", Mesh(FixPath(L"../../Assets/Models/sphere.obj").c_str()), lightFilter()));
+	entities.push_back(Entity("Red-Green Helix", Mesh(FixPath(L"../../Assets/Models/helix.obj").c_str()), lightFilter()));
+	entities.push_back(Entity("Floor Cube", Mesh(FixPath(L"../../Assets/Models/cube.obj").c_str()), lightFilter()));
 
 	//Position all the objects.
 	for (int i = 0; i < entities.size() - 1; i++) {
@@ -157,6 +207,10 @@ void Game::CreateGeometry()
 	entities[4].GetTransform()->MoveAbsolute(0.0f, -12.0f, 0.0f);
 	entities[4].GetTransform()->Scale(20.0f, 1.0f, 20.0f);
 
+	//The donut and helix spin in Update - everything else stays in the static shadow cache
+	entities[0].SetDynamic(true);
+	entities[3].SetDynamic(true);
+
 	for (int i = 0; i < 3; i++) {
 		
 	}
@@ -178,14 +232,27 @@ void Game::CreateGeometry()
 	light.color = XMFLOAT3(0.0f, 0.0f, 1.0f);
 	lights.push_back(light);
 	lightNames.push_back("Blue");
+
+	//Third Light: Green spot light, down onto the helix
+	Light spot = {};
+	spot.type = LIGHT_TYPE_SPOT;
+	spot.range = 14.0f;
+	spot.intensity = 10;
+	spot.position = XMFLOAT3(6.0f, -3.0f, -3.0f);
+	spot.direction = XMFLOAT3(0.0f, -1.0f, 0.5f);
+	spot.spotAngle = XMConvertToRadians(60.0f);
+	spot.color = XMFLOAT3(0.2f, 1.0f, 0.2f);
+	lights.push_back(spot);
+	lightNames.push_back("Green");
 }
 
 void Game::ConstructShadowMap() {
 	// Create the actual texture that will be the shadow map
 	D3D11_TEXTURE2D_DESC shadowDesc = {};
-	shadowDesc.Width = shadowMapResolution; // Ideally a power of 2 (like 1024)
-	shadowDesc.Height = shadowMapResolution; // Ideally a power of 2 (like 1024)
-	shadowDesc.ArraySize = 1;
+	//One slice per cascade, all the same size
+	shadowDesc.Width = cascadeSettings.Resolution; // Ideally a power of 2 (like 1024)
+	shadowDesc.Height = cascadeSettings.Resolution; // Ideally a power of 2 (like 1024)
+	shadowDesc.ArraySize = CascadedShadows::MaxCascades;
 	shadowDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
 	shadowDesc.CPUAccessFlags = 0;
 	shadowDesc.Format = DXGI_FORMAT_R32_TYPELESS;
@@ -194,25 +261,38 @@ void Game::ConstructShadowMap() {
 	shadowDesc.SampleDesc.Count = 1;
 	shadowDesc.SampleDesc.Quality = 0;
 	shadowDesc.Usage = D3D11_USAGE_DEFAULT;
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowTexture;
 	Graphics::Device->CreateTexture2D(&shadowDesc, 0, shadowTexture.GetAddressOf());
 
-	// Create the depth/stencil view
-	D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = {};
-	shadowDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
-	shadowDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-	shadowDSDesc.Texture2D.MipSlice = 0;
-	Graphics::Device->CreateDepthStencilView(
-		shadowTexture.Get(),
-		&shadowDSDesc,
-		shadowDSV.GetAddressOf());
+	//Same again for the cache of static casters - only ever drawn into and copied from
+	shadowDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	Graphics::Device->CreateTexture2D(&shadowDesc, 0, staticShadowTexture.GetAddressOf());
+
+	// Create a depth/stencil view for each cascade's slice
+	for (unsigned int i = 0; i < CascadedShadows::MaxCascades; i++) {
+		D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = {};
+		shadowDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
+		shadowDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+		shadowDSDesc.Texture2DArray.MipSlice = 0;
+		shadowDSDesc.Texture2DArray.FirstArraySlice = i;
+		shadowDSDesc.Texture2DArray.ArraySize = 1;
+		Graphics::Device->CreateDepthStencilView(
+			shadowTexture.Get(),
+			&shadowDSDesc,
+			shadowDSVs[i].GetAddressOf());
+		Graphics::Device->CreateDepthStencilView(
+			staticShadowTexture.Get(),
+			&shadowDSDesc,
+			staticShadowDSVs[i].GetAddressOf());
+	}
 
-	// Create the SRV for the shadow map
+	// Create the SRV for the shadow map - the whole array, the pixel shader picks the slice
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MipLevels = 1;
-	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	srvDesc.Texture2DArray.MipLevels = 1;
+	srvDesc.Texture2DArray.MostDetailedMip = 0;
+	srvDesc.Texture2DArray.FirstArraySlice = 0;
+	srvDesc.Texture2DArray.ArraySize = CascadedShadows::MaxCascades;
 	Graphics::Device->CreateShaderResourceView(
 		shadowTexture.Get(),
 		&srvDesc,
@@ -222,7 +302,7 @@ void Game::ConstructShadowMap() {
 	D3D11_RASTERIZER_DESC shadowRastDesc = {};
 	shadowRastDesc.FillMode = D3D11_FILL_SOLID;
 	shadowRastDesc.CullMode = D3D11_CULL_BACK;
-	shadowRastDesc.DepthClipEnable = true;
+	shadowRastDesc.DepthClipEnable = false; // Casters nearer the light than a cascade reaches still clamp onto it
 	shadowRastDesc.DepthBias = 1000; // Min. precision units, not world units!
 	shadowRastDesc.SlopeScaledDepthBias = 1.0f; // Bias more based on slope
 	Graphics::Device->CreateRasterizerState(&shadowRastDesc, &shadowRasterizer);
@@ -237,19 +317,29 @@ void Game::ConstructShadowMap() {
 	shadowSampDesc.BorderColor[0] = 1.0f; // Only need the first component
 	Graphics::Device->CreateSamplerState(&shadowSampDesc, &shadowSampler);
 
-	XMMATRIX lightView = XMMatrixLookToLH(
-		XMLoadFloat3(&lights[0].direction) * -20,
-		XMLoadFloat3(&lights[0].direction),					//Shadows will be straight down
-		XMVectorSet( 0, 1, 0, 0));
-	XMStoreFloat4x4(&shadowViewMatrix, lightView);
-
-	float lightProjectionSize = 15.0f;
-	XMMATRIX lightProjection = XMMatrixOrthographicLH(
-		lightProjectionSize,
-		lightProjectionSize,
-		1.0f,
-		50.0f);
-	XMStoreFloat4x4(&shadowProjectionMatrix, lightProjection);
+	//The atlas for the point and spot lights - one square texture, drawn into a tile at a time
+	D3D11_TEXTURE2D_DESC atlasDesc = shadowDesc;
+	atlasDesc.Width = shadowAtlas.GetSettings().Size;
+	atlasDesc.Height = shadowAtlas.GetSettings().Size;
+	atlasDesc.ArraySize = 1;
+	atlasDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> atlasTexture;
+	Graphics::Device->CreateTexture2D(&atlasDesc, 0, atlasTexture.GetAddressOf());
+
+	D3D11_DEPTH_STENCIL_VIEW_DESC atlasDSDesc = {};
+	atlasDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
+	atlasDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+	atlasDSDesc.Texture2D.MipSlice = 0;
+	Graphics::Device->CreateDepthStencilView(atlasTexture.Get(), &atlasDSDesc, shadowAtlasDSV.GetAddressOf());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC atlasSRVDesc = {};
+	atlasSRVDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	atlasSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	atlasSRVDesc.Texture2D.MipLevels = 1;
+	atlasSRVDesc.Texture2D.MostDetailedMip = 0;
+	Graphics::Device->CreateShaderResourceView(atlasTexture.Get(), &atlasSRVDesc, shadowAtlasSRV.GetAddressOf());
+
+	//The cascades' matrices follow the camera, and the atlas tiles the lights on screen, so they're fit every frame in Draw
 }
 
 void Game::SetupPostProcesses() {
@@ -262,70 +352,102 @@ void Game::SetupPostProcesses() {
 	ppSampDesc.MaxLOD = D3D11_FLOAT32_MAX;
 	Graphics::Device->CreateSamplerState(&ppSampDesc, postProcessSampler.GetAddressOf());
 
+	// Everything between the scene and the back buffer comes from the graph's pool
+	postTargets = std::make_unique<D3D11PostTargetPool>(Graphics::Device);
+	CreateSceneTargets();
+
+	// Auto exposure histogram - raw, so the shaders can add to it atomically
+	D3D11_BUFFER_DESC histogramDesc = {};
+	histogramDesc.ByteWidth = AutoExposure::BinCount * sizeof(unsigned int);
+	histogramDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+	histogramDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+	histogramDesc.Usage = D3D11_USAGE_DEFAULT;
+	vector<unsigned int> emptyBins(AutoExposure::BinCount);
+	D3D11_SUBRESOURCE_DATA histogramData = {};
+	histogramData.pSysMem = emptyBins.data();
+	Graphics::Device->CreateBuffer(&histogramDesc, &histogramData, histogramBuffer.GetAddressOf());
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC histogramUavDesc = {};
+	histogramUavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	histogramUavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	histogramUavDesc.Buffer.NumElements = AutoExposure::BinCount;
+	histogramUavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+	Graphics::Device->CreateUnorderedAccessView(histogramBuffer.Get(), &histogramUavDesc, histogramUAV.GetAddressOf());
+
+	// Adapted luminance and exposure - written by the exposure pass, read by the tonemap.
+	// Starts adapted to the key value, so the first frame has an exposure of 1
+	D3D11_BUFFER_DESC exposureDesc = {};
+	exposureDesc.ByteWidth = 2 * sizeof(float);
+	exposureDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+	exposureDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	exposureDesc.StructureByteStride = sizeof(float);
+	exposureDesc.Usage = D3D11_USAGE_DEFAULT;
+	float initialExposure[2] = { autoExposure.KeyValue, 1.0f };
+	D3D11_SUBRESOURCE_DATA exposureData = {};
+	exposureData.pSysMem = initialExposure;
+	Graphics::Device->CreateBuffer(&exposureDesc, &exposureData, exposureBuffer.GetAddressOf());
+	Graphics::Device->CreateUnorderedAccessView(exposureBuffer.Get(), 0, exposureUAV.GetAddressOf());
+	Graphics::Device->CreateShaderResourceView(exposureBuffer.Get(), 0, exposureSRV.GetAddressOf());
+
+	// CPU readable copies of both, for recording frames to replay against AutoExposure
+	D3D11_BUFFER_DESC stagingDesc = histogramDesc;
+	stagingDesc.BindFlags = 0;
+	stagingDesc.MiscFlags = 0;
+	stagingDesc.Usage = D3D11_USAGE_STAGING;
+	stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	Graphics::Device->CreateBuffer(&stagingDesc, 0, histogramStaging.GetAddressOf());
+	stagingDesc.ByteWidth = exposureDesc.ByteWidth;
+	for (auto& staging : exposureStaging)
+		Graphics::Device->CreateBuffer(&stagingDesc, 0, staging.GetAddressOf());
+}
+
+// --------------------------------------------------------
+// (Re)creates the window sized targets the post process
+// graph doesn't own: the scene it reads from (linear HDR,
+// so the lighting doesn't clip before the tonemap), and
+// the compute path's output
+// --------------------------------------------------------
+void Game::CreateSceneTargets() {
 	// Describe the texture we're creating
-	D3D11_TEXTURE2D_DESC blurTextureDesc = {};
-	blurTextureDesc.Width = Window::Width();
-	blurTextureDesc.Height = Window::Height();
-	blurTextureDesc.ArraySize = 1;
-	blurTextureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-	blurTextureDesc.CPUAccessFlags = 0;
-	blurTextureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	blurTextureDesc.MipLevels = 1;
-	blurTextureDesc.MiscFlags = 0;
-	blurTextureDesc.SampleDesc.Count = 1;
-	blurTextureDesc.SampleDesc.Quality = 0;
-	blurTextureDesc.Usage = D3D11_USAGE_DEFAULT;
-	// Create the resource (no need to track it after the views are created below)
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> blurTexture;
-	Graphics::Device->CreateTexture2D(&blurTextureDesc, 0, blurTexture.GetAddressOf());
-	
-	// Describe the texture we're creating
-	D3D11_TEXTURE2D_DESC invertTextureDesc = {};
-	invertTextureDesc.Width = Window::Width();
-	invertTextureDesc.Height = Window::Height();
-	invertTextureDesc.ArraySize = 1;
-	invertTextureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-	invertTextureDesc.CPUAccessFlags = 0;
-	invertTextureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	invertTextureDesc.MipLevels = 1;
-	invertTextureDesc.MiscFlags = 0;
-	invertTextureDesc.SampleDesc.Count = 1;
-	invertTextureDesc.SampleDesc.Quality = 0;
-	invertTextureDesc.Usage = D3D11_USAGE_DEFAULT;
+	D3D11_TEXTURE2D_DESC sceneTextureDesc = {};
+	sceneTextureDesc.Width = Window::Width();
+	sceneTextureDesc.Height = Window::Height();
+	sceneTextureDesc.ArraySize = 1;
+	sceneTextureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	sceneTextureDesc.CPUAccessFlags = 0;
+	sceneTextureDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	sceneTextureDesc.MipLevels = 1;
+	sceneTextureDesc.MiscFlags = 0;
+	sceneTextureDesc.SampleDesc.Count = 1;
+	sceneTextureDesc.SampleDesc.Quality = 0;
+	sceneTextureDesc.Usage = D3D11_USAGE_DEFAULT;
 	// Create the resource (no need to track it after the views are created below)
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> invertTexture;
-	Graphics::Device->CreateTexture2D(&invertTextureDesc, 0, invertTexture.GetAddressOf());
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> sceneTexture;
+	Graphics::Device->CreateTexture2D(&sceneTextureDesc, 0, sceneTexture.GetAddressOf());
 
 	// Create the Render Target View
-	D3D11_RENDER_TARGET_VIEW_DESC blurRtvDesc = {};
-	blurRtvDesc.Format = blurTextureDesc.Format;
-	blurRtvDesc.Texture2D.MipSlice = 0;
-	blurRtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+	D3D11_RENDER_TARGET_VIEW_DESC sceneRtvDesc = {};
+	sceneRtvDesc.Format = sceneTextureDesc.Format;
+	sceneRtvDesc.Texture2D.MipSlice = 0;
+	sceneRtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
 	Graphics::Device ->CreateRenderTargetView(
-		blurTexture.Get(),
-		&blurRtvDesc,
-		blurRenderTargetView.ReleaseAndGetAddressOf());
+		sceneTexture.Get(),
+		&sceneRtvDesc,
+		sceneRenderTargetView.ReleaseAndGetAddressOf());
 	// Create the Shader Resource View
 	// By passing it a null description for the SRV, we
 	// get a "default" SRV that has access to the entire resource
 	Graphics::Device->CreateShaderResourceView(
-		blurTexture.Get(),
-		0,
-		blurShaderResourceView.ReleaseAndGetAddressOf());
-
-	D3D11_RENDER_TARGET_VIEW_DESC invertRtvDesc = {};
-	invertRtvDesc.Format = invertTextureDesc.Format;
-	invertRtvDesc.Texture2D.MipSlice = 0;
-	invertRtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-	Graphics::Device ->CreateRenderTargetView(
-		invertTexture.Get(),
-		&invertRtvDesc,
-		invertRenderTargetView.ReleaseAndGetAddressOf());
-	
-	Graphics::Device->CreateShaderResourceView(
-		invertTexture.Get(),
+		sceneTexture.Get(),
 		0,
-		invertShaderResourceView.ReleaseAndGetAddressOf());
+		sceneShaderResourceView.ReleaseAndGetAddressOf());
+
+	// The compute path's output - same size and format as the back buffer, so it can be copied straight over
+	D3D11_TEXTURE2D_DESC tiledPostDesc = sceneTextureDesc;
+	tiledPostDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+	tiledPostDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	Graphics::Device->CreateTexture2D(&tiledPostDesc, 0, tiledPostTexture.ReleaseAndGetAddressOf());
+	Graphics::Device->CreateUnorderedAccessView(tiledPostTexture.Get(), 0, tiledPostUAV.ReleaseAndGetAddressOf());
 }
 
 
@@ -341,6 +463,9 @@ void Game::OnResize()
 			c->UpdateProjectionMatrix(Window::AspectRatio());
 		}
 	}
+
+	//The post process graph resizes its own targets the next time it runs
+	if (postTargets) CreateSceneTargets();
 }
 
 
@@ -349,15 +474,35 @@ void Game::OnResize()
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
+	//Swap in any shaders that finished recompiling since last frame
+	//(a new shader may have moved its variables, so the draw list layouts are rebuilt)
+	if (shaderHotReload && shaderHotReload->ApplyPending() > 0) RegisterDrawPipelines();
+
+	//Upload any textures the loader finished decoding (capped so a big batch doesn't hitch one frame)
+	{
+		PROFILE_ZONE("Texture Uploads");
+		TextureLoader::ProcessUploads(32 * 1024 * 1024);
+	}
+	{
+		PROFILE_ZONE("Texture Streaming");
+		TextureStreamer::Update(GetStreamingCamera(*cameras[activeCamera]), GatherStreamingObjects());
+	}
+
 	//Update the UI
-	UpdateImGui(deltaTime);
-	BuildUI();
+	{
+		PROFILE_ZONE("ImGui Build");
+		UpdateImGui(deltaTime);
+		BuildUI();
+	}
 	cameras[activeCamera]->Update(deltaTime);
 	entities[0].GetTransform()->Rotate(0, deltaTime, 0);
 	entities[3].GetTransform()->Rotate(0, deltaTime, 0);
 
-	for (int i = 0; i < entities.size(); i++) {
-		entities[i].GetTransform()->SetWorldMatrices();
+	{
+		PROFILE_ZONE("Entity Transforms");
+		for (int i = 0; i < entities.size(); i++) {
+			entities[i].GetTransform()->SetWorldMatrices();
+		}
 	}
 
 	// Example input checking: Quit if the escape key is pressed
@@ -375,50 +520,79 @@ void Game::Draw(float deltaTime, float totalTime)
 	// - These things should happen ONCE PER FRAME
 	// - At the beginning of Game::Draw() before drawing *anything*
 	{
+		gpuTimers->BeginFrame();
+
 		// Clear the back buffer (erase what's on screen) and depth buffer
 		Graphics::Context->ClearRenderTargetView(Graphics::BackBufferRTV.Get(), displayColor);
-		Graphics::Context->ClearRenderTargetView(blurRenderTargetView.Get(), displayColor);
-		Graphics::Context->ClearRenderTargetView(invertRenderTargetView.Get(), displayColor);
+		Graphics::Context->ClearRenderTargetView(sceneRenderTargetView.Get(), displayColor);
 		Graphics::Context->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-		Graphics::Context->OMSetRenderTargets(1, blurRenderTargetView.GetAddressOf(), Graphics::DepthBufferDSV.Get());
+		Graphics::State->SetRenderTargets(1, sceneRenderTargetView.GetAddressOf(), Graphics::DepthBufferDSV.Get());
 		
 		// Render Shadow Map
 		{
-			//Clear the map first
-			Graphics::Context->ClearDepthStencilView(shadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-
-			//Set merger state and clear pixel shader
+			PROFILE_ZONE("Shadow Pass");
+			ScopedGpuPass shadowGpuPass(*gpuTimers, "Shadow Map");
+			//Fit the cascades to the active camera's frustum and the light as it is now, then to what casts into them
+			GatherShadowCasters();
+			XMFLOAT4X4 cameraView = cameras[activeCamera]->GetViewMatrix();
+			XMFLOAT4X4 cameraProjection = cameras[activeCamera]->GetProjectionMatrix();
+			shadowCascades = CascadedShadows::Build(cameraView, cameraProjection, lights[0].direction, cascadeSettings);
+			CascadedShadows::Cull(shadowCascades, cameraView, cameraProjection, shadowCasters);
+			shadowCascadeData = CascadedShadows::Pack(shadowCascades);
+
+			//Clear pixel shader, the viewport is the same for every slice
 			ID3D11RenderTargetView* nullRTV{};
-			Graphics::Context->OMSetRenderTargets(1, &nullRTV, shadowDSV.Get());
-			Graphics::Context->PSSetShader(0, 0, 0);
-			Graphics::Context->RSSetState(shadowRasterizer.Get());
-			
-			//Change the viewport
-			D3D11_VIEWPORT viewport = {};
-			viewport.Width = (float)shadowMapResolution;
-			viewport.Height = (float)shadowMapResolution;
+			Graphics::State->SetPixelShader(0);
+			RenderViewport viewport = {};
+			viewport.Width = (float)cascadeSettings.Resolution;
+			viewport.Height = (float)cascadeSettings.Resolution;
 			viewport.MaxDepth = 1.0f;
-			Graphics::Context->RSSetViewports(1, &viewport);
 
-			shadowVS->SetShader();
-			shadowVS->SetMatrix4x4("view", shadowViewMatrix);
-			shadowVS->SetMatrix4x4("projection", shadowProjectionMatrix);
-			// Loop and draw all entities
-			for (auto& e : entities)
+			shadowSubmission = SubmissionStats();
+			shadowCache.ResetStats();
+			for (size_t c = 0; c < shadowCascades.size(); c++) {
+				const ShadowCachePlan& plan = shadowCache.Plan((unsigned int)c, shadowCascades[c], castersDynamic, castersMoved, alwaysRedrawShadows);
+				if (plan.Action == ShadowCacheAction::Keep)
+					continue;
+
+				//Static casters only go into the cache when it's stale (the light turned, the cascade moved, or one was edited)
+				if (plan.Action == ShadowCacheAction::Rebuild) {
+					Graphics::Context->ClearDepthStencilView(staticShadowDSVs[c].Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+					DrawShadowCasters(staticShadowDSVs[c].Get(), viewport, shadowCascades[c].View, shadowCascades[c].Projection, plan.StaticCasters);
+				}
+
+				//Then the live slice starts from the cache, with just the dynamic casters drawn over it
+				Graphics::State->SetRenderTargets(1, &nullRTV, 0);
+				UINT slice = D3D11CalcSubresource(0, (UINT)c, 1);
+				Graphics::Context->CopySubresourceRegion(shadowTexture.Get(), slice, 0, 0, 0, staticShadowTexture.Get(), slice, 0);
+				DrawShadowCasters(shadowDSVs[c].Get(), viewport, shadowCascades[c].View, shadowCascades[c].Projection, plan.DynamicCasters);
+			}
+
+			//The point and spot lights get atlas tiles sized by how much of the screen they light, kept where they were if they can be
 			{
-				shadowVS->SetMatrix4x4("world", e.GetTransform()->GetWorldMatrix());
-				shadowVS->CopyAllBufferData();
-				// Draw the mesh directly to avoid the entity's material
-				// Note: Your code may differ significantly here!
-				e.GetMesh()->Draw();
+				PROFILE_ZONE("Shadow Atlas");
+				localShadowRequests = LocalShadows::Requests(lights, cameraView, cameraProjection);
+				localShadowFaces = LocalShadows::Faces(lights, localShadowRequests, shadowAtlas.Allocate(localShadowRequests), shadowCasters);
+				localShadowData = LocalShadows::Pack(localShadowFaces, shadowAtlas.GetSettings().Size);
+
+				//A tile can't be cleared on its own (not without D3D 11.1's ClearView), so the whole atlas is redrawn
+				Graphics::Context->ClearDepthStencilView(shadowAtlasDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+				for (auto& face : localShadowFaces) {
+					RenderViewport tile = {};
+					tile.TopLeftX = (float)face.Tile.X;
+					tile.TopLeftY = (float)face.Tile.Y;
+					tile.Width = (float)face.Tile.Size;
+					tile.Height = (float)face.Tile.Size;
+					tile.MaxDepth = 1.0f;
+					DrawShadowCasters(shadowAtlasDSV.Get(), tile, face.View, face.Projection, face.Casters);
+				}
 			}
 
 			viewport.Width = (float)Window::Width();
 			viewport.Height = (float)Window::Height();
-			Graphics::Context->RSSetViewports(1, &viewport);
-			if (isBlurry) Graphics::Context->OMSetRenderTargets(1, blurRenderTargetView.GetAddressOf(), Graphics::DepthBufferDSV.Get());
-			else Graphics::Context->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), Graphics::DepthBufferDSV.Get());
-			Graphics::Context->RSSetState(0);
+			Graphics::State->SetViewports(1, &viewport);
+			Graphics::State->SetRenderTargets(1, sceneRenderTargetView.GetAddressOf(), Graphics::DepthBufferDSV.Get());
+			Graphics::State->SetRasterizerState(0);
 		}
 	}
 
@@ -426,15 +600,85 @@ void Game::Draw(float deltaTime, float totalTime)
 	// - These steps are generally repeated for EACH object you draw
 	// - Other Direct3D calls will also be necessary to do more complex things
 	{
+		PROFILE_ZONE("Draw Geometry");
+		unsigned int mainGpuPass = gpuTimers->BeginPass("Main Pass");
+		//Draw in material ID order, so each material is bound once per frame
+		vector<MaterialDrawItem> drawList(entities.size());
 		for (int i = 0; i < entities.size(); i++) {
-			entities[i].GetMaterial()->GetVertexShader()->SetShader();
-			entities[i].GetMaterial()->GetPixelShader()->SetShader();
-			ConstructShaderData(entities[i], totalTime);
-			entities[i].Draw();
+			drawList[i].MaterialId = entities[i].GetMaterial()->GetId();
+			drawList[i].Index = i;
+		}
+		materialBatchStats = MaterialBatching::Sort(drawList);
+
+		if (deferredSubmission) {
+			drawPackets.clear();
+			drawConstants.clear();
+			for (auto& item : drawList) {
+				Entity& entity = entities[item.Index];
+				std::shared_ptr<Material> material = entity.GetMaterial();
+				ConstructShaderData(entity, totalTime);
+				drawPackets.push_back(DrawPackets::Capture(material->GetVertexShader().get(), material->GetPixelShader().get(),
+					material.get(), entity.GetMesh().get(), drawConstants));
+			}
+
+			//Every list starts from scratch, so each one binds the pass's frame-wide state
+			ID3D11RenderTargetView* target = sceneRenderTargetView.Get();
+			ID3D11DepthStencilView* depth = Graphics::DepthBufferDSV.Get();
+			ID3D11ShaderResourceView* shadowMap = shadowSRV.Get();
+			ID3D11ShaderResourceView* shadowAtlasMap = shadowAtlasSRV.Get();
+			ID3D11SamplerState* shadowMapSampler = shadowSampler.Get();
+			UINT shadowMapSlot = pixelShader->GetShaderResourceViewInfo("ShadowMap")->BindIndex;
+			UINT shadowAtlasSlot = pixelShader->GetShaderResourceViewInfo("ShadowAtlas")->BindIndex;
+			UINT shadowSamplerSlot = pixelShader->GetSamplerInfo("ShadowSampler")->BindIndex;
+			RenderViewport viewport = {};
+			viewport.Width = (float)Window::Width();
+			viewport.Height = (float)Window::Height();
+			viewport.MaxDepth = 1.0f;
+			mainSubmission = SubmitDrawPackets([&](ID3D11DeviceContext* context) {
+				context->OMSetRenderTargets(1, &target, depth);
+				context->RSSetViewports(1, (const D3D11_VIEWPORT*)&viewport);
+				context->PSSetShaderResources(shadowMapSlot, 1, &shadowMap);
+				context->PSSetShaderResources(shadowAtlasSlot, 1, &shadowAtlasMap);
+				context->PSSetSamplers(shadowSamplerSlot, 1, &shadowMapSampler);
+			});
+
+			//The sky binds its own shaders and states, but not the targets
+			Graphics::State->SetRenderTargets(1, &target, depth);
+			Graphics::State->SetViewports(1, &viewport);
+		}
+		else {
+			//Frame-wide resources live outside every material's registers, so they're bound once
+			pixelShader->SetShaderResourceView("ShadowMap", shadowSRV);
+			pixelShader->SetShaderResourceView("ShadowAtlas", shadowAtlasSRV);
+			pixelShader->SetSamplerState("ShadowSampler", shadowSampler);
+
+			//The builder sorts by material and only binds what changes
+			DrawFrameConstants frame = {};
+			frame.View = cameras[activeCamera]->GetViewMatrix();
+			frame.Projection = cameras[activeCamera]->GetProjectionMatrix();
+			frame.CameraPosition = cameras[activeCamera]->GetTransform().GetPosition();
+			frame.TotalTime = totalTime;
+			frame.Lights = &lights[0];
+			frame.LightBytes = (unsigned int)(sizeof(Light) * lights.size());
+			frame.ShadowCascades = &shadowCascadeData;
+			frame.ShadowCascadeBytes = sizeof(shadowCascadeData);
+			frame.LocalShadows = &localShadowData;
+			frame.LocalShadowBytes = sizeof(localShadowData);
+			GatherDrawObjects(0, true);
+			commandBuffer.Clear();
+			materialBatchStats = drawListBuilder.Build(drawObjects, frame, commandBuffer);
+			commandExecutor.Execute(commandBuffer);
 		}
 
-		skyBox->Draw(*cameras[activeCamera]);
-		if (isBlurry) PostRender();
+		gpuTimers->EndPass(mainGpuPass);
+		{
+			PROFILE_ZONE("Sky");
+			ScopedGpuPass skyGpuPass(*gpuTimers, "Sky");
+			skyBox->Draw(*cameras[activeCamera]);
+		}
+		PostRender(deltaTime);
+		PROFILE_ZONE("ImGui Render");
+		ScopedGpuPass imguiGpuPass(*gpuTimers, "ImGui");
 		ImGui::Render(); // Turns this frames UI into renderable triangles
 		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData()); // Draws it to the screen
 
@@ -445,49 +689,297 @@ void Game::Draw(float deltaTime, float totalTime)
 	// - These should happen exactly ONCE PER FRAME
 	// - At the very end of the frame (after drawing *everything*)
 	{
+		//Close the frame's queries and pick up any results that have come back
+		gpuTimers->EndFrame();
+
 		// Present at the end of the frame
+		PROFILE_ZONE("Present");
 		bool vsync = Graphics::VsyncState();
 		Graphics::SwapChain->Present(
 			vsync ? 1 : 0,
 			vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
 
 		// Re-bind back buffer and depth buffer after presenting
-		Graphics::Context->OMSetRenderTargets(
+		// (presenting unbinds them behind the state cache's back)
+		Graphics::State->InvalidateRenderTargets();
+		Graphics::State->SetRenderTargets(
 			1,
 			Graphics::BackBufferRTV.GetAddressOf(),
 			Graphics::DepthBufferDSV.Get());
 
+		//Only the slots that actually hold something get cleared
 		ID3D11ShaderResourceView* nullSRVs[128] = {};
-		Graphics::Context->PSSetShaderResources(0, 128, nullSRVs);
+		Graphics::State->SetPixelShaderResources(0, 128, nullSRVs);
+
+		//Keep this frame's numbers for the UI and start counting the next one
+		renderStateCounters = Graphics::State->GetCounters();
+		Graphics::State->ResetCounters();
 	}
 }
 
-void Game::PostRender() {
-	Graphics::Context->OMSetRenderTargets(1, invertRenderTargetView.GetAddressOf(), 0);
-	postProcessShader->SetShader();
-	
-	blurPixelShader->SetShader();
-	blurPixelShader->SetShaderResourceView("Pixels", blurShaderResourceView.Get());
-	blurPixelShader->SetSamplerState("ClampSampler", postProcessSampler.Get());
-	blurPixelShader->SetInt("blurRadius", blurRadius);
-	blurPixelShader->SetFloat("pixelWidth", 1.0f / Window::Width());
-	blurPixelShader->SetFloat("pixelHeight", 1.0f / Window::Height());
+void Game::PostRender(float deltaTime) {
+	PROFILE_ZONE("PostRender");
+	//The scene can't be read while it's still bound as a target
+	Graphics::State->SetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), 0);
+	UpdateAutoExposure(deltaTime);
+	if (isBlurry && blurMode == 2) {
+		RenderTiledPostProcess();
+		return;
+	}
+
+	//Redeclare the graph when its shape changes - it compiles and sizes its own targets when it runs
+	int mode = isBlurry ? blurMode : 3;
+	unsigned int levels = mode == 1 ? DualFilterBlur::SettingsForRadius(blurRadius).Levels : 0;
+	if (postGraphMode != mode || postGraphLevels != levels) BuildPostGraph(mode, levels);
+	postGraph.SetImport(postSceneResource, sceneShaderResourceView.Get(), 0);
+	postGraph.SetImport(postBackBufferResource, 0, Graphics::BackBufferRTV.Get());
 
+	postProcessShader->SetShader();
 	postProcessShader->CopyAllBufferData();
-	blurPixelShader->CopyAllBufferData();
+	if (!postGraph.Execute(*postTargets, Window::Width(), Window::Height()))
+		postGraphError = postGraph.GetError();
+
+	//Passes shrink the viewport to their targets, so put the window's back
+	RenderViewport viewport = {};
+	viewport.Width = (float)Window::Width();
+	viewport.Height = (float)Window::Height();
+	viewport.MaxDepth = 1.0f;
+	Graphics::State->SetViewports(1, &viewport);
+}
 
-	Graphics::Context->Draw(3, 0);
+void Game::BuildPostGraph(int mode, unsigned int dualFilterLevels) {
+	//Blur the scene one way or the other (or not) - the last pass writes the back buffer with the pointwise effects fused in
+	postGraph.Clear();
+	postSceneResource = postGraph.Import("Scene");
+	postBackBufferResource = postGraph.Import("Back Buffer");
+	if (mode == 3) AddOutputPass(postSceneResource, postBackBufferResource);
+	else if (mode == 1) AddDualFilterPasses(postSceneResource, postBackBufferResource, dualFilterLevels);
+	else AddGaussianPasses(postSceneResource, postBackBufferResource);
+
+	postGraphMode = mode;
+	postGraphLevels = dualFilterLevels;
+	postGraph.Compile(Window::Width(), Window::Height());
+	postGraphError = postGraph.GetError();
+}
 
-	Graphics::Context->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), 0);
+void Game::AddPostPass(const char* name, const vector<int>& inputs, int output, PostProcessGraph::PassFunction draw) {
+	//Every pass is timed, and drawn at its own target's size
+	postGraph.AddPass(name, inputs, output, [this, draw](const PostPassContext& pass) {
+		ScopedGpuPass gpuPass(*gpuTimers, pass.Name);
+
+		//Targets are shared, so this one may still be bound as the last pass's input -
+		//binding it as a target would unbind that behind the state cache's back
+		ID3D11ShaderResourceView* nullSRV = 0;
+		Graphics::State->SetPixelShaderResources(0, 1, &nullSRV);
+		Graphics::State->SetRenderTargets(1, &pass.Output, 0);
+
+		RenderViewport viewport = {};
+		viewport.Width = (float)pass.Width;
+		viewport.Height = (float)pass.Height;
+		viewport.MaxDepth = 1.0f;
+		Graphics::State->SetViewports(1, &viewport);
+		draw(pass);
+	});
+}
 
-	invertPixelShader->SetShader();
-	invertPixelShader->SetShaderResourceView("Pixels", invertShaderResourceView.Get());
-	invertPixelShader->SetSamplerState("ClampSampler", postProcessSampler.Get());
+void Game::AddGaussianPasses(int source, int output) {
+	//Separable Gaussian: horizontal, then vertical (with the effects) into the output
+	PostTargetDesc desc;
+	desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	int horizontal = postGraph.Create("Blur Horizontal", desc);
+	auto blurPass = [this](std::shared_ptr<SimplePixelShader> shader, const PostPassContext& pass, XMFLOAT2 direction) {
+		vector<GaussianTap> taps = GaussianBlur::LinearTaps(blurRadius);
+		XMFLOAT4 tapData[GaussianBlur::MaxTaps] = {};
+		for (size_t i = 0; i < taps.size(); i++) tapData[i] = XMFLOAT4(taps[i].Offset, taps[i].Weight, 0, 0);
+
+		shader->SetShader();
+		shader->SetSamplerState("ClampSampler", postProcessSampler.Get());
+		shader->SetData("taps", tapData, (unsigned int)sizeof(tapData));
+		shader->SetInt("tapCount", (int)taps.size());
+		shader->SetShaderResourceView("Pixels", pass.Inputs[0]);
+		shader->SetFloat2("direction", direction);
+		shader->CopyAllBufferData();
+		Graphics::Context->Draw(3, 0);
+	};
+
+	AddPostPass("Blur Horizontal", { source }, horizontal, [this, blurPass](const PostPassContext& pass) {
+		blurPass(blurPixelShader, pass, XMFLOAT2(1.0f / pass.Width, 0));
+	});
+	AddPostPass("Blur Vertical", { horizontal }, output, [this, blurPass](const PostPassContext& pass) {
+		blurPass(GetPostEffectsShader(L"PixelShaderBlur"), pass, XMFLOAT2(0, 1.0f / pass.Height));
+	});
+}
 
-	postProcessShader->CopyAllBufferData();
-	invertPixelShader->CopyAllBufferData();
+void Game::AddDualFilterPasses(int source, int output, unsigned int levels) {
+	//Down the chain from the scene, then back up it (same kernels as DualFilterBlur)
+	static const char* downNames[] = { "Dual Filter Down 1", "Dual Filter Down 2", "Dual Filter Down 3" };
+	static const char* upNames[] = { "Dual Filter Up 0", "Dual Filter Up 1", "Dual Filter Up 2" };
+	auto filterPass = [this](std::shared_ptr<SimplePixelShader> shader, const PostPassContext& pass, unsigned int sourceLevel) {
+		shader->SetShader();
+		shader->SetSamplerState("ClampSampler", postProcessSampler.Get());
+		shader->SetShaderResourceView("Pixels", pass.Inputs[0]);
+		shader->SetFloat2("halfPixel", XMFLOAT2(
+			0.5f / DualFilterBlur::LevelSize(Window::Width(), sourceLevel),
+			0.5f / DualFilterBlur::LevelSize(Window::Height(), sourceLevel)));
+		shader->SetFloat("offset", DualFilterBlur::SettingsForRadius(blurRadius).Offset);
+		shader->CopyAllBufferData();
+		Graphics::Context->Draw(3, 0);
+	};
+
+	//Each level gets its own resource on the way down and up - the graph works out which can share
+	int current = source;
+	for (unsigned int level = 1; level <= levels; level++) {
+		PostTargetDesc desc;
+		desc.Level = level;
+		desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+		int target = postGraph.Create(downNames[level - 1], desc);
+		AddPostPass(downNames[level - 1], { current }, target, [this, filterPass, level](const PostPassContext& pass) {
+			filterPass(dualFilterDownShader, pass, level - 1);
+		});
+		current = target;
+	}
+	for (unsigned int level = levels; level >= 1; level--) {
+		//The last one up writes the output, with the effects
+		PostTargetDesc desc;
+		desc.Level = level - 1;
+		desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+		int target = level == 1 ? output : postGraph.Create(upNames[level - 1], desc);
+		AddPostPass(upNames[level - 1], { current }, target, [this, filterPass, level](const PostPassContext& pass) {
+			filterPass(level == 1 ? GetPostEffectsShader(L"PixelShaderDualFilterUp") : dualFilterUpShader, pass, level);
+		});
+		current = target;
+	}
+}
 
-	Graphics::Context->Draw(3, 0);
+void Game::AddOutputPass(int source, int output) {
+	//No blur - the effects still have to take the HDR scene to the back buffer
+	AddPostPass("Post Output", { source }, output, [this](const PostPassContext& pass) {
+		std::shared_ptr<SimplePixelShader> shader = GetPostEffectsShader(L"PixelShaderPostOutput");
+		shader->SetShader();
+		shader->SetSamplerState("ClampSampler", postProcessSampler.Get());
+		shader->SetShaderResourceView("Pixels", pass.Inputs[0]);
+		shader->CopyAllBufferData();
+		Graphics::Context->Draw(3, 0);
+	});
+}
+
+std::shared_ptr<SimplePixelShader> Game::GetPostEffectsShader(const std::wstring& shaderName) {
+	//The permutation with exactly the effects in use compiled in (see PostPermutations)
+	unsigned int key = PostPermutations::BuildKey(postEffects);
+	std::shared_ptr<SimplePixelShader> shader = ShaderLibrary::GetPixelShaderPermutation(
+		FixPath(shaderName + L".cso"), FixPath(L"../../" + shaderName + L".hlsl"), PostPermutations::Defines(key));
+	SetPostEffectVariables(shader.get());
+	return shader;
+}
+
+void Game::SetPostEffectVariables(ISimpleShader* shader) {
+	//Effects that aren't compiled in have no variables, so setting them does nothing
+	shader->SetFloat3("postTint", postEffects.TintColor);
+	shader->SetFloat("postInverseGamma", 1.0f / postEffects.GammaValue);
+	shader->SetFloat("postExposure", postEffects.Exposure);
+	shader->SetFloat("postAutoExposure", postEffects.AutoExposure ? 1.0f : 0.0f);
+	shader->SetShaderResourceView("AdaptedExposure", exposureSRV.Get());
+	shader->SetFloat("postSaturation", postEffects.Saturation);
+	shader->SetFloat("postContrast", postEffects.Contrast);
+	shader->SetFloat("postVignetteStrength", postEffects.VignetteStrength);
+	shader->SetFloat("postVignetteRadius", postEffects.VignetteRadius);
+}
+
+void Game::UpdateAutoExposure(float deltaTime) {
+	//Count the scene into the histogram, then adapt toward its average (see AutoExposure) - all on the GPU
+	ScopedGpuPass exposureGpuPass(*gpuTimers, "Auto Exposure");
+	luminanceHistogramShader->SetShader();
+	luminanceHistogramShader->SetFloat("minLogLuminance", autoExposure.MinLogLuminance);
+	luminanceHistogramShader->SetFloat("inverseLogRange", 1.0f / autoExposure.LogLuminanceRange);
+	luminanceHistogramShader->CopyAllBufferData();
+	luminanceHistogramShader->SetShaderResourceView("Pixels", sceneShaderResourceView.Get());
+	luminanceHistogramShader->SetUnorderedAccessView("Histogram", histogramUAV.Get());
+	luminanceHistogramShader->DispatchByThreads(Window::Width(), Window::Height(), 1);
+	luminanceHistogramShader->SetShaderResourceView("Pixels", 0);
+	luminanceHistogramShader->SetUnorderedAccessView("Histogram", 0);
+
+	//Recording keeps what the exposure pass is about to read (it clears the histogram)
+	bool recording = exposureFramesToRecord > 0;
+	if (recording) {
+		Graphics::Context->CopyResource(histogramStaging.Get(), histogramBuffer.Get());
+		Graphics::Context->CopyResource(exposureStaging[0].Get(), exposureBuffer.Get());
+	}
+
+	exposureShader->SetShader();
+	exposureShader->SetFloat("minLogLuminance", autoExposure.MinLogLuminance);
+	exposureShader->SetFloat("logRange", autoExposure.LogLuminanceRange);
+	exposureShader->SetFloat("deltaTime", deltaTime);
+	exposureShader->SetFloat("adaptToBright", autoExposure.AdaptToBright);
+	exposureShader->SetFloat("adaptToDark", autoExposure.AdaptToDark);
+	exposureShader->SetFloat("keyValue", autoExposure.KeyValue);
+	exposureShader->CopyAllBufferData();
+	exposureShader->SetUnorderedAccessView("Histogram", histogramUAV.Get());
+	exposureShader->SetUnorderedAccessView("AdaptedExposure", exposureUAV.Get());
+	exposureShader->DispatchByGroups(1, 1, 1);
+	exposureShader->SetUnorderedAccessView("Histogram", 0);
+	exposureShader->SetUnorderedAccessView("AdaptedExposure", 0);
+
+	if (recording) {
+		Graphics::Context->CopyResource(exposureStaging[1].Get(), exposureBuffer.Get());
+		ReadBackExposureFrame(deltaTime);
+	}
+}
+
+void Game::ReadBackExposureFrame(float deltaTime) {
+	//Mapping right away stalls until the GPU catches up - fine for a few recorded frames
+	AutoExposureFrame frame;
+	frame.DeltaTime = deltaTime;
+	frame.Bins.resize(AutoExposure::BinCount);
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(Graphics::Context->Map(histogramStaging.Get(), 0, D3D11_MAP_READ, 0, &mapped))) return;
+	memcpy(frame.Bins.data(), mapped.pData, AutoExposure::BinCount * sizeof(unsigned int));
+	Graphics::Context->Unmap(histogramStaging.Get(), 0);
+
+	float* adaptation[2] = { &frame.PreviousLuminance, &frame.AdaptedLuminance };
+	for (int i = 0; i < 2; i++) {
+		if (FAILED(Graphics::Context->Map(exposureStaging[i].Get(), 0, D3D11_MAP_READ, 0, &mapped))) return;
+		*adaptation[i] = *(float*)mapped.pData;
+		Graphics::Context->Unmap(exposureStaging[i].Get(), 0);
+	}
+
+	exposureRecording.push_back(frame);
+	if (--exposureFramesToRecord == 0) {
+		exposureReplay = AutoExposure::Replay(exposureRecording, autoExposure);
+	}
+}
+
+void Game::RenderTiledPostProcess() {
+	//Blur and the post effects in one dispatch (see TiledPostProcess), then copy the result to the back buffer.
+	//It's the same permutation of the effects the pixel passes would compile
+	std::shared_ptr<SimpleComputeShader> tiledPostShader = ShaderLibrary::GetComputeShaderPermutation(
+		FixPath(L"ComputeShaderPostProcess.cso"), FixPath(L"../../ComputeShaderPostProcess.hlsl"),
+		PostPermutations::Defines(PostPermutations::BuildKey(postEffects)));
+
+	vector<float> weights = GaussianBlur::Weights(blurRadius);
+	XMFLOAT4 weightData[TiledPostProcess::MaxWeights / 4] = {};
+	memcpy(weightData, weights.data(), min(weights.size(), (size_t)TiledPostProcess::MaxWeights) * sizeof(float));
+
+	tiledPostShader->SetShader();
+	tiledPostShader->SetInt("apron", min((int)weights.size() - 1, TiledPostProcess::MaxApron));
+	tiledPostShader->SetData("weights", weightData, (unsigned int)sizeof(weightData));
+	SetPostEffectVariables(tiledPostShader.get());
+	tiledPostShader->CopyAllBufferData();
+	tiledPostShader->SetShaderResourceView("Pixels", sceneShaderResourceView.Get());
+	tiledPostShader->SetUnorderedAccessView("Output", tiledPostUAV.Get());
+
+	unsigned int tiledGpuPass = gpuTimers->BeginPass("Tiled Post");
+	tiledPostShader->DispatchByThreads(Window::Width(), Window::Height(), 1);
+	gpuTimers->EndPass(tiledGpuPass);
+
+	//Unbind them all, so next frame can draw the scene into its target (and adapt the exposure) again
+	tiledPostShader->SetShaderResourceView("Pixels", 0);
+	tiledPostShader->SetShaderResourceView("AdaptedExposure", 0);
+	tiledPostShader->SetUnorderedAccessView("Output", 0);
+
+	Microsoft::WRL::ComPtr<ID3D11Resource> backBuffer;
+	Graphics::BackBufferRTV->GetResource(backBuffer.GetAddressOf());
+	Graphics::Context->CopyResource(backBuffer.Get(), tiledPostTexture.Get());
 }
 
 void Game::ConstructShaderData(Entity currentEntity, float totalTime) {
@@ -496,8 +988,6 @@ void Game::ConstructShaderData(Entity currentEntity, float totalTime) {
 	vertexShader->SetMatrix4x4("worldInverseTranspose", currentEntity.GetTransform()->GetWorldInverseTransposeMatrix());
 	vertexShader->SetMatrix4x4("view", cameras[activeCamera]->GetViewMatrix());
 	vertexShader->SetMatrix4x4("projection", cameras[activeCamera]->GetProjectionMatrix());
-	vertexShader->SetMatrix4x4("lightView", shadowViewMatrix);
-	vertexShader->SetMatrix4x4("lightProjection", shadowProjectionMatrix);
 
 	std::shared_ptr<SimplePixelShader> pixelShader = currentEntity.GetMaterial()->GetPixelShader();
 	pixelShader->SetFloat4("colorTint", currentEntity.GetMaterial()->GetColorTint());
@@ -505,18 +995,133 @@ void Game::ConstructShaderData(Entity currentEntity, float totalTime) {
 	pixelShader->SetFloat("totalTime", totalTime);
 	pixelShader->SetFloat("roughness", currentEntity.GetMaterial()->GetRoughness());
 	pixelShader->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size());
-	for (auto& t : textures) {
-		pixelShader->SetShaderResourceView(t.first.c_str(), t.second);
+	pixelShader->SetData("shadowCascades", &shadowCascadeData, sizeof(shadowCascadeData));
+	pixelShader->SetData("localShadows", &localShadowData, sizeof(localShadowData));
+}
+
+// --------------------------------------------------------
+// Gives the command executor the objects behind the handles
+// the draw lists use: material IDs for materials and entity
+// indices for meshes.  Every entity shares Game's shaders.
+// --------------------------------------------------------
+void Game::RegisterDrawResources() {
+	for (int i = 0; i < entities.size(); i++) {
+		commandExecutor.SetMesh(i, entities[i].GetMesh());
+		commandExecutor.SetMaterial(entities[i].GetMaterial()->GetId(), entities[i].GetMaterial());
 	}
-	pixelShader->SetShaderResourceView("ShadowMap", shadowSRV);
-	for (auto& s : samplers) {
-		pixelShader->SetSamplerState(s.first.c_str(), s.second);
+	RegisterDrawPipelines();
+}
+
+void Game::RegisterDrawPipelines() {
+	commandExecutor.SetPipeline(0, vertexShader, pixelShader);
+	commandExecutor.SetPipeline(1, shadowVS, 0);
+	drawListBuilder.SetPipelineLayout(0, vertexShader->GetReflection(), pixelShader->GetReflection());
+	drawListBuilder.SetPipelineLayout(1, shadowVS->GetReflection(), ShaderReflectionData());
+}
+
+void Game::GatherDrawObjects(unsigned int pipeline, bool withMaterials) {
+	drawObjects.resize(entities.size());
+	for (int i = 0; i < entities.size(); i++) {
+		DrawObject& object = drawObjects[i];
+		std::shared_ptr<Material> material = entities[i].GetMaterial();
+		object.World = entities[i].GetTransform()->GetWorldMatrix();
+		object.WorldInverseTranspose = entities[i].GetTransform()->GetWorldInverseTransposeMatrix();
+		object.ColorTint = material->GetColorTint();
+		object.Roughness = material->GetRoughness();
+		object.Pipeline = pipeline;
+		object.Material = withMaterials ? material->GetId() : DrawObject::NoMaterial;
+		object.Mesh = i;
+		object.IndexCount = entities[i].GetMesh()->GetIndexCount();
 	}
-	pixelShader->SetSamplerState("ShadowSampler", shadowSampler);
+}
 
-	//Copy the data to the buffer at the start of the frame
-	vertexShader->CopyAllBufferData();
-	pixelShader->CopyAllBufferData();
+//Every entity casts (and receives), so each one's bounds go in - and whether it's dynamic, and moved since last frame
+void Game::GatherShadowCasters() {
+	shadowCasters.resize(entities.size());
+	castersDynamic.resize(entities.size());
+	castersMoved.assign(entities.size(), true);
+	casterWorlds.resize(entities.size());
+	for (size_t i = 0; i < entities.size(); i++) {
+		entities[i].GetWorldBounds(shadowCasters[i].Center, shadowCasters[i].Radius);
+		castersDynamic[i] = entities[i].IsDynamic();
+		XMFLOAT4X4 world = entities[i].GetTransform()->GetWorldMatrix();
+		castersMoved[i] = memcmp(&world, &casterWorlds[i], sizeof(world)) != 0;
+		casterWorlds[i] = world;
+	}
+}
+
+//Depth only, into one slice or tile - the light's matrices stand in for the camera's
+void Game::DrawShadowCasters(ID3D11DepthStencilView* depth, const RenderViewport& viewport, const XMFLOAT4X4& view,
+	const XMFLOAT4X4& projection, const vector<unsigned int>& casters) {
+	ID3D11RenderTargetView* nullRTV{};
+	Graphics::State->SetRenderTargets(1, &nullRTV, depth);
+	Graphics::State->SetRasterizerState(shadowRasterizer.Get());
+	Graphics::State->SetViewports(1, &viewport);
+	if (casters.empty())
+		return;
+
+	if (deferredSubmission) {
+		//Snapshot every draw's constants here, then record them across the workers
+		shadowVS->SetMatrix4x4("view", view);
+		shadowVS->SetMatrix4x4("projection", projection);
+		drawPackets.clear();
+		drawConstants.clear();
+		for (unsigned int caster : casters) {
+			Entity& e = entities[caster];
+			shadowVS->SetMatrix4x4("world", e.GetTransform()->GetWorldMatrix());
+			drawPackets.push_back(DrawPackets::Capture(shadowVS.get(), 0, 0, e.GetMesh().get(), drawConstants));
+		}
+
+		ID3D11RasterizerState* rasterizer = shadowRasterizer.Get();
+		SubmissionStats stats = SubmitDrawPackets([&](ID3D11DeviceContext* context) {
+			context->OMSetRenderTargets(1, &nullRTV, depth);
+			context->RSSetState(rasterizer);
+			context->RSSetViewports(1, (const D3D11_VIEWPORT*)&viewport);
+		});
+		//Every slice's (and tile's) submission adds up into the pass's
+		shadowSubmission.Draws += stats.Draws;
+		shadowSubmission.Lists += stats.Lists;
+		shadowSubmission.Threads = max(shadowSubmission.Threads, stats.Threads);
+		shadowSubmission.RecordMilliseconds += stats.RecordMilliseconds;
+		shadowSubmission.ExecuteMilliseconds += stats.ExecuteMilliseconds;
+	}
+	else {
+		DrawFrameConstants frame = {};
+		frame.View = view;
+		frame.Projection = projection;
+		GatherDrawObjects(1, false);
+		//Casters are in entity order, so they can be packed down in place
+		for (size_t k = 0; k < casters.size(); k++)
+			drawObjects[k] = drawObjects[casters[k]];
+		drawObjects.resize(casters.size());
+		commandBuffer.Clear();
+		drawListBuilder.Build(drawObjects, frame, commandBuffer, false);
+		commandExecutor.Execute(commandBuffer);
+	}
+}
+
+// --------------------------------------------------------
+// Records drawPackets across the submitter's threads and
+// runs the lists in order.  Executing a list leaves the
+// immediate context at its defaults, so the state cache is
+// reset and the topology (set once at start up) re-set.
+// --------------------------------------------------------
+SubmissionStats Game::SubmitDrawPackets(std::function<void(ID3D11DeviceContext*)> setup) {
+	commandLists->SetListSetup([&](ID3D11DeviceContext* context) {
+		context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		setup(context);
+	});
+
+	SubmissionStats stats = submitter->Submit(*commandLists, (unsigned int)drawPackets.size(),
+		[&](unsigned int context, unsigned int draw) {
+			DrawPackets::Record(commandLists->GetContext(context), drawPackets[draw], drawConstants);
+		},
+		(unsigned int)minDrawsPerList);
+	commandLists->SetListSetup(nullptr);
+
+	Graphics::State->Invalidate();
+	Graphics::Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	return stats;
 }
 
 #pragma region ImGui Code
@@ -540,6 +1145,32 @@ void Game::UpdateImGui(float deltaTime) {
 }
 
 //Handle all UI-related updating logic here
+// --------------------------------------------------------
+// What texture streaming needs from a camera and the scene
+// --------------------------------------------------------
+StreamingCamera Game::GetStreamingCamera(Camera& camera) {
+	StreamingCamera view;
+	view.Position = camera.GetTransform().GetPosition();
+	view.Forward = camera.GetTransform().GetForward();
+	view.VerticalFov = camera.GetFov();
+	view.ScreenHeight = (float)Window::Height();
+	view.IsOrthographic = camera.IsOrthographic();
+	return view;
+}
+
+vector<StreamingObject> Game::GatherStreamingObjects() {
+	vector<StreamingObject> objects(entities.size());
+	for (size_t i = 0; i < entities.size(); i++) {
+		entities[i].GetWorldBounds(objects[i].Center, objects[i].Radius);
+		objects[i].WorldUnitsPerUv = entities[i].GetWorldUnitsPerUv();
+		for (auto& texture : entities[i].GetMaterial()->GetTextures()) {
+			int index = TextureStreamer::Find(texture.get());
+			if (index >= 0) objects[i].Textures.push_back(index);
+		}
+	}
+	return objects;
+}
+
 void Game::BuildUI() {
 	//Framerate: Uses a float placeholder to display the value accurately
 	ImGui::Text("Framerate: %f FPS", ImGui::GetIO().Framerate);
@@ -547,6 +1178,12 @@ void Game::BuildUI() {
 	//Window Resolution: Display as 2 decimal integers.
 	ImGui::Text("Window Resolution: %dx%d", Window::Width(), Window::Height());
 
+	//Shaders hot reloaded since startup (see ShaderHotReload)
+	if (shaderHotReload && shaderHotReload->GetReloadCount() > 0)
+		ImGui::Text("Shader reloads: %u, last %s", shaderHotReload->GetReloadCount(), shaderHotReload->GetLastReloaded().c_str());
+	if (shaderHotReload && !shaderHotReload->GetLastError().empty())
+		ImGui::TextWrapped("Shader recompile failed, still running the last good one - %s", shaderHotReload->GetLastError().c_str());
+
 	//Window for Mesh Data
 	ImGui::Begin("Mesh Data");
 	
@@ -576,16 +1213,52 @@ void Game::BuildUI() {
 	}
 	ImGui::End();
 
-	ImGui::Begin("Point Light Control");
-	for (int i = 1; i < 2; i++) {
+	ImGui::Begin("Point & Spot Light Control");
+	for (int i = 1; i < lights.size(); i++) {
 		ImGui::PushID(i);
 		ImGui::Text(lightNames[i]);
 		ImGui::SliderFloat3("Position", &lights[i].position.x, -10.0f, 10.0f);
+		ImGui::SliderFloat("Range", &lights[i].range, 1.0f, 30.0f);
+		if (lights[i].type == LIGHT_TYPE_SPOT) {
+			ImGui::SliderFloat3("Direction", &lights[i].direction.x, -1.0f, 1.0f);
+			ImGui::SliderAngle("Cone", &lights[i].spotAngle, 5.0f, 150.0f);
+		}
 		ImGui::PopID();
 	}
 	ImGui::End();
 
-	ImGui::Image(shadowSRV.Get(), ImVec2(256, 256));
+	//Each light's share of the atlas follows how much of the screen it lights
+	ImGui::Begin("Shadow Atlas");
+	const ShadowAtlasStats& atlasStats = shadowAtlas.GetStats();
+	ImGui::Text("This frame: %u kept, %u placed, %u dropped%s", atlasStats.Kept, atlasStats.Placed, atlasStats.Dropped,
+		atlasStats.Repacked ? ", repacked" : "");
+	ImGui::Text("%.0f%% of the atlas in use", 100.0 * atlasStats.UsedArea / ((double)shadowAtlas.GetSettings().Size * shadowAtlas.GetSettings().Size));
+	for (const ShadowRequest& request : localShadowRequests) {
+		unsigned int tileSize = 0;
+		for (auto& face : localShadowFaces) {
+			if (face.Light == request.Light) { tileSize = face.Tile.Size; break; }
+		}
+		if (tileSize > 0) ImGui::Text("%s: importance %.3f, %u x %u per face, %u faces", lightNames[request.Light], request.Importance, tileSize, tileSize, request.Faces);
+		else ImGui::Text("%s: importance %.3f, no shadow", lightNames[request.Light], request.Importance);
+	}
+	ImGui::Image((ImTextureID)shadowAtlasSRV.Get(), ImVec2(256, 256));
+	ImGui::End();
+
+	//The cascades live in an array texture, so show what each one covers instead of the map itself
+	ImGui::Begin("Shadow Cascades");
+	ImGui::SliderFloat("Split Lambda", &cascadeSettings.Lambda, 0.0f, 1.0f);
+	ImGui::SliderFloat("Shadow Distance", &cascadeSettings.ShadowDistance, 5.0f, 100.0f);
+	//Off, static casters are only redrawn when the light, the cascade's bounds or they move
+	ImGui::Checkbox("Always Redraw", &alwaysRedrawShadows);
+	ImGui::Text("This frame: %u kept, %u overlaid, %u rebuilt", shadowCache.GetStats().Kept,
+		shadowCache.GetStats().Overlaid, shadowCache.GetStats().Rebuilt);
+	for (size_t i = 0; i < shadowCascades.size(); i++) {
+		ImGui::Text("Cascade %d: %.2f to %.2f, radius %.2f, %.4f units per texel", (int)i,
+			shadowCascades[i].Near, shadowCascades[i].Far, shadowCascades[i].Radius, shadowCascades[i].TexelSize);
+		ImGui::Text("  %u receivers, %d of %d casters, depth %.1f", shadowCascades[i].Receivers,
+			(int)shadowCascades[i].Casters.size(), (int)entities.size(), shadowCascades[i].LightMax.z - shadowCascades[i].LightMin.z);
+	}
+	ImGui::End();
 
 	ImGui::Begin("Camera Control");
 	ImGui::Text("Camera %d", activeCamera);
@@ -618,5 +1291,272 @@ void Game::BuildUI() {
 	}
 
 	ImGui::SliderFloat("Blur Radius", &blurRadius, 1.0f, 10.0f);
+	ImGui::RadioButton("Gaussian", &blurMode, 0);
+	ImGui::SameLine();
+	ImGui::RadioButton("Dual Filter", &blurMode, 1);
+	ImGui::SameLine();
+	ImGui::RadioButton("Tiled Compute", &blurMode, 2);
+	if (postGraphMode == blurMode) {
+		const PostGraphPlan& plan = postGraph.GetPlan();
+		ImGui::Text("Post graph: %d passes on %d pooled targets (%u textures created so far)",
+			(int)plan.Order.size(), (int)plan.Targets.size(), postTargets->GetCreatedCount());
+	}
+	if (!postGraphError.empty()) ImGui::TextWrapped("Post process graph won't run: %s", postGraphError.c_str());
+
+	ImGui::Begin("Post Effects");
+	//Fused into the last post pass - each combination is its own shader permutation, compiled on first use
+	ImGui::Checkbox("Tonemap", &postEffects.Tonemap);
+	ImGui::SameLine();
+	ImGui::Checkbox("Auto Exposure", &postEffects.AutoExposure);
+	ImGui::SliderFloat("Exposure", &postEffects.Exposure, 0.1f, 4.0f);
+	ImGui::Checkbox("Color Grade", &postEffects.ColorGrade);
+	ImGui::SliderFloat("Saturation", &postEffects.Saturation, 0.0f, 2.0f);
+	ImGui::SliderFloat("Contrast", &postEffects.Contrast, 0.5f, 2.0f);
+	ImGui::Checkbox("Tint", &postEffects.Tint);
+	ImGui::ColorEdit3("Tint Color", &postEffects.TintColor.x);
+	ImGui::Checkbox("Gamma", &postEffects.Gamma);
+	ImGui::SliderFloat("Gamma Value", &postEffects.GammaValue, 0.5f, 3.0f);
+	ImGui::Checkbox("Vignette", &postEffects.Vignette);
+	ImGui::SliderFloat("Vignette Strength", &postEffects.VignetteStrength, 0.0f, 1.0f);
+	ImGui::SliderFloat("Vignette Radius", &postEffects.VignetteRadius, 0.0f, 1.0f);
+	ImGui::Checkbox("Invert", &postEffects.Invert);
+	unsigned int postKey = PostPermutations::BuildKey(postEffects);
+	ImGui::Text("Permutation %u: %s", postKey, PostPermutations::Describe(postKey).c_str());
+
+	//The scene is HDR, so this is what decides how bright it ends up
+	ImGui::Separator();
+	ImGui::SliderFloat("Key Value", &autoExposure.KeyValue, 0.05f, 0.5f);
+	ImGui::SliderFloat("Adapt To Bright", &autoExposure.AdaptToBright, 0.1f, 10.0f);
+	ImGui::SliderFloat("Adapt To Dark", &autoExposure.AdaptToDark, 0.1f, 10.0f);
+	//Reads back the GPU's histogram and adaptation each frame, then replays them through AutoExposure
+	if (ImGui::Button("Record 120 Frames") && exposureFramesToRecord == 0) {
+		exposureRecording.clear();
+		exposureFramesToRecord = 120;
+	}
+	if (exposureFramesToRecord > 0) ImGui::Text("Recording... %d frames left", exposureFramesToRecord);
+	else if (exposureReplay.Frames > 0) {
+		ImGui::Text("Replayed %d frames: worst frame %.2e, worst chained %.2e",
+			exposureReplay.Frames, exposureReplay.MaxFrameError, exposureReplay.MaxChainError);
+		ImGui::Text("Adapted luminance %.3f, exposure %.3f", exposureRecording.back().AdaptedLuminance,
+			AutoExposure::Exposure(exposureRecording.back().AdaptedLuminance, autoExposure));
+	}
+	ImGui::End();
+
+	ImGui::Begin("Texture Loading");
+	ImGui::Text("Decode threads: %u", TextureLoader::ThreadCount());
+	ImGui::Text("Pending loads: %d", TextureLoader::PendingCount());
+	for (const string& error : TextureLoader::Errors()) ImGui::TextWrapped("%s", error.c_str());
+	if (ImGui::Button("Benchmark Decode")) {
+		//Every bundled texture (each PNG under Assets/Textures), decoded once serially and once on as many threads as the pool
+		decodeBenchmark = PngDecoder::Benchmark(FixPath(L"../../Assets/Textures"), TextureLoader::ThreadCount());
+	}
+	if (decodeBenchmark.FileCount > 0) {
+		ImGui::Text("%d files, %.1f megapixels", decodeBenchmark.FileCount, decodeBenchmark.Megapixels);
+		ImGui::Text("Serial: %.1f ms", decodeBenchmark.SerialMilliseconds);
+		ImGui::Text("Parallel (%d threads): %.1f ms", decodeBenchmark.ThreadCount, decodeBenchmark.ParallelMilliseconds);
+		ImGui::Text("Speedup: %.2fx", decodeBenchmark.SerialMilliseconds / max(decodeBenchmark.ParallelMilliseconds, 0.001));
+	}
+	if (ImGui::Button("Benchmark Mips")) {
+		//Full sRGB chain for the albedo, with each kernel
+		DecodedImage image;
+		if (PngDecoder::DecodeFile(FixPath(L"../../Assets/Textures/cobblestone/albedo.png"), image))
+			mipBenchmark = MipGenerator::Benchmark(image, MipColorSpace::SRGB);
+	}
+	if (mipBenchmark.Megapixels > 0) {
+		ImGui::Text("Mip chain: %.2f megapixels filtered", mipBenchmark.Megapixels);
+		ImGui::Text("Box scalar: %.1f ms, Box SSE: %.1f ms, Kaiser SSE: %.1f ms",
+			mipBenchmark.ScalarMilliseconds, mipBenchmark.SimdMilliseconds, mipBenchmark.KaiserMilliseconds);
+	}
+	if (ImGui::Button("Benchmark Blur")) {
+		//The old box and the separable Gaussian on the CPU, at the current radius
+		DecodedImage image;
+		if (PngDecoder::DecodeFile(FixPath(L"../../Assets/Textures/cobblestone/albedo.png"), image))
+			blurBenchmark = GaussianBlur::Benchmark(image, blurRadius);
+	}
+	if (blurBenchmark.Width > 0) {
+		ImGui::Text("Blur %ux%u, radius %.1f: box %d fetches/pixel, Gaussian %d, merged taps %d", blurBenchmark.Width, blurBenchmark.Height,
+			blurBenchmark.Radius, blurBenchmark.BoxFetches, blurBenchmark.GaussianFetches, blurBenchmark.LinearFetches);
+		ImGui::Text("Box: %.1f ms, Gaussian: %.1f ms, merged taps: %.1f ms, max difference %g",
+			blurBenchmark.BoxMilliseconds, blurBenchmark.GaussianMilliseconds, blurBenchmark.LinearMilliseconds, blurBenchmark.MaxDifference);
+	}
+	if (ImGui::Button("Benchmark Compression")) {
+		//Round trip the albedo through every block format
+		DecodedImage image;
+		compressionBenchmark.clear();
+		if (PngDecoder::DecodeFile(FixPath(L"../../Assets/Textures/cobblestone/albedo.png"), image))
+			for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 })
+				compressionBenchmark.push_back(BlockCompression::Measure(image, format));
+	}
+	for (auto& result : compressionBenchmark) {
+		const char* names[] = { "RGBA8", "BC1", "BC4", "BC5", "BC7" };
+		ImGui::Text("%s: %.1f dB PSNR, %.1f ms (%.1f MP/s)", names[(int)result.Format], result.Psnr, result.Milliseconds, result.MegapixelsPerSecond);
+	}
+
+	const BindingTable& bindings = entities[0].GetMaterial()->GetBindingTable();
+	ImGui::Text("Materials: %d registered, %d duplicates shared", (int)materialRegistry.Count(), materialRegistry.GetHitCount());
+	ImGui::Text("Last frame: %d draws, %d distinct materials, %d binds (%d unsorted), %d calls each",
+		materialBatchStats.Draws, materialBatchStats.DistinctMaterials, materialBatchStats.Transitions,
+		materialBatchStats.UnsortedTransitions, (int)BindingTables::CallCount(bindings));
+	for (auto& name : bindings.UnusedTextures)
+		ImGui::Text("Texture %s isn't used by the shader", name.c_str());
+
+	StreamingStats streaming = TextureStreamer::GetStats();
+	if (ImGui::SliderFloat("Streaming Budget (MB)", &streamingBudgetMegabytes, 0.25f, 64.0f))
+		TextureStreamer::SetBudget((size_t)(streamingBudgetMegabytes * 1024 * 1024));
+	ImGui::Text("Streamed textures: %d, resident %.2f / %.2f MB", streaming.TextureCount,
+		streaming.ResidentBytes / (1024.0 * 1024.0), streaming.BudgetBytes / (1024.0 * 1024.0));
+	ImGui::Text("Last update: %d uploads, %d evictions, %d waiting", streaming.UploadsLastUpdate, streaming.EvictionsLastUpdate, streaming.PendingUploads);
+	if (ImGui::Button("Simulate Streaming")) {
+		//Dolly from the first camera's start up to the objects, then turn away from them
+		Camera& start = *cameras[0];
+		vector<StreamingCamera> path;
+		for (int frame = 0; frame < 300; frame++) {
+			StreamingCamera view = GetStreamingCamera(start);
+			view.Position.z += min(frame, 200) * 0.14f;
+			if (frame >= 200) view.Forward = XMFLOAT3(-view.Forward.x, -view.Forward.y, -view.Forward.z);
+			path.push_back(view);
+		}
+		streamingSimulation = StreamingPolicy::Simulate(TextureStreamer::GetTextures(), GatherStreamingObjects(), path, TextureStreamer::GetBudget());
+	}
+	if (streamingSimulation.Frames > 0) {
+		ImGui::Text("%d frames, peak %.2f MB, %d over budget", streamingSimulation.Frames, streamingSimulation.PeakBytes / (1024.0 * 1024.0), streamingSimulation.FramesOverBudget);
+		ImGui::Text("%d uploads, %d evictions, %d priority inversions", streamingSimulation.Uploads, streamingSimulation.Evictions, streamingSimulation.Inversions);
+		ImGui::Text("Average mip deficit: %.2f levels", streamingSimulation.AverageMipDeficit);
+	}
+	ImGui::End();
+
+	ImGui::Begin("Render State");
+	const char* categoryNames[] = { "Shaders", "Constant Buffers", "Shader Resources", "Samplers", "Render Targets", "Rasterizer", "Depth Stencil", "Viewports" };
+	ImGui::Text("Last frame: %u state calls, %u reached the context", renderStateCounters.TotalRequested(), renderStateCounters.TotalForwarded());
+	for (int i = 0; i < (int)RenderStateCategory::Count; i++)
+		ImGui::Text("%s: %u / %u", categoryNames[i], renderStateCounters.Forwarded[i], renderStateCounters.Requested[i]);
+
+	ImGui::Separator();
+	if (ImGui::Button("Benchmark Headless Frames")) {
+		//The same update and draw list work at scale, against the null executor
+		headlessBenchmark.clear();
+		for (unsigned int count : { 10000u, 100000u }) {
+			HeadlessScene scene(count, vertexShader->GetReflection(), pixelShader->GetReflection());
+			NullCommandExecutor executor;
+			headlessBenchmark.push_back(scene.Run(10, executor));
+		}
+	}
+	for (auto& result : headlessBenchmark)
+		ImGui::Text("%u entities (%u visible): %.2f ms/frame (update %.2f, cull %.2f, draw list %.2f, execute %.2f), %.1f MB of commands", result.Entities, result.Visible,
+			result.FrameMilliseconds, result.UpdateMilliseconds, result.CullMilliseconds, result.BuildMilliseconds, result.ExecuteMilliseconds, result.CommandBytes / (1024.0 * 1024.0));
+	if (ImGui::Button("Benchmark Camera Path")) {
+		//Fixed time step along a path through this scene's cameras, saved next to the executable
+		BenchmarkSettings settings;
+		for (auto& camera : cameras) {
+			CameraKey key;
+			key.Position = camera->GetTransform().GetPosition();
+			key.Rotation = camera->GetTransform().GetRotation();
+			key.Fov = camera->GetFov();
+			key.IsOrthographic = camera->IsOrthographic();
+			settings.Path.push_back(key);
+		}
+		settings.AspectRatio = Window::AspectRatio();
+		pathBenchmark = FrameBenchmark::Run(settings, vertexShader->GetReflection(), pixelShader->GetReflection());
+
+		//The headless run has no GPU, so the report carries the GPU pass times of the last few hundred live frames
+		map<string, vector<double>> gpuTimes;
+		for (auto& frame : gpuTimers->GetHistory()) {
+			gpuTimes["Frame"].push_back(frame.Milliseconds);
+			for (auto& pass : frame.Passes) gpuTimes[pass.Name].push_back(pass.Milliseconds);
+		}
+		for (auto& pass : gpuTimes) pathBenchmark.GpuPasses.push_back({ pass.first, FrameBenchmark::Summarize(pass.second) });
+		pathBenchmarkSaved = FrameBenchmark::Save(pathBenchmark, FixPath("benchmark"));
+	}
+	if (!pathBenchmark.Frames.empty()) {
+		ImGui::Text("%u entities, %u frames%s", pathBenchmark.Settings.EntityCount, (unsigned int)pathBenchmark.Frames.size(), pathBenchmarkSaved ? ", saved to benchmark.json/.csv" : "");
+		const char* partNames[] = { "Update", "Cull", "Draw List", "Execute", "Total" };
+		BenchmarkStats* parts[] = { &pathBenchmark.Update, &pathBenchmark.Cull, &pathBenchmark.Build, &pathBenchmark.Execute, &pathBenchmark.Total };
+		for (int i = 0; i < 5; i++)
+			ImGui::Text("%s: p50 %.3f, p95 %.3f, p99 %.3f, max %.3f ms", partNames[i], parts[i]->P50, parts[i]->P95, parts[i]->P99, parts[i]->Max);
+	}
+	ImGui::Checkbox("Record Draws on Worker Threads", &deferredSubmission);
+	ImGui::SliderInt("Min Draws per List", &minDrawsPerList, 1, 64);
+	ImGui::Text("%u worker threads, %s command lists", submitter->GetThreadCount(), commandLists->HasDriverCommandLists() ? "driver" : "emulated");
+	if (deferredSubmission) {
+		for (SubmissionStats* stats : { &shadowSubmission, &mainSubmission })
+			ImGui::Text("%s: %u draws in %u lists on %u threads, record %.3f ms, execute %.3f ms", stats == &shadowSubmission ? "Shadow" : "Main",
+				stats->Draws, stats->Lists, stats->Threads, stats->RecordMilliseconds, stats->ExecuteMilliseconds);
+	}
+	ImGui::End();
+
+	ImGui::Begin("GPU Passes");
+	const GpuTimerStats& gpuStats = gpuTimers->GetStats();
+	const GpuFrameTimings& gpuFrame = gpuTimers->GetLatest();
+	ImGui::Text("Frame %llu: %.3f ms (read back %u frames late)", gpuFrame.Frame, gpuFrame.Milliseconds, gpuStats.Latency);
+	for (auto& pass : gpuFrame.Passes)
+		ImGui::Text("%*s%s: %.3f ms", pass.Depth * 2, "", pass.Name.c_str(), pass.Milliseconds);
+	ImGui::Text("%llu frames timed, %llu skipped (queries still in flight), %llu disjoint", gpuStats.FramesResolved, gpuStats.FramesSkipped, gpuStats.FramesDisjoint);
+	ImGui::End();
+
+	BuildProfilerUI();
+}
+
+//Flame view of the last complete frame's CPU zones - one band per thread, one row per depth
+void Game::BuildProfilerUI() {
+	ImGui::Begin("CPU Profiler");
+	bool enabled = Profiler::IsEnabled();
+	if (ImGui::Checkbox("Record Zones", &enabled)) Profiler::SetEnabled(enabled);
+	ImGui::SameLine();
+	ImGui::Checkbox("Pause", &profilerPaused);
+	ImGui::SameLine();
+	if (ImGui::Button("Save Chrome Trace")) {
+		profilerStatus = Profiler::SaveChromeTrace(FixPath("profile.json")) ? "Saved profile.json" : "Couldn't write profile.json";
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Measure Zone Overhead")) {
+		profilerOverhead = Profiler::MeasureZoneOverhead(1000000);
+		profilerStatus = "";
+	}
+	if (profilerOverhead > 0) ImGui::Text("%.1f ns per zone", profilerOverhead);
+	if (!profilerStatus.empty()) ImGui::Text("%s", profilerStatus.c_str());
+
+	if (!profilerPaused && Profiler::GetLastFrame(profilerFrameStart, profilerFrameEnd))
+		profilerCapture = Profiler::Capture(profilerFrameStart, profilerFrameEnd);
+	if (profilerCapture.empty()) {
+		ImGui::End();
+		return;
+	}
+
+	double frameMicroseconds = Profiler::TicksToMicroseconds(profilerFrameEnd - profilerFrameStart);
+	ImGui::Text("Frame: %.3f ms", frameMicroseconds / 1000.0);
+
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	float width = ImGui::GetContentRegionAvail().x;
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	for (auto& thread : profilerCapture) {
+		ImGui::Text("%s", thread.Name.c_str());
+		unsigned int rows = 1;
+		for (auto& e : thread.Events) rows = max(rows, e.Depth + 1);
+
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImGui::InvisibleButton(thread.Name.c_str(), ImVec2(width, rows * rowHeight));
+		for (auto& e : thread.Events) {
+			//Zones straddling the frame's edges are clipped to it
+			uint64_t start = max(e.Start, profilerFrameStart);
+			uint64_t end = min(e.End, profilerFrameEnd);
+			float x0 = origin.x + width * (float)(Profiler::TicksToMicroseconds(start - profilerFrameStart) / frameMicroseconds);
+			float x1 = origin.x + width * (float)(Profiler::TicksToMicroseconds(end - profilerFrameStart) / frameMicroseconds);
+			x1 = max(x1, x0 + 1.0f);
+			ImVec2 topLeft(x0, origin.y + e.Depth * rowHeight);
+			ImVec2 bottomRight(x1, topLeft.y + rowHeight - 1.0f);
+
+			//Color by name, so a zone keeps its color from frame to frame
+			size_t hash = std::hash<string>()(e.Name);
+			ImU32 color = IM_COL32(80 + hash % 128, 80 + (hash >> 8) % 128, 80 + (hash >> 16) % 128, 255);
+			drawList->AddRectFilled(topLeft, bottomRight, color);
+
+			double milliseconds = Profiler::TicksToMicroseconds(e.End - e.Start) / 1000.0;
+			if (x1 - x0 > ImGui::CalcTextSize(e.Name).x + 4.0f)
+				drawList->AddText(ImVec2(x0 + 2.0f, topLeft.y), IM_COL32_WHITE, e.Name);
+			if (ImGui::IsMouseHoveringRect(topLeft, bottomRight))
+				ImGui::SetTooltip("%s: %.3f ms", e.Name, milliseconds);
+		}
+	}
+	ImGui::End();
 }
 #pragma endregion
\ No newline at end of file
@@ -6,10 +6,32 @@
 #include "Light.h"
 #include "WICTextureLoader.h"
 #include "Sky.h"
+#include "ShaderHotReload.h"
+#include "TextureLoader.h"
+#include "GaussianBlur.h"
+#include "DualFilterBlur.h"
+#include "TiledPostProcess.h"
+#include "PostEffects.h"
+#include "AutoExposure.h"
+#include "CascadedShadows.h"
+#include "ShadowCache.h"
+#include "LocalShadows.h"
+#include "D3D11PostTargetPool.h"
+#include "TextureStreamer.h"
+#include "MaterialRegistry.h"
+#include "D3D11CommandLists.h"
+#include "D3D11CommandExecutor.h"
+#include "D3D11GpuQuerySource.h"
+#include "DrawListBuilder.h"
+#include "HeadlessScene.h"
+#include "FrameBenchmark.h"
+#include "Profiler.h"
 
 #include <d3d11.h>
 #include <wrl/client.h>
 #include <DirectXMath.h>
+#include <functional>
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -32,18 +54,74 @@ public:
 
 private:
 	int number;
-	int shadowMapResolution = 512;
 	float displayColor[4] = { 0.2f, 0.0f, 0.2f, 0.0f };
 	float colorTint[4] = { 1.0f, 1.0f, 0.5f, 1.0f };
 	bool isDemoVisible = true;
-	bool isBlurry = false;
+	bool isBlurry = false;	// The scene always goes through the post process (it's HDR) - this adds the blur
 	vector<Entity> entities;
 	vector<Light> lights;
 	vector<const char*> lightNames;
 	float movementSpeed = 0.1f;
 	float blurRadius = 1.0f;
+	int blurMode = 0;		// 0 = separable Gaussian, 1 = dual filter, 2 = tiled compute (blur and tonemap in one dispatch)
+	DecodeBenchmarkResult decodeBenchmark;
+	MipBenchmarkResult mipBenchmark;
+	BlurBenchmarkResult blurBenchmark;
+	PostEffectSettings postEffects;
+	AutoExposureSettings autoExposure;
+	vector<AutoExposureFrame> exposureRecording;
+	int exposureFramesToRecord = 0;
+	AutoExposureReplay exposureReplay;
+	CascadeSettings cascadeSettings;
+	vector<ShadowCascade> shadowCascades;
+	ShadowCascadeData shadowCascadeData;
+	vector<ShadowCaster> shadowCasters;
+	vector<DirectX::XMFLOAT4X4> casterWorlds;	// As of last frame, to tell which casters moved
+	vector<bool> castersDynamic;
+	vector<bool> castersMoved;
+	ShadowCache shadowCache;					// What each slice of the shadow map (and its static cache) holds
+	bool alwaysRedrawShadows = false;
+	ShadowAtlas shadowAtlas;					// Tiles for the point and spot lights, kept from frame to frame
+	vector<ShadowRequest> localShadowRequests;
+	vector<LocalShadowFace> localShadowFaces;
+	LocalShadowData localShadowData = {};
+	vector<CompressionResult> compressionBenchmark;
+	float streamingBudgetMegabytes = 16.0f;
+	StreamingSimulationResult streamingSimulation;
 	std::shared_ptr<Sky> skyBox;
 
+	// Multithreaded submission - draws snapshotted into packets, recorded into deferred contexts
+	std::unique_ptr<ParallelSubmitter> submitter;
+	std::unique_ptr<D3D11CommandListBackend> commandLists;
+	bool deferredSubmission = false;
+	int minDrawsPerList = 8;
+	vector<DrawPacket> drawPackets;
+	vector<unsigned char> drawConstants;
+	SubmissionStats shadowSubmission;
+	SubmissionStats mainSubmission;
+
+	// Serial submission - draw lists built into a command buffer, then executed on the device
+	// Pipeline handles: 0 is the lit entity pipeline, 1 the depth-only shadow pipeline
+	D3D11CommandExecutor commandExecutor;
+	DrawListBuilder drawListBuilder;
+	CommandBuffer commandBuffer;
+	vector<DrawObject> drawObjects;
+	vector<HeadlessFrameResult> headlessBenchmark;
+	BenchmarkReport pathBenchmark;
+	bool pathBenchmarkSaved = false;
+
+	// GPU pass timing - see GpuTimerRing
+	std::unique_ptr<D3D11GpuQuerySource> gpuQueries;
+	std::unique_ptr<GpuTimerRing> gpuTimers;
+
+	// CPU profiler view - the last complete frame, held while paused
+	bool profilerPaused = false;
+	vector<ProfileThread> profilerCapture;
+	uint64_t profilerFrameStart = 0;
+	uint64_t profilerFrameEnd = 0;
+	double profilerOverhead = 0;
+	string profilerStatus;
+
 	// Initialization helper methods - feel free to customize, combine, remove, etc.
 	void LoadShaders();
 	void CreateGeometry();
@@ -51,8 +129,29 @@ private:
 	void SetupPostProcesses();
 	void UpdateImGui(float deltaTime);
 	void BuildUI();
+	void BuildProfilerUI();
 	void ConstructShaderData(Entity currentEntity, float totalTime);
-	void PostRender();
+	StreamingCamera GetStreamingCamera(Camera& camera);
+	vector<StreamingObject> GatherStreamingObjects();
+	void CreateSceneTargets();
+	void PostRender(float deltaTime);
+	void UpdateAutoExposure(float deltaTime);
+	void ReadBackExposureFrame(float deltaTime);
+	void BuildPostGraph(int mode, unsigned int dualFilterLevels);
+	void AddPostPass(const char* name, const vector<int>& inputs, int output, PostProcessGraph::PassFunction draw);
+	void AddGaussianPasses(int source, int output);
+	void AddDualFilterPasses(int source, int output, unsigned int levels);
+	void AddOutputPass(int source, int output);
+	std::shared_ptr<SimplePixelShader> GetPostEffectsShader(const std::wstring& shaderName);
+	void SetPostEffectVariables(ISimpleShader* shader);
+	void RenderTiledPostProcess();
+	SubmissionStats SubmitDrawPackets(std::function<void(ID3D11DeviceContext*)> setup);
+	void RegisterDrawResources();
+	void RegisterDrawPipelines();
+	void GatherDrawObjects(unsigned int pipeline, bool withMaterials);
+	void GatherShadowCasters();
+	void DrawShadowCasters(ID3D11DepthStencilView* depth, const RenderViewport& viewport, const DirectX::XMFLOAT4X4& view,
+		const DirectX::XMFLOAT4X4& projection, const vector<unsigned int>& casters);
 
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
@@ -63,42 +162,68 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
 
-	// Textures
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> albedo;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> normalMap;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughnessMap;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> metalnessMap;
+	// Textures (loaded in the background, see TextureLoader)
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState;
 
-	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textures;
-	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11SamplerState>> samplers;
+	MaterialRegistry materialRegistry;
+	MaterialBatchStats materialBatchStats;
+	RenderStateCounters renderStateCounters;
 
 	// Shaders and shader-related constructs
 	std::shared_ptr<SimplePixelShader> pixelShader;
 	std::shared_ptr<SimpleVertexShader> vertexShader;
+	std::unique_ptr<ShaderHotReload> shaderHotReload;
 
 	vector<std::shared_ptr<Camera>> cameras;
 	int activeCamera;
 
 	// Shadow mapping data
-	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowDSV;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowTexture;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> staticShadowTexture;	// Static casters only, copied into shadowTexture before the dynamic ones draw
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowDSVs[CascadedShadows::MaxCascades];	// One per slice of the array
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> staticShadowDSVs[CascadedShadows::MaxCascades];
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowSRV;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowAtlasDSV;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowAtlasSRV;
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> shadowRasterizer;
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> shadowSampler;
 	std::shared_ptr<SimpleVertexShader> shadowVS;
-	DirectX::XMFLOAT4X4 shadowViewMatrix;
-	DirectX::XMFLOAT4X4 shadowProjectionMatrix;
 
 	// Post Processing data
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> postProcessSampler;
 	std::shared_ptr<SimpleVertexShader> postProcessShader;
 
+	// The HDR scene every post process path reads from (see CreateSceneTargets)
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> sceneRenderTargetView;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> sceneShaderResourceView;
+
 	std::shared_ptr<SimplePixelShader> blurPixelShader;
-	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> blurRenderTargetView;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> blurShaderResourceView;
-	
-	std::shared_ptr<SimplePixelShader> invertPixelShader;
-	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> invertRenderTargetView;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> invertShaderResourceView;
+	std::shared_ptr<SimplePixelShader> dualFilterDownShader;
+	std::shared_ptr<SimplePixelShader> dualFilterUpShader;
+
+	// Compute path - written by the dispatch, then copied to the back buffer
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> tiledPostTexture;
+	Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> tiledPostUAV;
+
+	// Auto exposure - the histogram is counted and cleared on the GPU each frame, and the
+	// adapted exposure stays there for the tonemap to read (staging copies are for recording)
+	std::shared_ptr<SimpleComputeShader> luminanceHistogramShader;
+	std::shared_ptr<SimpleComputeShader> exposureShader;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> histogramBuffer;
+	Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> histogramUAV;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> exposureBuffer;
+	Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> exposureUAV;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> exposureSRV;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> histogramStaging;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> exposureStaging[2];	// Before and after the adaptation
+
+	// The passes between the scene and the back buffer, rebuilt when the blur mode changes
+	PostProcessGraph postGraph;
+	std::unique_ptr<D3D11PostTargetPool> postTargets;
+	int postGraphMode = -1;		// blurMode it was built for, or 3 for no blur (just the output pass)
+	unsigned int postGraphLevels = 0;
+	int postSceneResource = -1;
+	int postBackBufferResource = -1;
+	std::string postGraphError;	// Why the graph last failed to compile, shown with the blur settings
 };
 
@@ -0,0 +1,187 @@
+#include "GaussianBlur.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+	// Offsets past this couldn't be merged into MaxTaps taps
+	const int MaxOffset = 2 * (GaussianBlur::MaxTaps - 1);
+
+	const float* Texel(const float* src, unsigned int width, unsigned int height, int x, int y)
+	{
+		x = min(max(x, 0), (int)width - 1);
+		y = min(max(y, 0), (int)height - 1);
+		return src + ((size_t)y * width + x) * 4;
+	}
+}
+
+vector<float> GaussianBlur::Weights(float radius)
+{
+	// A box of radius r has variance r(r+1)/3, and 3 sigma covers all but ~0.3%
+	radius = max(radius, 0.0f);
+	float sigma = sqrtf(radius * (radius + 1) / 3.0f);
+	int extent = min((int)ceilf(3 * sigma), MaxOffset);
+	if (extent == 0)
+		return { 1.0f };
+
+	vector<float> weights(extent + 1);
+	float total = 0;
+	for (int i = 0; i <= extent; i++)
+	{
+		weights[i] = expf(-(float)(i * i) / (2 * sigma * sigma));
+		total += i == 0 ? weights[i] : 2 * weights[i];
+	}
+	for (float& weight : weights)
+		weight /= total;
+	return weights;
+}
+
+vector<GaussianTap> GaussianBlur::LinearTaps(float radius)
+{
+	vector<float> weights = Weights(radius);
+	vector<GaussianTap> taps;
+	taps.push_back({ 0, weights[0] });
+
+	// Texels i and i+1 share a tap at their weighted average position - bilinear
+	// filtering there gives each back its own weight.  An odd one out at the end
+	// gets a tap to itself.
+	for (size_t i = 1; i < weights.size(); i += 2)
+	{
+		float a = weights[i];
+		float b = i + 1 < weights.size() ? weights[i + 1] : 0.0f;
+		GaussianTap tap;
+		tap.Weight = a + b;
+		tap.Offset = (i * a + (i + 1) * b) / tap.Weight;
+		taps.push_back(tap);
+	}
+	return taps;
+}
+
+void GaussianBlur::BlurPass(const float* src, unsigned int width, unsigned int height, float* dst, const vector<float>& weights, bool vertical)
+{
+	int stepX = vertical ? 0 : 1;
+	int stepY = vertical ? 1 : 0;
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			float total[4] = {};
+			for (int i = -(int)weights.size() + 1; i < (int)weights.size(); i++)
+			{
+				const float* texel = Texel(src, width, height, (int)x + i * stepX, (int)y + i * stepY);
+				float weight = weights[abs(i)];
+				for (int c = 0; c < 4; c++)
+					total[c] += texel[c] * weight;
+			}
+
+			float* out = dst + ((size_t)y * width + x) * 4;
+			for (int c = 0; c < 4; c++)
+				out[c] = total[c];
+		}
+	}
+}
+
+void GaussianBlur::BlurPassLinear(const float* src, unsigned int width, unsigned int height, float* dst, const vector<GaussianTap>& taps, bool vertical)
+{
+	int stepX = vertical ? 0 : 1;
+	int stepY = vertical ? 1 : 0;
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			float total[4] = {};
+			for (size_t t = 0; t < taps.size(); t++)
+			{
+				// A bilinear fetch along one axis: blend the two texels around the position
+				for (float side : { 1.0f, -1.0f })
+				{
+					float position = side * taps[t].Offset;
+					int first = (int)floorf(position);
+					float blend = position - first;
+					const float* a = Texel(src, width, height, (int)x + first * stepX, (int)y + first * stepY);
+					const float* b = Texel(src, width, height, (int)x + (first + 1) * stepX, (int)y + (first + 1) * stepY);
+					for (int c = 0; c < 4; c++)
+						total[c] += (a[c] + (b[c] - a[c]) * blend) * taps[t].Weight;
+
+					if (t == 0)
+						break;
+				}
+			}
+
+			float* out = dst + ((size_t)y * width + x) * 4;
+			for (int c = 0; c < 4; c++)
+				out[c] = total[c];
+		}
+	}
+}
+
+void GaussianBlur::BoxBlur(const float* src, unsigned int width, unsigned int height, float* dst, int radius)
+{
+	float scale = 1.0f / ((2 * radius + 1) * (2 * radius + 1));
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			float total[4] = {};
+			for (int dx = -radius; dx <= radius; dx++)
+			{
+				for (int dy = -radius; dy <= radius; dy++)
+				{
+					const float* texel = Texel(src, width, height, (int)x + dx, (int)y + dy);
+					for (int c = 0; c < 4; c++)
+						total[c] += texel[c];
+				}
+			}
+
+			float* out = dst + ((size_t)y * width + x) * 4;
+			for (int c = 0; c < 4; c++)
+				out[c] = total[c] * scale;
+		}
+	}
+}
+
+BlurBenchmarkResult GaussianBlur::Benchmark(const DecodedImage& image, float radius)
+{
+	BlurBenchmarkResult result;
+	result.Width = image.Width;
+	result.Height = image.Height;
+	result.Radius = radius;
+
+	size_t count = (size_t)image.Width * image.Height * 4;
+	vector<float> source(count), temporary(count), box(count), gaussian(count), linear(count);
+	for (size_t i = 0; i < count; i++)
+		source[i] = image.Pixels[i] / 255.0f;
+
+	auto milliseconds = [](chrono::steady_clock::time_point start) {
+		return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	};
+
+	// The shader truncates the radius to an int
+	int boxRadius = (int)radius;
+	result.BoxFetches = (2 * boxRadius + 1) * (2 * boxRadius + 1);
+	auto start = chrono::steady_clock::now();
+	BoxBlur(source.data(), image.Width, image.Height, box.data(), boxRadius);
+	result.BoxMilliseconds = milliseconds(start);
+
+	vector<float> weights = Weights(radius);
+	result.GaussianFetches = 2 * (2 * (int)weights.size() - 1);
+	start = chrono::steady_clock::now();
+	BlurPass(source.data(), image.Width, image.Height, temporary.data(), weights, false);
+	BlurPass(temporary.data(), image.Width, image.Height, gaussian.data(), weights, true);
+	result.GaussianMilliseconds = milliseconds(start);
+
+	vector<GaussianTap> taps = LinearTaps(radius);
+	result.LinearFetches = 2 * (2 * (int)taps.size() - 1);
+	start = chrono::steady_clock::now();
+	BlurPassLinear(source.data(), image.Width, image.Height, temporary.data(), taps, false);
+	BlurPassLinear(temporary.data(), image.Width, image.Height, linear.data(), taps, true);
+	result.LinearMilliseconds = milliseconds(start);
+
+	for (size_t i = 0; i < count; i++)
+		result.MaxDifference = max(result.MaxDifference, fabsf(gaussian[i] - linear[i]));
+	return result;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "PngDecoder.h"
+
+#include <vector>
+
+// One filter tap, mirrored: sampled at +Offset and -Offset texels
+// along the pass (the first tap sits on the center and is sampled once)
+struct GaussianTap
+{
+	float Offset = 0;
+	float Weight = 0;
+};
+
+// Timings from blurring the same image with each kernel
+struct BlurBenchmarkResult
+{
+	unsigned int Width = 0;
+	unsigned int Height = 0;
+	float Radius = 0;
+	int BoxFetches = 0;				// Per pixel, all passes
+	int GaussianFetches = 0;		// One per weight
+	int LinearFetches = 0;			// One per merged tap
+	double BoxMilliseconds = 0;		// The old (2r+1)^2 box
+	double GaussianMilliseconds = 0;
+	double LinearMilliseconds = 0;
+	float MaxDifference = 0;		// Largest difference between the two Gaussian kernels
+};
+
+// --------------------------------------------------------
+// The separable Gaussian behind PixelShaderBlur.hlsl: the
+// weights the shader is given, plus CPU versions of the
+// blur for checking and timing it without a GPU.
+//
+// The kernel's variance matches a box of the same radius,
+// so the UI's blur radius keeps its meaning.  Neighbouring
+// weights are merged into one tap placed between their
+// texels, so a single bilinear fetch reads both - about
+// half the fetches of one per weight, with the same result.
+//
+// The CPU versions work on float RGBA with clamped edges,
+// one pass (horizontal or vertical) at a time.
+// --------------------------------------------------------
+namespace GaussianBlur
+{
+	const unsigned int MaxTaps = 16;	// Must match MAX_GAUSSIAN_TAPS in PixelShaderBlur.hlsl
+
+	// Normalized weights for texel offsets 0..n (mirrored for negative offsets)
+	std::vector<float> Weights(float radius);
+
+	// Weights merged into bilinear taps - at most MaxTaps
+	std::vector<GaussianTap> LinearTaps(float radius);
+
+	// One weight per texel
+	void BlurPass(const float* src, unsigned int width, unsigned int height, float* dst, const std::vector<float>& weights, bool vertical);
+
+	// Merged taps, read with bilinear filtering the way the sampler does
+	void BlurPassLinear(const float* src, unsigned int width, unsigned int height, float* dst, const std::vector<GaussianTap>& taps, bool vertical);
+
+	// What PixelShaderBlur.hlsl used to do, for comparison
+	void BoxBlur(const float* src, unsigned int width, unsigned int height, float* dst, int radius);
+
+	// Blurs the image with each kernel and times them
+	BlurBenchmarkResult Benchmark(const DecodedImage& image, float radius);
+}
@@ -0,0 +1,136 @@
+#include "GpuTimerRing.h"
+
+#include <algorithm>
+
+using namespace std;
+
+GpuTimerRing::GpuTimerRing(IGpuQuerySource* source, unsigned int slotCount, unsigned int maxPasses) :
+	source(source),
+	slots(max(slotCount, 1u)),
+	maxPasses(maxPasses),
+	current(NoPass),
+	depth(0),
+	frame(0),
+	historyLength(600)
+{
+}
+
+void GpuTimerRing::SetHistoryLength(size_t frames)
+{
+	historyLength = frames;
+	while (history.size() > historyLength)
+		history.pop_front();
+}
+
+void GpuTimerRing::BeginFrame()
+{
+	unsigned int slot = (unsigned int)(frame % slots.size());
+	frame++;
+	depth = 0;
+
+	// The slot comes around again before the GPU finished with it -
+	// check once more, then give up on this frame rather than wait
+	if (slots[slot].State == SlotState::Pending)
+		Collect();
+	if (slots[slot].State != SlotState::Free)
+	{
+		current = NoPass;
+		stats.FramesSkipped++;
+		return;
+	}
+
+	current = slot;
+	slots[slot].State = SlotState::Recording;
+	slots[slot].Frame = frame;
+	slots[slot].Passes.clear();
+	source->BeginFrame(slot);
+}
+
+void GpuTimerRing::EndFrame()
+{
+	if (current != NoPass)
+	{
+		source->EndFrame(current);
+		slots[current].State = SlotState::Pending;
+		pending.push_back(current);
+		current = NoPass;
+	}
+
+	Collect();
+}
+
+unsigned int GpuTimerRing::BeginPass(const char* name)
+{
+	if (current == NoPass)
+		return NoPass;
+
+	Slot& slot = slots[current];
+	if (slot.Passes.size() >= maxPasses)
+	{
+		stats.PassesDropped++;
+		return NoPass;
+	}
+
+	unsigned int pass = (unsigned int)slot.Passes.size();
+	GpuPassTiming timing;
+	timing.Name = name;
+	timing.Depth = depth++;
+	slot.Passes.push_back(timing);
+	source->Timestamp(current, pass * 2);
+	return pass;
+}
+
+void GpuTimerRing::EndPass(unsigned int pass)
+{
+	if (pass == NoPass || current == NoPass)
+		return;
+
+	depth--;
+	source->Timestamp(current, pass * 2 + 1);
+}
+
+void GpuTimerRing::Collect()
+{
+	// Results arrive in submission order, so stop at the first that isn't ready
+	while (!pending.empty())
+	{
+		unsigned int index = pending.front();
+		Slot& slot = slots[index];
+		if (!source->Read(index, (unsigned int)slot.Passes.size() * 2, readBack))
+			break;
+
+		pending.pop_front();
+		slot.State = SlotState::Free;
+		stats.Latency = (unsigned int)(frame - slot.Frame);
+
+		if (readBack.Disjoint || readBack.Frequency == 0 || readBack.Timestamps.size() < slot.Passes.size() * 2)
+		{
+			stats.FramesDisjoint++;
+			continue;
+		}
+
+		GpuFrameTimings timings;
+		timings.Frame = slot.Frame;
+		timings.Passes = slot.Passes;
+		double toMilliseconds = 1000.0 / readBack.Frequency;
+		uint64_t first = UINT64_MAX, last = 0;
+		for (size_t i = 0; i < timings.Passes.size(); i++)
+		{
+			uint64_t start = readBack.Timestamps[i * 2];
+			uint64_t end = readBack.Timestamps[i * 2 + 1];
+			timings.Passes[i].Milliseconds = end > start ? (end - start) * toMilliseconds : 0;
+			first = min(first, start);
+			last = max(last, end);
+		}
+		timings.Milliseconds = last > first ? (last - first) * toMilliseconds : 0;
+
+		stats.FramesResolved++;
+		latest = timings;
+		if (historyLength > 0)
+		{
+			history.push_back(timings);
+			if (history.size() > historyLength)
+				history.pop_front();
+		}
+	}
+}
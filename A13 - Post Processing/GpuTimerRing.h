@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// What one frame's queries returned
+struct GpuQueryFrame
+{
+	bool Disjoint = false;			// Timestamps are meaningless (clock changed, etc.)
+	uint64_t Frequency = 0;			// Timestamp ticks per second
+	std::vector<uint64_t> Timestamps;
+};
+
+// --------------------------------------------------------
+// The queries GpuTimerRing drives, one set per ring slot.
+// D3D11GpuQuerySource issues real disjoint/timestamp
+// queries; tests can supply one that answers from a script.
+// --------------------------------------------------------
+class IGpuQuerySource
+{
+public:
+	virtual ~IGpuQuerySource() = default;
+
+	virtual void BeginFrame(unsigned int slot) = 0;
+	virtual void Timestamp(unsigned int slot, unsigned int index) = 0;
+	virtual void EndFrame(unsigned int slot) = 0;
+
+	// Must not wait - false if the slot's results aren't in yet
+	virtual bool Read(unsigned int slot, unsigned int timestampCount, GpuQueryFrame& frame) = 0;
+};
+
+struct GpuPassTiming
+{
+	std::string Name;
+	unsigned int Depth = 0;		// Passes open around this one
+	double Milliseconds = 0;
+};
+
+struct GpuFrameTimings
+{
+	uint64_t Frame = 0;				// Counts every BeginFrame, skipped or not
+	double Milliseconds = 0;		// First pass start to last pass end
+	std::vector<GpuPassTiming> Passes;
+};
+
+struct GpuTimerStats
+{
+	uint64_t FramesResolved = 0;
+	uint64_t FramesSkipped = 0;		// Every slot was still waiting on the GPU
+	uint64_t FramesDisjoint = 0;
+	uint64_t PassesDropped = 0;		// Over the per-frame pass limit
+	unsigned int Latency = 0;		// Frames between issuing and reading the latest results
+};
+
+// --------------------------------------------------------
+// Times GPU passes with pairs of timestamp queries, read
+// back a few frames late so the CPU never waits on them.
+//
+// Each frame takes the next of slotCount query sets.  After
+// a frame is closed, every finished slot is read (oldest
+// first, without blocking).  If the GPU falls so far behind
+// that the next slot is still in flight, that frame simply
+// isn't timed - nothing stalls and nothing is overwritten.
+// --------------------------------------------------------
+class GpuTimerRing
+{
+public:
+	static const unsigned int NoPass = 0xFFFFFFFF;
+
+	GpuTimerRing(IGpuQuerySource* source, unsigned int slotCount, unsigned int maxPasses);
+
+	void BeginFrame();
+	void EndFrame();
+
+	// Passes may nest, but must close in the order they opened
+	unsigned int BeginPass(const char* name);
+	void EndPass(unsigned int pass);
+
+	// Most recent results, empty until the first frame resolves
+	const GpuFrameTimings& GetLatest() const { return latest; }
+	const std::deque<GpuFrameTimings>& GetHistory() const { return history; }
+	void SetHistoryLength(size_t frames);
+	const GpuTimerStats& GetStats() const { return stats; }
+
+	// Timestamps one slot needs for maxPasses passes
+	static unsigned int TimestampsPerSlot(unsigned int maxPasses) { return maxPasses * 2; }
+
+private:
+	enum class SlotState { Free, Recording, Pending };
+
+	struct Slot
+	{
+		SlotState State = SlotState::Free;
+		uint64_t Frame = 0;
+		std::vector<GpuPassTiming> Passes;	// Names and depths, times filled in on read
+	};
+
+	IGpuQuerySource* source;
+	std::vector<Slot> slots;
+	std::deque<unsigned int> pending;		// Slots waiting on the GPU, oldest first
+	unsigned int maxPasses;
+	unsigned int current;					// Slot being recorded, or NoPass
+	unsigned int depth;
+	uint64_t frame;
+	GpuQueryFrame readBack;
+
+	GpuFrameTimings latest;
+	std::deque<GpuFrameTimings> history;
+	size_t historyLength;
+	GpuTimerStats stats;
+
+	void Collect();
+};
+
+// Times the enclosing scope as one pass
+class ScopedGpuPass
+{
+public:
+	ScopedGpuPass(GpuTimerRing& ring, const char* name) : ring(ring), pass(ring.BeginPass(name)) {}
+	~ScopedGpuPass() { ring.EndPass(pass); }
+	ScopedGpuPass(const ScopedGpuPass&) = delete;
+	ScopedGpuPass& operator=(const ScopedGpuPass&) = delete;
+
+private:
+	GpuTimerRing& ring;
+	unsigned int pass;
+};
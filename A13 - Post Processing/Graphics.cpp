@@ -1,4 +1,5 @@
 #include "Graphics.h"
+#include "D3D11RenderContext.h"
 #include <dxgi1_6.h>
 
 // Tell the drivers to use high-performance GPU in multi-GPU systems (like laptops)
@@ -122,6 +123,10 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 		Context.GetAddressOf());	// Pointer to our Device Context pointer
 	if (FAILED(hr)) return hr;
 
+	// Wrap the context in the state cache
+	StateContext = std::make_unique<D3D11RenderContext>(Context);
+	State = std::make_unique<RenderStateCache>(StateContext.get());
+
 	// We're set up
 	apiInitialized = true;
 
@@ -152,6 +157,8 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 // --------------------------------------------------------
 void Graphics::ShutDown()
 {
+	State.reset();
+	StateContext.reset();
 }
 
 
@@ -238,6 +245,10 @@ void Graphics::ResizeBuffers(unsigned int width, unsigned int height)
 	viewport.MaxDepth = 1.0f;
 	Context->RSSetViewports(1, &viewport);
 
+	// The calls above (and the buffer swap) went around the state cache
+	if (State)
+		State->Invalidate();
+
 	// Are we in a fullscreen state?
 	SwapChain->GetFullscreenState(&isFullscreen, 0);
 }
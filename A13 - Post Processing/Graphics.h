@@ -2,12 +2,15 @@
 
 #include <Windows.h>
 #include <d3d11.h>
+#include <memory>
 #include <string>
 #include <wrl/client.h>
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
 
+#include "RenderStateCache.h"
+
 namespace Graphics
 {
 	// --- GLOBAL VARS ---
@@ -21,6 +24,11 @@ namespace Graphics
 	inline Microsoft::WRL::ComPtr<ID3D11RenderTargetView> BackBufferRTV;
 	inline Microsoft::WRL::ComPtr<ID3D11DepthStencilView> DepthBufferDSV;
 
+	// Filters redundant state changes on Context - set state through
+	// this rather than Context directly, or the two will disagree
+	inline std::unique_ptr<IRenderContext> StateContext;
+	inline std::unique_ptr<RenderStateCache> State;
+
 	// --- FUNCTIONS ---
 
 	// Getters
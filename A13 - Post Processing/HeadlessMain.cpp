@@ -0,0 +1,22 @@
+// --------------------------------------------------------
+// Console entry point for platforms without WinMain, so the
+// headless benchmark can run on build machines.  The
+// HeadlessBenchmark target in CMakeLists.txt builds it with
+// the D3D-free sources it needs.
+// --------------------------------------------------------
+#if !defined(_WIN32)
+
+#include "FrameBenchmark.h"
+
+#include <string>
+
+int main(int argc, char** argv)
+{
+	std::string commandLine = "--benchmark";
+	for (int i = 1; i < argc; i++)
+		commandLine += std::string(" ") + argv[i];
+
+	return FrameBenchmark::RunFromCommandLine(commandLine);
+}
+
+#endif
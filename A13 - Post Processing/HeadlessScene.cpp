@@ -0,0 +1,174 @@
+#include "HeadlessScene.h"
+#include "CascadedShadows.h"
+#include "LocalShadows.h"
+
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+using namespace DirectX;
+
+HeadlessScene::HeadlessScene(unsigned int entityCount, const ShaderReflectionData& vertexShader, const ShaderReflectionData& pixelShader, unsigned int materialCount, unsigned int meshCount) :
+	totalTime(0)
+{
+	builder.SetPipelineLayout(0, vertexShader, pixelShader);
+
+	// A square grid, three units apart like Game's row of objects
+	unsigned int side = (unsigned int)ceil(sqrt((double)entityCount));
+	transforms.resize(entityCount);
+	objects.resize(entityCount);
+	for (unsigned int i = 0; i < entityCount; i++)
+	{
+		transforms[i].SetPosition(3.0f * (i % side), -8.0f, 3.0f * (i / side));
+
+		objects[i].Material = i % materialCount;
+		objects[i].Mesh = i % meshCount;
+		objects[i].IndexCount = 36 + 1000 * objects[i].Mesh;
+		objects[i].ColorTint = XMFLOAT4(1.0f, 1.0f - 0.1f * objects[i].Material, 1.0f, 1.0f);
+		objects[i].Roughness = 0.1f;
+	}
+
+	// Same count and layout as Game's lights
+	lights.resize(5);
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		lights[i] = {};
+		lights[i].type = i < 3 ? LIGHT_TYPE_DIRECTIONAL : LIGHT_TYPE_POINT;
+		lights[i].direction = XMFLOAT3(1, -1, 0);
+		lights[i].color = XMFLOAT3(1, 1, 1);
+		lights[i].intensity = 1.0f;
+		lights[i].range = 10.0f;
+	}
+}
+
+void HeadlessScene::Update(float deltaTime)
+{
+	totalTime += deltaTime;
+
+	// Game spins two of its five objects
+	for (size_t i = 0; i < transforms.size(); i += 5)
+	{
+		transforms[i].Rotate(0, deltaTime, 0);
+		if (i + 3 < transforms.size())
+			transforms[i + 3].Rotate(0, deltaTime, 0);
+	}
+
+	for (auto& transform : transforms)
+		transform.SetWorldMatrices();
+}
+
+unsigned int HeadlessScene::Cull(const Frustum* frustum)
+{
+	visible.clear();
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		if (frustum && !frustum->IntersectsSphere(transforms[i].GetPosition(), ObjectRadius))
+			continue;
+
+		objects[i].World = transforms[i].GetWorldMatrix();
+		objects[i].WorldInverseTranspose = transforms[i].GetWorldInverseTransposeMatrix();
+		visible.push_back(objects[i]);
+	}
+	return (unsigned int)visible.size();
+}
+
+MaterialBatchStats HeadlessScene::BuildDrawList(const DrawFrameConstants& frame, CommandBuffer& buffer)
+{
+	buffer.Clear();
+	return builder.Build(visible, frame, buffer);
+}
+
+HeadlessFrameResult HeadlessScene::Run(unsigned int frameCount, NullCommandExecutor& executor)
+{
+	HeadlessFrameResult result;
+	result.Entities = (unsigned int)transforms.size();
+	result.Frames = frameCount;
+	if (frameCount == 0)
+		return result;
+
+	// A fixed camera looking down the grid
+	DrawFrameConstants frame = {};
+	XMStoreFloat4x4(&frame.View, XMMatrixLookToLH(XMVectorSet(0, -5, -30, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)));
+	XMStoreFloat4x4(&frame.Projection, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.01f, 1000.0f));
+	frame.Lights = lights.data();
+	frame.LightBytes = (unsigned int)(sizeof(Light) * lights.size());
+
+	// The camera doesn't move, so neither do the cascades
+	ShadowCascadeData cascades = CascadedShadows::Pack(CascadedShadows::Build(frame.View, frame.Projection, lights[0].direction, CascadeSettings()));
+	frame.ShadowCascades = &cascades;
+	frame.ShadowCascadeBytes = sizeof(cascades);
+	ShadowAtlas atlas;
+	vector<ShadowRequest> requests = LocalShadows::Requests(lights, frame.View, frame.Projection);
+	LocalShadowData localShadows = LocalShadows::Pack(LocalShadows::Faces(lights, requests, atlas.Allocate(requests), {}), atlas.GetSettings().Size);
+	frame.LocalShadows = &localShadows;
+	frame.LocalShadowBytes = sizeof(localShadows);
+	Frustum frustum = Frustum::FromViewProjection(frame.View, frame.Projection);
+
+	const float deltaTime = 1.0f / 60.0f;
+	for (unsigned int i = 0; i < frameCount; i++)
+	{
+		executor.ResetStats();
+
+		auto start = chrono::high_resolution_clock::now();
+		Update(deltaTime);
+		auto updated = chrono::high_resolution_clock::now();
+
+		result.Visible = Cull(&frustum);
+		auto culled = chrono::high_resolution_clock::now();
+
+		frame.TotalTime = totalTime;
+		BuildDrawList(frame, buffer);
+		auto built = chrono::high_resolution_clock::now();
+
+		executor.Execute(buffer);
+		auto executed = chrono::high_resolution_clock::now();
+
+		result.UpdateMilliseconds += chrono::duration<double, milli>(updated - start).count();
+		result.CullMilliseconds += chrono::duration<double, milli>(culled - updated).count();
+		result.BuildMilliseconds += chrono::duration<double, milli>(built - culled).count();
+		result.ExecuteMilliseconds += chrono::duration<double, milli>(executed - built).count();
+	}
+
+	result.UpdateMilliseconds /= frameCount;
+	result.CullMilliseconds /= frameCount;
+	result.BuildMilliseconds /= frameCount;
+	result.ExecuteMilliseconds /= frameCount;
+	result.FrameMilliseconds = result.UpdateMilliseconds + result.CullMilliseconds + result.BuildMilliseconds + result.ExecuteMilliseconds;
+	result.CommandBytes = buffer.GetCommands().size() * sizeof(Command) + buffer.GetData().size();
+	result.Executed = executor.GetStats();
+	return result;
+}
+
+ShaderReflectionData HeadlessScene::DefaultVertexReflection()
+{
+	ShaderReflectionData reflection;
+	ReflectedConstantBuffer buffer;
+	buffer.Name = "ExternalData";
+	const char* matrices[] = { "world", "worldInverseTranspose", "view", "projection" };
+	for (unsigned int i = 0; i < 4; i++)
+		buffer.Variables.push_back({ matrices[i], i * 64, 64 });
+	buffer.Size = 4 * 64;
+	reflection.ConstantBuffers.push_back(buffer);
+	return reflection;
+}
+
+ShaderReflectionData HeadlessScene::DefaultPixelReflection()
+{
+	// HLSL packing: cameraPos and totalTime share a register, the light
+	// array starts on the register after roughness, and the cascades and
+	// local shadows (structs, so each on a fresh register) follow the lights
+	ShaderReflectionData reflection;
+	ReflectedConstantBuffer buffer;
+	buffer.Name = "ExternalData";
+	buffer.Variables.push_back({ "colorTint", 0, 16 });
+	buffer.Variables.push_back({ "cameraPos", 16, 12 });
+	buffer.Variables.push_back({ "totalTime", 28, 4 });
+	buffer.Variables.push_back({ "roughness", 32, 4 });
+	buffer.Variables.push_back({ "lights", 48, 5 * sizeof(Light) });
+	buffer.Variables.push_back({ "shadowCascades", 48 + 5 * sizeof(Light), sizeof(ShadowCascadeData) });
+	unsigned int localShadows = (48 + 5 * sizeof(Light) + sizeof(ShadowCascadeData) + 15) / 16 * 16;
+	buffer.Variables.push_back({ "localShadows", localShadows, sizeof(LocalShadowData) });
+	buffer.Size = localShadows + sizeof(LocalShadowData);
+	reflection.ConstantBuffers.push_back(buffer);
+	return reflection;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CommandBuffer.h"
+#include "DrawListBuilder.h"
+#include "Frustum.h"
+#include "Light.h"
+#include "ShaderReflectionCache.h"
+#include "Transform.h"
+
+#include <vector>
+
+// Average milliseconds per frame for each part of a headless run
+struct HeadlessFrameResult
+{
+	unsigned int Entities = 0;
+	unsigned int Frames = 0;
+	double UpdateMilliseconds = 0;
+	double CullMilliseconds = 0;
+	double BuildMilliseconds = 0;
+	double ExecuteMilliseconds = 0;
+	double FrameMilliseconds = 0;
+	unsigned int Visible = 0;			// Last frame only
+	size_t CommandBytes = 0;			// Per frame: commands plus constant data
+	NullExecutorStats Executed;			// Last frame only
+};
+
+// --------------------------------------------------------
+// The CPU side of Game's frame with no window or device:
+// the same per-frame entity work Game::Update does (spin a
+// share of the objects, rebuild every world matrix) and the
+// same main pass draw list, culled to a camera's frustum,
+// built into a command buffer and run on any executor
+// (normally a NullCommandExecutor).
+//
+// Objects are laid out on a grid and cycle through a few
+// materials and meshes, so batching has something to do.
+// --------------------------------------------------------
+class HeadlessScene
+{
+public:
+	HeadlessScene(unsigned int entityCount, const ShaderReflectionData& vertexShader, const ShaderReflectionData& pixelShader,
+		unsigned int materialCount = 8, unsigned int meshCount = 4);
+
+	// Every object is bounded by a sphere this big around its position
+	static constexpr float ObjectRadius = 1.75f;
+
+	void Update(float deltaTime);
+
+	// Refreshes the objects' matrices and keeps the ones inside the
+	// frustum (or all of them, with no frustum) for BuildDrawList
+	unsigned int Cull(const Frustum* frustum);
+	MaterialBatchStats BuildDrawList(const DrawFrameConstants& frame, CommandBuffer& buffer);
+
+	// Runs frameCount frames at a fixed time step and averages them
+	HeadlessFrameResult Run(unsigned int frameCount, NullCommandExecutor& executor);
+
+	std::vector<Transform>& GetTransforms() { return transforms; }
+	const std::vector<Light>& GetLights() const { return lights; }
+
+	// Reflection matching the ExternalData cbuffers in VertexShader.hlsl and
+	// PixelShader.hlsl, for runs with no compiled shaders to reflect
+	static ShaderReflectionData DefaultVertexReflection();
+	static ShaderReflectionData DefaultPixelReflection();
+
+private:
+	std::vector<Transform> transforms;
+	std::vector<DrawObject> objects;
+	std::vector<DrawObject> visible;
+	std::vector<Light> lights;
+	DrawListBuilder builder;
+	CommandBuffer buffer;
+	float totalTime;
+};
@@ -12,4 +12,6 @@ struct Light {
 	DirectX::XMFLOAT3 position;
 	float intensity;
 	DirectX::XMFLOAT3 color;
+	float spotAngle;	//Full width of a spot light's cone, in radians
+	DirectX::XMFLOAT3 padding;	//Rounds it up to 64 bytes, the shader array's stride
 };
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "LocalShadows.h"
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	// Looking down each axis, in the order the faces are stored
+	const XMFLOAT3 FaceDirections[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	const XMFLOAT3 FaceUps[6] = { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, 1, 0 }, { 0, 1, 0 } };
+}
+
+unsigned int LocalShadows::FaceCount(const Light& light)
+{
+	if (light.type == LIGHT_TYPE_POINT)
+		return 6;
+	return light.type == LIGHT_TYPE_SPOT ? 1 : 0;
+}
+
+void LocalShadows::Bounds(const Light& light, XMFLOAT3& center, float& radius)
+{
+	center = light.position;
+	radius = light.range;
+	if (light.type != LIGHT_TYPE_SPOT)
+		return;
+
+	// The smallest sphere around the cone: narrow ones are held by their tip and
+	// the far end of their edges, wide ones by the circle at the far end
+	float halfAngle = min(light.spotAngle * 0.5f, XM_PIDIV2);
+	XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&light.direction));
+	float along;
+	if (halfAngle > XM_PIDIV4)
+	{
+		along = light.range * cosf(halfAngle);
+		radius = light.range * sinf(halfAngle);
+	}
+	else
+	{
+		radius = light.range / (2.0f * cosf(halfAngle));
+		along = radius;
+	}
+	XMStoreFloat3(&center, XMLoadFloat3(&light.position) + direction * along);
+}
+
+float LocalShadows::Importance(const Light& light, const XMFLOAT4X4& view, const XMFLOAT4X4& projection)
+{
+	XMFLOAT3 center;
+	float radius;
+	Bounds(light, center, radius);
+	if (FaceCount(light) == 0 || !Frustum::FromViewProjection(view, projection).IntersectsSphere(center, radius))
+		return 0;
+
+	// The camera's inside what it lights, so it's all around
+	XMVECTOR cameraCenter = XMVector3TransformCoord(XMLoadFloat3(&center), XMLoadFloat4x4(&view));
+	float distance = XMVectorGetX(XMVector3Length(cameraCenter));
+	if (distance <= radius)
+		return 1;
+
+	// The sphere's angular radius against the vertical field of view - projection._22 is 1 / tan(fov / 2)
+	float tangent = radius / sqrtf(distance * distance - radius * radius);
+	return min(tangent * projection._22, 1.0f);
+}
+
+vector<ShadowRequest> LocalShadows::Requests(const vector<Light>& lights, const XMFLOAT4X4& view, const XMFLOAT4X4& projection)
+{
+	vector<ShadowRequest> requests;
+	for (unsigned int i = 0; i < lights.size() && i < MaxLights; i++)
+	{
+		if (FaceCount(lights[i]) == 0)
+			continue;
+		ShadowRequest request;
+		request.Light = i;
+		request.Importance = Importance(lights[i], view, projection);
+		request.Faces = FaceCount(lights[i]);
+		requests.push_back(request);
+	}
+	return requests;
+}
+
+unsigned int LocalShadows::CubeFace(XMFLOAT3 direction)
+{
+	float x = fabsf(direction.x);
+	float y = fabsf(direction.y);
+	float z = fabsf(direction.z);
+	if (x >= y && x >= z)
+		return direction.x < 0 ? 1 : 0;
+	if (y >= z)
+		return direction.y < 0 ? 3 : 2;
+	return direction.z < 0 ? 5 : 4;
+}
+
+void LocalShadows::FaceMatrices(const Light& light, unsigned int face, XMFLOAT4X4& view, XMFLOAT4X4& projection)
+{
+	XMVECTOR position = XMLoadFloat3(&light.position);
+	if (light.type == LIGHT_TYPE_SPOT)
+	{
+		// Square around the cone, which only needs an up that isn't along it
+		XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&light.direction));
+		XMVECTOR up = fabsf(XMVectorGetY(direction)) > 0.99f ? XMVectorSet(0, 0, 1, 0) : XMVectorSet(0, 1, 0, 0);
+		float angle = min(max(light.spotAngle, 0.01f), XM_PI * 0.9f);
+		XMStoreFloat4x4(&view, XMMatrixLookToLH(position, direction, up));
+		XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(angle, 1.0f, NearPlane, light.range));
+		return;
+	}
+
+	// A quarter turn each way, so the six faces meet exactly at the cube's edges
+	XMStoreFloat4x4(&view, XMMatrixLookToLH(position, XMLoadFloat3(&FaceDirections[face]), XMLoadFloat3(&FaceUps[face])));
+	XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, NearPlane, light.range));
+}
+
+vector<LocalShadowFace> LocalShadows::Faces(const vector<Light>& lights, const vector<ShadowRequest>& requests,
+	const vector<ShadowAllocation>& allocations, const vector<ShadowCaster>& casters)
+{
+	vector<LocalShadowFace> faces;
+	for (size_t i = 0; i < requests.size() && i < allocations.size(); i++)
+	{
+		for (unsigned int f = 0; f < allocations[i].Tiles.size(); f++)
+		{
+			LocalShadowFace face;
+			face.Light = requests[i].Light;
+			face.Face = f;
+			face.Tile = allocations[i].Tiles[f];
+			FaceMatrices(lights[face.Light], f, face.View, face.Projection);
+
+			// The face's far plane is the light's range, so its frustum does all the culling
+			Frustum frustum = Frustum::FromViewProjection(face.View, face.Projection);
+			for (unsigned int c = 0; c < casters.size(); c++)
+			{
+				if (frustum.IntersectsSphere(casters[c].Center, casters[c].Radius))
+					face.Casters.push_back(c);
+			}
+			faces.push_back(face);
+		}
+	}
+	return faces;
+}
+
+LocalShadowData LocalShadows::Pack(const vector<LocalShadowFace>& faces, unsigned int atlasSize)
+{
+	LocalShadowData data = {};
+	for (unsigned int i = 0; i < faces.size() && i < ShadowAtlas::MaxTiles; i++)
+	{
+		const LocalShadowFace& face = faces[i];
+		XMStoreFloat4x4(&data.ViewProjections[i], XMLoadFloat4x4(&face.View) * XMLoadFloat4x4(&face.Projection));
+		data.Tiles[i] = XMFLOAT4((float)face.Tile.X / atlasSize, (float)face.Tile.Y / atlasSize,
+			(float)face.Tile.Size / atlasSize, (float)face.Tile.Size / atlasSize);
+
+		// A light's faces are next to each other, so the first one starts its run
+		if (face.Light >= MaxLights)
+			continue;
+		XMINT4& lightTiles = data.LightTiles[face.Light];
+		if (lightTiles.y == 0)
+			lightTiles.x = (int)i;
+		lightTiles.y++;
+	}
+	return data;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include "CascadedShadows.h"
+#include "Light.h"
+#include "ShadowAtlas.h"
+
+#include <vector>
+
+// One face of a light's shadow - a cube has six, a spot one - and the atlas tile it's drawn into
+struct LocalShadowFace
+{
+	unsigned int Light = 0;		// Index into the lights
+	unsigned int Face = 0;
+	ShadowTile Tile;
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	std::vector<unsigned int> Casters;	// Indices of the casters inside the face's frustum
+};
+
+// Same layout as LocalShadows in PixelShader.hlsl
+struct LocalShadowData
+{
+	DirectX::XMFLOAT4X4 ViewProjections[ShadowAtlas::MaxTiles];
+	DirectX::XMFLOAT4 Tiles[ShadowAtlas::MaxTiles];	// Atlas UV offset (xy) and scale (zw) of each face
+	DirectX::XMINT4 LightTiles[5];					// Each light's first face (x) and how many (y) - none for no shadow
+};
+
+// --------------------------------------------------------
+// Shadows for the point and spot lights, drawn into tiles
+// of a ShadowAtlas.  A point light gets a cube - six 90
+// degree perspective faces, in +X, -X, +Y, -Y, +Z, -Z order
+// - and a spot light one perspective face as wide as its
+// cone.
+//
+// How big a light's tiles are comes from its importance:
+// how much of the screen the sphere around everything it
+// lights covers.  Off screen, it gets no shadow at all.
+//
+// Nothing here touches D3D, so the importance, the face
+// matrices (against the shader's face selection) and the
+// caster culling are checked headlessly
+// (Tests/LocalShadowsTests.cpp).
+// --------------------------------------------------------
+namespace LocalShadows
+{
+	const unsigned int MaxLights = 5;	// Must match MAX_LIGHTS in PixelShader.hlsl
+	const float NearPlane = 0.1f;		// Of every face's projection
+
+	// 6 for a point light, 1 for a spot, none for a directional
+	unsigned int FaceCount(const Light& light);
+
+	// A sphere around everything the light reaches
+	void Bounds(const Light& light, DirectX::XMFLOAT3& center, float& radius);
+
+	// How much of the screen's height the light's bounds cover, from 0 (none of it, or off screen) to 1
+	float Importance(const Light& light, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
+
+	// An atlas request for every point and spot light, identified by its index
+	std::vector<ShadowRequest> Requests(const std::vector<Light>& lights, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
+
+	// The cube face a light-to-point direction falls in - the same choice SampleLocalShadow makes
+	unsigned int CubeFace(DirectX::XMFLOAT3 direction);
+
+	// The view and projection of one of a light's faces
+	void FaceMatrices(const Light& light, unsigned int face, DirectX::XMFLOAT4X4& view, DirectX::XMFLOAT4X4& projection);
+
+	// Every face that got tiles this frame, with the casters each one draws
+	std::vector<LocalShadowFace> Faces(const std::vector<Light>& lights, const std::vector<ShadowRequest>& requests,
+		const std::vector<ShadowAllocation>& allocations, const std::vector<ShadowCaster>& casters);
+
+	// What the pixel shader needs to find and sample each light's faces
+	LocalShadowData Pack(const std::vector<LocalShadowFace>& faces, unsigned int atlasSize);
+}
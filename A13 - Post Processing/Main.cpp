@@ -6,6 +6,8 @@
 #include "Graphics.h"
 #include "Game.h"
 #include "Input.h"
+#include "FrameBenchmark.h"
+#include "Profiler.h"
 
 // Annonymous namespace to hold variables
 // only accessible in this file
@@ -78,6 +80,11 @@ int WINAPI WinMain(
 	printf("Console window created successfully.  Feel free to printf() here.\n");
 #endif
 
+	// A benchmark run needs no window or device - it runs, saves its report and exits
+	int benchmarkResult = FrameBenchmark::RunFromCommandLine(lpCmdLine);
+	if (benchmarkResult >= 0)
+		return benchmarkResult;
+
 	// Set up app initialization details
 	unsigned int windowWidth = 1280;
 	unsigned int windowHeight = 720;
@@ -112,6 +119,7 @@ int WINAPI WinMain(
 	Input::Initialize(Window::Handle());
 
 	// Now the game itself can be initialzied
+	Profiler::SetThreadName("Main");
 	game->Initialize();
 
 	// Time tracking
@@ -150,15 +158,27 @@ int WINAPI WinMain(
 			float totalTime = (float)((currentTime - startTime) * perfSeconds);
 			previousTime = currentTime;
 
+			// Every zone from here to the next mark belongs to this frame
+			Profiler::MarkFrame();
+
 			// Calculate basic fps
 			Window::UpdateStats(totalTime);
 
 			// Input updating
-			Input::Update();
+			{
+				PROFILE_ZONE("Input::Update");
+				Input::Update();
+			}
 
 			// Update and draw
-			game->Update(deltaTime, totalTime);
-			game->Draw(deltaTime, totalTime);
+			{
+				PROFILE_ZONE("Game::Update");
+				game->Update(deltaTime, totalTime);
+			}
+			{
+				PROFILE_ZONE("Game::Draw");
+				game->Draw(deltaTime, totalTime);
+			}
 
 			// Notify Input system about end of frame
 			Input::EndOfFrame();
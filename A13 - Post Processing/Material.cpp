@@ -1,4 +1,5 @@
 #include "Material.h"
+#include "Graphics.h"
 
 using namespace std;
 using namespace DirectX;
@@ -36,4 +37,108 @@ shared_ptr<SimplePixelShader> Material::GetPixelShader() {
 
 float Material::GetRoughness() {
 	return roughness;
-}
\ No newline at end of file
+}
+
+const vector<shared_ptr<AsyncTexture>>& Material::GetTextures() {
+	return textures;
+}
+
+MaterialKey Material::GetKey() {
+	MaterialKey key;
+	key.ColorTint = colorTint;
+	key.Roughness = roughness;
+	key.VertexShader = vertexShader.get();
+	key.PixelShader = pixelShader.get();
+	for (size_t i = 0; i < textures.size(); i++)
+		key.Textures.push_back({ textureNames[i], textures[i].get() });
+	for (size_t i = 0; i < samplers.size(); i++)
+		key.Samplers.push_back({ samplerNames[i], samplers[i].Get() });
+	key.Normalize();
+	return key;
+}
+
+unsigned int Material::GetId() {
+	return id;
+}
+
+void Material::SetId(unsigned int id) {
+	this->id = id;
+}
+
+const BindingTable& Material::GetBindingTable() {
+	PrepareBindings();
+	return bindingTable;
+}
+
+void Material::SetTexture(string name, shared_ptr<AsyncTexture> texture) {
+	for (size_t i = 0; i < textureNames.size(); i++) {
+		if (textureNames[i] == name) {
+			textures[i] = texture;
+			return;
+		}
+	}
+	textureNames.push_back(name);
+	textures.push_back(texture);
+	bindingsDirty = true;
+}
+
+void Material::SetSampler(string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler) {
+	for (size_t i = 0; i < samplerNames.size(); i++) {
+		if (samplerNames[i] == name) {
+			samplers[i] = sampler;
+			return;
+		}
+	}
+	samplerNames.push_back(name);
+	samplers.push_back(sampler);
+	bindingsDirty = true;
+}
+
+void Material::PrepareBindings() {
+	ID3DBlob* shader = pixelShader->GetShaderBlob().Get();
+	if (!bindingsDirty && shader == bindingShader) return;
+
+	bindingTable = BindingTables::Build(pixelShader->GetReflection(), textureNames, samplerNames);
+	bindingShader = shader;
+	bindingsDirty = false;
+}
+
+// --------------------------------------------------------
+// No name lookups here - the table already knows which
+// register each resource goes to.  Texture views are read
+// fresh every time, as loading and streaming swap them.
+// --------------------------------------------------------
+void Material::BindResources() {
+	PrepareBindings();
+
+	for (const BindingRange& range : bindingTable.TextureRanges) {
+		srvArray.resize(range.Sources.size());
+		for (size_t i = 0; i < range.Sources.size(); i++)
+			srvArray[i] = range.Sources[i] < 0 ? 0 : textures[range.Sources[i]]->GetSRV().Get();
+		Graphics::State->SetPixelShaderResources(range.FirstSlot, (UINT)srvArray.size(), srvArray.data());
+	}
+
+	for (const BindingRange& range : bindingTable.SamplerRanges) {
+		samplerArray.resize(range.Sources.size());
+		for (size_t i = 0; i < range.Sources.size(); i++)
+			samplerArray[i] = range.Sources[i] < 0 ? 0 : samplers[range.Sources[i]].Get();
+		Graphics::State->SetPixelSamplers(range.FirstSlot, (UINT)samplerArray.size(), samplerArray.data());
+	}
+}
+void Material::BindResources(ID3D11DeviceContext* context) const {
+	//Stack arrays, as the member ones can't be shared between threads
+	ID3D11ShaderResourceView* views[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+	ID3D11SamplerState* samplerStates[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+
+	for (const BindingRange& range : bindingTable.TextureRanges) {
+		for (size_t i = 0; i < range.Sources.size(); i++)
+			views[i] = range.Sources[i] < 0 ? 0 : textures[range.Sources[i]]->GetSRV().Get();
+		context->PSSetShaderResources(range.FirstSlot, (UINT)range.Sources.size(), views);
+	}
+
+	for (const BindingRange& range : bindingTable.SamplerRanges) {
+		for (size_t i = 0; i < range.Sources.size(); i++)
+			samplerStates[i] = range.Sources[i] < 0 ? 0 : samplers[range.Sources[i]].Get();
+		context->PSSetSamplers(range.FirstSlot, (UINT)range.Sources.size(), samplerStates);
+	}
+}
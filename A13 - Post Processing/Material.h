@@ -1,8 +1,14 @@
 #pragma once
 #include <memory>
+#include <string>
+#include <vector>
 #include <DirectXMath.h>
 
 #include "SimpleShader.h"
+#include "TextureLoader.h"
+#include "BindingTable.h"
+#include "MaterialRegistry.h"
+
 class Material
 {
 public:
@@ -12,14 +18,46 @@ public:
 	void SetVertexShader(SimpleVertexShader vertexShader);
 	void SetPixelShader(SimplePixelShader pixelShader);
 
+	//Pixel shader resources, matched to the shader by name
+	void SetTexture(std::string name, std::shared_ptr<AsyncTexture> texture);
+	void SetSampler(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler);
+
+	//Binds every texture and sampler with one call per register range
+	void BindResources();
+
+	//Same, but straight onto a context (bypassing the state cache) - safe to call
+	//from several threads at once, as long as PrepareBindings() ran on the main thread first
+	void BindResources(ID3D11DeviceContext* context) const;
+	void PrepareBindings();
+
 	DirectX::XMFLOAT4 GetColorTint();
 	std::shared_ptr<SimpleVertexShader> GetVertexShader();
 	std::shared_ptr<SimplePixelShader> GetPixelShader();
 	float GetRoughness();
+	const std::vector<std::shared_ptr<AsyncTexture>>& GetTextures();
+	const BindingTable& GetBindingTable();
+
+	//Content identity, for interning in a MaterialRegistry
+	MaterialKey GetKey();
+	unsigned int GetId();
+	void SetId(unsigned int id);
 private:
 	DirectX::XMFLOAT4 colorTint;
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 	std::shared_ptr<SimplePixelShader> pixelShader;
 	float roughness;
-};
+	unsigned int id = MaterialRegistry::InvalidId;
+
+	std::vector<std::string> textureNames;
+	std::vector<std::shared_ptr<AsyncTexture>> textures;
+	std::vector<std::string> samplerNames;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11SamplerState>> samplers;
 
+	//Rebuilt when resources are added or the shader's bytecode changes (hot reload)
+	BindingTable bindingTable;
+	ID3DBlob* bindingShader = 0;
+	bool bindingsDirty = true;
+	std::vector<ID3D11ShaderResourceView*> srvArray;
+	std::vector<ID3D11SamplerState*> samplerArray;
+
+};
@@ -0,0 +1,103 @@
+#include "MaterialRegistry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+using namespace std;
+
+namespace
+{
+	// Same FNV-1a as the rest of the project's content hashes
+	void Mix(size_t& hash, const void* data, size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; i++)
+		{
+			hash ^= ((const unsigned char*)data)[i];
+			hash *= (size_t)1099511628211ull;
+		}
+	}
+
+	void MixResources(size_t& hash, const vector<pair<string, const void*>>& resources)
+	{
+		for (auto& resource : resources)
+		{
+			Mix(hash, resource.first.data(), resource.first.size());
+			Mix(hash, &resource.second, sizeof(resource.second));
+		}
+	}
+}
+
+void MaterialKey::Normalize()
+{
+	sort(Textures.begin(), Textures.end());
+	sort(Samplers.begin(), Samplers.end());
+}
+
+size_t MaterialKey::Hash() const
+{
+	size_t hash = (size_t)14695981039346656037ull;
+	Mix(hash, &ColorTint, sizeof(ColorTint));
+	Mix(hash, &Roughness, sizeof(Roughness));
+	Mix(hash, &VertexShader, sizeof(VertexShader));
+	Mix(hash, &PixelShader, sizeof(PixelShader));
+	MixResources(hash, Textures);
+	MixResources(hash, Samplers);
+	return hash;
+}
+
+bool MaterialKey::operator==(const MaterialKey& other) const
+{
+	return memcmp(&ColorTint, &other.ColorTint, sizeof(ColorTint)) == 0 &&
+		Roughness == other.Roughness &&
+		VertexShader == other.VertexShader &&
+		PixelShader == other.PixelShader &&
+		Textures == other.Textures &&
+		Samplers == other.Samplers;
+}
+
+unsigned int MaterialRegistry::Intern(const MaterialKey& key)
+{
+	// Hash collisions are resolved by comparing the full keys
+	vector<unsigned int>& bucket = buckets[key.Hash()];
+	for (unsigned int id : bucket)
+	{
+		if (keys[id] == key)
+		{
+			hits++;
+			return id;
+		}
+	}
+
+	unsigned int id = (unsigned int)keys.size();
+	keys.push_back(key);
+	bucket.push_back(id);
+	return id;
+}
+
+int MaterialBatching::CountTransitions(const vector<MaterialDrawItem>& items)
+{
+	int transitions = 0;
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		if (i == 0 || items[i].MaterialId != items[i - 1].MaterialId)
+			transitions++;
+	}
+	return transitions;
+}
+
+MaterialBatchStats MaterialBatching::Sort(vector<MaterialDrawItem>& items)
+{
+	MaterialBatchStats stats;
+	stats.Draws = (int)items.size();
+	stats.UnsortedTransitions = CountTransitions(items);
+
+	stable_sort(items.begin(), items.end(), [](const MaterialDrawItem& a, const MaterialDrawItem& b) {
+		return a.MaterialId < b.MaterialId;
+	});
+
+	// Once sorted, every transition is a new material
+	stats.Transitions = CountTransitions(items);
+	stats.DistinctMaterials = stats.Transitions;
+	return stats;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// Everything that makes two materials draw identically:
+// their constants plus the identity of their shaders and
+// resources.  Resources are kept sorted by name, so the
+// order they were added in doesn't matter.
+// --------------------------------------------------------
+struct MaterialKey
+{
+	DirectX::XMFLOAT4 ColorTint = { 1, 1, 1, 1 };
+	float Roughness = 0;
+	const void* VertexShader = 0;
+	const void* PixelShader = 0;
+	std::vector<std::pair<std::string, const void*>> Textures;
+	std::vector<std::pair<std::string, const void*>> Samplers;
+
+	// Sorts the resource lists - call after filling them in
+	void Normalize();
+	size_t Hash() const;
+	bool operator==(const MaterialKey& other) const;
+};
+
+// One draw, reduced to what sorting needs
+struct MaterialDrawItem
+{
+	unsigned int MaterialId = 0;
+	int Index = 0;		// Whatever the caller draws with (entity index, etc.)
+};
+
+struct MaterialBatchStats
+{
+	int Draws = 0;
+	int DistinctMaterials = 0;
+	int Transitions = 0;			// Material changes in the sorted order (binds needed)
+	int UnsortedTransitions = 0;	// Material changes in the original order
+};
+
+// --------------------------------------------------------
+// Interns materials by content, so identical materials
+// collapse to one shared instance with one small, stable
+// ID.  IDs count up from 0 in order of first appearance and
+// are never reused, so they can index arrays and sort draws.
+//
+// Nothing here touches D3D: Intern() works with anything
+// that has GetKey() and SetId(), so a stand-in type can be
+// used to test it headlessly.
+// --------------------------------------------------------
+class MaterialRegistry
+{
+public:
+	static const unsigned int InvalidId = 0xFFFFFFFF;
+
+	// ID for this content, assigning the next one if it's new
+	unsigned int Intern(const MaterialKey& key);
+
+	// Returns the first instance registered with the same content
+	// (possibly the one passed in), with its ID set
+	template<typename T>
+	std::shared_ptr<T> Intern(std::shared_ptr<T> material)
+	{
+		MaterialKey key = material->GetKey();
+		unsigned int id = Intern(key);
+		if (id == instances.size())
+			instances.push_back(material);
+
+		std::shared_ptr<T> shared = std::static_pointer_cast<T>(instances[id]);
+		shared->SetId(id);
+		return shared;
+	}
+
+	// How many times Intern() found existing content
+	int GetHitCount() const { return hits; }
+	size_t Count() const { return keys.size(); }
+	const MaterialKey& GetKey(unsigned int id) const { return keys[id]; }
+
+private:
+	std::vector<MaterialKey> keys;
+	std::vector<std::shared_ptr<void>> instances;
+	std::unordered_map<size_t, std::vector<unsigned int>> buckets;
+	int hits = 0;
+};
+
+namespace MaterialBatching
+{
+	// Stable sort by material ID, so draws within a batch keep their order
+	MaterialBatchStats Sort(std::vector<MaterialDrawItem>& items);
+
+	// Material changes walking the items in their current order
+	int CountTransitions(const std::vector<MaterialDrawItem>& items);
+}
@@ -6,6 +6,8 @@
 #include <wrl/client.h>
 #include <DirectXMath.h>
 #include <d3dcompiler.h>
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <vector>
 
@@ -18,6 +20,7 @@ Mesh::Mesh(Vertex vertices[], int vCount, unsigned int indices[], int iCount) {
 	vertexCount = vCount;
 	indexCount = iCount;
 	CalculateTangents(vertices, vCount, indices, iCount);
+	CalculateBounds(vertices, vCount, indices, iCount);
 	ConstructBuffers(vertices, indices);
 }
 
@@ -232,6 +235,7 @@ Mesh::Mesh(const wchar_t* filePath) {
 	vertexCount = vertCounter;
 	indexCount = indexCounter;
 	CalculateTangents(&verts[0], vertexCount, &indices[0], indexCount);
+	CalculateBounds(&verts[0], vertexCount, &indices[0], indexCount);
 	ConstructBuffers(&verts[0], &indices[0]);
 }
 
@@ -380,11 +384,72 @@ void Mesh::CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices,
 	}
 }
 
+// --------------------------------------------------------
+// Bounding sphere (around the box center) plus the mesh's UV
+// density: the square root of its surface area over its UV
+// area, i.e. how many world units one whole UV span covers.
+// Texture streaming uses both to work out texel density.
+// --------------------------------------------------------
+void Mesh::CalculateBounds(Vertex* verts, int numVerts, unsigned int* indices, int numIndices)
+{
+	boundsCenter = XMFLOAT3(0, 0, 0);
+	boundsRadius = 0;
+	worldUnitsPerUv = 1;
+	if (numVerts == 0) return;
+
+	XMVECTOR minimum = XMLoadFloat3(&verts[0].Position);
+	XMVECTOR maximum = minimum;
+	for (int i = 1; i < numVerts; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&verts[i].Position);
+		minimum = XMVectorMin(minimum, position);
+		maximum = XMVectorMax(maximum, position);
+	}
+	XMVECTOR center = (minimum + maximum) * 0.5f;
+	XMStoreFloat3(&boundsCenter, center);
+
+	for (int i = 0; i < numVerts; i++)
+		boundsRadius = max(boundsRadius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&verts[i].Position) - center)));
+
+	float worldArea = 0;
+	float uvArea = 0;
+	for (int i = 0; i + 2 < numIndices; i += 3)
+	{
+		Vertex& v1 = verts[indices[i]];
+		Vertex& v2 = verts[indices[i + 1]];
+		Vertex& v3 = verts[indices[i + 2]];
+
+		XMVECTOR e1 = XMLoadFloat3(&v2.Position) - XMLoadFloat3(&v1.Position);
+		XMVECTOR e2 = XMLoadFloat3(&v3.Position) - XMLoadFloat3(&v1.Position);
+		worldArea += 0.5f * XMVectorGetX(XMVector3Length(XMVector3Cross(e1, e2)));
+
+		float u1 = v2.UV.x - v1.UV.x, t1 = v2.UV.y - v1.UV.y;
+		float u2 = v3.UV.x - v1.UV.x, t2 = v3.UV.y - v1.UV.y;
+		uvArea += 0.5f * fabsf(u1 * t2 - u2 * t1);
+	}
+	if (worldArea > 0 && uvArea > 0)
+		worldUnitsPerUv = sqrtf(worldArea / uvArea);
+}
+
+XMFLOAT3 Mesh::GetBoundsCenter() {
+	return boundsCenter;
+}
+
+float Mesh::GetBoundsRadius() {
+	return boundsRadius;
+}
+
+float Mesh::GetWorldUnitsPerUv() {
+	return worldUnitsPerUv;
+}
+
 void Mesh::Draw() {
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
-	Graphics::Context->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
-	Graphics::Context->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	Draw(Graphics::Context.Get());
+}
+
+//Same as Draw(), but onto any context - deferred contexts included
+void Mesh::Draw(ID3D11DeviceContext* context) {
+	Bind(context);
 
 	// Tell Direct3D to draw
 	//  - Begins the rendering pipeline on the GPU
@@ -392,12 +457,20 @@ void Mesh::Draw() {
 	//  - This will use all currently set Direct3D resources (shaders, buffers, etc)
 	//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
 	//     vertices in the currently set VERTEX BUFFER
-	Graphics::Context->DrawIndexed(
+	context->DrawIndexed(
 			indexCount,     // The number of indices to use (we could draw a subset if we wanted)
 			0,     // Offset to the first index we want to use
 			0);    // Offset to add to each index when looking up 
 }
 
+//Just the vertex and index buffers, for callers issuing their own draws
+void Mesh::Bind(ID3D11DeviceContext* context) {
+	UINT stride = sizeof(Vertex);
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
+	context->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+}
+
 Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetVertexBuffer() {
 	return vertexBuffer;
 }
@@ -13,7 +13,12 @@ public:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
 	int GetVertexCount();
 	int GetIndexCount();
+	DirectX::XMFLOAT3 GetBoundsCenter();
+	float GetBoundsRadius();
+	float GetWorldUnitsPerUv();
 	void Draw();
+	void Draw(ID3D11DeviceContext* context);
+	void Bind(ID3D11DeviceContext* context);
 	Mesh(Vertex vertices[], int vertexCount, unsigned int indices[], int indexCount);
 	Mesh(const wchar_t* filePath);
 	~Mesh();
@@ -21,10 +26,16 @@ public:
 private:
 	void ConstructBuffers(Vertex vertices[], unsigned int indices[]);
 	void CalculateTangents(Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount);
+	void CalculateBounds(Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount);
 
 	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
 	int vertexCount;
 	int indexCount;
+
+	//Local space bounding sphere, and the average surface covered by one 0-1 UV span
+	DirectX::XMFLOAT3 boundsCenter;
+	float boundsRadius;
+	float worldUnitsPerUv;
 };
 
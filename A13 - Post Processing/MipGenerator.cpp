@@ -0,0 +1,485 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <emmintrin.h>
+
+using namespace std;
+
+namespace
+{
+	// Which downsample kernel a chain is built with
+	enum class Kernel { BoxScalar, BoxSimd, Kaiser };
+
+	// --------------------------------------------------------
+	// 8-bit to float conversion tables, one per channel, so
+	// sRGB decode and normal unpacking are a single lookup
+	// --------------------------------------------------------
+	struct ByteToFloat
+	{
+		float channel[4][256];
+
+		ByteToFloat(MipColorSpace colorSpace)
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				float v = i / 255.0f;
+				float rgb = v;
+				if (colorSpace == MipColorSpace::SRGB)
+					rgb = v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+				else if (colorSpace == MipColorSpace::Normal)
+					rgb = v * 2.0f - 1.0f;
+
+				channel[0][i] = rgb;
+				channel[1][i] = rgb;
+				channel[2][i] = rgb;
+				channel[3][i] = v; // Alpha is always linear
+			}
+		}
+	};
+
+	const ByteToFloat& GetTable(MipColorSpace colorSpace)
+	{
+		static const ByteToFloat linear(MipColorSpace::Linear);
+		static const ByteToFloat srgb(MipColorSpace::SRGB);
+		static const ByteToFloat normal(MipColorSpace::Normal);
+
+		switch (colorSpace)
+		{
+		case MipColorSpace::SRGB: return srgb;
+		case MipColorSpace::Normal: return normal;
+		default: return linear;
+		}
+	}
+
+	// --------------------------------------------------------
+	// Pixel sources for the kernels.  The first reduction reads
+	// the 8-bit image directly through a table, so a float copy
+	// of the (largest) top level is never made.
+	// --------------------------------------------------------
+	struct FloatSource
+	{
+		const float* data;
+		unsigned int width;
+
+		__m128 Load(unsigned int x, unsigned int y) const { return _mm_loadu_ps(data + ((size_t)y * width + x) * 4); }
+		void Load(unsigned int x, unsigned int y, float out[4]) const
+		{
+			const float* p = data + ((size_t)y * width + x) * 4;
+			out[0] = p[0]; out[1] = p[1]; out[2] = p[2]; out[3] = p[3];
+		}
+	};
+
+	struct ByteSource
+	{
+		const unsigned char* data;
+		unsigned int width;
+		const ByteToFloat* table;
+
+		__m128 Load(unsigned int x, unsigned int y) const
+		{
+			const unsigned char* p = data + ((size_t)y * width + x) * 4;
+			return _mm_set_ps(table->channel[3][p[3]], table->channel[2][p[2]], table->channel[1][p[1]], table->channel[0][p[0]]);
+		}
+		void Load(unsigned int x, unsigned int y, float out[4]) const
+		{
+			const unsigned char* p = data + ((size_t)y * width + x) * 4;
+			for (int c = 0; c < 4; c++)
+				out[c] = table->channel[c][p[c]];
+		}
+	};
+
+	// Maps a possibly out of range texel index back into the image
+	unsigned int Edge(int i, unsigned int size, bool wrap)
+	{
+		if (wrap)
+			return (unsigned int)(((i % (int)size) + (int)size) % (int)size);
+		return (unsigned int)max(0, min(i, (int)size - 1));
+	}
+
+	unsigned int Half(unsigned int size) { return max(1u, size / 2); }
+
+	// Source indices for every destination texel along one axis, worked
+	// out once per level so the inner loops don't wrap or clamp
+	vector<unsigned int> TapIndices(unsigned int size, int taps, int firstOffset, bool wrap)
+	{
+		unsigned int dstSize = Half(size);
+		vector<unsigned int> indices((size_t)dstSize * taps);
+		for (unsigned int d = 0; d < dstSize; d++)
+		{
+			for (int i = 0; i < taps; i++)
+			{
+				// Nothing to reduce along an axis that's already one texel wide
+				indices[(size_t)d * taps + i] = size > 1 ? Edge((int)d * 2 + firstOffset + i, size, wrap) : 0;
+			}
+		}
+		return indices;
+	}
+
+	// --------------------------------------------------------
+	// 2x2 box filter.  Both versions add in the same order,
+	// so their results are bit-for-bit identical.
+	// --------------------------------------------------------
+	template <typename Source>
+	void BoxSimd(const Source& src, unsigned int width, unsigned int height, float* dst, bool wrap)
+	{
+		unsigned int dstWidth = Half(width);
+		unsigned int dstHeight = Half(height);
+		const __m128 quarter = _mm_set1_ps(0.25f);
+		vector<unsigned int> columns = TapIndices(width, 2, 0, wrap);
+		vector<unsigned int> rows = TapIndices(height, 2, 0, wrap);
+
+		for (unsigned int y = 0; y < dstHeight; y++)
+		{
+			unsigned int y0 = rows[y * 2];
+			unsigned int y1 = rows[y * 2 + 1];
+			float* out = dst + (size_t)y * dstWidth * 4;
+
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				unsigned int x0 = columns[x * 2];
+				unsigned int x1 = columns[x * 2 + 1];
+
+				__m128 top = _mm_add_ps(src.Load(x0, y0), src.Load(x1, y0));
+				__m128 bottom = _mm_add_ps(src.Load(x0, y1), src.Load(x1, y1));
+				_mm_storeu_ps(out + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+			}
+		}
+	}
+
+	template <typename Source>
+	void BoxScalar(const Source& src, unsigned int width, unsigned int height, float* dst, bool wrap)
+	{
+		unsigned int dstWidth = Half(width);
+		unsigned int dstHeight = Half(height);
+		vector<unsigned int> columns = TapIndices(width, 2, 0, wrap);
+		vector<unsigned int> rows = TapIndices(height, 2, 0, wrap);
+
+		for (unsigned int y = 0; y < dstHeight; y++)
+		{
+			unsigned int y0 = rows[y * 2];
+			unsigned int y1 = rows[y * 2 + 1];
+			float* out = dst + (size_t)y * dstWidth * 4;
+
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				unsigned int x0 = columns[x * 2];
+				unsigned int x1 = columns[x * 2 + 1];
+
+				float a[4], b[4], c[4], d[4];
+				src.Load(x0, y0, a);
+				src.Load(x1, y0, b);
+				src.Load(x0, y1, c);
+				src.Load(x1, y1, d);
+				for (int ch = 0; ch < 4; ch++)
+					out[x * 4 + ch] = ((a[ch] + b[ch]) + (c[ch] + d[ch])) * 0.25f;
+			}
+		}
+	}
+
+	// --------------------------------------------------------
+	// Kaiser-windowed sinc (alpha = 4) with a radius of 1.5
+	// destination texels, i.e. 6 source taps per axis
+	// --------------------------------------------------------
+	const int KaiserTaps = 6;
+
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (int k = 1; k < 20; k++)
+		{
+			term *= (x / (2.0f * k)) * (x / (2.0f * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	const float* KaiserWeights()
+	{
+		static float weights[KaiserTaps] = {};
+		static bool built = [] {
+			const float pi = 3.14159265f;
+			const float alpha = 4.0f;
+			const float radius = 1.5f;
+			float total = 0;
+			for (int i = 0; i < KaiserTaps; i++)
+			{
+				// Source taps sit at -2.5 .. 2.5 texels from the output's center,
+				// which is -1.25 .. 1.25 in destination texels
+				float t = (i - 2.5f) * 0.5f;
+				float sinc = fabsf(t) < 1e-5f ? 1.0f : sinf(pi * t) / (pi * t);
+				float r = t / radius;
+				float window = BesselI0(alpha * sqrtf(max(0.0f, 1.0f - r * r))) / BesselI0(alpha);
+				weights[i] = sinc * window;
+				total += weights[i];
+			}
+			for (int i = 0; i < KaiserTaps; i++)
+				weights[i] /= total;
+			return true;
+		}();
+		(void)built;
+		return weights;
+	}
+
+	// Separable: horizontal into a temporary, then vertical into dst
+	template <typename Source>
+	void KaiserSimd(const Source& src, unsigned int width, unsigned int height, float* dst, bool wrap)
+	{
+		unsigned int dstWidth = Half(width);
+		unsigned int dstHeight = Half(height);
+		const float* weights = KaiserWeights();
+
+		__m128 w[KaiserTaps];
+		for (int i = 0; i < KaiserTaps; i++)
+			w[i] = _mm_set1_ps(weights[i]);
+
+		vector<unsigned int> columns = TapIndices(width, KaiserTaps, -2, wrap);
+		vector<unsigned int> rows = TapIndices(height, KaiserTaps, -2, wrap);
+
+		vector<float> temp((size_t)dstWidth * height * 4);
+		for (unsigned int y = 0; y < height; y++)
+		{
+			float* out = temp.data() + (size_t)y * dstWidth * 4;
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				const unsigned int* sx = &columns[(size_t)x * KaiserTaps];
+				__m128 sum = _mm_setzero_ps();
+				for (int i = 0; i < KaiserTaps; i++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(src.Load(sx[i], y), w[i]));
+				_mm_storeu_ps(out + x * 4, sum);
+			}
+		}
+
+		FloatSource horizontal = { temp.data(), dstWidth };
+		for (unsigned int y = 0; y < dstHeight; y++)
+		{
+			const unsigned int* sy = &rows[(size_t)y * KaiserTaps];
+			float* out = dst + (size_t)y * dstWidth * 4;
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (int i = 0; i < KaiserTaps; i++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(horizontal.Load(x, sy[i]), w[i]));
+				_mm_storeu_ps(out + x * 4, sum);
+			}
+		}
+	}
+
+	template <typename Source>
+	void Reduce(Kernel kernel, const Source& src, unsigned int width, unsigned int height, float* dst, bool wrap)
+	{
+		switch (kernel)
+		{
+		case Kernel::BoxScalar: BoxScalar(src, width, height, dst, wrap); break;
+		case Kernel::BoxSimd: BoxSimd(src, width, height, dst, wrap); break;
+		case Kernel::Kaiser: KaiserSimd(src, width, height, dst, wrap); break;
+		}
+	}
+
+	// Averaged normals get shorter, so push them back onto the unit sphere
+	void Renormalize(float* data, size_t pixels)
+	{
+		for (size_t i = 0; i < pixels; i++)
+		{
+			float* n = data + i * 4;
+			float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (length > 1e-6f)
+			{
+				n[0] /= length;
+				n[1] /= length;
+				n[2] /= length;
+			}
+			else
+			{
+				n[0] = 0; n[1] = 0; n[2] = 1;
+			}
+		}
+	}
+
+	unsigned char ToByte(float v)
+	{
+		return (unsigned char)(max(0.0f, min(1.0f, v)) * 255.0f + 0.5f);
+	}
+
+	// --------------------------------------------------------
+	// Linear to 8-bit sRGB without a pow per channel.  The
+	// linear values halfway between neighboring sRGB codes are
+	// precomputed; a coarse table gives a starting code and
+	// the thresholds nudge it, which rounds the same as
+	// encoding exactly.
+	// --------------------------------------------------------
+	struct SrgbEncoder
+	{
+		static const int CoarseSize = 4096;
+		float thresholds[256];
+		unsigned char coarse[CoarseSize + 1];
+
+		SrgbEncoder()
+		{
+			for (int i = 0; i < 255; i++)
+			{
+				float s = (i + 0.5f) / 255.0f;
+				thresholds[i] = s <= 0.04045f ? s / 12.92f : powf((s + 0.055f) / 1.055f, 2.4f);
+			}
+			thresholds[255] = 2.0f; // Never reached after clamping
+
+			int code = 0;
+			for (int i = 0; i <= CoarseSize; i++)
+			{
+				while (code < 255 && (float)i / CoarseSize >= thresholds[code]) code++;
+				coarse[i] = (unsigned char)code;
+			}
+		}
+
+		unsigned char Encode(float v) const
+		{
+			v = max(0.0f, min(1.0f, v));
+			int code = coarse[(int)(v * CoarseSize)];
+			while (code < 255 && v >= thresholds[code]) code++;
+			while (code > 0 && v < thresholds[code - 1]) code--;
+			return (unsigned char)code;
+		}
+	};
+
+	void ToBytes(const float* data, size_t pixels, MipColorSpace colorSpace, unsigned char* out)
+	{
+		static const SrgbEncoder srgb;
+		for (size_t i = 0; i < pixels; i++)
+		{
+			const float* p = data + i * 4;
+			for (int c = 0; c < 3; c++)
+			{
+				if (colorSpace == MipColorSpace::SRGB)
+					out[i * 4 + c] = srgb.Encode(p[c]);
+				else if (colorSpace == MipColorSpace::Normal)
+					out[i * 4 + c] = ToByte(p[c] * 0.5f + 0.5f);
+				else
+					out[i * 4 + c] = ToByte(p[c]);
+			}
+			out[i * 4 + 3] = ToByte(p[3]);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Builds levels 1 and below
+	// --------------------------------------------------------
+	vector<DecodedImage> BuildChain(const DecodedImage& image, MipColorSpace colorSpace, Kernel kernel, bool wrap)
+	{
+		vector<DecodedImage> levels;
+		unsigned int count = MipGenerator::MipCount(image.Width, image.Height);
+		if (count <= 1 || image.Pixels.size() < (size_t)image.Width * image.Height * 4)
+			return levels;
+		levels.reserve(count - 1);
+
+		ByteSource top = { image.Pixels.data(), image.Width, &GetTable(colorSpace) };
+		vector<float> current;
+		vector<float> next;
+		unsigned int width = image.Width;
+		unsigned int height = image.Height;
+
+		for (unsigned int level = 1; level < count; level++)
+		{
+			unsigned int nextWidth = Half(width);
+			unsigned int nextHeight = Half(height);
+			size_t pixels = (size_t)nextWidth * nextHeight;
+			next.resize(pixels * 4);
+
+			if (level == 1)
+				Reduce(kernel, top, width, height, next.data(), wrap);
+			else
+				Reduce(kernel, FloatSource{ current.data(), width }, width, height, next.data(), wrap);
+
+			if (colorSpace == MipColorSpace::Normal)
+				Renormalize(next.data(), pixels);
+
+			DecodedImage mip;
+			mip.Width = nextWidth;
+			mip.Height = nextHeight;
+			mip.Pixels.resize(pixels * 4);
+			ToBytes(next.data(), pixels, colorSpace, mip.Pixels.data());
+			levels.push_back(move(mip));
+
+			swap(current, next);
+			width = nextWidth;
+			height = nextHeight;
+		}
+
+		return levels;
+	}
+}
+
+unsigned int MipGenerator::MipCount(unsigned int width, unsigned int height)
+{
+	unsigned int count = 1;
+	unsigned int size = max(width, height);
+	while (size > 1)
+	{
+		size /= 2;
+		count++;
+	}
+	return count;
+}
+
+vector<DecodedImage> MipGenerator::Generate(DecodedImage image, MipColorSpace colorSpace, MipFilter filter, bool wrapEdges)
+{
+	vector<DecodedImage> levels = BuildChain(image, colorSpace, filter == MipFilter::Kaiser ? Kernel::Kaiser : Kernel::BoxSimd, wrapEdges);
+
+	vector<DecodedImage> chain;
+	chain.reserve(levels.size() + 1);
+	chain.push_back(move(image));
+	for (auto& level : levels)
+		chain.push_back(move(level));
+	return chain;
+}
+
+void MipGenerator::DownsampleBox(const float* src, unsigned int width, unsigned int height, float* dst, bool wrapEdges)
+{
+	BoxSimd(FloatSource{ src, width }, width, height, dst, wrapEdges);
+}
+
+void MipGenerator::DownsampleBoxScalar(const float* src, unsigned int width, unsigned int height, float* dst, bool wrapEdges)
+{
+	BoxScalar(FloatSource{ src, width }, width, height, dst, wrapEdges);
+}
+
+void MipGenerator::DownsampleKaiser(const float* src, unsigned int width, unsigned int height, float* dst, bool wrapEdges)
+{
+	KaiserSimd(FloatSource{ src, width }, width, height, dst, wrapEdges);
+}
+
+// --------------------------------------------------------
+// Builds the chain three times (scalar box, SSE box, Kaiser)
+// --------------------------------------------------------
+MipBenchmarkResult MipGenerator::Benchmark(const DecodedImage& image, MipColorSpace colorSpace)
+{
+	MipBenchmarkResult result;
+
+	auto milliseconds = [](chrono::steady_clock::time_point start) {
+		return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	};
+
+	auto start = chrono::steady_clock::now();
+	vector<DecodedImage> levels = BuildChain(image, colorSpace, Kernel::BoxScalar, true);
+	result.ScalarMilliseconds = milliseconds(start);
+
+	start = chrono::steady_clock::now();
+	BuildChain(image, colorSpace, Kernel::BoxSimd, true);
+	result.SimdMilliseconds = milliseconds(start);
+
+	start = chrono::steady_clock::now();
+	BuildChain(image, colorSpace, Kernel::Kaiser, true);
+	result.KaiserMilliseconds = milliseconds(start);
+
+	unsigned int width = image.Width;
+	unsigned int height = image.Height;
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		result.Megapixels += (double)width * height / 1000000.0;
+		width = Half(width);
+		height = Half(height);
+	}
+
+	return result;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "PngDecoder.h"
+
+#include <vector>
+
+// How a texture's color channels should be treated when filtering
+enum class MipColorSpace
+{
+	Linear,	// Data maps (roughness, metalness, etc.) - averaged as-is
+	SRGB,	// Colors - averaged in linear light, then re-encoded
+	Normal	// Tangent space normals - unpacked, averaged and renormalized
+};
+
+enum class MipFilter
+{
+	Box,	// 2x2 average, fastest
+	Kaiser	// 6 tap Kaiser-windowed sinc, sharper with less aliasing
+};
+
+// Timings from building the same chain with each kernel
+struct MipBenchmarkResult
+{
+	double Megapixels = 0;			// Pixels processed across the whole chain
+	double ScalarMilliseconds = 0;	// Box, reference kernel
+	double SimdMilliseconds = 0;	// Box, SSE kernel
+	double KaiserMilliseconds = 0;	// Kaiser, SSE kernel
+};
+
+// --------------------------------------------------------
+// Builds full mip chains on the CPU, so textures can be
+// uploaded with every level at once (no GenerateMips, no
+// render target binding) and filtered in the right space.
+//
+// Filtering happens on 32-bit float RGBA, one pixel per SSE
+// register.  Each level is built from the previous level's
+// floats rather than its 8-bit result, so rounding error
+// doesn't accumulate down the chain.
+//
+// Tests/MipGeneratorTests.cpp checks the chains against a
+// direct double precision reference.
+// --------------------------------------------------------
+namespace MipGenerator
+{
+	unsigned int MipCount(unsigned int width, unsigned int height);
+
+	// Returns the whole chain, with the original image as level 0.
+	// Wrapping edges suits tiling textures; cube faces should clamp
+	std::vector<DecodedImage> Generate(DecodedImage image, MipColorSpace colorSpace, MipFilter filter = MipFilter::Box, bool wrapEdges = true);
+
+	// Single 2x reductions of float RGBA data (exposed for comparison)
+	void DownsampleBox(const float* src, unsigned int width, unsigned int height, float* dst, bool wrapEdges);
+	void DownsampleBoxScalar(const float* src, unsigned int width, unsigned int height, float* dst, bool wrapEdges);
+	void DownsampleKaiser(const float* src, unsigned int width, unsigned int height, float* dst, bool wrapEdges);
+
+	// Builds the chain for the image with each kernel and times them
+	MipBenchmarkResult Benchmark(const DecodedImage& image, MipColorSpace colorSpace);
+}
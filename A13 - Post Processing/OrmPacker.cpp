@@ -0,0 +1,84 @@
+#include "OrmPacker.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	// Copies one source's red channel into a channel of the packed image,
+	// or fills that channel with a constant when there's no source.
+	// Source texels are picked by texel center: (2x + 1) / 2 * srcW / dstW
+	void FillChannel(DecodedImage& packed, int channel, const DecodedImage* source, unsigned char fallback)
+	{
+		for (unsigned int y = 0; y < packed.Height; y++)
+		{
+			unsigned char* out = &packed.Pixels[(size_t)y * packed.Width * 4 + channel];
+			if (!source)
+			{
+				for (unsigned int x = 0; x < packed.Width; x++)
+					out[x * 4] = fallback;
+				continue;
+			}
+
+			unsigned int sy = (unsigned int)(((unsigned long long)y * 2 + 1) * source->Height / (2ull * packed.Height));
+			const unsigned char* row = &source->Pixels[(size_t)sy * source->Width * 4];
+			for (unsigned int x = 0; x < packed.Width; x++)
+			{
+				unsigned int sx = (unsigned int)(((unsigned long long)x * 2 + 1) * source->Width / (2ull * packed.Width));
+				out[x * 4] = row[sx * 4];
+			}
+		}
+	}
+
+	bool IsValid(const DecodedImage* image)
+	{
+		return !image || (image->Width > 0 && image->Height > 0 && image->Pixels.size() >= (size_t)image->Width * image->Height * 4);
+	}
+}
+
+bool OrmPacker::Pack(const DecodedImage* occlusion, const DecodedImage* roughness, const DecodedImage* metalness, DecodedImage& packed, string* error)
+{
+	if (!occlusion && !roughness && !metalness)
+	{
+		if (error) *error = "No maps to pack";
+		return false;
+	}
+	if (!IsValid(occlusion) || !IsValid(roughness) || !IsValid(metalness))
+	{
+		if (error) *error = "Source map has no pixels";
+		return false;
+	}
+
+	packed.Width = 0;
+	packed.Height = 0;
+	for (const DecodedImage* source : { occlusion, roughness, metalness })
+	{
+		if (!source) continue;
+		packed.Width = max(packed.Width, source->Width);
+		packed.Height = max(packed.Height, source->Height);
+	}
+	packed.Pixels.assign((size_t)packed.Width * packed.Height * 4, 255);
+
+	FillChannel(packed, OcclusionChannel, occlusion, DefaultOcclusion);
+	FillChannel(packed, RoughnessChannel, roughness, DefaultRoughness);
+	FillChannel(packed, MetalnessChannel, metalness, DefaultMetalness);
+	return true;
+}
+
+bool OrmPacker::PackFiles(const wstring& occlusion, const wstring& roughness, const wstring& metalness, DecodedImage& packed, string* error)
+{
+	const wstring* paths[3] = { &occlusion, &roughness, &metalness };
+	DecodedImage images[3];
+	const DecodedImage* sources[3] = {};
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (paths[i]->empty()) continue;
+		if (!PngDecoder::DecodeFile(*paths[i], images[i], error))
+			return false;
+		sources[i] = &images[i];
+	}
+
+	return Pack(sources[0], sources[1], sources[2], packed, error);
+}
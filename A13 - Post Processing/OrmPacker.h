@@ -0,0 +1,39 @@
+#pragma once
+
+#include "PngDecoder.h"
+
+#include <string>
+
+// --------------------------------------------------------
+// Bakes separate occlusion, roughness and metalness maps
+// into a single ORM texture (the glTF layout):
+//
+//  R - ambient occlusion
+//  G - roughness
+//  B - metalness
+//  A - unused, always 255
+//
+// Each source contributes its red channel, as grayscale
+// maps decode to equal RGB.  Any map can be left out and its
+// channel is filled with a neutral value instead.  Maps of
+// different sizes are allowed: the result takes the largest
+// size and smaller maps are point sampled up to it, so a
+// low resolution metalness mask keeps its exact values.
+// --------------------------------------------------------
+namespace OrmPacker
+{
+	const int OcclusionChannel = 0;
+	const int RoughnessChannel = 1;
+	const int MetalnessChannel = 2;
+
+	// Used for any map that isn't provided
+	const unsigned char DefaultOcclusion = 255;
+	const unsigned char DefaultRoughness = 255;
+	const unsigned char DefaultMetalness = 0;
+
+	// Null for a missing map, at least one must be given
+	bool Pack(const DecodedImage* occlusion, const DecodedImage* roughness, const DecodedImage* metalness, DecodedImage& packed, std::string* error = 0);
+
+	// Empty paths are treated as missing maps; files that fail to decode are errors
+	bool PackFiles(const std::wstring& occlusion, const std::wstring& roughness, const std::wstring& metalness, DecodedImage& packed, std::string* error = 0);
+}
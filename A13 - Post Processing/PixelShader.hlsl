@@ -1,18 +1,40 @@
 #include "ShaderIncludes.hlsli"
 
+#define MAX_CASCADES 4 // Must match CascadedShadows::MaxCascades
+#define MAX_SHADOW_TILES 16 // Must match ShadowAtlas::MaxTiles
+#define MAX_LIGHTS 5 // Must match LocalShadows::MaxLights
+
+// Same layout as ShadowCascadeData
+struct ShadowCascades
+{
+    matrix viewProjections[MAX_CASCADES];
+    float4 ends; // Far view depth of each cascade
+    int count;
+};
+
+// Same layout as LocalShadowData
+struct LocalShadows
+{
+    matrix viewProjections[MAX_SHADOW_TILES];
+    float4 tiles[MAX_SHADOW_TILES]; // Atlas UV offset (xy) and scale (zw)
+    int4 lightTiles[MAX_LIGHTS]; // First tile (x) and how many (y) - none for no shadow
+};
+
 cbuffer ExternalData : register(b0) {
 	float4 colorTint;
     float3 cameraPos;
     float totalTime;
     float roughness;
-    Light lights[5];
+    Light lights[MAX_LIGHTS];
+    ShadowCascades shadowCascades;
+    LocalShadows localShadows;
 }
 
 Texture2D Albedo : register(t0);
 Texture2D NormalMap : register(t1);
-Texture2D RoughnessMap : register(t2);
-Texture2D MetalnessMap : register(t3);
-Texture2D ShadowMap : register(t4);
+Texture2D OrmMap : register(t2); // R - occlusion, G - roughness, B - metalness
+Texture2DArray ShadowMap : register(t3); // One slice per cascade
+Texture2D ShadowAtlas : register(t4); // Tiles for the point and spot lights
 SamplerState LerpSampler : register(s0);
 SamplerComparisonState ShadowSampler : register(s1);
 
@@ -34,11 +56,73 @@ float3 constructLight(VertexToPixel input, Light light, float3 surfaceColor, flo
     float3 balancedDiffuse = DiffuseEnergyConserve(diffuseTerm, fresnel, metalness);
     
     float3 finalLight = (balancedDiffuse * surfaceColor + specular) * light.intensity * light.color;
-    if (light.type == LIGHT_TYPE_POINT)
+    if (light.type != LIGHT_TYPE_DIRECTIONAL)
         finalLight *= Attenuate(light, input.worldPosition);
     return finalLight;
 }
 
+// Picks the first cascade that reaches this far from the camera
+// and compares against it - past the last one is fully lit
+float SampleShadow(float3 worldPosition, float viewDepth)
+{
+    int cascade = 0;
+    [unroll]
+    for (int i = 0; i < MAX_CASCADES - 1; i++)
+        cascade += (i < shadowCascades.count - 1 && viewDepth > shadowCascades.ends[i]) ? 1 : 0;
+    if (viewDepth > shadowCascades.ends[cascade])
+        return 1;
+    
+    float4 shadowPos = mul(shadowCascades.viewProjections[cascade], float4(worldPosition, 1.0f));
+    float2 shadowUV = shadowPos.xy * 0.5f + 0.5f;
+    shadowUV.y = 1 - shadowUV.y; // Flip the Y
+    
+    // Orthographic, so no divide by w - z is already the light-to-pixel depth
+    return ShadowMap.SampleCmpLevelZero(ShadowSampler, float3(shadowUV, cascade), shadowPos.z).r;
+}
+
+// Finds the light's face for this pixel - by the major axis for a cube, in
+// +X, -X, +Y, -Y, +Z, -Z order - then compares within that face's tile
+float SampleLocalShadow(int light, float3 worldPosition)
+{
+    int4 lightTiles = localShadows.lightTiles[light];
+    if (lightTiles.y == 0)
+        return 1;
+    
+    int tile = lightTiles.x;
+    if (lightTiles.y == 6)
+    {
+        float3 direction = worldPosition - lights[light].position;
+        float3 axis = abs(direction);
+        if (axis.x >= axis.y && axis.x >= axis.z)
+            tile += direction.x < 0 ? 1 : 0;
+        else if (axis.y >= axis.z)
+            tile += direction.y < 0 ? 3 : 2;
+        else
+            tile += direction.z < 0 ? 5 : 4;
+    }
+    
+    // Perspective this time, so divide by w
+    float4 shadowPos = mul(localShadows.viewProjections[tile], float4(worldPosition, 1.0f));
+    shadowPos.xyz /= shadowPos.w;
+    float2 shadowUV = shadowPos.xy * float2(0.5f, -0.5f) + 0.5f;
+    
+    // Kept half a texel inside the tile, so filtering never reads its neighbours
+    float2 atlasSize;
+    ShadowAtlas.GetDimensions(atlasSize.x, atlasSize.y);
+    float4 rect = localShadows.tiles[tile];
+    float2 halfTexel = 0.5f / atlasSize;
+    shadowUV = clamp(rect.xy + shadowUV * rect.zw, rect.xy + halfTexel, rect.xy + rect.zw - halfTexel);
+    return ShadowAtlas.SampleCmpLevelZero(ShadowSampler, shadowUV, shadowPos.z).r;
+}
+
+// Fades out over the outer fifth of a spot light's cone
+float SpotCone(Light light, float3 worldPosition)
+{
+    float cosine = dot(normalize(worldPosition - light.position), normalize(light.direction));
+    float outer = light.spotAngle * 0.5f;
+    return smoothstep(cos(outer), cos(outer * 0.8f), cosine);
+}
+
 float3 transformNormal(float3 normal, float3 tangent, float3 unpackedNormal)
 {
     float3 gsTangent = normalize(tangent - normal * dot(tangent, normal));
@@ -58,35 +142,36 @@ float3 transformNormal(float3 normal, float3 tangent, float3 unpackedNormal)
 // --------------------------------------------------------
 float4 main(VertexToPixel input) : SV_TARGET
 {
-    input.shadowMapPos /= input.shadowMapPos.w;
-    
-    float2 shadowUV = input.shadowMapPos.xy * 0.5f + 0.5f;
-    shadowUV.y = 1 - shadowUV.y; // Flip the Y
-    
-    // Grab the distances we need: light-to-pixel and closest-surface
-    float distToLight = input.shadowMapPos.z;
-    float shadowAmount = ShadowMap.SampleCmpLevelZero(ShadowSampler, shadowUV, distToLight).r;
+    float shadowAmount = SampleShadow(input.worldPosition, input.viewDepth);
     
     input.normal = normalize(input.normal);
     input.tangent = normalize(input.tangent);
     
-    float3 unpackedNormal = normalize(NormalMap.Sample(LerpSampler, input.uv).rgb * 2 - 1);
+    // Normal maps are BC5 (XY only), so rebuild Z from the unit length
+    float2 normalXY = NormalMap.Sample(LerpSampler, input.uv).rg * 2 - 1;
+    float3 unpackedNormal = float3(normalXY, sqrt(saturate(1 - dot(normalXY, normalXY))));
     input.normal = transformNormal(input.normal, input.tangent, unpackedNormal);
     
     float3 finalLight;
     
     float3 surfaceColor = pow(Albedo.Sample(LerpSampler, input.uv).rgb, 2.2f);
-    float roughness = RoughnessMap.Sample(LerpSampler, input.uv).r;
-    float metalness = MetalnessMap.Sample(LerpSampler, input.uv).r;
+    // One fetch for every scalar map; occlusion (orm.r) has nothing to
+    // scale until there's an ambient term
+    float3 orm = OrmMap.Sample(LerpSampler, input.uv).rgb;
+    float roughness = orm.g;
+    float metalness = orm.b;
     float3 specularColor = lerp(F0_NON_METAL, surfaceColor, metalness);
     
-    for (int i = 0; i < 5; i++)
+    for (int i = 0; i < MAX_LIGHTS; i++)
     {
-        if (lights[i].type == LIGHT_TYPE_POINT)
+        if (lights[i].type != LIGHT_TYPE_DIRECTIONAL)
         {
             Light editableLight = lights[i];
             editableLight.direction = input.worldPosition - editableLight.position;
-            finalLight += constructLight(input, editableLight, surfaceColor, specularColor, roughness, metalness);
+            float3 lightResult = constructLight(input, editableLight, surfaceColor, specularColor, roughness, metalness);
+            if (lights[i].type == LIGHT_TYPE_SPOT)
+                lightResult *= SpotCone(lights[i], input.worldPosition);
+            finalLight += lightResult * SampleLocalShadow(i, input.worldPosition);
         }
         else
         {
@@ -104,5 +189,6 @@ float4 main(VertexToPixel input) : SV_TARGET
 	//   interpolated for each pixel between the corresponding vertices 
 	//   of the triangle we're rendering
 	//return colorTint * float4(input.tangent, 1);
-    return float4(pow(finalLight, 1.0f/2.2f), 1);
+    // Linear HDR - the post process exposes, tonemaps and encodes it for display
+    return float4(finalLight, 1);
 }
\ No newline at end of file
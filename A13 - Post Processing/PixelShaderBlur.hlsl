@@ -1,8 +1,17 @@
+#include "PostEffects.hlsli"
+
+// Must match GaussianBlur::MaxTaps
+#define MAX_GAUSSIAN_TAPS 16
+
+// One pass of a separable Gaussian - run once horizontally, then
+// once vertically on the result.  Weights come from GaussianBlur
+// on the CPU, already merged into bilinear taps.  As the last
+// pass it's compiled with the post effects in use.
 cbuffer externalData : register(b0)
 {
-    int blurRadius;
-    float pixelWidth;
-    float pixelHeight;
+    float2 direction;                   // One texel along the pass: (1/width, 0) or (0, 1/height)
+    int tapCount;
+    float4 taps[MAX_GAUSSIAN_TAPS];     // x = offset in texels, y = weight (sampled at +/- offset)
 }
 struct VertexToPixel
 {
@@ -15,22 +24,13 @@ SamplerState ClampSampler : register(s0);
 
 float4 main(VertexToPixel input) : SV_TARGET
 {
-    // Track the total color and number of samples
-    float4 total = 0;
-    int sampleCount = 0;
-    // Loop through the "box"
-    for (int x = -blurRadius; x <= blurRadius; x++)
+    // The center tap is only sampled once
+    float4 total = Pixels.Sample(ClampSampler, input.uv) * taps[0].y;
+    for (int i = 1; i < tapCount; i++)
     {
-        for (int y = -blurRadius; y <= blurRadius; y++)
-        {
-            // Calculate the uv for this sample
-            float2 uv = input.uv;
-            uv += float2(x * pixelWidth, y * pixelHeight);
-            // Add this color to the running total
-            total += Pixels.Sample(ClampSampler, uv);
-            sampleCount++;
-        }
+        // Each tap lands between two texels, so one filtered fetch reads both
+        float2 offset = direction * taps[i].x;
+        total += (Pixels.Sample(ClampSampler, input.uv + offset) + Pixels.Sample(ClampSampler, input.uv - offset)) * taps[i].y;
     }
-    // Return the average
-    return total / sampleCount;
-}
\ No newline at end of file
+    return ApplyPostEffects(total, input.uv);
+}
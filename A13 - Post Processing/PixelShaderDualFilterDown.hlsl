@@ -0,0 +1,27 @@
+// Dual filter downsample - draws into a target half the size of
+// Pixels.  Must match DualFilterBlur::Downsample on the CPU.
+cbuffer externalData : register(b0)
+{
+    float2 halfPixel;   // Half a texel of the source: 0.5 / source size
+    float offset;       // Tap spread, in half texels
+}
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+Texture2D Pixels : register(t0);
+SamplerState ClampSampler : register(s0);
+
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    // The center, plus the four diagonals - each a filtered fetch of four texels
+    float2 spread = halfPixel * offset;
+    float4 total = Pixels.Sample(ClampSampler, input.uv) * 4.0f;
+    total += Pixels.Sample(ClampSampler, input.uv - spread);
+    total += Pixels.Sample(ClampSampler, input.uv + spread);
+    total += Pixels.Sample(ClampSampler, input.uv + float2(spread.x, -spread.y));
+    total += Pixels.Sample(ClampSampler, input.uv + float2(-spread.x, spread.y));
+    return total / 8.0f;
+}
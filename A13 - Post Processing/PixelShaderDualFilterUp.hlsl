@@ -0,0 +1,33 @@
+#include "PostEffects.hlsli"
+
+// Dual filter upsample - draws into a target twice the size of
+// Pixels.  Must match DualFilterBlur::Upsample on the CPU.  As
+// the last pass it's compiled with the post effects in use.
+cbuffer externalData : register(b0)
+{
+    float2 halfPixel;   // Half a texel of the source: 0.5 / source size
+    float offset;       // Tap spread, in half texels
+}
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+Texture2D Pixels : register(t0);
+SamplerState ClampSampler : register(s0);
+
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    // The four axes a full texel out, and the four diagonals (weighted double) half a texel out
+    float2 spread = halfPixel * offset;
+    float4 total = Pixels.Sample(ClampSampler, input.uv + float2(-spread.x * 2.0f, 0.0f));
+    total += Pixels.Sample(ClampSampler, input.uv + float2(spread.x * 2.0f, 0.0f));
+    total += Pixels.Sample(ClampSampler, input.uv + float2(0.0f, -spread.y * 2.0f));
+    total += Pixels.Sample(ClampSampler, input.uv + float2(0.0f, spread.y * 2.0f));
+    total += Pixels.Sample(ClampSampler, input.uv + float2(-spread.x, spread.y)) * 2.0f;
+    total += Pixels.Sample(ClampSampler, input.uv + float2(spread.x, spread.y)) * 2.0f;
+    total += Pixels.Sample(ClampSampler, input.uv + float2(spread.x, -spread.y)) * 2.0f;
+    total += Pixels.Sample(ClampSampler, input.uv + float2(-spread.x, -spread.y)) * 2.0f;
+    return ApplyPostEffects(total / 12.0f, input.uv);
+}
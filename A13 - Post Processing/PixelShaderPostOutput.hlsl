@@ -0,0 +1,17 @@
+#include "PostEffects.hlsli"
+
+// Writes the scene to the back buffer through the post effects,
+// for when there's no blur pass to fuse them into
+struct VertexToPixel
+{
+    float4 position : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+Texture2D Pixels : register(t0);
+SamplerState ClampSampler : register(s0);
+
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    return ApplyPostEffects(Pixels.Sample(ClampSampler, input.uv), input.uv);
+}
@@ -5,6 +5,8 @@ SamplerState LerpSampler : register(s0);
 
 float4 main(VertexToPixel_Sky input) : SV_TARGET
 {
-	
-    return SkyBoxTexture.Sample(LerpSampler, input.sampleDirection);
+    // The cube map is gamma encoded (UNORM, not SRGB) but the scene target is
+    // linear, and the output pass encodes it - so decode it here
+    float4 color = SkyBoxTexture.Sample(LerpSampler, input.sampleDirection);
+    return float4(pow(color.rgb, 2.2f), color.a);
 }
\ No newline at end of file
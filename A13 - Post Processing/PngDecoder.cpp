@@ -0,0 +1,596 @@
+#include "PngDecoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+	// --------------------------------------------------------
+	// LSB-first bit reader over a byte buffer, as DEFLATE wants.
+	// Reading past the end yields zeros; callers check Overrun()
+	// so a truncated stream fails instead of looping forever.
+	// --------------------------------------------------------
+	struct BitReader
+	{
+		const unsigned char* data;
+		size_t size;
+		size_t pos = 0;
+		unsigned long long bits = 0;
+		int count = 0;
+
+		void Refill()
+		{
+			while (count <= 56)
+			{
+				unsigned long long b = pos < size ? data[pos] : 0;
+				pos++;
+				bits |= b << count;
+				count += 8;
+			}
+		}
+
+		unsigned int Get(int n)
+		{
+			if (n == 0) return 0;
+			if (count < n) Refill();
+			unsigned int v = (unsigned int)(bits & ((1ull << n) - 1));
+			bits >>= n;
+			count -= n;
+			return v;
+		}
+
+		void AlignToByte()
+		{
+			int drop = count % 8;
+			bits >>= drop;
+			count -= drop;
+		}
+
+		bool Overrun() const { return pos > size + 8; }
+	};
+
+	// --------------------------------------------------------
+	// Canonical Huffman table with a direct lookup for short
+	// codes and a bit-by-bit fallback for long ones
+	// --------------------------------------------------------
+	const int FastBits = 9;
+
+	struct Huffman
+	{
+		unsigned short fast[1 << FastBits];	// (length << 9) | symbol, 0 if not a short code
+		unsigned short count[16];			// Number of codes of each length
+		unsigned short symbol[288];			// Symbols ordered by code
+
+		bool Build(const unsigned char* lengths, int n)
+		{
+			memset(fast, 0, sizeof(fast));
+			memset(count, 0, sizeof(count));
+			for (int i = 0; i < n; i++)
+				count[lengths[i]]++;
+			count[0] = 0;
+
+			// Reject over-subscribed code sets (incomplete ones are legal)
+			int left = 1;
+			for (int len = 1; len < 16; len++)
+			{
+				left <<= 1;
+				left -= count[len];
+				if (left < 0) return false;
+			}
+
+			unsigned short offsets[16];
+			offsets[1] = 0;
+			for (int len = 1; len < 15; len++)
+				offsets[len + 1] = offsets[len] + count[len];
+			for (int i = 0; i < n; i++)
+			{
+				if (lengths[i] != 0)
+					symbol[offsets[lengths[i]]++] = (unsigned short)i;
+			}
+
+			// Fill the fast table using bit-reversed canonical codes
+			int code = 0;
+			int index = 0;
+			for (int len = 1; len < 16; len++)
+			{
+				for (int k = 0; k < count[len]; k++, code++)
+				{
+					unsigned short sym = symbol[index++];
+					if (len > FastBits) continue;
+
+					int reversed = 0;
+					for (int b = 0; b < len; b++)
+						reversed |= ((code >> b) & 1) << (len - 1 - b);
+					for (int j = reversed; j < (1 << FastBits); j += (1 << len))
+						fast[j] = (unsigned short)((len << 9) | sym);
+				}
+				code <<= 1;
+			}
+			return true;
+		}
+
+		int Decode(BitReader& br) const
+		{
+			if (br.count < 16) br.Refill();
+			unsigned short entry = fast[br.bits & ((1 << FastBits) - 1)];
+			if (entry)
+			{
+				int len = entry >> 9;
+				br.bits >>= len;
+				br.count -= len;
+				return entry & 511;
+			}
+
+			// Slow path: walk the canonical code one bit at a time
+			int code = 0, first = 0, index = 0;
+			for (int len = 1; len < 16; len++)
+			{
+				code |= (int)br.Get(1);
+				int cnt = count[len];
+				if (code - cnt < first)
+					return symbol[index + (code - first)];
+				index += cnt;
+				first += cnt;
+				first <<= 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+	};
+
+	const unsigned short LengthBase[29] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+	const unsigned char LengthExtra[29] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+	const unsigned short DistBase[30] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+	const unsigned char DistExtra[30] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+	bool InflateCodes(BitReader& br, const Huffman& lit, const Huffman& dist, vector<unsigned char>& out)
+	{
+		while (true)
+		{
+			int sym = lit.Decode(br);
+			if (sym < 0 || br.Overrun()) return false;
+
+			if (sym < 256)
+			{
+				out.push_back((unsigned char)sym);
+				continue;
+			}
+			if (sym == 256)
+				return true;
+
+			sym -= 257;
+			if (sym >= 29) return false;
+			size_t length = LengthBase[sym] + br.Get(LengthExtra[sym]);
+
+			int dsym = dist.Decode(br);
+			if (dsym < 0 || dsym >= 30) return false;
+			size_t distance = DistBase[dsym] + br.Get(DistExtra[dsym]);
+			if (distance > out.size()) return false;
+
+			// Byte-by-byte, since the source and destination may overlap
+			size_t from = out.size() - distance;
+			for (size_t i = 0; i < length; i++)
+				out.push_back(out[from + i]);
+		}
+	}
+
+	bool InflateRaw(BitReader& br, vector<unsigned char>& out)
+	{
+		Huffman lit, dist;
+		bool last = false;
+		while (!last)
+		{
+			last = br.Get(1) != 0;
+			unsigned int type = br.Get(2);
+
+			if (type == 0)
+			{
+				// Stored block
+				br.AlignToByte();
+				unsigned int len = br.Get(16);
+				unsigned int nlen = br.Get(16);
+				if ((len ^ 0xFFFF) != nlen) return false;
+				for (unsigned int i = 0; i < len; i++)
+					out.push_back((unsigned char)br.Get(8));
+				if (br.Overrun()) return false;
+			}
+			else if (type == 1)
+			{
+				// Fixed Huffman codes
+				unsigned char lengths[288 + 30];
+				for (int i = 0; i < 144; i++) lengths[i] = 8;
+				for (int i = 144; i < 256; i++) lengths[i] = 9;
+				for (int i = 256; i < 280; i++) lengths[i] = 7;
+				for (int i = 280; i < 288; i++) lengths[i] = 8;
+				for (int i = 0; i < 30; i++) lengths[288 + i] = 5;
+				lit.Build(lengths, 288);
+				dist.Build(lengths + 288, 30);
+				if (!InflateCodes(br, lit, dist, out)) return false;
+			}
+			else if (type == 2)
+			{
+				// Dynamic Huffman codes
+				static const unsigned char order[19] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+				int hlit = br.Get(5) + 257;
+				int hdist = br.Get(5) + 1;
+				int hclen = br.Get(4) + 4;
+				if (hlit > 286 || hdist > 30) return false;
+
+				unsigned char codeLengths[19] = {};
+				for (int i = 0; i < hclen; i++)
+					codeLengths[order[i]] = (unsigned char)br.Get(3);
+				Huffman lengthCode;
+				if (!lengthCode.Build(codeLengths, 19)) return false;
+
+				unsigned char lengths[286 + 30] = {};
+				int n = 0;
+				while (n < hlit + hdist)
+				{
+					int sym = lengthCode.Decode(br);
+					if (sym < 0 || br.Overrun()) return false;
+
+					if (sym < 16)
+					{
+						lengths[n++] = (unsigned char)sym;
+						continue;
+					}
+
+					unsigned char value = 0;
+					int repeat = 0;
+					if (sym == 16)
+					{
+						if (n == 0) return false;
+						value = lengths[n - 1];
+						repeat = 3 + br.Get(2);
+					}
+					else if (sym == 17) repeat = 3 + br.Get(3);
+					else repeat = 11 + br.Get(7);
+
+					if (n + repeat > hlit + hdist) return false;
+					while (repeat--) lengths[n++] = value;
+				}
+
+				if (!lit.Build(lengths, hlit) || !dist.Build(lengths + hlit, hdist)) return false;
+				if (!InflateCodes(br, lit, dist, out)) return false;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	unsigned int ReadBigEndian(const unsigned char* p)
+	{
+		return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+	}
+
+	unsigned char Paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+		if (pa <= pb && pa <= pc) return (unsigned char)a;
+		if (pb <= pc) return (unsigned char)b;
+		return (unsigned char)c;
+	}
+
+	bool Fail(string* error, const char* message)
+	{
+		if (error) *error = message;
+		return false;
+	}
+}
+
+// --------------------------------------------------------
+// Decompresses a zlib stream (2 byte header + DEFLATE data).
+// The trailing Adler-32 checksum isn't verified.
+// --------------------------------------------------------
+bool PngDecoder::Inflate(const unsigned char* data, size_t size, vector<unsigned char>& out)
+{
+	if (size < 2) return false;
+
+	// Compression method must be DEFLATE with no preset dictionary
+	if ((data[0] & 0x0F) != 8 || (data[1] & 0x20) || ((data[0] << 8) | data[1]) % 31 != 0)
+		return false;
+
+	BitReader br = { data + 2, size - 2 };
+	return InflateRaw(br, out);
+}
+
+// --------------------------------------------------------
+// Decodes an in-memory PNG file into 8-bit RGBA
+// --------------------------------------------------------
+bool PngDecoder::Decode(const unsigned char* fileBytes, size_t size, DecodedImage& image, string* error)
+{
+	static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	if (size < 8 || memcmp(fileBytes, signature, 8) != 0)
+		return Fail(error, "Not a PNG file");
+
+	unsigned int width = 0, height = 0;
+	int bitDepth = 0, colorType = -1, interlace = 0;
+	vector<unsigned char> palette;		// RGBA entries
+	vector<unsigned char> compressed;
+	bool hasColorKey = false;
+	unsigned short colorKey[3] = {};
+
+	// Walk the chunks
+	size_t pos = 8;
+	bool ended = false;
+	while (!ended && pos + 12 <= size)
+	{
+		unsigned int length = ReadBigEndian(fileBytes + pos);
+		const unsigned char* type = fileBytes + pos + 4;
+		const unsigned char* data = fileBytes + pos + 8;
+		if (length > size - pos - 12)
+			return Fail(error, "Truncated chunk");
+
+		if (memcmp(type, "IHDR", 4) == 0)
+		{
+			if (length < 13) return Fail(error, "Bad IHDR");
+			width = ReadBigEndian(data);
+			height = ReadBigEndian(data + 4);
+			bitDepth = data[8];
+			colorType = data[9];
+			interlace = data[12];
+		}
+		else if (memcmp(type, "PLTE", 4) == 0)
+		{
+			palette.assign((length / 3) * 4, 255);
+			for (unsigned int i = 0; i < length / 3; i++)
+			{
+				palette[i * 4 + 0] = data[i * 3 + 0];
+				palette[i * 4 + 1] = data[i * 3 + 1];
+				palette[i * 4 + 2] = data[i * 3 + 2];
+			}
+		}
+		else if (memcmp(type, "tRNS", 4) == 0)
+		{
+			if (colorType == 3)
+			{
+				for (unsigned int i = 0; i < length && i * 4 + 3 < palette.size(); i++)
+					palette[i * 4 + 3] = data[i];
+			}
+			else if (colorType == 0 && length >= 2)
+			{
+				hasColorKey = true;
+				colorKey[0] = (unsigned short)((data[0] << 8) | data[1]);
+			}
+			else if (colorType == 2 && length >= 6)
+			{
+				hasColorKey = true;
+				for (int c = 0; c < 3; c++)
+					colorKey[c] = (unsigned short)((data[c * 2] << 8) | data[c * 2 + 1]);
+			}
+		}
+		else if (memcmp(type, "IDAT", 4) == 0)
+		{
+			compressed.insert(compressed.end(), data, data + length);
+		}
+		else if (memcmp(type, "IEND", 4) == 0)
+		{
+			ended = true;
+		}
+
+		pos += 12 + (size_t)length;
+	}
+
+	// Validate the header
+	int channels = 0;
+	switch (colorType)
+	{
+	case 0: channels = 1; break;	// Gray
+	case 2: channels = 3; break;	// RGB
+	case 3: channels = 1; break;	// Palette
+	case 4: channels = 2; break;	// Gray + alpha
+	case 6: channels = 4; break;	// RGBA
+	default: return Fail(error, "Unsupported color type");
+	}
+	if (bitDepth != 1 && bitDepth != 2 && bitDepth != 4 && bitDepth != 8 && bitDepth != 16)
+		return Fail(error, "Unsupported bit depth");
+	if ((colorType == 3 && bitDepth == 16) || ((colorType == 2 || colorType == 4 || colorType == 6) && bitDepth < 8))
+		return Fail(error, "Invalid color type and bit depth combination");
+	if (colorType == 3 && palette.empty())
+		return Fail(error, "Missing palette");
+	if (interlace != 0)
+		return Fail(error, "Interlaced PNGs are not supported");
+	if (width == 0 || height == 0 || (unsigned long long)width * height > (1ull << 28))
+		return Fail(error, "Bad image dimensions");
+
+	// Decompress the scanlines
+	size_t bitsPerPixel = (size_t)channels * bitDepth;
+	size_t stride = (width * bitsPerPixel + 7) / 8;
+	size_t filterBytes = bitsPerPixel >= 8 ? bitsPerPixel / 8 : 1;
+
+	vector<unsigned char> raw;
+	raw.reserve((stride + 1) * height);
+	if (!Inflate(compressed.data(), compressed.size(), raw))
+		return Fail(error, "Corrupt image data");
+	if (raw.size() < (stride + 1) * height)
+		return Fail(error, "Not enough image data");
+
+	// Undo the per-row filters in place
+	vector<unsigned char> zeroRow(stride, 0);
+	for (unsigned int y = 0; y < height; y++)
+	{
+		unsigned char filter = raw[y * (stride + 1)];
+		unsigned char* row = &raw[y * (stride + 1) + 1];
+		const unsigned char* prev = y > 0 ? &raw[(y - 1) * (stride + 1) + 1] : zeroRow.data();
+
+		for (size_t i = 0; i < stride; i++)
+		{
+			int a = i >= filterBytes ? row[i - filterBytes] : 0;
+			int b = prev[i];
+			int c = i >= filterBytes ? prev[i - filterBytes] : 0;
+
+			switch (filter)
+			{
+			case 0: break;
+			case 1: row[i] = (unsigned char)(row[i] + a); break;
+			case 2: row[i] = (unsigned char)(row[i] + b); break;
+			case 3: row[i] = (unsigned char)(row[i] + ((a + b) >> 1)); break;
+			case 4: row[i] = (unsigned char)(row[i] + Paeth(a, b, c)); break;
+			default: return Fail(error, "Bad filter type");
+			}
+		}
+	}
+
+	// Expand everything to RGBA8
+	image.Width = width;
+	image.Height = height;
+	image.Pixels.resize((size_t)width * height * 4);
+
+	unsigned int maxValue = (1u << bitDepth) - 1;
+	for (unsigned int y = 0; y < height; y++)
+	{
+		const unsigned char* row = &raw[y * (stride + 1) + 1];
+		unsigned char* dest = &image.Pixels[(size_t)y * width * 4];
+
+		for (unsigned int x = 0; x < width; x++)
+		{
+			// Pull out each channel at full precision
+			unsigned int samples[4] = {};
+			for (int c = 0; c < channels; c++)
+			{
+				size_t index = (size_t)x * channels + c;
+				if (bitDepth == 16)
+					samples[c] = (row[index * 2] << 8) | row[index * 2 + 1];
+				else if (bitDepth == 8)
+					samples[c] = row[index];
+				else
+				{
+					size_t bit = index * bitDepth;
+					samples[c] = (row[bit / 8] >> (8 - bitDepth - (bit % 8))) & maxValue;
+				}
+			}
+
+			// Scale a sample to 8 bits (palette indices are left alone)
+			auto to8 = [&](unsigned int v) -> unsigned char
+			{
+				if (bitDepth == 16) return (unsigned char)(v >> 8);
+				if (bitDepth == 8) return (unsigned char)v;
+				return (unsigned char)(v * 255 / maxValue);
+			};
+
+			unsigned char* px = dest + x * 4;
+			switch (colorType)
+			{
+			case 0:
+				px[0] = px[1] = px[2] = to8(samples[0]);
+				px[3] = (hasColorKey && samples[0] == colorKey[0]) ? 0 : 255;
+				break;
+			case 2:
+				px[0] = to8(samples[0]);
+				px[1] = to8(samples[1]);
+				px[2] = to8(samples[2]);
+				px[3] = (hasColorKey && samples[0] == colorKey[0] && samples[1] == colorKey[1] && samples[2] == colorKey[2]) ? 0 : 255;
+				break;
+			case 3:
+			{
+				size_t entry = samples[0] * 4;
+				if (entry + 3 >= palette.size()) return Fail(error, "Palette index out of range");
+				memcpy(px, &palette[entry], 4);
+				break;
+			}
+			case 4:
+				px[0] = px[1] = px[2] = to8(samples[0]);
+				px[3] = to8(samples[1]);
+				break;
+			case 6:
+				px[0] = to8(samples[0]);
+				px[1] = to8(samples[1]);
+				px[2] = to8(samples[2]);
+				px[3] = to8(samples[3]);
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool PngDecoder::DecodeFile(const wstring& path, DecodedImage& image, string* error)
+{
+	ifstream file(filesystem::path(path), ios::binary);
+	if (!file.is_open())
+		return Fail(error, "Unable to open file");
+
+	vector<unsigned char> bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	return Decode(bytes.data(), bytes.size(), image, error);
+}
+
+// --------------------------------------------------------
+// Times decoding the files one after another, then again
+// split across the threads.  Files are read into memory up
+// front so only the decode is measured.
+// --------------------------------------------------------
+DecodeBenchmarkResult PngDecoder::Benchmark(const wstring& directory, unsigned int threadCount)
+{
+	DecodeBenchmarkResult result;
+
+	// Sorted, so every run decodes the same files in the same order
+	vector<filesystem::path> files;
+	error_code ec;
+	for (const auto& entry : filesystem::recursive_directory_iterator(filesystem::path(directory), ec))
+	{
+		if (entry.is_regular_file(ec) && entry.path().extension() == ".png")
+			files.push_back(entry.path());
+	}
+	sort(files.begin(), files.end());
+
+	vector<vector<unsigned char>> fileBytes;
+	for (auto& f : files)
+	{
+		ifstream file(f, ios::binary);
+		if (file.is_open())
+			fileBytes.push_back(vector<unsigned char>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>()));
+	}
+
+	result.FileCount = (int)fileBytes.size();
+	result.ThreadCount = threadCount > 0 ? (int)threadCount : (int)max(1u, thread::hardware_concurrency());
+	if (fileBytes.empty())
+		return result;
+
+	auto milliseconds = [](chrono::steady_clock::time_point start) {
+		return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	};
+
+	// Serial
+	auto start = chrono::steady_clock::now();
+	for (auto& bytes : fileBytes)
+	{
+		DecodedImage image;
+		if (Decode(bytes.data(), bytes.size(), image))
+			result.Megapixels += (double)image.Width * image.Height / 1000000.0;
+	}
+	result.SerialMilliseconds = milliseconds(start);
+
+	// Parallel - dedicated threads, so nothing else queued on a pool skews the timing
+	atomic<int> next = 0;
+	vector<thread> threads;
+	start = chrono::steady_clock::now();
+	for (int t = 0; t < result.ThreadCount; t++)
+	{
+		threads.push_back(thread([&]() {
+			for (int i = next++; i < result.FileCount; i = next++)
+			{
+				DecodedImage image;
+				Decode(fileBytes[i].data(), fileBytes[i].size(), image);
+			}
+		}));
+	}
+	for (auto& t : threads)
+		t.join();
+	result.ParallelMilliseconds = milliseconds(start);
+
+	return result;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// A decoded image, always expanded to 8-bit RGBA
+// --------------------------------------------------------
+struct DecodedImage
+{
+	unsigned int Width = 0;
+	unsigned int Height = 0;
+	std::vector<unsigned char> Pixels; // Width * Height * 4 bytes, top row first
+};
+
+// Timings from decoding the same set of files serially and
+// across a number of threads
+struct DecodeBenchmarkResult
+{
+	int FileCount = 0;
+	int ThreadCount = 0;
+	double Megapixels = 0;
+	double SerialMilliseconds = 0;
+	double ParallelMilliseconds = 0;
+};
+
+// --------------------------------------------------------
+// Small self-contained PNG decoder (no WIC, no COM), so
+// images can be decoded on any thread and on any platform.
+//
+// Supports every non-interlaced color type at bit depths
+// 1-16.  Interlaced files are rejected so the caller can
+// fall back to another loader.
+// --------------------------------------------------------
+namespace PngDecoder
+{
+	bool Decode(const unsigned char* fileBytes, size_t size, DecodedImage& image, std::string* error = 0);
+	bool DecodeFile(const std::wstring& path, DecodedImage& image, std::string* error = 0);
+
+	// Raw zlib/DEFLATE decompression (exposed for testing)
+	bool Inflate(const unsigned char* data, size_t size, std::vector<unsigned char>& out);
+
+	// Serial vs parallel decode of every PNG under a directory - zero threads means one per core
+	DecodeBenchmarkResult Benchmark(const std::wstring& directory, unsigned int threadCount = 0);
+}
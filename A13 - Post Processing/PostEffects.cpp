@@ -0,0 +1,137 @@
+#include "PostEffects.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+	// Define names, in bit order - must match PostEffects.hlsli
+	const char* DefineNames[PostEffectCount] = { "POST_TONEMAP", "POST_COLOR_GRADE", "POST_TINT", "POST_ENCODE", "POST_GAMMA", "POST_VIGNETTE", "POST_INVERT" };
+	const char* EffectNames[PostEffectCount] = { "Tonemap", "Color Grade", "Tint", "Encode", "Gamma", "Vignette", "Invert" };
+
+	float Saturate(float value)
+	{
+		return min(max(value, 0.0f), 1.0f);
+	}
+
+	float SmoothStep(float edge0, float edge1, float x)
+	{
+		float t = Saturate((x - edge0) / (edge1 - edge0));
+		return t * t * (3 - 2 * t);
+	}
+}
+
+unsigned int PostPermutations::BuildKey(const PostEffectSettings& settings)
+{
+	unsigned int key = 0;
+	if (settings.Tonemap)
+		key |= PostEffectTonemap;
+	if (settings.ColorGrade && (settings.Saturation != 1.0f || settings.Contrast != 1.0f))
+		key |= PostEffectColorGrade;
+	if (settings.Tint && (settings.TintColor.x != 1.0f || settings.TintColor.y != 1.0f || settings.TintColor.z != 1.0f))
+		key |= PostEffectTint;
+	key |= PostEffectEncode;
+	if (settings.Gamma && settings.GammaValue != 1.0f && settings.GammaValue > 0)
+		key |= PostEffectGamma;
+	if (settings.Vignette && settings.VignetteStrength != 0.0f)
+		key |= PostEffectVignette;
+	if (settings.Invert)
+		key |= PostEffectInvert;
+	return key;
+}
+
+vector<pair<string, string>> PostPermutations::Defines(unsigned int key)
+{
+	vector<pair<string, string>> defines;
+	for (int i = 0; i < PostEffectCount; i++)
+	{
+		if (key & (1u << i))
+			defines.push_back({ DefineNames[i], "1" });
+	}
+	return defines;
+}
+
+unsigned int PostPermutations::KeyFromDefines(const vector<pair<string, string>>& defines)
+{
+	unsigned int key = 0;
+	for (auto& define : defines)
+	{
+		for (int i = 0; i < PostEffectCount; i++)
+		{
+			if (define.first == DefineNames[i] && define.second != "0")
+				key |= 1u << i;
+		}
+	}
+	return key;
+}
+
+string PostPermutations::Describe(unsigned int key)
+{
+	string description;
+	for (int i = 0; i < PostEffectCount; i++)
+	{
+		if (!(key & (1u << i)))
+			continue;
+		if (!description.empty())
+			description += " + ";
+		description += EffectNames[i];
+	}
+	return description.empty() ? "None" : description;
+}
+
+float PostPermutations::Filmic(float value)
+{
+	return Saturate((value * (2.51f * value + 0.03f)) / (value * (2.43f * value + 0.59f) + 0.14f));
+}
+
+void PostPermutations::Apply(unsigned int key, const PostEffectSettings& settings, float u, float v, float* color)
+{
+	// Same order, same math as ApplyPostEffects() in PostEffects.hlsli
+	if (key & PostEffectTonemap)
+	{
+		for (int c = 0; c < 3; c++)
+			color[c] = Filmic(color[c] * settings.Exposure);
+	}
+	if (key & PostEffectColorGrade)
+	{
+		float luma = color[0] * 0.2126f + color[1] * 0.7152f + color[2] * 0.0722f;
+		for (int c = 0; c < 3; c++)
+		{
+			color[c] = luma + (color[c] - luma) * settings.Saturation;
+			color[c] = (color[c] - 0.5f) * settings.Contrast + 0.5f;
+		}
+	}
+	if (key & PostEffectTint)
+	{
+		color[0] *= settings.TintColor.x;
+		color[1] *= settings.TintColor.y;
+		color[2] *= settings.TintColor.z;
+	}
+	if (key & PostEffectEncode)
+	{
+		for (int c = 0; c < 3; c++)
+			color[c] = powf(Saturate(color[c]), 1.0f / 2.2f);
+	}
+	if (key & PostEffectGamma)
+	{
+		for (int c = 0; c < 3; c++)
+			color[c] = powf(Saturate(color[c]), 1.0f / settings.GammaValue);
+	}
+	if (key & PostEffectVignette)
+	{
+		float du = u - 0.5f;
+		float dv = v - 0.5f;
+		float distance = sqrtf(du * du + dv * dv) * 1.41421356f;
+		float scale = 1.0f - settings.VignetteStrength * SmoothStep(settings.VignetteRadius, 1.0f, distance);
+		for (int c = 0; c < 3; c++)
+			color[c] *= scale;
+	}
+	if (key & PostEffectInvert)
+	{
+		// All four channels, like the invert pass this replaced
+		for (int c = 0; c < 4; c++)
+			color[c] = 1.0f - color[c];
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// One bit per pointwise effect, in the order they're applied
+enum PostEffectBits : unsigned int
+{
+	PostEffectTonemap = 1 << 0,
+	PostEffectColorGrade = 1 << 1,
+	PostEffectTint = 1 << 2,
+	PostEffectEncode = 1 << 3,		// Linear to display gamma - always on, so it marks the pass that writes the back buffer
+	PostEffectGamma = 1 << 4,
+	PostEffectVignette = 1 << 5,
+	PostEffectInvert = 1 << 6
+};
+const int PostEffectCount = 7;
+
+// What the UI controls - an effect only makes it into the key if it's
+// enabled and its settings would actually change something
+struct PostEffectSettings
+{
+	bool Tonemap = true;
+	bool AutoExposure = true;	// Scale by the adapted exposure (see AutoExposure) before the curve
+	float Exposure = 1.0f;		// Manual exposure on top of that
+	bool ColorGrade = false;
+	float Saturation = 1.0f;
+	float Contrast = 1.0f;
+	bool Tint = false;
+	DirectX::XMFLOAT3 TintColor = { 1, 1, 1 };
+	bool Gamma = false;
+	float GammaValue = 1.0f;	// Output = input ^ (1 / GammaValue)
+	bool Vignette = false;
+	float VignetteStrength = 0.5f;
+	float VignetteRadius = 0.5f;	// Distance from the center (corners are 1) where darkening starts
+	bool Invert = true;
+};
+
+// --------------------------------------------------------
+// Picks the variant of the final post pass that has exactly
+// the pointwise effects in use compiled in (PostEffects.hlsli
+// with one define per bit), so the effects cost no extra
+// passes and disabled ones cost nothing at all.
+//
+// The scene is linear HDR, so the chain starts with the
+// exposure and ACES curve and always ends up encoded for
+// display; the effects after the encode work on what ends
+// up on screen.
+//
+// Apply() is the same chain on the CPU, for checking the
+// shader against and for checking the keys themselves.
+// --------------------------------------------------------
+namespace PostPermutations
+{
+	// Permutation for these settings - effects that would be no-ops are left out
+	unsigned int BuildKey(const PostEffectSettings& settings);
+
+	// Defines that compile the permutation (e.g. POST_INVERT=1), in bit order
+	std::vector<std::pair<std::string, std::string>> Defines(unsigned int key);
+
+	// The key a set of defines compiles - the inverse of Defines()
+	unsigned int KeyFromDefines(const std::vector<std::pair<std::string, std::string>>& defines);
+
+	// Readable list of the effects in a key, e.g. "Gamma + Invert"
+	std::string Describe(unsigned int key);
+
+	// ACES filmic curve (Narkowicz's fit) on one linear channel
+	float Filmic(float value);
+
+	// The effects in the key, on one RGBA color at a UV (0-1 across the screen).
+	// Exposure is taken as the whole exposure - multiply the adapted one in first
+	void Apply(unsigned int key, const PostEffectSettings& settings, float u, float v, float* color);
+}
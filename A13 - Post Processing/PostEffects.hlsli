@@ -0,0 +1,60 @@
+#ifndef __POST_EFFECTS__
+#define __POST_EFFECTS__
+
+// The pointwise post effects, applied by whichever pass writes
+// the back buffer.  Each is only compiled in when its define
+// is set (see PostPermutations) - with none, this is free.
+// Colors come in linear HDR and leave encoded for display.
+// Must match PostPermutations::Apply on the CPU.
+cbuffer postEffectData : register(b1)
+{
+    float3 postTint;
+    float postInverseGamma;     // 1 / gamma
+    float postExposure;         // Manual exposure, on top of the adapted one
+    float postAutoExposure;     // 1 to use the adapted exposure, 0 to ignore it
+    float postSaturation;
+    float postContrast;
+    float postVignetteStrength;
+    float postVignetteRadius;   // Distance from the center (corners are 1) where darkening starts
+}
+
+// [0] = adapted luminance, [1] = the exposure for it (ComputeShaderExposure)
+StructuredBuffer<float> AdaptedExposure : register(t1);
+
+// ACES filmic curve - Narkowicz's fit
+float3 Filmic(float3 color)
+{
+    return saturate((color * (2.51f * color + 0.03f)) / (color * (2.43f * color + 0.59f) + 0.14f));
+}
+
+float4 ApplyPostEffects(float4 color, float2 uv)
+{
+#if POST_TONEMAP
+    float exposure = postExposure * lerp(1.0f, AdaptedExposure[1], postAutoExposure);
+    color.rgb = Filmic(color.rgb * exposure);
+#endif
+#if POST_COLOR_GRADE
+    float luma = dot(color.rgb, float3(0.2126f, 0.7152f, 0.0722f));
+    color.rgb = lerp(luma.xxx, color.rgb, postSaturation);
+    color.rgb = (color.rgb - 0.5f) * postContrast + 0.5f;
+#endif
+#if POST_TINT
+    color.rgb *= postTint;
+#endif
+#if POST_ENCODE
+    color.rgb = pow(saturate(color.rgb), 1.0f / 2.2f);
+#endif
+#if POST_GAMMA
+    color.rgb = pow(saturate(color.rgb), postInverseGamma);
+#endif
+#if POST_VIGNETTE
+    float distanceFromCenter = length(uv - 0.5f) * 1.41421356f;
+    color.rgb *= 1 - postVignetteStrength * smoothstep(postVignetteRadius, 1.0f, distanceFromCenter);
+#endif
+#if POST_INVERT
+    color = 1 - color;
+#endif
+    return color;
+}
+
+#endif
@@ -0,0 +1,250 @@
+#include "PostProcessGraph.h"
+
+#include <algorithm>
+
+using namespace std;
+
+bool PostTargetSize::operator==(const PostTargetSize& other) const
+{
+	return Width == other.Width && Height == other.Height && Format == other.Format;
+}
+
+void PostProcessGraph::Clear()
+{
+	resources.clear();
+	passes.clear();
+	plan = PostGraphPlan();
+	compiled = false;
+}
+
+int PostProcessGraph::Import(const string& name)
+{
+	Resource resource;
+	resource.Name = name;
+	resource.Imported = true;
+	resources.push_back(resource);
+	compiled = false;
+	return (int)resources.size() - 1;
+}
+
+int PostProcessGraph::Create(const string& name, const PostTargetDesc& desc)
+{
+	Resource resource;
+	resource.Name = name;
+	resource.Desc = desc;
+	resources.push_back(resource);
+	compiled = false;
+	return (int)resources.size() - 1;
+}
+
+int PostProcessGraph::AddPass(const string& name, const vector<int>& inputs, int output, PassFunction execute)
+{
+	Pass pass;
+	pass.Name = name;
+	pass.Inputs = inputs;
+	pass.Output = output;
+	pass.Execute = execute;
+	passes.push_back(pass);
+	compiled = false;
+	return (int)passes.size() - 1;
+}
+
+void PostProcessGraph::SetImport(int resource, ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv)
+{
+	resources[resource].ImportSRV = srv;
+	resources[resource].ImportRTV = rtv;
+}
+
+PostTargetSize PostProcessGraph::GetSize(int resource) const
+{
+	const PostTargetDesc& desc = resources[resource].Desc;
+	PostTargetSize size;
+	size.Width = max(width >> desc.Level, 1u);
+	size.Height = max(height >> desc.Level, 1u);
+	size.Format = desc.Format;
+	return size;
+}
+
+bool PostProcessGraph::Compile(unsigned int width, unsigned int height)
+{
+	this->width = width;
+	this->height = height;
+	plan = PostGraphPlan();
+	error.clear();
+	compiled = false;
+	allocated = false;
+
+	// Who writes what - each resource may be written once
+	int resourceCount = (int)resources.size();
+	vector<int> writer(resourceCount, -1);
+	for (int p = 0; p < (int)passes.size(); p++)
+	{
+		const Pass& pass = passes[p];
+		if (pass.Output < 0 || pass.Output >= resourceCount)
+		{
+			error = "Pass '" + pass.Name + "' has no valid output";
+			return false;
+		}
+		if (writer[pass.Output] >= 0)
+		{
+			error = "'" + resources[pass.Output].Name + "' is written by both '" + passes[writer[pass.Output]].Name + "' and '" + pass.Name + "'";
+			return false;
+		}
+		for (int input : pass.Inputs)
+		{
+			if (input < 0 || input >= resourceCount || input == pass.Output)
+			{
+				error = "Pass '" + pass.Name + "' reads an invalid input (or its own output)";
+				return false;
+			}
+		}
+		writer[pass.Output] = p;
+	}
+
+	// Work back from whatever's written to an import, keeping the passes that feed it
+	vector<bool> live(passes.size(), false);
+	vector<int> pending;
+	for (int p = 0; p < (int)passes.size(); p++)
+	{
+		if (resources[passes[p].Output].Imported)
+		{
+			live[p] = true;
+			pending.push_back(p);
+		}
+	}
+	while (!pending.empty())
+	{
+		int p = pending.back();
+		pending.pop_back();
+		for (int input : passes[p].Inputs)
+		{
+			int source = writer[input];
+			if (source < 0)
+			{
+				if (!resources[input].Imported)
+				{
+					error = "Pass '" + passes[p].Name + "' reads '" + resources[input].Name + "', which nothing writes";
+					return false;
+				}
+				continue;
+			}
+			if (!live[source])
+			{
+				live[source] = true;
+				pending.push_back(source);
+			}
+		}
+	}
+
+	// Kahn's sort, always taking the earliest declared pass that's ready
+	// so a graph declared in a sensible order runs in that order
+	vector<bool> scheduled(passes.size(), false);
+	vector<bool> written(resourceCount, false);
+	for (int p = 0; p < (int)passes.size(); p++)
+	{
+		if (!live[p])
+			plan.Culled.push_back(p);
+	}
+	size_t liveCount = passes.size() - plan.Culled.size();
+	while (plan.Order.size() < liveCount)
+	{
+		int next = -1;
+		for (int p = 0; p < (int)passes.size() && next < 0; p++)
+		{
+			if (!live[p] || scheduled[p])
+				continue;
+			bool ready = true;
+			for (int input : passes[p].Inputs)
+				ready = ready && (writer[input] < 0 || written[input]);
+			if (ready)
+				next = p;
+		}
+		if (next < 0)
+		{
+			error = "The passes depend on each other in a cycle";
+			plan.Order.clear();
+			return false;
+		}
+
+		scheduled[next] = true;
+		written[passes[next].Output] = true;
+		plan.Order.push_back(next);
+	}
+
+	// Lifetimes, as positions in the order
+	plan.FirstUse.assign(resourceCount, -1);
+	plan.LastUse.assign(resourceCount, -1);
+	for (int position = 0; position < (int)plan.Order.size(); position++)
+	{
+		const Pass& pass = passes[plan.Order[position]];
+		plan.FirstUse[pass.Output] = position;
+		plan.LastUse[pass.Output] = max(plan.LastUse[pass.Output], position);
+		for (int input : pass.Inputs)
+		{
+			if (plan.FirstUse[input] < 0)
+				plan.FirstUse[input] = position;
+			plan.LastUse[input] = position;
+		}
+	}
+
+	// Each transient goes in the first matching texture that's done being read
+	// before it's written (strictly before - a pass can't write what it reads)
+	plan.PoolSlot.assign(resourceCount, -1);
+	vector<int> slotBusyUntil;
+	for (int position = 0; position < (int)plan.Order.size(); position++)
+	{
+		int output = passes[plan.Order[position]].Output;
+		if (resources[output].Imported)
+			continue;
+
+		PostTargetSize size = GetSize(output);
+		int slot = -1;
+		for (int s = 0; s < (int)plan.Targets.size() && slot < 0; s++)
+		{
+			if (plan.Targets[s] == size && slotBusyUntil[s] < position)
+				slot = s;
+		}
+		if (slot < 0)
+		{
+			slot = (int)plan.Targets.size();
+			plan.Targets.push_back(size);
+			slotBusyUntil.push_back(0);
+		}
+
+		plan.PoolSlot[output] = slot;
+		slotBusyUntil[slot] = plan.LastUse[output];
+	}
+
+	compiled = true;
+	return true;
+}
+
+bool PostProcessGraph::Execute(IPostTargetPool& pool, unsigned int width, unsigned int height)
+{
+	if (!compiled || width != this->width || height != this->height)
+	{
+		if (!Compile(width, height))
+			return false;
+	}
+	if (!allocated)
+	{
+		pool.Allocate(plan.Targets);
+		allocated = true;
+	}
+
+	for (int p : plan.Order)
+	{
+		const Pass& pass = passes[p];
+		PostPassContext context;
+		context.Name = pass.Name.c_str();
+		for (int input : pass.Inputs)
+			context.Inputs.push_back(resources[input].Imported ? resources[input].ImportSRV : pool.GetShaderResource(plan.PoolSlot[input]));
+		context.Output = resources[pass.Output].Imported ? resources[pass.Output].ImportRTV : pool.GetRenderTarget(plan.PoolSlot[pass.Output]);
+
+		PostTargetSize size = GetSize(pass.Output);
+		context.Width = size.Width;
+		context.Height = size.Height;
+		pass.Execute(context);
+	}
+	return true;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Only pointers to these are handed around, so the graph
+// never needs the D3D headers (and builds anywhere)
+struct ID3D11RenderTargetView;
+struct ID3D11ShaderResourceView;
+
+// What a transient target needs to be, relative to the graph's output
+struct PostTargetDesc
+{
+	unsigned int Level = 0;		// Output size halved this many times, like a mip level
+	unsigned int Format = 28;	// A DXGI_FORMAT (28 is R8G8B8A8_UNORM)
+};
+
+// A target's actual size - two resources can share a texture when these match
+struct PostTargetSize
+{
+	unsigned int Width = 0;
+	unsigned int Height = 0;
+	unsigned int Format = 0;
+
+	bool operator==(const PostTargetSize& other) const;
+	bool operator!=(const PostTargetSize& other) const { return !(*this == other); }
+};
+
+// Everything a pass gets when it runs
+struct PostPassContext
+{
+	const char* Name = 0;
+	std::vector<ID3D11ShaderResourceView*> Inputs;
+	ID3D11RenderTargetView* Output = 0;
+	unsigned int Width = 0;		// Output's size
+	unsigned int Height = 0;
+};
+
+// How the last compile laid things out
+struct PostGraphPlan
+{
+	std::vector<int> Order;					// Pass indices in the order they run
+	std::vector<int> Culled;				// Passes whose output nothing uses
+	std::vector<int> PoolSlot;				// Per resource: pool texture it lives in, -1 for imports and unused ones
+	std::vector<int> FirstUse;				// Per resource: positions in Order of its write...
+	std::vector<int> LastUse;				// ...and its last read (-1 if never used)
+	std::vector<PostTargetSize> Targets;	// Per pool slot
+};
+
+// --------------------------------------------------------
+// The pool textures a graph runs on.  D3D11PostTargetPool
+// creates real ones; tests can supply one that only
+// records what it was asked for.
+// --------------------------------------------------------
+class IPostTargetPool
+{
+public:
+	virtual ~IPostTargetPool() = default;
+
+	// Makes slot i match targets[i], keeping any texture that already does
+	virtual void Allocate(const std::vector<PostTargetSize>& targets) = 0;
+
+	virtual ID3D11RenderTargetView* GetRenderTarget(int slot) = 0;
+	virtual ID3D11ShaderResourceView* GetShaderResource(int slot) = 0;
+};
+
+// --------------------------------------------------------
+// A post process as a list of passes, each reading some
+// resources and writing one.  Resources are either imported
+// (the scene, the back buffer - owned elsewhere, bound each
+// frame) or transient, which the graph places in pool
+// textures on its own.
+//
+// Compiling orders the passes by what they read, drops any
+// whose output never reaches an import, and works out when
+// each transient is first written and last read.  Transients
+// with the same size and format whose lifetimes don't
+// overlap share a texture, so a chain of any length runs on
+// two ping-ponged targets.
+//
+// Declare the graph again whenever it changes (it's cheap);
+// Execute() recompiles when it needs to, including when the
+// output size changes, and only reallocates pool textures
+// that no longer fit.
+// --------------------------------------------------------
+class PostProcessGraph
+{
+public:
+	typedef std::function<void(const PostPassContext&)> PassFunction;
+
+	// Forget every resource and pass (pool textures are kept for reuse)
+	void Clear();
+
+	int Import(const std::string& name);
+	int Create(const std::string& name, const PostTargetDesc& desc = PostTargetDesc());
+	int AddPass(const std::string& name, const std::vector<int>& inputs, int output, PassFunction execute);
+
+	// What an import is bound to this frame
+	void SetImport(int resource, ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv);
+
+	// Orders and places everything for this output size - false (see GetError) if the graph can't run
+	bool Compile(unsigned int width, unsigned int height);
+
+	// Compiles if needed, makes sure the pool fits, then runs the passes in order
+	bool Execute(IPostTargetPool& pool, unsigned int width, unsigned int height);
+
+	const PostGraphPlan& GetPlan() const { return plan; }
+	const std::string& GetError() const { return error; }
+	const std::string& GetPassName(int pass) const { return passes[pass].Name; }
+	const std::string& GetResourceName(int resource) const { return resources[resource].Name; }
+	PostTargetSize GetSize(int resource) const;
+
+private:
+	struct Resource
+	{
+		std::string Name;
+		bool Imported = false;
+		PostTargetDesc Desc;
+		ID3D11ShaderResourceView* ImportSRV = 0;
+		ID3D11RenderTargetView* ImportRTV = 0;
+	};
+
+	struct Pass
+	{
+		std::string Name;
+		std::vector<int> Inputs;
+		int Output = -1;
+		PassFunction Execute;
+	};
+
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	PostGraphPlan plan;
+	std::string error;
+	bool compiled = false;
+	bool allocated = false;		// The pool has been fitted to this plan
+	unsigned int width = 0;
+	unsigned int height = 0;
+};
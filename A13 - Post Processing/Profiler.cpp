@@ -0,0 +1,268 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_TSC 1
+#endif
+
+using namespace std;
+
+namespace Profiler
+{
+	// Anonymous namespace to hold every thread's ring
+	// and the frame markers
+	namespace
+	{
+		// Written only by its own thread.  The count is published after
+		// each event, so readers know which slots hold finished events.
+		struct ThreadRing
+		{
+			unsigned int id = 0;
+			string name;
+			ProfileEvent events[EventsPerThread];
+			atomic<uint64_t> written{ 0 };
+
+			// Open zones - only touched by the owning thread
+			const char* openNames[MaxDepth];
+			uint64_t openStarts[MaxDepth];
+			unsigned int depth = 0;
+		};
+
+		mutex ringsMutex;
+		vector<unique_ptr<ThreadRing>> rings;
+		thread_local ThreadRing* ring = 0;
+
+		atomic<bool> enabled{ true };
+		atomic<uint64_t> frameStart{ 0 };
+		atomic<uint64_t> lastFrameStart{ 0 };
+		atomic<uint64_t> lastFrameEnd{ 0 };
+
+		ThreadRing* GetRing()
+		{
+			if (!ring)
+			{
+				lock_guard<mutex> lock(ringsMutex);
+				rings.push_back(make_unique<ThreadRing>());
+				ring = rings.back().get();
+				ring->id = (unsigned int)rings.size();
+				ring->name = "Thread " + to_string(ring->id);
+			}
+			return ring;
+		}
+
+		// TSC ticks aren't a fixed unit, so they're measured against steady_clock once
+		double TicksPerMicrosecond()
+		{
+#if PROFILER_TSC
+			static const double ticks = [] {
+				auto clockStart = chrono::steady_clock::now();
+				uint64_t tickStart = Now();
+				while (chrono::steady_clock::now() - clockStart < chrono::milliseconds(20));
+				uint64_t tickEnd = Now();
+				double elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - clockStart).count();
+				return (tickEnd - tickStart) / elapsed;
+			}();
+			return ticks;
+#else
+			return (double)chrono::steady_clock::period::den / chrono::steady_clock::period::num / 1e6;
+#endif
+		}
+
+		void WriteEscaped(ostringstream& out, const string& text)
+		{
+			for (char c : text)
+			{
+				if (c == '"' || c == '\\') out << '\\' << c;
+				else if ((unsigned char)c < 0x20) out << ' ';
+				else out << c;
+			}
+		}
+	}
+
+	void SetEnabled(bool on) { enabled = on; }
+	bool IsEnabled() { return enabled; }
+
+	void SetThreadName(const char* name)
+	{
+		ThreadRing* ring = GetRing();
+		lock_guard<mutex> lock(ringsMutex);
+		ring->name = name;
+	}
+
+	uint64_t Now()
+	{
+#if PROFILER_TSC
+		return __rdtsc();
+#else
+		return (uint64_t)chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	double TicksToMicroseconds(uint64_t ticks)
+	{
+		return ticks / TicksPerMicrosecond();
+	}
+
+	bool BeginZone(const char* name)
+	{
+		if (!enabled.load(memory_order_relaxed))
+			return false;
+
+		ThreadRing* ring = GetRing();
+		if (ring->depth < MaxDepth)
+		{
+			ring->openNames[ring->depth] = name;
+			ring->openStarts[ring->depth] = Now();
+		}
+		ring->depth++;
+		return true;
+	}
+
+	void EndZone()
+	{
+		// Only reached after a BeginZone on this thread, so the ring exists
+		uint64_t end = Now();
+		if (ring->depth == 0)
+			return;
+
+		ring->depth--;
+		if (ring->depth >= MaxDepth)
+			return;
+
+		uint64_t index = ring->written.load(memory_order_relaxed);
+		ProfileEvent& event = ring->events[index % EventsPerThread];
+		event.Name = ring->openNames[ring->depth];
+		event.Start = ring->openStarts[ring->depth];
+		event.End = end;
+		event.Depth = ring->depth;
+		ring->written.store(index + 1, memory_order_release);
+	}
+
+	void MarkFrame()
+	{
+		uint64_t now = Now();
+		uint64_t start = frameStart.exchange(now);
+		if (start == 0)
+			return;
+
+		lastFrameStart = start;
+		lastFrameEnd = now;
+	}
+
+	bool GetLastFrame(uint64_t& start, uint64_t& end)
+	{
+		start = lastFrameStart;
+		end = lastFrameEnd;
+		return end > start;
+	}
+
+	vector<ProfileThread> Capture(uint64_t start, uint64_t end)
+	{
+		vector<ProfileThread> threads;
+		lock_guard<mutex> lock(ringsMutex);
+		for (auto& ring : rings)
+		{
+			ProfileThread thread;
+			thread.Id = ring->id;
+			thread.Name = ring->name;
+
+			// Copy what looks finished, then drop anything the owner may have
+			// started overwriting while we copied (it lapped the ring)
+			uint64_t written = ring->written.load(memory_order_acquire);
+			uint64_t first = written > EventsPerThread ? written - EventsPerThread : 0;
+			for (uint64_t i = first; i < written; i++)
+				thread.Events.push_back(ring->events[i % EventsPerThread]);
+
+			uint64_t after = ring->written.load(memory_order_acquire);
+			uint64_t safe = after > EventsPerThread ? after - EventsPerThread : 0;
+			if (safe > first)
+				thread.Events.erase(thread.Events.begin(), thread.Events.begin() + (size_t)min(safe - first, (uint64_t)thread.Events.size()));
+
+			thread.Events.erase(remove_if(thread.Events.begin(), thread.Events.end(), [&](const ProfileEvent& e) {
+				return e.End < start || e.Start > end;
+			}), thread.Events.end());
+
+			if (!thread.Events.empty())
+				threads.push_back(thread);
+		}
+		return threads;
+	}
+
+	string ToChromeTrace(const vector<ProfileThread>& threads)
+	{
+		// Times are relative to the earliest zone, so they stay small
+		uint64_t origin = UINT64_MAX;
+		for (auto& thread : threads)
+			for (auto& e : thread.Events)
+				origin = min(origin, e.Start);
+
+		ostringstream out;
+		out.precision(3);
+		out << fixed << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		for (auto& thread : threads)
+		{
+			out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.Id << ",\"args\":{\"name\":\"";
+			WriteEscaped(out, thread.Name);
+			out << "\"}}";
+			first = false;
+
+			for (auto& e : thread.Events)
+			{
+				out << ",\n{\"name\":\"";
+				WriteEscaped(out, e.Name);
+				out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.Id
+					<< ",\"ts\":" << TicksToMicroseconds(e.Start - origin)
+					<< ",\"dur\":" << TicksToMicroseconds(e.End - e.Start) << "}";
+			}
+		}
+		out << "\n]}\n";
+		return out.str();
+	}
+
+	bool SaveChromeTrace(const string& path)
+	{
+		ofstream file(path, ios::trunc);
+		file << ToChromeTrace(Capture(0, UINT64_MAX));
+		return file.good();
+	}
+
+	double MeasureZoneOverhead(unsigned int iterations)
+	{
+		if (iterations == 0)
+			return 0;
+
+		auto start = chrono::steady_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			ProfileZone zone("Profiler Overhead");
+		}
+		auto end = chrono::steady_clock::now();
+		return chrono::duration<double, nano>(end - start).count() / iterations;
+	}
+
+	double MeasureClockOverhead(unsigned int iterations)
+	{
+		if (iterations == 0)
+			return 0;
+
+		// Summed so the reads can't be optimized away
+		volatile uint64_t sink = 0;
+		auto start = chrono::steady_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+			sink = sink + Now();
+		auto end = chrono::steady_clock::now();
+		return chrono::duration<double, nano>(end - start).count() / iterations;
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One finished zone.  Name must outlive the profiler (use literals).
+struct ProfileEvent
+{
+	const char* Name = 0;
+	uint64_t Start = 0;		// Profiler::Now() ticks
+	uint64_t End = 0;
+	unsigned int Depth = 0;	// Zones open around this one on the same thread
+};
+
+// Everything one thread recorded in a captured window, in the order zones finished
+struct ProfileThread
+{
+	unsigned int Id = 0;
+	std::string Name;
+	std::vector<ProfileEvent> Events;
+};
+
+// --------------------------------------------------------
+// An instrumenting CPU profiler.  Zones are opened and
+// closed with ProfileZone (or PROFILE_ZONE), and each thread
+// writes finished zones into a ring of its own, so recording
+// takes no locks and never allocates - a lock is only taken
+// the first time a thread records anything, and by readers.
+//
+// Timestamps are raw TSC ticks on x86/x64 (steady_clock
+// elsewhere), converted to time only when they're read.
+// Rings are overwritten once full, so captures only ever
+// see the most recent EventsPerThread zones of each thread.
+// --------------------------------------------------------
+namespace Profiler
+{
+	const unsigned int EventsPerThread = 16384;
+	const unsigned int MaxDepth = 64;	// Deeper zones are counted but not recorded
+
+	void SetEnabled(bool enabled);
+	bool IsEnabled();
+
+	// Shows up in the flame view and trace - call once, from the thread itself
+	void SetThreadName(const char* name);
+
+	uint64_t Now();
+	double TicksToMicroseconds(uint64_t ticks);
+
+	// Prefer ProfileZone.  Begin returns false when nothing was opened,
+	// in which case End must not be called
+	bool BeginZone(const char* name);
+	void EndZone();
+
+	// Call once at the top of every frame, from the main thread
+	void MarkFrame();
+
+	// Bounds of the last complete frame, false until there is one
+	bool GetLastFrame(uint64_t& start, uint64_t& end);
+
+	// Zones overlapping [start, end], per thread (threads with none are left out)
+	std::vector<ProfileThread> Capture(uint64_t start, uint64_t end);
+
+	// Chrome trace-event JSON (chrome://tracing, Perfetto) of a capture
+	std::string ToChromeTrace(const std::vector<ProfileThread>& threads);
+
+	// Saves every zone still held in the rings
+	bool SaveChromeTrace(const std::string& path);
+
+	// Average cost of one empty zone on the calling thread, in nanoseconds
+	double MeasureZoneOverhead(unsigned int iterations);
+
+	// Average cost of one Now(), in nanoseconds.  Every zone reads the
+	// clock twice, and under some hypervisors that's most of its cost
+	double MeasureClockOverhead(unsigned int iterations);
+}
+
+// Times the enclosing scope
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name) : active(Profiler::BeginZone(name)) {}
+	~ProfileZone() { if (active) Profiler::EndZone(); }
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	bool active;
+};
+
+#define PROFILE_ZONE_JOIN2(a, b) a##b
+#define PROFILE_ZONE_JOIN(a, b) PROFILE_ZONE_JOIN2(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_JOIN(profileZone, __LINE__)(name)
@@ -0,0 +1,251 @@
+#include "RenderStateCache.h"
+
+#include <cstring>
+
+bool RenderViewport::operator==(const RenderViewport& other) const
+{
+	return TopLeftX == other.TopLeftX && TopLeftY == other.TopLeftY &&
+		Width == other.Width && Height == other.Height &&
+		MinDepth == other.MinDepth && MaxDepth == other.MaxDepth;
+}
+
+unsigned int RenderStateCounters::TotalRequested() const
+{
+	unsigned int total = 0;
+	for (unsigned int count : Requested)
+		total += count;
+	return total;
+}
+
+unsigned int RenderStateCounters::TotalForwarded() const
+{
+	unsigned int total = 0;
+	for (unsigned int count : Forwarded)
+		total += count;
+	return total;
+}
+
+RenderStateCache::RenderStateCache(IRenderContext* context) :
+	context(context)
+{
+	Invalidate();
+}
+
+template<typename T>
+bool RenderStateCache::ChangedRange(T** shadow, bool* known, unsigned int slots, unsigned int startSlot, unsigned int count, T* const* values, unsigned int& first, unsigned int& last)
+{
+	// Out of range calls aren't ours to judge - forward them and forget
+	// the shadowed slots, since D3D's behavior there is its own business
+	if (startSlot >= slots || count > slots - startSlot)
+	{
+		for (unsigned int i = startSlot; i < slots; i++)
+			known[i] = false;
+		first = 0;
+		last = count - 1;
+		return count > 0;
+	}
+
+	bool changed = false;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int slot = startSlot + i;
+		T* value = values ? values[i] : 0;
+		if (known[slot] && shadow[slot] == value)
+			continue;
+
+		if (!changed)
+			first = i;
+		last = i;
+		changed = true;
+
+		shadow[slot] = value;
+		known[slot] = true;
+	}
+	return changed;
+}
+
+void RenderStateCache::SetInputLayout(ID3D11InputLayout* layout)
+{
+	counters.Requested[(int)RenderStateCategory::Shaders]++;
+	if (inputLayoutKnown && inputLayout == layout)
+		return;
+
+	inputLayout = layout;
+	inputLayoutKnown = true;
+	counters.Forwarded[(int)RenderStateCategory::Shaders]++;
+	context->IASetInputLayout(layout);
+}
+
+void RenderStateCache::SetVertexShader(ID3D11VertexShader* shader)
+{
+	counters.Requested[(int)RenderStateCategory::Shaders]++;
+	if (vertexShaderKnown && vertexShader == shader)
+		return;
+
+	vertexShader = shader;
+	vertexShaderKnown = true;
+	counters.Forwarded[(int)RenderStateCategory::Shaders]++;
+	context->VSSetShader(shader);
+}
+
+void RenderStateCache::SetPixelShader(ID3D11PixelShader* shader)
+{
+	counters.Requested[(int)RenderStateCategory::Shaders]++;
+	if (pixelShaderKnown && pixelShader == shader)
+		return;
+
+	pixelShader = shader;
+	pixelShaderKnown = true;
+	counters.Forwarded[(int)RenderStateCategory::Shaders]++;
+	context->PSSetShader(shader);
+}
+
+void RenderStateCache::SetVertexConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	counters.Requested[(int)RenderStateCategory::ConstantBuffers]++;
+	unsigned int first, last;
+	if (!ChangedRange(vsBuffers, vsBuffersKnown, ConstantBufferSlots, startSlot, count, buffers, first, last))
+		return;
+
+	counters.Forwarded[(int)RenderStateCategory::ConstantBuffers]++;
+	context->VSSetConstantBuffers(startSlot + first, last - first + 1, buffers + first);
+}
+
+void RenderStateCache::SetPixelConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	counters.Requested[(int)RenderStateCategory::ConstantBuffers]++;
+	unsigned int first, last;
+	if (!ChangedRange(psBuffers, psBuffersKnown, ConstantBufferSlots, startSlot, count, buffers, first, last))
+		return;
+
+	counters.Forwarded[(int)RenderStateCategory::ConstantBuffers]++;
+	context->PSSetConstantBuffers(startSlot + first, last - first + 1, buffers + first);
+}
+
+void RenderStateCache::SetPixelShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views)
+{
+	counters.Requested[(int)RenderStateCategory::ShaderResources]++;
+	unsigned int first, last;
+	if (!ChangedRange(srvs, srvsKnown, ShaderResourceSlots, startSlot, count, views, first, last))
+		return;
+
+	counters.Forwarded[(int)RenderStateCategory::ShaderResources]++;
+	context->PSSetShaderResources(startSlot + first, last - first + 1, views + first);
+}
+
+void RenderStateCache::SetPixelSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers)
+{
+	counters.Requested[(int)RenderStateCategory::Samplers]++;
+	unsigned int first, last;
+	if (!ChangedRange(this->samplers, samplersKnown, SamplerSlots, startSlot, count, samplers, first, last))
+		return;
+
+	counters.Forwarded[(int)RenderStateCategory::Samplers]++;
+	context->PSSetSamplers(startSlot + first, last - first + 1, samplers + first);
+}
+
+void RenderStateCache::SetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthView)
+{
+	counters.Requested[(int)RenderStateCategory::RenderTargets]++;
+
+	// Targets are set as a whole (unlisted slots get unbound), so compare the whole set
+	bool same = renderTargetsKnown && count == renderTargetCount && depthView == this->depthView;
+	for (unsigned int i = 0; same && i < count; i++)
+		same = renderTargets[i] == views[i];
+	if (same)
+		return;
+
+	renderTargetsKnown = count <= RenderTargetSlots;
+	renderTargetCount = count;
+	this->depthView = depthView;
+	for (unsigned int i = 0; i < count && i < RenderTargetSlots; i++)
+		renderTargets[i] = views[i];
+
+	counters.Forwarded[(int)RenderStateCategory::RenderTargets]++;
+	context->OMSetRenderTargets(count, views, depthView);
+}
+
+void RenderStateCache::SetRasterizerState(ID3D11RasterizerState* state)
+{
+	counters.Requested[(int)RenderStateCategory::Rasterizer]++;
+	if (rasterizerKnown && rasterizer == state)
+		return;
+
+	rasterizer = state;
+	rasterizerKnown = true;
+	counters.Forwarded[(int)RenderStateCategory::Rasterizer]++;
+	context->RSSetState(state);
+}
+
+void RenderStateCache::SetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef)
+{
+	counters.Requested[(int)RenderStateCategory::DepthStencil]++;
+	if (depthStencilKnown && depthStencil == state && this->stencilRef == stencilRef)
+		return;
+
+	depthStencil = state;
+	this->stencilRef = stencilRef;
+	depthStencilKnown = true;
+	counters.Forwarded[(int)RenderStateCategory::DepthStencil]++;
+	context->OMSetDepthStencilState(state, stencilRef);
+}
+
+void RenderStateCache::SetViewports(unsigned int count, const RenderViewport* viewports)
+{
+	counters.Requested[(int)RenderStateCategory::Viewports]++;
+
+	bool same = viewportsKnown && count == viewportCount;
+	for (unsigned int i = 0; same && i < count; i++)
+		same = this->viewports[i] == viewports[i];
+	if (same)
+		return;
+
+	viewportsKnown = count <= ViewportSlots;
+	viewportCount = count;
+	for (unsigned int i = 0; i < count && i < ViewportSlots; i++)
+		this->viewports[i] = viewports[i];
+
+	counters.Forwarded[(int)RenderStateCategory::Viewports]++;
+	context->RSSetViewports(count, viewports);
+}
+
+void RenderStateCache::Invalidate()
+{
+	inputLayoutKnown = false;
+	vertexShaderKnown = false;
+	pixelShaderKnown = false;
+	rasterizerKnown = false;
+	depthStencilKnown = false;
+	viewportsKnown = false;
+	memset(vsBuffersKnown, 0, sizeof(vsBuffersKnown));
+	memset(psBuffersKnown, 0, sizeof(psBuffersKnown));
+	memset(srvsKnown, 0, sizeof(srvsKnown));
+	memset(samplersKnown, 0, sizeof(samplersKnown));
+
+	inputLayout = 0;
+	vertexShader = 0;
+	pixelShader = 0;
+	rasterizer = 0;
+	depthStencil = 0;
+	stencilRef = 0;
+	viewportCount = 0;
+	memset(vsBuffers, 0, sizeof(vsBuffers));
+	memset(psBuffers, 0, sizeof(psBuffers));
+	memset(srvs, 0, sizeof(srvs));
+	memset(samplers, 0, sizeof(samplers));
+
+	InvalidateRenderTargets();
+}
+
+void RenderStateCache::InvalidateRenderTargets()
+{
+	renderTargetsKnown = false;
+	renderTargetCount = 0;
+	depthView = 0;
+	memset(renderTargets, 0, sizeof(renderTargets));
+}
+
+void RenderStateCache::ResetCounters()
+{
+	counters = RenderStateCounters();
+}
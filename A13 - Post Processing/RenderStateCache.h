@@ -0,0 +1,153 @@
+#pragma once
+
+// Only pointers to these are ever stored or compared, so the
+// cache itself never needs the D3D headers (and builds anywhere)
+struct ID3D11InputLayout;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11Buffer;
+struct ID3D11ShaderResourceView;
+struct ID3D11SamplerState;
+struct ID3D11RenderTargetView;
+struct ID3D11DepthStencilView;
+struct ID3D11RasterizerState;
+struct ID3D11DepthStencilState;
+
+// Same layout as D3D11_VIEWPORT
+struct RenderViewport
+{
+	float TopLeftX = 0;
+	float TopLeftY = 0;
+	float Width = 0;
+	float Height = 0;
+	float MinDepth = 0;
+	float MaxDepth = 1;
+
+	bool operator==(const RenderViewport& other) const;
+};
+
+// --------------------------------------------------------
+// The subset of ID3D11DeviceContext the state cache drives.
+// D3D11RenderContext forwards to a real context; tests can
+// supply their own implementation that just records calls.
+// --------------------------------------------------------
+class IRenderContext
+{
+public:
+	virtual ~IRenderContext() = default;
+
+	virtual void IASetInputLayout(ID3D11InputLayout* layout) = 0;
+	virtual void VSSetShader(ID3D11VertexShader* shader) = 0;
+	virtual void PSSetShader(ID3D11PixelShader* shader) = 0;
+	virtual void VSSetConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers) = 0;
+	virtual void PSSetConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers) = 0;
+	virtual void PSSetShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views) = 0;
+	virtual void PSSetSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers) = 0;
+	virtual void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthView) = 0;
+	virtual void RSSetState(ID3D11RasterizerState* state) = 0;
+	virtual void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) = 0;
+	virtual void RSSetViewports(unsigned int count, const RenderViewport* viewports) = 0;
+};
+
+// What the cache did with each kind of call
+enum class RenderStateCategory
+{
+	Shaders,
+	ConstantBuffers,
+	ShaderResources,
+	Samplers,
+	RenderTargets,
+	Rasterizer,
+	DepthStencil,
+	Viewports,
+	Count
+};
+
+struct RenderStateCounters
+{
+	unsigned int Requested[(int)RenderStateCategory::Count] = {};
+	unsigned int Forwarded[(int)RenderStateCategory::Count] = {};
+
+	unsigned int TotalRequested() const;
+	unsigned int TotalForwarded() const;
+};
+
+// --------------------------------------------------------
+// Shadows what's bound on a context and drops calls that
+// wouldn't change anything.  Range calls (SRVs, samplers,
+// constant buffers) are trimmed to the slots that actually
+// differ, and skipped entirely if none do.
+//
+// The shadow has to stay truthful, so anything that changes
+// state behind the cache's back (the debug UI restores what
+// it changes, but Present and ResizeBuffers don't) must be
+// followed by an Invalidate call.  Comparing raw pointers
+// is safe while it is: the context holds a reference to
+// everything bound, so a bound address can't be reused.
+// --------------------------------------------------------
+class RenderStateCache
+{
+public:
+	static const unsigned int ConstantBufferSlots = 14;
+	static const unsigned int ShaderResourceSlots = 128;
+	static const unsigned int SamplerSlots = 16;
+	static const unsigned int RenderTargetSlots = 8;
+	static const unsigned int ViewportSlots = 16;
+
+	RenderStateCache(IRenderContext* context);
+
+	void SetInputLayout(ID3D11InputLayout* layout);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void SetVertexConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers);
+	void SetPixelConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers);
+	void SetPixelShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views);
+	void SetPixelSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers);
+	void SetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthView);
+	void SetRasterizerState(ID3D11RasterizerState* state);
+	void SetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef = 0);
+	void SetViewports(unsigned int count, const RenderViewport* viewports);
+
+	// Forget everything, so the next call of every kind goes through
+	void Invalidate();
+
+	// Forget just the output merger's targets (they're unbound by Present)
+	void InvalidateRenderTargets();
+
+	// Counters since the last reset - reset once per frame for per-frame numbers
+	const RenderStateCounters& GetCounters() const { return counters; }
+	void ResetCounters();
+
+private:
+	IRenderContext* context;
+	RenderStateCounters counters;
+
+	// "Known" flags - false means the real state is unknown, so the next call always goes through
+	bool inputLayoutKnown, vertexShaderKnown, pixelShaderKnown;
+	bool rasterizerKnown, depthStencilKnown, renderTargetsKnown, viewportsKnown;
+	bool vsBuffersKnown[ConstantBufferSlots];
+	bool psBuffersKnown[ConstantBufferSlots];
+	bool srvsKnown[ShaderResourceSlots];
+	bool samplersKnown[SamplerSlots];
+
+	ID3D11InputLayout* inputLayout;
+	ID3D11VertexShader* vertexShader;
+	ID3D11PixelShader* pixelShader;
+	ID3D11Buffer* vsBuffers[ConstantBufferSlots];
+	ID3D11Buffer* psBuffers[ConstantBufferSlots];
+	ID3D11ShaderResourceView* srvs[ShaderResourceSlots];
+	ID3D11SamplerState* samplers[SamplerSlots];
+	ID3D11RenderTargetView* renderTargets[RenderTargetSlots];
+	unsigned int renderTargetCount;
+	ID3D11DepthStencilView* depthView;
+	ID3D11RasterizerState* rasterizer;
+	ID3D11DepthStencilState* depthStencil;
+	unsigned int stencilRef;
+	RenderViewport viewports[ViewportSlots];
+	unsigned int viewportCount;
+
+	// Shared by every slot-array setter: finds the first and last slots
+	// that differ (or aren't known), updates the shadow and reports the range
+	template<typename T>
+	bool ChangedRange(T** shadow, bool* known, unsigned int slots, unsigned int startSlot, unsigned int count, T* const* values, unsigned int& first, unsigned int& last);
+};
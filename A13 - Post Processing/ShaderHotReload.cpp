@@ -0,0 +1,229 @@
+#include "ShaderHotReload.h"
+#include "ShaderLibrary.h"
+#include "PathHelpers.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+ShaderHotReload::ShaderHotReload(wstring sourceDirectory) :
+	sourceDirectory(sourceDirectory),
+	running(false),
+	reloadCount(0)
+{
+}
+
+ShaderHotReload::~ShaderHotReload()
+{
+	Stop();
+}
+
+void ShaderHotReload::Start()
+{
+	if (running) return;
+
+	running = true;
+	worker = thread(&ShaderHotReload::WatchLoop, this);
+}
+
+void ShaderHotReload::Stop()
+{
+	running = false;
+	if (worker.joinable())
+		worker.join();
+}
+
+// --------------------------------------------------------
+// Picks a shader model 5 profile based on the file name
+// --------------------------------------------------------
+const char* ShaderHotReload::GetCompileTarget(const string& fileName)
+{
+	string name = ShaderIncludeGraph::NormalizeName(fileName);
+	size_t slash = name.find_last_of('/');
+	if (slash != string::npos) name = name.substr(slash + 1);
+
+	if (name.rfind("vertexshader", 0) == 0) return "vs_5_0";
+	if (name.rfind("pixelshader", 0) == 0) return "ps_5_0";
+	if (name.rfind("computeshader", 0) == 0) return "cs_5_0";
+	return 0;
+}
+
+// --------------------------------------------------------
+// Swaps recompiled bytecode into the matching shaders.
+// Because the SimpleShader objects are reloaded in place,
+// every material and pass holding them sees the change.
+// --------------------------------------------------------
+int ShaderHotReload::ApplyPending()
+{
+	vector<CompileResult> ready;
+	{
+		lock_guard<mutex> lock(pendingMutex);
+		ready.swap(pending);
+	}
+
+	int reloaded = 0;
+	for (auto& r : ready)
+	{
+		// A failed compile keeps the shader that's running, and its errors for the UI
+		if (!r.Blob)
+		{
+			lastError = r.FileName + ": " + r.Errors;
+			lastErrorFile = r.FileName;
+			continue;
+		}
+		if (r.FileName == lastErrorFile)
+		{
+			lastError.clear();
+			lastErrorFile.clear();
+		}
+
+		// PixelShader.hlsl -> PixelShader.cso, matching the paths used to load it
+		string cso = r.FileName.substr(0, r.FileName.find_last_of('.')) + ".cso";
+		if (ShaderLibrary::Reload(FixPath(NarrowToWide(cso)), r.Blob))
+		{
+			lastReloaded = r.FileName;
+			reloaded++;
+		}
+	}
+	reloadCount += reloaded;
+	return reloaded;
+}
+
+// --------------------------------------------------------
+// Background loop: wait for a directory change notification
+// (or just poll if notifications aren't available), feed any
+// modified files through the debouncer, then recompile every
+// shader that depends on them.
+// --------------------------------------------------------
+void ShaderHotReload::WatchLoop()
+{
+	auto start = chrono::steady_clock::now();
+	auto now = [&]() { return chrono::duration<double>(chrono::steady_clock::now() - start).count(); };
+
+	ScanSources(now(), true);
+
+	HANDLE change = FindFirstChangeNotificationW(
+		sourceDirectory.c_str(),
+		FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	bool polling = (change == INVALID_HANDLE_VALUE);
+
+	while (running)
+	{
+		if (polling)
+		{
+			// Fallback: just check timestamps a few times a second
+			Sleep(250);
+			ScanSources(now(), false);
+		}
+		else if (WaitForSingleObject(change, 100) == WAIT_OBJECT_0)
+		{
+			ScanSources(now(), false);
+			FindNextChangeNotification(change);
+		}
+
+		// Recompile anything that has settled
+		vector<string> changed = debouncer.CollectReady(now());
+		vector<string> toCompile;
+		for (const string& file : changed)
+		{
+			for (const string& shader : includeGraph.GetAffectedShaders(file))
+			{
+				if (find(toCompile.begin(), toCompile.end(), shader) == toCompile.end())
+					toCompile.push_back(shader);
+			}
+		}
+
+		for (const string& shader : toCompile)
+		{
+			auto name = actualNames.find(shader);
+			if (name == actualNames.end() || !GetCompileTarget(name->second))
+				continue;
+
+			string errors;
+			Microsoft::WRL::ComPtr<ID3DBlob> blob = Compile(name->second, errors);
+
+			lock_guard<mutex> lock(pendingMutex);
+			pending.push_back({ name->second, blob, errors });
+		}
+	}
+
+	if (!polling)
+		FindCloseChangeNotification(change);
+}
+
+// --------------------------------------------------------
+// Checks the timestamp of every shader source file, keeping
+// the include graph up to date and reporting any changes
+// to the debouncer
+// --------------------------------------------------------
+void ShaderHotReload::ScanSources(double time, bool initial)
+{
+	error_code ec;
+	for (const auto& entry : filesystem::directory_iterator(sourceDirectory, ec))
+	{
+		if (!entry.is_regular_file(ec)) continue;
+
+		string ext = entry.path().extension().string();
+		if (ext != ".hlsl" && ext != ".hlsli") continue;
+
+		string fileName = entry.path().filename().string();
+		string key = ShaderIncludeGraph::NormalizeName(fileName);
+		filesystem::file_time_type stamp = entry.last_write_time(ec);
+		if (ec) continue;
+
+		auto it = timestamps.find(key);
+		if (it != timestamps.end() && it->second == stamp)
+			continue;
+		timestamps[key] = stamp;
+		actualNames[key] = fileName;
+
+		// Refresh this file's includes
+		ifstream file(entry.path());
+		stringstream source;
+		source << file.rdbuf();
+		includeGraph.SetFile(key, source.str());
+
+		if (!initial)
+			debouncer.Notify(key, time);
+	}
+}
+
+// --------------------------------------------------------
+// Compiles a single shader from source.  Returns null if
+// compilation failed, with the compiler's errors in
+// errorText, and the currently loaded shader is left alone.
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3DBlob> ShaderHotReload::Compile(const string& fileName, string& errorText)
+{
+	unsigned int flags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined(DEBUG) || defined(_DEBUG)
+	flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+
+	wstring path = sourceDirectory + L"/" + NarrowToWide(fileName);
+	Microsoft::WRL::ComPtr<ID3DBlob> blob;
+	Microsoft::WRL::ComPtr<ID3DBlob> errors;
+	HRESULT hr = D3DCompileFromFile(
+		path.c_str(),
+		0,
+		D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"main",
+		GetCompileTarget(fileName),
+		flags,
+		0,
+		blob.GetAddressOf(),
+		errors.GetAddressOf());
+
+	if (FAILED(hr))
+	{
+		errorText = errors ? string((const char*)errors->GetBufferPointer(), errors->GetBufferSize()) : "Couldn't compile";
+		return 0;
+	}
+
+	return blob;
+}
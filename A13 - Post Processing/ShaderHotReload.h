@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ShaderIncludeGraph.h"
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <wrl/client.h>
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// Watches the shader source directory and recompiles any
+// shader affected by an edit (following #include chains)
+// on a background thread.  Finished bytecode is queued and
+// only swapped into the ShaderLibrary's shaders when the
+// main thread calls ApplyPending() between frames.
+//
+// Shader type is taken from the file name, following this
+// project's convention: VertexShader*.hlsl, PixelShader*.hlsl
+// and ComputeShader*.hlsl.
+// --------------------------------------------------------
+class ShaderHotReload
+{
+public:
+	ShaderHotReload(std::wstring sourceDirectory);
+	~ShaderHotReload();
+	ShaderHotReload(const ShaderHotReload&) = delete;
+	ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+
+	void Start();
+	void Stop();
+
+	// Main thread only - swaps in any finished recompiles
+	// and returns how many shaders were replaced
+	int ApplyPending();
+
+	// Main thread only - what ApplyPending has swapped in so far
+	unsigned int GetReloadCount() const { return reloadCount; }
+	const std::string& GetLastReloaded() const { return lastReloaded; }
+
+	// Main thread only - the compiler's output for the last recompile that
+	// failed (the loaded shader is left running), empty once it compiles again
+	const std::string& GetLastError() const { return lastError; }
+
+	static const char* GetCompileTarget(const std::string& fileName);
+
+private:
+	void WatchLoop();
+	void ScanSources(double time, bool initial);
+	Microsoft::WRL::ComPtr<ID3DBlob> Compile(const std::string& fileName, std::string& errorText);
+
+	// A finished recompile - no blob means it failed, with the errors
+	struct CompileResult
+	{
+		std::string FileName;
+		Microsoft::WRL::ComPtr<ID3DBlob> Blob;
+		std::string Errors;
+	};
+
+	std::wstring sourceDirectory;
+	std::thread worker;
+	std::atomic<bool> running;
+
+	// Results handed from the worker to the main thread
+	std::mutex pendingMutex;
+	std::vector<CompileResult> pending;
+
+	// Main thread only
+	unsigned int reloadCount;
+	std::string lastReloaded;
+	std::string lastError;
+	std::string lastErrorFile;
+
+	// Worker-only state
+	ShaderIncludeGraph includeGraph;
+	ChangeDebouncer debouncer;
+	std::unordered_map<std::string, std::filesystem::file_time_type> timestamps;
+	std::unordered_map<std::string, std::string> actualNames; // Normalized -> on-disk name
+};
@@ -0,0 +1,155 @@
+#include "ShaderIncludeGraph.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+using namespace std;
+
+// --------------------------------------------------------
+// Pulls the quoted file names out of every #include line.
+// Angle-bracket includes are ignored, since they refer to
+// system headers we'd never be editing.
+// --------------------------------------------------------
+vector<string> ShaderIncludeGraph::ParseIncludes(const string& source)
+{
+	vector<string> result;
+	istringstream stream(source);
+	string line;
+	bool inBlockComment = false;
+
+	while (getline(stream, line))
+	{
+		// Skip anything inside a /* */ comment
+		size_t pos = 0;
+		if (inBlockComment)
+		{
+			size_t end = line.find("*/");
+			if (end == string::npos) continue;
+			inBlockComment = false;
+			pos = end + 2;
+		}
+
+		// Find the first non-whitespace character
+		while (pos < line.size() && isspace((unsigned char)line[pos])) pos++;
+		if (line.compare(pos, 2, "/*") == 0)
+		{
+			if (line.find("*/", pos + 2) == string::npos) inBlockComment = true;
+			continue;
+		}
+		if (pos >= line.size() || line[pos] != '#') continue;
+
+		// Allow whitespace between '#' and "include"
+		pos++;
+		while (pos < line.size() && isspace((unsigned char)line[pos])) pos++;
+		if (line.compare(pos, 7, "include") != 0) continue;
+		pos += 7;
+
+		size_t open = line.find('"', pos);
+		if (open == string::npos) continue;
+		size_t close = line.find('"', open + 1);
+		if (close == string::npos) continue;
+
+		result.push_back(NormalizeName(line.substr(open + 1, close - open - 1)));
+	}
+
+	return result;
+}
+
+string ShaderIncludeGraph::NormalizeName(const string& fileName)
+{
+	string name = fileName;
+	replace(name.begin(), name.end(), '\\', '/');
+	transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)tolower(c); });
+	return name;
+}
+
+void ShaderIncludeGraph::SetFile(const string& fileName, const string& source)
+{
+	string name = NormalizeName(fileName);
+	RemoveFile(name);
+
+	vector<string> fileIncludes = ParseIncludes(source);
+	for (const string& inc : fileIncludes)
+		includedBy[inc].insert(name);
+	includes[name] = fileIncludes;
+}
+
+void ShaderIncludeGraph::RemoveFile(const string& fileName)
+{
+	string name = NormalizeName(fileName);
+	auto it = includes.find(name);
+	if (it == includes.end())
+		return;
+
+	for (const string& inc : it->second)
+		includedBy[inc].erase(name);
+	includes.erase(it);
+}
+
+// --------------------------------------------------------
+// Walks the reverse include edges breadth-first, collecting
+// every .hlsl file that (directly or indirectly) includes
+// the changed file.  Cycles are handled by the visited set.
+// --------------------------------------------------------
+vector<string> ShaderIncludeGraph::GetAffectedShaders(const string& changedFile) const
+{
+	vector<string> result;
+	unordered_set<string> visited;
+	vector<string> queue = { NormalizeName(changedFile) };
+
+	for (size_t i = 0; i < queue.size(); i++)
+	{
+		string current = queue[i];
+		if (!visited.insert(current).second)
+			continue;
+
+		// Only .hlsl files are entry points - .hlsli files are include-only
+		if (current.size() >= 5 && current.compare(current.size() - 5, 5, ".hlsl") == 0)
+			result.push_back(current);
+
+		auto parents = includedBy.find(current);
+		if (parents == includedBy.end())
+			continue;
+		for (const string& parent : parents->second)
+			queue.push_back(parent);
+	}
+
+	sort(result.begin(), result.end());
+	return result;
+}
+
+const vector<string>* ShaderIncludeGraph::GetIncludes(const string& fileName) const
+{
+	auto it = includes.find(NormalizeName(fileName));
+	return it == includes.end() ? 0 : &it->second;
+}
+
+void ChangeDebouncer::Notify(const string& fileName, double time)
+{
+	lastChange[ShaderIncludeGraph::NormalizeName(fileName)] = time;
+}
+
+// --------------------------------------------------------
+// Returns (and forgets) every file that hasn't been touched
+// for at least the quiet period
+// --------------------------------------------------------
+vector<string> ChangeDebouncer::CollectReady(double time)
+{
+	vector<string> ready;
+	for (auto it = lastChange.begin(); it != lastChange.end();)
+	{
+		if (time - it->second >= quietSeconds)
+		{
+			ready.push_back(it->first);
+			it = lastChange.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	sort(ready.begin(), ready.end());
+	return ready;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// --------------------------------------------------------
+// Tracks which shader source files #include which others,
+// so a change to a shared .hlsli can be traced back to every
+// .hlsl entry point that needs recompiling.
+//
+// File names are stored lower-case (Windows paths aren't
+// case sensitive) and relative to the shader directory.
+// --------------------------------------------------------
+class ShaderIncludeGraph
+{
+public:
+	// Parses the #include "..." directives out of a file's source
+	static std::vector<std::string> ParseIncludes(const std::string& source);
+	static std::string NormalizeName(const std::string& fileName);
+
+	// Adds or replaces a file and its direct includes
+	void SetFile(const std::string& fileName, const std::string& source);
+	void RemoveFile(const std::string& fileName);
+
+	// Every compilable shader (.hlsl) that depends on the changed file,
+	// including the file itself if it's a shader
+	std::vector<std::string> GetAffectedShaders(const std::string& changedFile) const;
+
+	const std::vector<std::string>* GetIncludes(const std::string& fileName) const;
+	size_t FileCount() const { return includes.size(); }
+
+private:
+	// file -> files it includes, and the reverse
+	std::unordered_map<std::string, std::vector<std::string>> includes;
+	std::unordered_map<std::string, std::unordered_set<std::string>> includedBy;
+};
+
+// --------------------------------------------------------
+// Collapses bursts of change notifications (editors often
+// write a file several times per save) into a single event
+// per file, once it has been quiet for a short delay.
+//
+// Time is passed in explicitly so this is easy to drive
+// from a test or a simulated clock.
+// --------------------------------------------------------
+class ChangeDebouncer
+{
+public:
+	ChangeDebouncer(double quietSeconds = 0.2) : quietSeconds(quietSeconds) {}
+
+	void Notify(const std::string& fileName, double time);
+	std::vector<std::string> CollectReady(double time);
+	bool HasPending() const { return !lastChange.empty(); }
+
+private:
+	double quietSeconds;
+	std::unordered_map<std::string, double> lastChange;
+};
@@ -32,7 +32,7 @@ struct VertexToPixel
 	//  |    |                |
 	//  v    v                v
     float4 screenPosition : SV_POSITION; // XYZW position (System Value Position)
-    float4 shadowMapPos : SHADOW_POSITION;
+    float viewDepth : VIEW_DEPTH; // Picks the shadow cascade
     float3 normal : NORMAL; // Normal
     float3 worldPosition : POSITION;
     float3 tangent : TANGENT;
@@ -63,6 +63,8 @@ struct Light
     float3 position;
     float intensity;
     float3 color;
+    float spotAngle; // Full width of a spot light's cone, in radians
+    float3 padding;
 };
 
 // A constant Fresnel value for non-metals (glass and plastic have values of about 0.04)
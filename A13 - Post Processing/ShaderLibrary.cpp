@@ -0,0 +1,135 @@
+#include "ShaderLibrary.h"
+#include "Graphics.h"
+
+#include <d3dcompiler.h>
+#include <unordered_map>
+
+using namespace std;
+
+namespace ShaderLibrary
+{
+	// Annonymous namespace to hold the loaded shaders,
+	// keyed by the full path of their .cso file
+	namespace
+	{
+		unordered_map<wstring, shared_ptr<SimpleVertexShader>> vertexShaders;
+		unordered_map<wstring, shared_ptr<SimplePixelShader>> pixelShaders;
+		unordered_map<wstring, shared_ptr<SimpleComputeShader>> computeShaders;
+
+		// Keyed by .cso path, then the defines ("A=1;B=1;")
+		template <typename T>
+		using PermutationMap = unordered_map<wstring, unordered_map<string, shared_ptr<T>>>;
+		PermutationMap<SimplePixelShader> pixelPermutations;
+		PermutationMap<SimpleComputeShader> computePermutations;
+
+		// Returns the existing shader for this file, or loads it on first use
+		template <typename T>
+		shared_ptr<T> GetOrLoad(unordered_map<wstring, shared_ptr<T>>& shaders, const wstring& shaderFile)
+		{
+			auto it = shaders.find(shaderFile);
+			if (it != shaders.end())
+				return it->second;
+
+			shared_ptr<T> shader = make_shared<T>(Graphics::Device, Graphics::Context, shaderFile.c_str());
+			shaders.insert({ shaderFile, shader });
+			return shader;
+		}
+
+		// Compiles the source with the defines for this target ("ps_5_0", etc.),
+		// starting from the plain shader so a failed compile still has one
+		template <typename T>
+		shared_ptr<T> GetOrCompile(PermutationMap<T>& permutationMap, const wstring& shaderFile, const wstring& sourceFile, const vector<pair<string, string>>& defines, const char* target)
+		{
+			string key;
+			for (auto& define : defines)
+				key += define.first + "=" + define.second + ";";
+
+			auto& permutations = permutationMap[shaderFile];
+			auto it = permutations.find(key);
+			if (it != permutations.end())
+				return it->second;
+
+			shared_ptr<T> shader = make_shared<T>(Graphics::Device, Graphics::Context, shaderFile.c_str());
+			vector<D3D_SHADER_MACRO> macros;
+			for (auto& define : defines)
+				macros.push_back({ define.first.c_str(), define.second.c_str() });
+			macros.push_back({ 0, 0 });
+
+			unsigned int flags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined(DEBUG) || defined(_DEBUG)
+			flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+
+			Microsoft::WRL::ComPtr<ID3DBlob> blob;
+			Microsoft::WRL::ComPtr<ID3DBlob> errors;
+			HRESULT hr = D3DCompileFromFile(
+				sourceFile.c_str(),
+				macros.data(),
+				D3D_COMPILE_STANDARD_FILE_INCLUDE,
+				"main",
+				target,
+				flags,
+				0,
+				blob.GetAddressOf(),
+				errors.GetAddressOf());
+
+			if (FAILED(hr))
+			{
+				printf("Failed to compile permutation %s of %ls\n", key.c_str(), sourceFile.c_str());
+				if (errors) printf("%s\n", (const char*)errors->GetBufferPointer());
+			}
+			else
+			{
+				shader->Reload(blob);
+			}
+
+			permutations.insert({ key, shader });
+			return shader;
+		}
+
+		template <typename T>
+		bool ReloadIfLoaded(unordered_map<wstring, shared_ptr<T>>& shaders, const wstring& shaderFile, Microsoft::WRL::ComPtr<ID3DBlob> blob)
+		{
+			auto it = shaders.find(shaderFile);
+			return it != shaders.end() && it->second->Reload(blob);
+		}
+	}
+}
+
+shared_ptr<SimpleVertexShader> ShaderLibrary::GetVertexShader(const wstring& shaderFile) { return GetOrLoad(vertexShaders, shaderFile); }
+shared_ptr<SimplePixelShader> ShaderLibrary::GetPixelShader(const wstring& shaderFile) { return GetOrLoad(pixelShaders, shaderFile); }
+shared_ptr<SimpleComputeShader> ShaderLibrary::GetComputeShader(const wstring& shaderFile) { return GetOrLoad(computeShaders, shaderFile); }
+
+shared_ptr<SimplePixelShader> ShaderLibrary::GetPixelShaderPermutation(const wstring& shaderFile, const wstring& sourceFile, const vector<pair<string, string>>& defines)
+{
+	// No defines is just the plain shader
+	if (defines.empty())
+		return GetPixelShader(shaderFile);
+	return GetOrCompile(pixelPermutations, shaderFile, sourceFile, defines, "ps_5_0");
+}
+
+shared_ptr<SimpleComputeShader> ShaderLibrary::GetComputeShaderPermutation(const wstring& shaderFile, const wstring& sourceFile, const vector<pair<string, string>>& defines)
+{
+	if (defines.empty())
+		return GetComputeShader(shaderFile);
+	return GetOrCompile(computePermutations, shaderFile, sourceFile, defines, "cs_5_0");
+}
+
+bool ShaderLibrary::Reload(const wstring& shaderFile, Microsoft::WRL::ComPtr<ID3DBlob> blob)
+{
+	pixelPermutations.erase(shaderFile);
+	computePermutations.erase(shaderFile);
+	return
+		ReloadIfLoaded(vertexShaders, shaderFile, blob) ||
+		ReloadIfLoaded(pixelShaders, shaderFile, blob) ||
+		ReloadIfLoaded(computeShaders, shaderFile, blob);
+}
+
+void ShaderLibrary::Clear()
+{
+	vertexShaders.clear();
+	pixelShaders.clear();
+	computeShaders.clear();
+	pixelPermutations.clear();
+	computePermutations.clear();
+}
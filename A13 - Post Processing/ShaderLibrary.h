@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SimpleShader.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// Hands out one shared SimpleShader per compiled shader
+// file, so passes that use the same .cso (e.g. the main
+// pass and the sky) don't each load and build their own.
+// --------------------------------------------------------
+namespace ShaderLibrary
+{
+	std::shared_ptr<SimpleVertexShader> GetVertexShader(const std::wstring& shaderFile);
+	std::shared_ptr<SimplePixelShader> GetPixelShader(const std::wstring& shaderFile);
+	std::shared_ptr<SimpleComputeShader> GetComputeShader(const std::wstring& shaderFile);
+
+	// A shader compiled from its source with these defines, once per set of
+	// defines.  If the source won't compile, this is the plain compiled shader.
+	std::shared_ptr<SimplePixelShader> GetPixelShaderPermutation(const std::wstring& shaderFile, const std::wstring& sourceFile, const std::vector<std::pair<std::string, std::string>>& defines);
+	std::shared_ptr<SimpleComputeShader> GetComputeShaderPermutation(const std::wstring& shaderFile, const std::wstring& sourceFile, const std::vector<std::pair<std::string, std::string>>& defines);
+
+	// Swaps new bytecode into an already loaded shader, if there is one
+	// (its permutations are dropped, and recompiled when next asked for)
+	bool Reload(const std::wstring& shaderFile, Microsoft::WRL::ComPtr<ID3DBlob> blob);
+
+	// Releases every shader the library is holding on to
+	void Clear();
+}
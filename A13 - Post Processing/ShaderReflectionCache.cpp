@@ -0,0 +1,441 @@
+#include "ShaderReflectionCache.h"
+
+// Only Reflect() needs D3D - the cache and its serialization build anywhere
+#if defined(_WIN32)
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <wrl/client.h>
+
+#pragma comment(lib, "dxguid.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+#endif
+
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+	// Bump the version whenever the layout of ShaderReflectionData changes
+	// so stale caches from an older build are simply ignored
+	const unsigned int CacheMagic = 0x31435253; // "SRC1"
+	const unsigned int CacheVersion = 1;
+
+	unordered_map<unsigned long long, ShaderReflectionData> entries;
+	bool dirty = false;
+
+	// --- Writing helpers ---
+
+	void WriteUInt(vector<unsigned char>& bytes, unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+			bytes.push_back((unsigned char)(value >> (i * 8)));
+	}
+
+	void WriteUInt64(vector<unsigned char>& bytes, unsigned long long value)
+	{
+		for (int i = 0; i < 8; i++)
+			bytes.push_back((unsigned char)(value >> (i * 8)));
+	}
+
+	void WriteString(vector<unsigned char>& bytes, const string& str)
+	{
+		WriteUInt(bytes, (unsigned int)str.size());
+		bytes.insert(bytes.end(), str.begin(), str.end());
+	}
+
+	void WriteResources(vector<unsigned char>& bytes, const vector<ReflectedResource>& resources)
+	{
+		WriteUInt(bytes, (unsigned int)resources.size());
+		for (const ReflectedResource& r : resources)
+		{
+			WriteString(bytes, r.Name);
+			WriteUInt(bytes, r.BindIndex);
+		}
+	}
+
+	void WriteData(vector<unsigned char>& bytes, const ShaderReflectionData& data)
+	{
+		WriteUInt(bytes, (unsigned int)data.ConstantBuffers.size());
+		for (const ReflectedConstantBuffer& cb : data.ConstantBuffers)
+		{
+			WriteString(bytes, cb.Name);
+			WriteUInt(bytes, cb.Type);
+			WriteUInt(bytes, cb.Size);
+			WriteUInt(bytes, cb.BindIndex);
+			WriteUInt(bytes, (unsigned int)cb.Variables.size());
+			for (const ReflectedVariable& v : cb.Variables)
+			{
+				WriteString(bytes, v.Name);
+				WriteUInt(bytes, v.ByteOffset);
+				WriteUInt(bytes, v.Size);
+			}
+		}
+
+		WriteResources(bytes, data.ShaderResourceViews);
+		WriteResources(bytes, data.Samplers);
+		WriteResources(bytes, data.UnorderedAccessViews);
+
+		WriteUInt(bytes, (unsigned int)data.InputParameters.size());
+		for (const ReflectedInputParameter& p : data.InputParameters)
+		{
+			WriteString(bytes, p.SemanticName);
+			WriteUInt(bytes, p.SemanticIndex);
+			WriteUInt(bytes, p.Mask);
+			WriteUInt(bytes, p.ComponentType);
+		}
+
+		for (int i = 0; i < 3; i++)
+			WriteUInt(bytes, data.ThreadGroupSize[i]);
+	}
+
+	// --- Reading helpers ---
+	// Every read is bounds checked so a truncated or corrupt
+	// file fails cleanly instead of reading past the buffer
+
+	struct Reader
+	{
+		const unsigned char* bytes;
+		size_t size;
+		size_t pos;
+	};
+
+	bool ReadUInt(Reader& r, unsigned int& value)
+	{
+		if (r.size - r.pos < 4) return false;
+		value = 0;
+		for (int i = 0; i < 4; i++)
+			value |= (unsigned int)r.bytes[r.pos + i] << (i * 8);
+		r.pos += 4;
+		return true;
+	}
+
+	bool ReadUInt64(Reader& r, unsigned long long& value)
+	{
+		if (r.size - r.pos < 8) return false;
+		value = 0;
+		for (int i = 0; i < 8; i++)
+			value |= (unsigned long long)r.bytes[r.pos + i] << (i * 8);
+		r.pos += 8;
+		return true;
+	}
+
+	bool ReadString(Reader& r, string& str)
+	{
+		unsigned int length;
+		if (!ReadUInt(r, length) || r.size - r.pos < length) return false;
+		str.assign((const char*)r.bytes + r.pos, length);
+		r.pos += length;
+		return true;
+	}
+
+	// A count is only believed if what's left could hold that many of
+	// the smallest possible record, so a corrupt one fails here instead
+	// of asking for gigabytes before the reads run out
+	bool ReadCount(Reader& r, unsigned int& count, size_t minimumRecordSize)
+	{
+		return ReadUInt(r, count) && count <= (r.size - r.pos) / minimumRecordSize;
+	}
+
+	// Smallest serialized size of each record - every string is at least its length
+	const size_t MinimumResourceSize = 8;
+	const size_t MinimumConstantBufferSize = 20;
+	const size_t MinimumVariableSize = 12;
+	const size_t MinimumInputParameterSize = 16;
+
+	bool ReadResources(Reader& r, vector<ReflectedResource>& resources)
+	{
+		unsigned int count;
+		if (!ReadCount(r, count, MinimumResourceSize)) return false;
+		resources.resize(count);
+		for (ReflectedResource& res : resources)
+		{
+			if (!ReadString(r, res.Name) || !ReadUInt(r, res.BindIndex))
+				return false;
+		}
+		return true;
+	}
+
+	bool ReadData(Reader& r, ShaderReflectionData& data)
+	{
+		unsigned int cbCount;
+		if (!ReadCount(r, cbCount, MinimumConstantBufferSize)) return false;
+		data.ConstantBuffers.resize(cbCount);
+		for (ReflectedConstantBuffer& cb : data.ConstantBuffers)
+		{
+			unsigned int varCount;
+			if (!ReadString(r, cb.Name) ||
+				!ReadUInt(r, cb.Type) ||
+				!ReadUInt(r, cb.Size) ||
+				!ReadUInt(r, cb.BindIndex) ||
+				!ReadCount(r, varCount, MinimumVariableSize))
+				return false;
+
+			cb.Variables.resize(varCount);
+			for (ReflectedVariable& v : cb.Variables)
+			{
+				if (!ReadString(r, v.Name) || !ReadUInt(r, v.ByteOffset) || !ReadUInt(r, v.Size))
+					return false;
+			}
+		}
+
+		if (!ReadResources(r, data.ShaderResourceViews) ||
+			!ReadResources(r, data.Samplers) ||
+			!ReadResources(r, data.UnorderedAccessViews))
+			return false;
+
+		unsigned int inputCount;
+		if (!ReadCount(r, inputCount, MinimumInputParameterSize)) return false;
+		data.InputParameters.resize(inputCount);
+		for (ReflectedInputParameter& p : data.InputParameters)
+		{
+			if (!ReadString(r, p.SemanticName) ||
+				!ReadUInt(r, p.SemanticIndex) ||
+				!ReadUInt(r, p.Mask) ||
+				!ReadUInt(r, p.ComponentType))
+				return false;
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			if (!ReadUInt(r, data.ThreadGroupSize[i])) return false;
+		}
+		return true;
+	}
+}
+
+bool ShaderReflectionData::operator==(const ShaderReflectionData& other) const
+{
+	// Serialized form is canonical, so comparing bytes compares everything
+	vector<unsigned char> a, b;
+	WriteData(a, *this);
+	WriteData(b, other);
+	return a == b;
+}
+
+// --------------------------------------------------------
+// 64-bit FNV-1a over the compiled shader bytecode
+// --------------------------------------------------------
+unsigned long long ShaderReflectionCache::HashBytecode(const void* bytecode, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)bytecode;
+	unsigned long long hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+bool ShaderReflectionCache::Find(unsigned long long hash, ShaderReflectionData& data)
+{
+	auto it = entries.find(hash);
+	if (it == entries.end())
+		return false;
+
+	data = it->second;
+	return true;
+}
+
+void ShaderReflectionCache::Insert(unsigned long long hash, const ShaderReflectionData& data)
+{
+	entries[hash] = data;
+	dirty = true;
+}
+
+void ShaderReflectionCache::Clear()
+{
+	entries.clear();
+	dirty = false;
+}
+
+size_t ShaderReflectionCache::Count() { return entries.size(); }
+bool ShaderReflectionCache::IsDirty() { return dirty; }
+
+#if defined(_WIN32)
+// --------------------------------------------------------
+// Runs D3DReflect over the bytecode and copies out the
+// constant buffer layouts, resource bind points, vertex
+// inputs and compute thread group size.
+//
+// Returns false if the bytecode couldn't be reflected
+// --------------------------------------------------------
+bool ShaderReflectionCache::Reflect(const void* bytecode, size_t size, ShaderReflectionData& data)
+{
+	data = ShaderReflectionData();
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
+	HRESULT hr = D3DReflect(
+		bytecode,
+		size,
+		IID_ID3D11ShaderReflection,
+		(void**)refl.GetAddressOf());
+	if (FAILED(hr))
+		return false;
+
+	D3D11_SHADER_DESC shaderDesc;
+	refl->GetDesc(&shaderDesc);
+
+	// Bound resources (textures, samplers and UAVs)
+	for (unsigned int r = 0; r < shaderDesc.BoundResources; r++)
+	{
+		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
+		refl->GetResourceBindingDesc(r, &resourceDesc);
+
+		ReflectedResource resource;
+		resource.Name = resourceDesc.Name;
+		resource.BindIndex = resourceDesc.BindPoint;
+
+		switch (resourceDesc.Type)
+		{
+		case D3D_SIT_STRUCTURED: // Treat structured buffers as texture resources
+		case D3D_SIT_TEXTURE:
+			data.ShaderResourceViews.push_back(resource);
+			break;
+
+		case D3D_SIT_SAMPLER:
+			data.Samplers.push_back(resource);
+			break;
+
+		case D3D_SIT_UAV_APPEND_STRUCTURED:
+		case D3D_SIT_UAV_CONSUME_STRUCTURED:
+		case D3D_SIT_UAV_RWBYTEADDRESS:
+		case D3D_SIT_UAV_RWSTRUCTURED:
+		case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
+		case D3D_SIT_UAV_RWTYPED:
+			data.UnorderedAccessViews.push_back(resource);
+			break;
+
+		default: // Constant buffers are handled below, and nothing else is bound by SimpleShader
+			break;
+		}
+	}
+
+	// Constant buffers and their variables
+	for (unsigned int b = 0; b < shaderDesc.ConstantBuffers; b++)
+	{
+		ID3D11ShaderReflectionConstantBuffer* cb = refl->GetConstantBufferByIndex(b);
+
+		D3D11_SHADER_BUFFER_DESC bufferDesc;
+		cb->GetDesc(&bufferDesc);
+
+		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
+
+		ReflectedConstantBuffer buffer;
+		buffer.Name = bufferDesc.Name;
+		buffer.Type = bufferDesc.Type;
+		buffer.Size = bufferDesc.Size;
+		buffer.BindIndex = bindDesc.BindPoint;
+
+		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
+		{
+			D3D11_SHADER_VARIABLE_DESC varDesc;
+			cb->GetVariableByIndex(v)->GetDesc(&varDesc);
+
+			ReflectedVariable var;
+			var.Name = varDesc.Name;
+			var.ByteOffset = varDesc.StartOffset;
+			var.Size = varDesc.Size;
+			buffer.Variables.push_back(var);
+		}
+
+		data.ConstantBuffers.push_back(buffer);
+	}
+
+	// Vertex inputs, used to build an input layout
+	for (unsigned int i = 0; i < shaderDesc.InputParameters; i++)
+	{
+		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
+		refl->GetInputParameterDesc(i, &paramDesc);
+
+		ReflectedInputParameter param;
+		param.SemanticName = paramDesc.SemanticName;
+		param.SemanticIndex = paramDesc.SemanticIndex;
+		param.Mask = paramDesc.Mask;
+		param.ComponentType = paramDesc.ComponentType;
+		data.InputParameters.push_back(param);
+	}
+
+	// Thread group size (zeroes for anything that isn't a compute shader)
+	refl->GetThreadGroupSize(
+		&data.ThreadGroupSize[0],
+		&data.ThreadGroupSize[1],
+		&data.ThreadGroupSize[2]);
+
+	return true;
+}
+#endif
+
+// --------------------------------------------------------
+// Writes every cached entry into a flat byte array
+// --------------------------------------------------------
+void ShaderReflectionCache::Serialize(vector<unsigned char>& bytes)
+{
+	bytes.clear();
+	WriteUInt(bytes, CacheMagic);
+	WriteUInt(bytes, CacheVersion);
+	WriteUInt(bytes, (unsigned int)entries.size());
+	for (auto& e : entries)
+	{
+		WriteUInt64(bytes, e.first);
+		WriteData(bytes, e.second);
+	}
+}
+
+// --------------------------------------------------------
+// Replaces the cache contents with the serialized entries.
+// On any format mismatch the cache is left empty.
+// --------------------------------------------------------
+bool ShaderReflectionCache::Deserialize(const unsigned char* bytes, size_t size)
+{
+	Clear();
+
+	Reader r = { bytes, size, 0 };
+	unsigned int magic, version, count;
+	if (!ReadUInt(r, magic) || magic != CacheMagic ||
+		!ReadUInt(r, version) || version != CacheVersion ||
+		!ReadUInt(r, count))
+		return false;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned long long hash;
+		ShaderReflectionData data;
+		if (!ReadUInt64(r, hash) || !ReadData(r, data))
+		{
+			Clear();
+			return false;
+		}
+		entries[hash] = data;
+	}
+
+	return true;
+}
+
+bool ShaderReflectionCache::Load(const wstring& cacheFile)
+{
+	ifstream file(filesystem::path(cacheFile), ios::binary);
+	if (!file.is_open())
+		return false;
+
+	vector<unsigned char> bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	return Deserialize(bytes.data(), bytes.size());
+}
+
+bool ShaderReflectionCache::Save(const wstring& cacheFile)
+{
+	vector<unsigned char> bytes;
+	Serialize(bytes);
+
+	ofstream file(filesystem::path(cacheFile), ios::binary | ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	file.write((const char*)bytes.data(), bytes.size());
+	dirty = false;
+	return file.good();
+}
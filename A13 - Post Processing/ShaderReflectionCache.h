@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Plain-data copies of everything SimpleShader pulls out of
+// D3DReflect.  None of these touch the device, so they can
+// be built, serialized and compared without a GPU.
+// --------------------------------------------------------
+struct ReflectedVariable
+{
+	std::string Name;
+	unsigned int ByteOffset = 0;
+	unsigned int Size = 0;
+};
+
+struct ReflectedConstantBuffer
+{
+	std::string Name;
+	unsigned int Type = 0;		// D3D_CBUFFER_TYPE
+	unsigned int Size = 0;
+	unsigned int BindIndex = 0;
+	std::vector<ReflectedVariable> Variables;
+};
+
+struct ReflectedResource
+{
+	std::string Name;
+	unsigned int BindIndex = 0;
+};
+
+struct ReflectedInputParameter
+{
+	std::string SemanticName;
+	unsigned int SemanticIndex = 0;
+	unsigned int Mask = 0;
+	unsigned int ComponentType = 0;	// D3D_REGISTER_COMPONENT_TYPE
+};
+
+struct ShaderReflectionData
+{
+	std::vector<ReflectedConstantBuffer> ConstantBuffers;
+	std::vector<ReflectedResource> ShaderResourceViews;
+	std::vector<ReflectedResource> Samplers;
+	std::vector<ReflectedResource> UnorderedAccessViews;
+	std::vector<ReflectedInputParameter> InputParameters;
+	unsigned int ThreadGroupSize[3] = { 0, 0, 0 };
+
+	bool operator==(const ShaderReflectionData& other) const;
+};
+
+// --------------------------------------------------------
+// Persistent cache of shader reflection results, keyed by
+// a hash of the compiled bytecode.  Loaded once at startup
+// so that SimpleShader can skip D3DReflect for any .cso
+// that hasn't changed since the last run.
+// --------------------------------------------------------
+namespace ShaderReflectionCache
+{
+	// Hashing
+	unsigned long long HashBytecode(const void* bytecode, size_t size);
+
+	// Lookup and insertion
+	bool Find(unsigned long long hash, ShaderReflectionData& data);
+	void Insert(unsigned long long hash, const ShaderReflectionData& data);
+	void Clear();
+	size_t Count();
+	bool IsDirty();
+
+	// Builds reflection data directly from bytecode (the slow path)
+	bool Reflect(const void* bytecode, size_t size, ShaderReflectionData& data);
+
+	// Whole-cache serialization
+	void Serialize(std::vector<unsigned char>& bytes);
+	bool Deserialize(const unsigned char* bytes, size_t size);
+
+	// Disk persistence
+	bool Load(const std::wstring& cacheFile);
+	bool Save(const std::wstring& cacheFile);
+}
@@ -0,0 +1,261 @@
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+	bool SameTiles(const vector<ShadowTile>& a, const vector<ShadowTile>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++)
+			if (a[i].X != b[i].X || a[i].Y != b[i].Y || a[i].Size != b[i].Size) return false;
+		return true;
+	}
+}
+
+ShadowAtlas::ShadowAtlas(const ShadowAtlasSettings& settings)
+	: settings(settings)
+{
+	Clear();
+}
+
+unsigned int ShadowAtlas::TileSize(float importance, unsigned int currentSize) const
+{
+	if (importance <= 0)
+		return 0;
+
+	// In powers of two, so each size covers the same spread of importance
+	float smallest = log2f((float)settings.MinTileSize);
+	float largest = log2f((float)settings.MaxTileSize);
+	float ideal = min(max(log2f(importance * settings.MaxTileSize), smallest), largest);
+	if (currentSize > 0 && fabsf(ideal - log2f((float)currentSize)) <= 0.5f + settings.Hysteresis)
+		return currentSize;
+	return 1u << (unsigned int)lroundf(ideal);
+}
+
+void ShadowAtlas::Clear()
+{
+	Node root;
+	root.Tile.Size = settings.Size;
+	nodes.assign(1, root);
+	slots.clear();
+	stats.UsedArea = 0;
+}
+
+int ShadowAtlas::Claim(unsigned int size)
+{
+	// The smallest free square that holds it, so big ones stay whole for as long as they can
+	int best = -1;
+	for (int i = 0; i < (int)nodes.size(); i++)
+	{
+		if (nodes[i].State == NodeState::Free && nodes[i].Tile.Size >= size && (best < 0 || nodes[i].Tile.Size < nodes[best].Tile.Size))
+			best = i;
+	}
+	if (best < 0)
+		return -1;
+
+	// Then quarter it down to size, taking the first quarter each time
+	while (nodes[best].Tile.Size > size)
+	{
+		if (nodes[best].Children < 0)
+		{
+			nodes[best].Children = (int)nodes.size();
+			nodes.resize(nodes.size() + 4);
+		}
+
+		ShadowTile tile = nodes[best].Tile;
+		unsigned int half = tile.Size / 2;
+		for (int c = 0; c < 4; c++)
+		{
+			Node& child = nodes[nodes[best].Children + c];
+			child.Tile.X = tile.X + (c & 1) * half;
+			child.Tile.Y = tile.Y + (c >> 1) * half;
+			child.Tile.Size = half;
+			child.Parent = best;
+			child.State = NodeState::Free;
+		}
+		nodes[best].State = NodeState::Split;
+		best = nodes[best].Children;
+	}
+	nodes[best].State = NodeState::Used;
+	return best;
+}
+
+void ShadowAtlas::Release(int node)
+{
+	nodes[node].State = NodeState::Free;
+
+	// Four free quarters are a free square again
+	for (int parent = nodes[node].Parent; parent >= 0; parent = nodes[parent].Parent)
+	{
+		int first = nodes[parent].Children;
+		for (int c = 0; c < 4; c++)
+			if (nodes[first + c].State != NodeState::Free) return;
+		for (int c = 0; c < 4; c++)
+			nodes[first + c].State = NodeState::Unused;
+		nodes[parent].State = NodeState::Free;
+	}
+}
+
+bool ShadowAtlas::Place(Slot& slot, unsigned int faces, unsigned int size)
+{
+	// All of the faces or none of them
+	for (unsigned int f = 0; f < faces; f++)
+	{
+		int node = Claim(size);
+		if (node < 0)
+		{
+			Free(slot);
+			return false;
+		}
+		slot.Nodes.push_back(node);
+	}
+	slot.Size = size;
+	return true;
+}
+
+void ShadowAtlas::Free(Slot& slot)
+{
+	for (int node : slot.Nodes)
+		Release(node);
+	slot.Nodes.clear();
+	slot.Size = 0;
+}
+
+const vector<ShadowAllocation>& ShadowAtlas::Allocate(const vector<ShadowRequest>& requests)
+{
+	stats = ShadowAtlasStats();
+
+	// Most important first, for the tile budget and for placing
+	vector<size_t> order(requests.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return requests[a].Importance > requests[b].Importance; });
+
+	// Each request takes over its light's slot from last frame, if it had one
+	vector<Slot> previous;
+	previous.swap(slots);
+	slots.resize(requests.size());
+	vector<unsigned int> wanted(requests.size(), 0);
+	vector<unsigned int> previousWanted(requests.size(), 0);
+	vector<vector<ShadowTile>> previousTiles(requests.size());
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		slots[i].Light = requests[i].Light;
+		for (auto& slot : previous)
+		{
+			if (slot.Light == requests[i].Light && !slot.Nodes.empty())
+			{
+				for (int node : slot.Nodes)
+					previousTiles[i].push_back(nodes[node].Tile);
+				// Sized against what it wanted, so a light squeezed smaller doesn't stay squeezed
+				wanted[i] = TileSize(requests[i].Importance, slot.Wanted);
+				previousWanted[i] = slot.Wanted;
+				slots[i].Size = slot.Size;
+				slots[i].Nodes = slot.Nodes;
+				slot.Nodes.clear();
+				break;
+			}
+		}
+		if (previousTiles[i].empty())
+			wanted[i] = TileSize(requests[i].Importance, 0);
+		slots[i].Wanted = wanted[i];
+	}
+
+	// Lights that weren't asked for again give their tiles back
+	bool freed = false;
+	for (auto& slot : previous)
+	{
+		freed = freed || !slot.Nodes.empty();
+		Free(slot);
+	}
+
+	// Only so many tiles fit in the shader's constants
+	unsigned int tiles = 0;
+	for (size_t i : order)
+	{
+		if (wanted[i] > 0 && tiles + requests[i].Faces > MaxTiles)
+			wanted[i] = 0;
+		tiles += wanted[i] > 0 ? requests[i].Faces : 0;
+	}
+
+	// Lights that still want what they have stay where they are, the rest let go
+	bool squeezed = false;
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		if (slots[i].Nodes.empty())
+			continue;
+		if (wanted[i] != previousWanted[i] || slots[i].Nodes.size() != requests[i].Faces)
+		{
+			Free(slots[i]);
+			freed = true;
+		}
+		else if (slots[i].Size < wanted[i])
+			squeezed = true;
+	}
+
+	// New (or resized) lights go in the gaps, most important first
+	bool full = false;
+	for (size_t i : order)
+	{
+		if (wanted[i] > 0 && slots[i].Nodes.empty() && !Place(slots[i], requests[i].Faces, wanted[i]))
+			full = true;
+	}
+
+	// A light short of what it wants while there's space it could have: start
+	// over, largest first, halving whoever doesn't fit until they do.  Nobody
+	// gets more than a more important light was left with.
+	if (full || (squeezed && freed))
+	{
+		stats.Repacked = true;
+		vector<Slot> kept;
+		kept.swap(slots);
+		Clear();
+		slots.resize(requests.size());
+		for (size_t i = 0; i < requests.size(); i++)
+		{
+			slots[i].Light = requests[i].Light;
+			slots[i].Wanted = kept[i].Wanted;
+		}
+
+		unsigned int largest = settings.MaxTileSize;
+		for (size_t i : order)
+		{
+			for (unsigned int size = min(wanted[i], largest); size >= settings.MinTileSize && size > 0; size /= 2)
+				if (Place(slots[i], requests[i].Faces, size)) break;
+			if (!slots[i].Nodes.empty())
+				largest = min(largest, slots[i].Size);
+		}
+	}
+
+	allocations.assign(requests.size(), ShadowAllocation());
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		ShadowAllocation& allocation = allocations[i];
+		allocation.Size = slots[i].Size;
+		for (int node : slots[i].Nodes)
+			allocation.Tiles.push_back(nodes[node].Tile);
+		allocation.Changed = !SameTiles(allocation.Tiles, previousTiles[i]);
+
+		if (allocation.Tiles.empty())
+			stats.Dropped += requests[i].Importance > 0 ? 1 : 0;
+		else if (allocation.Changed)
+			stats.Placed++;
+		else
+			stats.Kept++;
+		stats.UsedArea += (unsigned int)allocation.Tiles.size() * allocation.Size * allocation.Size;
+	}
+	return allocations;
+}
+
+unsigned int ShadowAtlas::LargestFree() const
+{
+	unsigned int largest = 0;
+	for (const Node& node : nodes)
+		if (node.State == NodeState::Free) largest = max(largest, node.Tile.Size);
+	return largest;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <vector>
+
+struct ShadowAtlasSettings
+{
+	unsigned int Size = 2048;			// The atlas is this square
+	unsigned int MaxTileSize = 512;		// Per face, for a light that fills the screen
+	unsigned int MinTileSize = 64;		// Per face, for one that's barely on it
+	float Hysteresis = 0.25f;			// How far (in powers of two) past the halfway point to a new size a tile has to be pushed before it changes
+};
+
+// A square of the atlas, in texels
+struct ShadowTile
+{
+	unsigned int X = 0;
+	unsigned int Y = 0;
+	unsigned int Size = 0;
+};
+
+// A light that wants a shadow this frame
+struct ShadowRequest
+{
+	unsigned int Light = 0;		// Identifies it from frame to frame
+	float Importance = 0;		// 0 (not on screen) to 1 (fills it) - see LocalShadows::Importance
+	unsigned int Faces = 1;		// Tiles it needs, all the same size - 6 for a cube
+};
+
+// Where a request's faces went - no tiles means no shadow this frame
+struct ShadowAllocation
+{
+	unsigned int Size = 0;
+	std::vector<ShadowTile> Tiles;
+	bool Changed = true;		// Not where (or as big as) it was last frame
+};
+
+struct ShadowAtlasStats
+{
+	unsigned int Kept = 0;		// Lights left where they were
+	unsigned int Placed = 0;	// Lights given new tiles
+	unsigned int Dropped = 0;	// Lights left without a shadow
+	bool Repacked = false;		// Everything was freed and placed again, most important first
+	unsigned int UsedArea = 0;	// Texels in tiles
+};
+
+// --------------------------------------------------------
+// Hands out square tiles of one shadow map texture to the
+// point and spot lights, sized by how much of the screen
+// each one covers.
+//
+// The atlas is a quadtree: every tile is a power of two
+// and sits in a node of that size, so a freed tile merges
+// back with its three siblings into the bigger square they
+// came from.  A tile goes in the smallest free node that
+// holds it.
+//
+// Lights keep their tiles from frame to frame unless they
+// change size, and sizes only change once the importance
+// has moved well past the halfway point to the next power
+// of two, so a light hovering at a boundary doesn't flip
+// back and forth.  When a light can't get the size it
+// wants, everything is freed and placed again from the
+// most important light down - placing power of two
+// squares largest first never fragments, so only the
+// least important lights ever shrink or go without.
+//
+// Nothing here touches D3D, so the packing and the reuse
+// are checked on their own (Tests/ShadowAtlasTests.cpp).
+// --------------------------------------------------------
+class ShadowAtlas
+{
+public:
+	static const unsigned int MaxTiles = 16;	// Must match MAX_SHADOW_TILES in PixelShader.hlsl
+
+	ShadowAtlas(const ShadowAtlasSettings& settings = ShadowAtlasSettings());
+
+	// One allocation per request, in the same order.  Lights that were
+	// requested last frame and aren't now give their tiles back.
+	const std::vector<ShadowAllocation>& Allocate(const std::vector<ShadowRequest>& requests);
+
+	// The tile size for an importance, given the size the light has now (0 for none)
+	unsigned int TileSize(float importance, unsigned int currentSize) const;
+
+	// Frees every tile, so the next Allocate places everything from scratch
+	void Clear();
+
+	const ShadowAtlasSettings& GetSettings() const { return settings; }
+	const ShadowAtlasStats& GetStats() const { return stats; }
+
+	// The biggest tile that's free - the whole atlas once every light has gone
+	unsigned int LargestFree() const;
+
+private:
+	enum class NodeState { Free, Split, Used, Unused };
+	struct Node
+	{
+		ShadowTile Tile;
+		int Parent = -1;
+		int Children = -1;	// The first of four, next to each other - -1 until it's first split
+		NodeState State = NodeState::Free;
+	};
+
+	// A light's tiles, as the atlas holds them
+	struct Slot
+	{
+		unsigned int Light = 0;
+		unsigned int Size = 0;
+		unsigned int Wanted = 0;	// What it asked for, which it may have been squeezed below
+		std::vector<int> Nodes;
+	};
+
+	int Claim(unsigned int size);
+	void Release(int node);
+	bool Place(Slot& slot, unsigned int faces, unsigned int size);
+	void Free(Slot& slot);
+
+	ShadowAtlasSettings settings;
+	std::vector<Node> nodes;
+	std::vector<Slot> slots;
+	std::vector<ShadowAllocation> allocations;
+	ShadowAtlasStats stats;
+};
@@ -0,0 +1,55 @@
+#include "ShadowCache.h"
+
+using namespace std;
+
+const ShadowCachePlan& ShadowCache::Plan(unsigned int cascade, const ShadowCascade& current, const vector<bool>& dynamic, const vector<bool>& moved, bool forceRebuild)
+{
+	if (cascade >= slices.size())
+		slices.resize(cascade + 1);
+	Slice& slice = slices[cascade];
+
+	plan.StaticCasters.clear();
+	plan.DynamicCasters.clear();
+	for (unsigned int caster : current.Casters)
+	{
+		if (caster < dynamic.size() && dynamic[caster])
+			plan.DynamicCasters.push_back(caster);
+		else
+			plan.StaticCasters.push_back(caster);
+	}
+
+	// The cache is compared as if the static casters were all the cascade had
+	ShadowCascade currentStatic = current;
+	currentStatic.Casters = plan.StaticCasters;
+
+	if (forceRebuild || !slice.Valid || CascadedShadows::NeedsRedraw(slice.Static, currentStatic, moved))
+	{
+		plan.Action = ShadowCacheAction::Rebuild;
+		slice.Static = currentStatic;
+		stats.Rebuilt++;
+	}
+	else if (CascadedShadows::NeedsRedraw(slice.Live, current, moved))
+	{
+		plan.Action = ShadowCacheAction::Overlay;
+		stats.Overlaid++;
+	}
+	else
+	{
+		plan.Action = ShadowCacheAction::Keep;
+		stats.Kept++;
+	}
+
+	slice.Live = current;
+	slice.Valid = true;
+	return plan;
+}
+
+void ShadowCache::Invalidate()
+{
+	slices.clear();
+}
+
+void ShadowCache::ResetStats()
+{
+	stats = ShadowCacheStats();
+}
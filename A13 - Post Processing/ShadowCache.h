@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CascadedShadows.h"
+
+#include <vector>
+
+// What a cascade's slice of the shadow map needs this frame
+enum class ShadowCacheAction
+{
+	Keep,		// The live slice is still right - nothing to do
+	Overlay,	// Copy the cached static slice over it, then draw the dynamic casters on top
+	Rebuild,	// Draw the static casters into the cache first, then overlay as above
+};
+
+struct ShadowCachePlan
+{
+	ShadowCacheAction Action = ShadowCacheAction::Rebuild;
+	std::vector<unsigned int> StaticCasters;	// For the cache - only drawn on a rebuild
+	std::vector<unsigned int> DynamicCasters;	// Drawn over the copy on a rebuild or an overlay
+};
+
+struct ShadowCacheStats
+{
+	unsigned int Kept = 0;
+	unsigned int Overlaid = 0;
+	unsigned int Rebuilt = 0;
+};
+
+// --------------------------------------------------------
+// Keeps track of what each cascade's two slices hold: the
+// cached one, with only the static casters in it, and the
+// live one the pixel shader reads - the cache plus the
+// dynamic casters drawn over it.
+//
+// The cache only goes stale when its projection changes
+// (the light turns, or the cascade moves a texel) or its
+// static casters do - a static caster moving (they can be
+// edited) counts too.  The live slice also goes stale when
+// a dynamic caster moves, comes or goes, but then it's just
+// a copy and a few draws.
+//
+// Nothing here touches D3D: Plan() says what to draw and
+// assumes it's done, so the invalidation rules can be
+// checked on their own (Tests/ShadowCacheTests.cpp).
+// --------------------------------------------------------
+class ShadowCache
+{
+public:
+	// What the cascade needs, given which casters are dynamic and which moved since last frame.
+	// The plan is taken as carried out - call it once per cascade per frame.
+	const ShadowCachePlan& Plan(unsigned int cascade, const ShadowCascade& current, const std::vector<bool>& dynamic, const std::vector<bool>& moved, bool forceRebuild = false);
+
+	// Forget every slice, so each cascade rebuilds next time
+	void Invalidate();
+
+	// Counts since the last reset - reset once per frame for per-frame numbers
+	const ShadowCacheStats& GetStats() const { return stats; }
+	void ResetStats();
+
+private:
+	struct Slice
+	{
+		bool Valid = false;
+		ShadowCascade Static;	// As drawn, with only the static casters
+		ShadowCascade Live;		// As drawn, with all of them
+	};
+
+	std::vector<Slice> slices;
+	ShadowCachePlan plan;
+	ShadowCacheStats stats;
+};
@@ -4,6 +4,9 @@
 bool ISimpleShader::ReportErrors = false;
 bool ISimpleShader::ReportWarnings = false;
 
+// No state cache unless the program provides one
+RenderStateCache* ISimpleShader::StateCache = 0;
+
 // To enable error reporting, use either or both 
 // of the following lines somewhere in your program, 
 // preferably before loading/using any shaders.
@@ -54,14 +57,17 @@ void ISimpleShader::CleanUp()
 	if (constantBuffers)
 	{
 		delete[] constantBuffers;
+		constantBuffers = 0;
 		constantBufferCount = 0;
 	}
 
 	for (unsigned int i = 0; i < shaderResourceViews.size(); i++)
 		delete shaderResourceViews[i];
+	shaderResourceViews.clear();
 	
 	for (unsigned int i = 0; i < samplerStates.size(); i++)
 		delete samplerStates[i];
+	samplerStates.clear();
 
 	// Clean up tables
 	varTable.clear();
@@ -72,7 +78,9 @@ void ISimpleShader::CleanUp()
 
 // --------------------------------------------------------
 // Loads the specified shader and builds the variable table 
-// using shader reflection.
+// using shader reflection.  Reflection results are looked
+// up in the ShaderReflectionCache first, so D3DReflect only
+// runs for bytecode that hasn't been seen before.
 //
 // shaderFile - A "wide string" specifying the compiled shader to load
 // 
@@ -94,6 +102,58 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	return InitializeFromBlob(shaderFile);
+}
+
+// --------------------------------------------------------
+// Replaces this shader with freshly compiled bytecode, keeping
+// the same object so anything holding a pointer to it picks up
+// the change.  Only call this between frames.
+//
+// newBlob - The compiled shader code to swap in
+// 
+// Returns true if the new shader was created properly
+// --------------------------------------------------------
+bool ISimpleShader::Reload(Microsoft::WRL::ComPtr<ID3DBlob> newBlob)
+{
+	if (!newBlob)
+		return false;
+
+	shaderBlob = newBlob;
+	return InitializeFromBlob(L"(reloaded shader)");
+}
+
+// --------------------------------------------------------
+// Creates the shader and builds the variable table from
+// whatever bytecode is currently in shaderBlob
+//
+// shaderName - Used to identify the shader in error messages
+// 
+// Returns true if shader is created properly, false otherwise
+// --------------------------------------------------------
+bool ISimpleShader::InitializeFromBlob(LPCWSTR shaderName)
+{
+	// Grab this shader's reflection info, either from the cache (if this
+	// exact bytecode has been seen before) or from D3DReflect directly
+	unsigned long long hash = ShaderReflectionCache::HashBytecode(
+		shaderBlob->GetBufferPointer(),
+		shaderBlob->GetBufferSize());
+	if (!ShaderReflectionCache::Find(hash, reflection))
+	{
+		if (!ShaderReflectionCache::Reflect(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), reflection))
+		{
+			if (ReportErrors)
+			{
+				LogError("SimpleShader::LoadShaderFile() - Unable to reflect shader file '");
+				LogW(shaderName);
+				LogError("'.\n");
+			}
+
+			return false;
+		}
+		ShaderReflectionCache::Insert(hash, reflection);
+	}
+
 	// Create the shader - Calls an overloaded version of this abstract
 	// method in the appropriate child class
 	shaderValid = CreateShader(shaderBlob);
@@ -102,89 +162,50 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		if (ReportErrors)
 		{
 			LogError("SimpleShader::LoadShaderFile() - Error creating shader from file '");
-			LogW(shaderFile);
+			LogW(shaderName);
 			LogError("'. Ensure the type of shader (vertex, pixel, etc.) matches the SimpleShader type (SimpleVertexShader, SimplePixelShader, etc.) you're using.\n");
 		}
 
 		return false;
 	}
 
-	// Set up shader reflection to get information about
-	// this shader and its variables,  buffers, etc.
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-	
-	// Get the description of the shader
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
 	// Create resource arrays
-	constantBufferCount = shaderDesc.ConstantBuffers;
+	constantBufferCount = (unsigned int)reflection.ConstantBuffers.size();
 	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
 	
 	// Handle bound resources (like shaders and samplers)
-	unsigned int resourceCount = shaderDesc.BoundResources;
-	for (unsigned int r = 0; r < resourceCount; r++)
+	for (const ReflectedResource& resource : reflection.ShaderResourceViews)
 	{
-		// Get this resource's description
-		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
-		refl->GetResourceBindingDesc(r, &resourceDesc);
-
-		// Check the type
-		switch (resourceDesc.Type)
-		{
-		case D3D_SIT_STRUCTURED: // Treat structured buffers as texture resources
-		case D3D_SIT_TEXTURE: // A texture resource
-		{
-			// Create the SRV wrapper
-			SimpleSRV* srv = new SimpleSRV();
-			srv->BindIndex = resourceDesc.BindPoint;				// Shader bind point
-			srv->Index = (unsigned int)shaderResourceViews.size();	// Raw index
+		// Create the SRV wrapper
+		SimpleSRV* srv = new SimpleSRV();
+		srv->BindIndex = resource.BindIndex;					// Shader bind point
+		srv->Index = (unsigned int)shaderResourceViews.size();	// Raw index
 
-			textureTable.insert(std::pair<std::string, SimpleSRV*>(resourceDesc.Name, srv));
-			shaderResourceViews.push_back(srv);
-		}
-			break;
+		textureTable.insert(std::pair<std::string, SimpleSRV*>(resource.Name, srv));
+		shaderResourceViews.push_back(srv);
+	}
 
-		case D3D_SIT_SAMPLER: // A sampler resource
-		{
-			// Create the sampler wrapper
-			SimpleSampler* samp = new SimpleSampler();
-			samp->BindIndex = resourceDesc.BindPoint;			// Shader bind point
-			samp->Index = (unsigned int)samplerStates.size();	// Raw index
+	for (const ReflectedResource& resource : reflection.Samplers)
+	{
+		// Create the sampler wrapper
+		SimpleSampler* samp = new SimpleSampler();
+		samp->BindIndex = resource.BindIndex;				// Shader bind point
+		samp->Index = (unsigned int)samplerStates.size();	// Raw index
 
-			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resourceDesc.Name, samp));
-			samplerStates.push_back(samp);
-		}
-			break;
-		}
+		samplerTable.insert(std::pair<std::string, SimpleSampler*>(resource.Name, samp));
+		samplerStates.push_back(samp);
 	}
 
 	// Loop through all constant buffers
 	for (unsigned int b = 0; b < constantBufferCount; b++)
 	{
-		// Get this buffer
-		ID3D11ShaderReflectionConstantBuffer* cb =
-			refl->GetConstantBufferByIndex(b);
-		
-		// Get the description of this buffer
-		D3D11_SHADER_BUFFER_DESC bufferDesc;
-		cb->GetDesc(&bufferDesc);
+		const ReflectedConstantBuffer& bufferDesc = reflection.ConstantBuffers[b];
 
 		// Save the type, which we reference when setting these buffers
-		constantBuffers[b].Type = bufferDesc.Type;
-		
-		// Get the description of the resource binding, so
-		// we know exactly how it's bound in the shader
-		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
-		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
+		constantBuffers[b].Type = (D3D_CBUFFER_TYPE)bufferDesc.Type;
 		
 		// Set up the buffer and put its pointer in the table
-		constantBuffers[b].BindIndex = bindDesc.BindPoint;
+		constantBuffers[b].BindIndex = bufferDesc.BindIndex;
 		constantBuffers[b].Name = bufferDesc.Name;
 		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
 
@@ -204,27 +225,16 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
 
 		// Loop through all variables in this buffer
-		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
+		for (const ReflectedVariable& varDesc : bufferDesc.Variables)
 		{
-			// Get this variable
-			ID3D11ShaderReflectionVariable* var =
-				cb->GetVariableByIndex(v);
-			
-			// Get the description of the variable and its type
-			D3D11_SHADER_VARIABLE_DESC varDesc;
-			var->GetDesc(&varDesc);
-
 			// Create the variable struct
 			SimpleShaderVariable varStruct = {};
 			varStruct.ConstantBufferIndex = b;
-			varStruct.ByteOffset = varDesc.StartOffset;
+			varStruct.ByteOffset = varDesc.ByteOffset;
 			varStruct.Size = varDesc.Size;
-			
-			// Get a string version
-			std::string varName(varDesc.Name);
 
 			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
+			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varDesc.Name, varStruct));
 			constantBuffers[b].Variables.push_back(varStruct);
 		}
 	}
@@ -697,6 +707,7 @@ SimpleVertexShader::SimpleVertexShader(Microsoft::WRL::ComPtr<ID3D11Device> devi
 	// Ensure we set to zero to successfully trigger
 	// the Input Layout creation during LoadShaderFile()
 	this->perInstanceCompatible = false;
+	this->customInputLayout = false;
 
 	// Load the actual compiled shader file
 	this->LoadShaderFile(shaderFile);
@@ -713,6 +724,7 @@ SimpleVertexShader::SimpleVertexShader(Microsoft::WRL::ComPtr<ID3D11Device> devi
 {
 	// Save the custom input layout
 	this->inputLayout = inputLayout;
+	this->customInputLayout = inputLayout != nullptr;
 
 	// Unable to determine from an input layout, require user to tell us
 	this->perInstanceCompatible = perInstanceCompatible;
@@ -755,7 +767,7 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Did the creation work?
 	if (result != S_OK)
@@ -763,36 +775,26 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 
 	// Do we already have an input layout?
 	// (This would come from one of the constructor overloads)
-	if (inputLayout)
+	if (customInputLayout)
 		return true;
 
+	// Otherwise build it from this bytecode's input signature - a
+	// reloaded shader's may not match the one the old layout came from
+	inputLayout.Reset();
+	perInstanceCompatible = false;
+
 	// Vertex shader was created successfully, so we now use the
-	// shader code to re-reflect and create an input layout that 
+	// reflected input signature to create an input layout that 
 	// matches what the vertex shader expects.  Code adapted from:
 	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
 
-	// Reflect shader info
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-	
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
 	// Read input layout description from shader info
 	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i< shaderDesc.InputParameters; i++)
+	for (const ReflectedInputParameter& paramDesc : reflection.InputParameters)
 	{
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetInputParameterDesc(i, &paramDesc);
-
 		// Check the semantic name for "_PER_INSTANCE"
 		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
+		const std::string& sem = paramDesc.SemanticName;
 		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
 		bool isPerInstance = 
 			lenDiff >= 0 &&
@@ -800,7 +802,7 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 
 		// Fill out input element desc
 		D3D11_INPUT_ELEMENT_DESC elementDesc = {};
-		elementDesc.SemanticName = paramDesc.SemanticName;
+		elementDesc.SemanticName = paramDesc.SemanticName.c_str();
 		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
 		elementDesc.InputSlot = 0;
 		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
@@ -869,8 +871,16 @@ void SimpleVertexShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader and input layout
-	deviceContext->IASetInputLayout(inputLayout.Get());
-	deviceContext->VSSetShader(shader.Get(), 0, 0);
+	if (StateCache)
+	{
+		StateCache->SetInputLayout(inputLayout.Get());
+		StateCache->SetVertexShader(shader.Get());
+	}
+	else
+	{
+		deviceContext->IASetInputLayout(inputLayout.Get());
+		deviceContext->VSSetShader(shader.Get(), 0, 0);
+	}
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -880,6 +890,15 @@ void SimpleVertexShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
+		if (StateCache)
+		{
+			StateCache->SetVertexConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
+			continue;
+		}
+
 		deviceContext->VSSetConstantBuffers(
 			constantBuffers[i].BindIndex,
 			1,
@@ -996,7 +1015,7 @@ bool SimplePixelShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Check the result
 	return (result == S_OK);
@@ -1012,7 +1031,10 @@ void SimplePixelShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 	
 	// Set the shader
-	deviceContext->PSSetShader(shader.Get(), 0, 0);
+	if (StateCache)
+		StateCache->SetPixelShader(shader.Get());
+	else
+		deviceContext->PSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1022,6 +1044,15 @@ void SimplePixelShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
+		if (StateCache)
+		{
+			StateCache->SetPixelConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
+			continue;
+		}
+
 		deviceContext->PSSetConstantBuffers(
 			constantBuffers[i].BindIndex,
 			1,
@@ -1053,7 +1084,10 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (StateCache)
+		StateCache->SetPixelShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	else
+		deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1083,7 +1117,10 @@ bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (StateCache)
+		StateCache->SetPixelSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	else
+		deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1140,7 +1177,7 @@ bool SimpleDomainShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Check the result
 	return (result == S_OK);
@@ -1283,7 +1320,7 @@ bool SimpleHullShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Check the result
 	return (result == S_OK);
@@ -1435,7 +1472,7 @@ bool SimpleGeometryShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderB
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Check the result
 	return (result == S_OK);
@@ -1507,7 +1544,7 @@ bool SimpleGeometryShader::CreateShaderWithStreamOut(Microsoft::WRL::ComPtr<ID3D
 		0,                              // No buffer strides
 		rast,                           // Index of the stream to rasterize (if any)
 		NULL,                           // Not using class linkage
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 	
 	return (result == S_OK);
 }
@@ -1724,50 +1761,21 @@ bool SimpleComputeShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBl
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Was the shader created correctly?
 	if (result != S_OK)
 		return false;
 
-	// Set up shader reflection to get information about UAV's
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-
-	// Get the description of the shader
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-	
 	// Grab the thread info
-	threadsTotal = refl->GetThreadGroupSize(
-		&threadsX,
-		&threadsY,
-		&threadsZ);
-
-	// Loop and get all UAV resources
-	unsigned int resourceCount = shaderDesc.BoundResources;
-	for (unsigned int r = 0; r < resourceCount; r++)
-	{
-		// Get this resource's description
-		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
-		refl->GetResourceBindingDesc(r, &resourceDesc);
-
-		// Check the type, looking for any kind of UAV
-		switch (resourceDesc.Type)
-		{
-		case D3D_SIT_UAV_APPEND_STRUCTURED:
-		case D3D_SIT_UAV_CONSUME_STRUCTURED:
-		case D3D_SIT_UAV_RWBYTEADDRESS:
-		case D3D_SIT_UAV_RWSTRUCTURED:
-		case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
-		case D3D_SIT_UAV_RWTYPED:
-			uavTable.insert(std::pair<std::string, unsigned int>(resourceDesc.Name, resourceDesc.BindPoint));
-		}
-	}
+	threadsX = reflection.ThreadGroupSize[0];
+	threadsY = reflection.ThreadGroupSize[1];
+	threadsZ = reflection.ThreadGroupSize[2];
+	threadsTotal = threadsX * threadsY * threadsZ;
+
+	// Grab all UAV resources
+	for (const ReflectedResource& uav : reflection.UnorderedAccessViews)
+		uavTable.insert(std::pair<std::string, unsigned int>(uav.Name, uav.BindIndex));
 
 	// All set
 	return true;
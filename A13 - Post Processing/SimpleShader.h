@@ -11,6 +11,8 @@
 #include <vector>
 #include <string>
 
+#include "ShaderReflectionCache.h"
+#include "RenderStateCache.h"
 
 // --------------------------------------------------------
 // Used by simple shaders to store information about
@@ -75,6 +77,9 @@ public:
 	void CopyBufferData(unsigned int index);
 	void CopyBufferData(std::string bufferName);
 
+	// Swaps in new bytecode (used for hot reloading)
+	bool Reload(Microsoft::WRL::ComPtr<ID3DBlob> newBlob);
+
 	// Sets arbitrary shader data
 	bool SetData(std::string name, const void* data, unsigned int size);
 
@@ -117,11 +122,16 @@ public:
 	
 	// Misc getters
 	Microsoft::WRL::ComPtr<ID3DBlob> GetShaderBlob() { return shaderBlob; }
+	const ShaderReflectionData& GetReflection() { return reflection; }
 
 	// Error reporting
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Optional - when set, pixel/vertex shader binds go through
+	// this cache instead of straight to the device context
+	static RenderStateCache* StateCache;
+
 protected:
 	
 	bool shaderValid;
@@ -141,8 +151,12 @@ protected:
 	std::unordered_map<std::string, SimpleSRV*> textureTable;
 	std::unordered_map<std::string, SimpleSampler*> samplerTable;
 
-	// Initialization method
+	// Reflection results for the loaded bytecode (possibly from the cache)
+	ShaderReflectionData reflection;
+
+	// Initialization methods
 	bool LoadShaderFile(LPCWSTR shaderFile);
+	bool InitializeFromBlob(LPCWSTR shaderName);
 
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
@@ -183,6 +197,7 @@ public:
 
 protected:
 	bool perInstanceCompatible;
+	bool customInputLayout;		// Given to the constructor, so kept across reloads
 	 Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
 	 Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
@@ -2,6 +2,7 @@
 #include "Mesh.h"
 #include "SimpleShader.h"
 #include "Camera.h"
+#include "TextureLoader.h"
 
 #include <d3d11.h>
 #include <wrl/client.h>
@@ -15,7 +16,7 @@ public:
 	~Sky();
 private:
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> skyTexture;
+	std::shared_ptr<AsyncTexture> skyTexture;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> stencilState;
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizer;
 
@@ -24,7 +25,7 @@ private:
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 
 	// Helper for creating a cubemap from 6 individual textures
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateCubemap(
+	std::shared_ptr<AsyncTexture> CreateCubemap(
 		const wchar_t* right,
 		const wchar_t* left,
 		const wchar_t* up,
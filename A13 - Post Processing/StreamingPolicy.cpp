@@ -0,0 +1,215 @@
+#include "StreamingPolicy.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+	// Nearest a surface is treated as being, so standing inside
+	// a bounding sphere doesn't divide by zero
+	const float MinimumDistance = 0.01f;
+
+	float PixelsPerWorldUnit(const StreamingCamera& camera, float distance)
+	{
+		if (camera.IsOrthographic)
+			return camera.ScreenHeight / camera.OrthographicHeight;
+		return camera.ScreenHeight / (2.0f * max(distance, MinimumDistance) * tanf(camera.VerticalFov * 0.5f));
+	}
+
+	// Distance from the camera to the near side of the sphere, or
+	// negative if the sphere is entirely behind or beyond the view
+	float VisibleDistance(const StreamingCamera& camera, const StreamingObject& object)
+	{
+		float dx = object.Center.x - camera.Position.x;
+		float dy = object.Center.y - camera.Position.y;
+		float dz = object.Center.z - camera.Position.z;
+		float along = dx * camera.Forward.x + dy * camera.Forward.y + dz * camera.Forward.z;
+		if (along < -object.Radius || along - object.Radius > camera.FarPlane)
+			return -1;
+
+		return max(sqrtf(dx * dx + dy * dy + dz * dz) - object.Radius, 0.0f);
+	}
+
+	size_t LevelBytes(const StreamingTexture& texture, int first, int last)
+	{
+		size_t bytes = 0;
+		for (int mip = first; mip <= last; mip++)
+			bytes += texture.MipBytes[mip];
+		return bytes;
+	}
+}
+
+float StreamingPolicy::DesiredMip(const StreamingCamera& camera, const StreamingObject& object, unsigned int textureWidth)
+{
+	float distance = VisibleDistance(camera, object);
+	if (distance < 0)
+		return -1;
+
+	float texelsPerWorldUnit = textureWidth / max(object.WorldUnitsPerUv, 1e-6f);
+	float texelsPerPixel = texelsPerWorldUnit / PixelsPerWorldUnit(camera, distance);
+	return max(log2f(texelsPerPixel), 0.0f);
+}
+
+int StreamingPolicy::TailMipFor(unsigned int width, int mipCount, unsigned int tailSize)
+{
+	int mip = 0;
+	while (mip < mipCount - 1 && (width >> mip) > tailSize)
+		mip++;
+	return mip;
+}
+
+StreamingPlan StreamingPolicy::Plan(const vector<StreamingTexture>& textures, const vector<StreamingObject>& objects, const StreamingCamera& camera, size_t budgetBytes)
+{
+	int count = (int)textures.size();
+
+	StreamingPlan plan;
+	plan.TargetMip.resize(count);
+	plan.DesiredMip.resize(count);
+
+	// Each texture wants whatever its most demanding visible object needs,
+	// and unseen textures want nothing beyond their tail.  Screen size
+	// breaks ties, so the bigger of two equally starved objects goes first
+	vector<float> screenSize(count, 0);
+	for (int t = 0; t < count; t++)
+		plan.DesiredMip[t] = (float)textures[t].TailMip;
+
+	for (auto& object : objects)
+	{
+		for (int t : object.Textures)
+		{
+			if (t < 0 || t >= count) continue;
+
+			float mip = DesiredMip(camera, object, textures[t].Width);
+			if (mip < 0) continue;
+
+			plan.DesiredMip[t] = min(plan.DesiredMip[t], mip);
+			screenSize[t] = max(screenSize[t], object.Radius * PixelsPerWorldUnit(camera, VisibleDistance(camera, object)));
+		}
+	}
+
+	// Tails first - these stay no matter what the budget says
+	vector<int> wanted(count);
+	for (int t = 0; t < count; t++)
+	{
+		const StreamingTexture& texture = textures[t];
+		int last = (int)texture.MipBytes.size() - 1;
+		plan.TargetMip[t] = texture.TailMip;
+		plan.TargetBytes += LevelBytes(texture, texture.TailMip, last);
+		wanted[t] = max(0, min((int)floorf(plan.DesiredMip[t]), texture.TailMip));
+	}
+
+	// Hand out one level at a time to the texture furthest from what it
+	// wants.  A texture whose next level doesn't fit drops out, leaving
+	// the remaining budget to cheaper (coarser) levels elsewhere
+	vector<char> blocked(count, 0);
+	while (true)
+	{
+		int best = -1;
+		float bestDeficit = 0;
+		for (int t = 0; t < count; t++)
+		{
+			if (blocked[t] || plan.TargetMip[t] <= wanted[t]) continue;
+
+			float deficit = plan.TargetMip[t] - plan.DesiredMip[t];
+			if (best < 0 || deficit > bestDeficit || (deficit == bestDeficit && screenSize[t] > screenSize[best]))
+			{
+				best = t;
+				bestDeficit = deficit;
+			}
+		}
+		if (best < 0) break;
+
+		size_t cost = textures[best].MipBytes[plan.TargetMip[best] - 1];
+		if (plan.TargetBytes + cost > budgetBytes)
+		{
+			blocked[best] = 1;
+			continue;
+		}
+
+		plan.TargetMip[best]--;
+		plan.TargetBytes += cost;
+
+		// Recorded the first time a texture goes past what it already has
+		if (plan.TargetMip[best] == textures[best].ResidentMip - 1)
+			plan.UploadOrder.push_back(best);
+	}
+
+	// Anything already resident beyond the plan stays while there's room,
+	// keeping the levels closest to being wanted again first
+	fill(blocked.begin(), blocked.end(), 0);
+	while (true)
+	{
+		int best = -1;
+		float bestExcess = 0;
+		for (int t = 0; t < count; t++)
+		{
+			if (blocked[t] || textures[t].ResidentMip >= plan.TargetMip[t]) continue;
+
+			float excess = plan.DesiredMip[t] - (plan.TargetMip[t] - 1);
+			if (best < 0 || excess < bestExcess)
+			{
+				best = t;
+				bestExcess = excess;
+			}
+		}
+		if (best < 0) break;
+
+		size_t cost = textures[best].MipBytes[plan.TargetMip[best] - 1];
+		if (plan.TargetBytes + cost > budgetBytes)
+		{
+			blocked[best] = 1;
+			continue;
+		}
+
+		plan.TargetMip[best]--;
+		plan.TargetBytes += cost;
+	}
+
+	return plan;
+}
+
+StreamingSimulationResult StreamingPolicy::Simulate(vector<StreamingTexture> textures, const vector<StreamingObject>& objects, const vector<StreamingCamera>& path, size_t budgetBytes)
+{
+	StreamingSimulationResult result;
+	double deficit = 0;
+	int samples = 0;
+
+	for (auto& camera : path)
+	{
+		StreamingPlan plan = Plan(textures, objects, camera, budgetBytes);
+
+		result.Frames++;
+		result.PeakBytes = max(result.PeakBytes, plan.TargetBytes);
+		if (plan.TargetBytes > budgetBytes)
+			result.FramesOverBudget++;
+
+		bool inverted = false;
+		for (size_t t = 0; t < textures.size(); t++)
+		{
+			if (plan.TargetMip[t] < textures[t].ResidentMip) result.Uploads++;
+			if (plan.TargetMip[t] > textures[t].ResidentMip) result.Evictions++;
+
+			deficit += max(0.0f, plan.TargetMip[t] - plan.DesiredMip[t]);
+			samples++;
+
+			// Identical chains should never be served in the opposite
+			// order to how badly they're needed
+			for (size_t u = 0; u < textures.size(); u++)
+			{
+				if (textures[u].MipBytes != textures[t].MipBytes) continue;
+				if (floorf(plan.DesiredMip[t]) < floorf(plan.DesiredMip[u]) && plan.TargetMip[t] > plan.TargetMip[u] + 1)
+					inverted = true;
+			}
+		}
+		if (inverted)
+			result.Inversions++;
+
+		for (size_t t = 0; t < textures.size(); t++)
+			textures[t].ResidentMip = plan.TargetMip[t];
+	}
+
+	result.AverageMipDeficit = samples > 0 ? (float)(deficit / samples) : 0;
+	return result;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+// What the streaming policy needs to know about the view
+struct StreamingCamera
+{
+	DirectX::XMFLOAT3 Position = {};
+	DirectX::XMFLOAT3 Forward = { 0, 0, 1 };
+	float VerticalFov = 0.8f;
+	float ScreenHeight = 720;
+	float FarPlane = 100;
+	bool IsOrthographic = false;
+	float OrthographicHeight = 1;	// World units covered by the screen's height
+};
+
+// Something drawn with streamed textures, as a bounding sphere
+struct StreamingObject
+{
+	DirectX::XMFLOAT3 Center = {};
+	float Radius = 1;
+	float WorldUnitsPerUv = 1;		// How much surface one whole 0-1 UV span covers
+	std::vector<int> Textures;		// Indices into the texture list handed to Plan()
+};
+
+// One streamable texture's mip chain and what's on the GPU right now
+struct StreamingTexture
+{
+	unsigned int Width = 0;
+	std::vector<size_t> MipBytes;	// Size of each level, finest first
+	int TailMip = 0;				// Coarsest levels from here down are always resident
+	int ResidentMip = 0;			// Finest level currently resident
+};
+
+struct StreamingPlan
+{
+	std::vector<int> TargetMip;		// Finest level each texture should have resident
+	std::vector<float> DesiredMip;	// What the view asks for, before the budget
+	std::vector<int> UploadOrder;	// Textures gaining levels, most needed first
+	size_t TargetBytes = 0;
+};
+
+// Summary of replaying a camera path through the policy
+struct StreamingSimulationResult
+{
+	int Frames = 0;
+	size_t PeakBytes = 0;
+	int FramesOverBudget = 0;		// Only possible if the mip tails alone don't fit
+	int Uploads = 0;				// Times a texture gained levels
+	int Evictions = 0;				// Times a texture lost levels
+	int Inversions = 0;				// Frames where a more needed texture ended up coarser than a less needed one of the same size
+	float AverageMipDeficit = 0;	// How far (in levels) textures sat above what the view wanted
+};
+
+// --------------------------------------------------------
+// Decides which mips of each streamed texture should be on
+// the GPU.  Pure CPU logic with no D3D, so it can be driven
+// with simulated cameras (see Simulate) as well as by the
+// TextureStreamer each frame.
+//
+//  - Mip tails are always resident, so nothing is ever
+//    drawn without a texture
+//  - Each texture wants the mip where one texel covers
+//    about one pixel on its nearest visible object
+//  - Levels are granted one at a time to whichever texture
+//    is furthest from what it wants, until the budget runs
+//    out
+//  - Levels already resident beyond that are only evicted
+//    when the budget needs the room
+// --------------------------------------------------------
+namespace StreamingPolicy
+{
+	// Fractional mip level that gives one texel per pixel, or
+	// a negative value if the object isn't in front of the camera
+	float DesiredMip(const StreamingCamera& camera, const StreamingObject& object, unsigned int textureWidth);
+
+	StreamingPlan Plan(const std::vector<StreamingTexture>& textures, const std::vector<StreamingObject>& objects, const StreamingCamera& camera, size_t budgetBytes);
+
+	// Plans every camera along the path in turn, treating each
+	// plan as instantly applied before the next frame
+	StreamingSimulationResult Simulate(std::vector<StreamingTexture> textures, const std::vector<StreamingObject>& objects, const std::vector<StreamingCamera>& path, size_t budgetBytes);
+
+	// First level no wider than tailSize (or the last level, if none are)
+	int TailMipFor(unsigned int width, int mipCount, unsigned int tailSize);
+}
@@ -0,0 +1,190 @@
+#include "HeadlessTests.h"
+#include "AutoExposure.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+	// Stand-ins for recorded sequences: the scene's luminance at a time, in seconds
+	struct LuminanceSequence
+	{
+		const char* Name;
+		float StartLuminance;	// What the eye is adapted to going in
+		float (*Luminance)(float time);
+	};
+
+	const LuminanceSequence Sequences[] = {
+		{ "Leaving a tunnel", 0.05f, [](float time) { return time < 1.0f ? 0.05f : 20.0f; } },
+		{ "Entering a tunnel", 20.0f, [](float time) { return time < 1.0f ? 20.0f : 0.05f; } },
+		{ "Lightning", 0.5f, [](float time) { return fabsf(time - 1.0f) < 0.5f / 60.0f ? 50.0f : 0.5f; } },
+		{ "Dusk", 4.0f, [](float time) { return 4.0f * exp2f(-time); } },
+	};
+
+	// Pixels around a luminance, spread over two stops each way but with
+	// that log-average, as a frame of the scene would be
+	vector<float> FrameAt(float luminance)
+	{
+		const int pixels = 64;
+		vector<float> frame(pixels * 4);
+		for (int i = 0; i < pixels; i++)
+		{
+			float value = luminance * exp2f(-2.0f + 4.0f * i / (pixels - 1));
+			frame[i * 4 + 0] = frame[i * 4 + 1] = frame[i * 4 + 2] = value;
+			frame[i * 4 + 3] = 1.0f;
+		}
+		return frame;
+	}
+
+	// Runs a sequence through the histogram and adaptation, one entry per frame
+	vector<float> Simulate(const LuminanceSequence& sequence, const vector<float>& frameTimes, const AutoExposureSettings& settings, vector<float>* targets = 0)
+	{
+		vector<float> adapted;
+		float luminance = sequence.StartLuminance;
+		float time = 0;
+		for (float deltaTime : frameTimes)
+		{
+			vector<float> frame = FrameAt(sequence.Luminance(time));
+			float target = AutoExposure::AverageLuminance(AutoExposure::BuildHistogram(frame.data(), frame.size() / 4, settings), settings);
+			luminance = AutoExposure::Adapt(luminance, target, deltaTime, settings);
+			adapted.push_back(luminance);
+			if (targets)
+				targets->push_back(target);
+			time += deltaTime;
+		}
+		return adapted;
+	}
+
+	float Stops(float a, float b)
+	{
+		return fabsf(log2f(a / b));
+	}
+}
+
+vector<string> AutoExposureTests()
+{
+	vector<string> failures;
+	AutoExposureSettings settings;
+	float binStops = settings.LogLuminanceRange / (AutoExposure::BinCount - 2);
+
+	// Bin edges
+	if (AutoExposure::Bin(0.0f, settings) != 0 || AutoExposure::Bin(exp2f(settings.MinLogLuminance) * 0.99f, settings) != 0)
+		failures.push_back("Luminance below the range wasn't put in bin 0");
+	if (AutoExposure::Bin(exp2f(settings.MinLogLuminance), settings) != 1)
+		failures.push_back("The bottom of the range wasn't put in bin 1");
+	if (AutoExposure::Bin(exp2f(settings.MinLogLuminance + settings.LogLuminanceRange) * 4.0f, settings) != AutoExposure::BinCount - 1)
+		failures.push_back("Luminance above the range wasn't put in the last bin");
+
+	// A frame's log-average comes back to within a bin, with black pixels not counting
+	for (float luminance : { 0.02f, 0.18f, 1.0f, 20.0f })
+	{
+		vector<float> frame = FrameAt(luminance);
+		float average = AutoExposure::AverageLuminance(AutoExposure::BuildHistogram(frame.data(), frame.size() / 4, settings), settings);
+		if (Stops(average, luminance) > binStops)
+			failures.push_back("Frame at " + to_string(luminance) + " averaged " + to_string(average));
+
+		frame.resize(frame.size() * 2, 0.0f);
+		float withBlack = AutoExposure::AverageLuminance(AutoExposure::BuildHistogram(frame.data(), frame.size() / 4, settings), settings);
+		if (withBlack != average)
+			failures.push_back("Black pixels moved the average at " + to_string(luminance));
+	}
+
+	// Nothing counted means nothing to adapt to
+	vector<float> black(64 * 4, 0.0f);
+	float blackAverage = AutoExposure::AverageLuminance(AutoExposure::BuildHistogram(black.data(), 64, settings), settings);
+	if (blackAverage != 0 || AutoExposure::Adapt(0.5f, blackAverage, 1.0f / 60.0f, settings) != 0.5f)
+		failures.push_back("A black frame moved the adaptation");
+	if (fabsf(AutoExposure::Exposure(settings.KeyValue, settings) - 1.0f) > 1e-6f)
+		failures.push_back("Adapted to the key value, exposure isn't 1");
+
+	vector<float> steady(300, 1.0f / 60.0f);
+	for (auto& sequence : Sequences)
+	{
+		vector<float> targets;
+		vector<float> adapted = Simulate(sequence, steady, settings, &targets);
+
+		// Never overshoots what it's adapting to
+		float lowest = sequence.StartLuminance;
+		float highest = sequence.StartLuminance;
+		for (size_t i = 0; i < adapted.size(); i++)
+		{
+			lowest = min(lowest, targets[i]);
+			highest = max(highest, targets[i]);
+			if (adapted[i] < lowest * 0.999f || adapted[i] > highest * 1.001f)
+			{
+				failures.push_back(string(sequence.Name) + " overshot on frame " + to_string(i));
+				break;
+			}
+		}
+	}
+
+	// A step is followed, but not snapped to, and adapting to the dark is slower
+	vector<float> tunnelOut = Simulate(Sequences[0], steady, settings);
+	vector<float> tunnelIn = Simulate(Sequences[1], steady, settings);
+	if (Stops(tunnelOut[65], 0.05f) > Stops(tunnelOut[65], 20.0f))
+		failures.push_back("Leaving a tunnel, more than half way there after 0.1 seconds");
+	if (Stops(tunnelOut[180], 20.0f) > binStops * 2)
+		failures.push_back("Leaving a tunnel, not adapted after 2 seconds");
+	if (Stops(tunnelIn[90], 0.05f) < Stops(tunnelOut[90], 20.0f))
+		failures.push_back("Adapting to the dark wasn't slower than to the light");
+	if (Stops(tunnelIn[299], 0.05f) > binStops * 2 + Stops(0.05f, 20.0f) * expf(-settings.AdaptToDark * 4.0f))
+		failures.push_back("Entering a tunnel, not adapted after 4 seconds");
+
+	// One bright frame barely moves it, and it settles back
+	vector<float> lightning = Simulate(Sequences[2], steady, settings);
+	float flash = 0;
+	for (float luminance : lightning)
+		flash = max(flash, Stops(luminance, 0.5f));
+	if (flash > 0.5f)
+		failures.push_back("One frame of lightning moved exposure " + to_string(flash) + " stops");
+	if (Stops(lightning.back(), 0.5f) > binStops * 2)
+		failures.push_back("Exposure didn't settle after the lightning");
+
+	// A steady fall in light is trailed by its speed over the adaptation rate
+	vector<float> dusk = Simulate(Sequences[3], steady, settings);
+	float lag = log2f(dusk.back() / (4.0f * exp2f(-5.0f)));
+	if (lag < 0 || lag > 1.0f / settings.AdaptToDark + binStops * 2)
+		failures.push_back("At dusk, trailed the light by " + to_string(lag) + " stops");
+
+	// Adapts the same at any frame rate (the step is at the start, so it lands on a frame at each)
+	LuminanceSequence daylight = { "Daylight", 0.05f, [](float) { return 20.0f; } };
+	vector<vector<float>> frameTimes = { vector<float>(15, 1.0f / 30.0f), vector<float>(72, 1.0f / 144.0f), {} };
+	for (int i = 0; i < 10; i++)
+	{
+		frameTimes[2].push_back(1.0f / 24.0f);
+		frameTimes[2].push_back(1.0f / 120.0f);
+	}
+	float afterHalfSecond[3];
+	for (int i = 0; i < 3; i++)
+		afterHalfSecond[i] = Simulate(daylight, frameTimes[i], settings).back();
+	for (int i = 1; i < 3; i++)
+	{
+		if (Stops(afterHalfSecond[i], afterHalfSecond[0]) > 0.01f)
+			failures.push_back("Adaptation depends on frame rate: " + to_string(afterHalfSecond[i]) + " vs " + to_string(afterHalfSecond[0]));
+	}
+
+	// Replaying frames recorded from the same math comes back exact, and a
+	// frame the GPU got wrong shows up in both errors
+	vector<AutoExposureFrame> recording;
+	float luminance = Sequences[0].StartLuminance;
+	for (int i = 0; i < 120; i++)
+	{
+		AutoExposureFrame frame;
+		frame.DeltaTime = 1.0f / 60.0f;
+		vector<float> pixels = FrameAt(Sequences[0].Luminance(i * frame.DeltaTime));
+		frame.Bins = AutoExposure::BuildHistogram(pixels.data(), pixels.size() / 4, settings);
+		frame.PreviousLuminance = luminance;
+		frame.AdaptedLuminance = luminance = AutoExposure::Adapt(luminance, AutoExposure::AverageLuminance(frame.Bins, settings), frame.DeltaTime, settings);
+		recording.push_back(frame);
+	}
+	AutoExposureReplay replay = AutoExposure::Replay(recording, settings);
+	if (replay.Frames != 120 || replay.MaxFrameError > 1e-6f || replay.MaxChainError > 1e-6f)
+		failures.push_back("A recording of the CPU's own adaptation didn't replay exactly");
+	recording[60].AdaptedLuminance *= 1.1f;
+	replay = AutoExposure::Replay(recording, settings);
+	if (replay.MaxFrameError < 0.05f || replay.MaxChainError < 0.05f)
+		failures.push_back("A frame 10% off didn't show up in the replay");
+	return failures;
+}
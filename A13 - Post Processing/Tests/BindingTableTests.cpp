@@ -0,0 +1,96 @@
+#include "HeadlessTests.h"
+#include "BindingTable.h"
+
+using namespace std;
+
+namespace
+{
+	// Like PixelShader.hlsl, with the scene's shadow map and sampler in the
+	// middle of the material's registers and a few gaps thrown in
+	ShaderReflectionData PixelReflection()
+	{
+		ShaderReflectionData data;
+		data.ShaderResourceViews = {
+			{ "SurfaceTexture", 0 },
+			{ "NormalMap", 1 },
+			{ "ShadowMap", 2 },		// Bound by the renderer, not the material
+			{ "RoughnessMap", 3 },
+			{ "MetalnessMap", 5 },	// Nothing declared at t4
+			{ "EmissiveMap", 6 },	// Declared, but the material never sets it
+		};
+		data.Samplers = {
+			{ "BasicSampler", 0 },
+			{ "ShadowSampler", 1 },
+			{ "ClampSampler", 2 },
+		};
+		return data;
+	}
+
+	string Describe(const vector<BindingRange>& ranges)
+	{
+		string text;
+		for (auto& range : ranges)
+		{
+			text += "[" + to_string(range.FirstSlot) + ":";
+			for (int source : range.Sources)
+				text += " " + to_string(source);
+			text += "]";
+		}
+		return text;
+	}
+
+	void Expect(vector<string>& failures, const string& what, const vector<BindingRange>& ranges, const string& expected)
+	{
+		string actual = Describe(ranges);
+		if (actual != expected)
+			failures.push_back(what + " came out as " + actual + " rather than " + expected);
+	}
+}
+
+vector<string> BindingTableTests()
+{
+	vector<string> failures;
+	ShaderReflectionData reflection = PixelReflection();
+
+	// Every name lands on its reflected register, the shadow map splits the
+	// texture ranges, t4 is filled with null, and missing names are reported
+	{
+		BindingTable table = BindingTables::Build(reflection,
+			{ "SurfaceTexture", "NormalMap", "RoughnessMap", "MetalnessMap", "DetailMap" },
+			{ "BasicSampler", "ClampSampler", "MissingSampler" });
+
+		Expect(failures, "Texture ranges", table.TextureRanges, "[0: 0 1][3: 2 -1 3]");
+		Expect(failures, "Sampler ranges", table.SamplerRanges, "[0: 0][2: 1]");
+		if (table.UnusedTextures != vector<string>{ "DetailMap" })
+			failures.push_back("DetailMap isn't in the shader, but wasn't the only unused texture");
+		if (table.UnusedSamplers != vector<string>{ "MissingSampler" })
+			failures.push_back("MissingSampler isn't in the shader, but wasn't the only unused sampler");
+		if (BindingTables::CallCount(table) != 4)
+			failures.push_back("Expected 4 bind calls, got " + to_string(BindingTables::CallCount(table)));
+	}
+
+	// The material's own order doesn't matter, only the registers do
+	{
+		BindingTable table = BindingTables::Build(reflection, { "MetalnessMap", "RoughnessMap", "NormalMap", "SurfaceTexture" }, { "ClampSampler", "BasicSampler" });
+		Expect(failures, "Reversed texture ranges", table.TextureRanges, "[0: 3 2][3: 1 -1 0]");
+		Expect(failures, "Reversed sampler ranges", table.SamplerRanges, "[0: 1][2: 0]");
+	}
+
+	// Nothing the shader declares means nothing to bind, and nothing is lost silently
+	{
+		BindingTable table = BindingTables::Build(ShaderReflectionData(), { "SurfaceTexture" }, { "BasicSampler" });
+		if (!table.TextureRanges.empty() || !table.SamplerRanges.empty())
+			failures.push_back("A shader without resources still got bind ranges");
+		if (table.UnusedTextures.size() != 1 || table.UnusedSamplers.size() != 1)
+			failures.push_back("A shader without resources didn't report the material's resources as unused");
+	}
+
+	// A material with nothing set never touches the renderer's registers
+	{
+		BindingTable table = BindingTables::Build(reflection, {}, {});
+		if (BindingTables::CallCount(table) != 0)
+			failures.push_back("An empty material still needs " + to_string(BindingTables::CallCount(table)) + " bind calls");
+	}
+
+	return failures;
+}
@@ -0,0 +1,181 @@
+#include "HeadlessTests.h"
+#include "BlockCompression.h"
+#include "DdsFile.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+using namespace std;
+
+namespace
+{
+	// The BC7 interpolation weights for 4-bit indices, from the format spec
+	const int SpecWeights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Packs fields least significant bit first, the way BC blocks are laid out
+	struct BitWriter
+	{
+		unsigned char* bytes;
+		int position = 0;
+
+		void Write(unsigned int value, int bits)
+		{
+			for (int i = 0; i < bits; i++, position++)
+				if (value & (1u << i))
+					bytes[position / 8] |= (unsigned char)(1 << (position % 8));
+		}
+	};
+
+	// A gradient along one line through RGBA, which one subset can follow,
+	// with a little noise so no format gets it exactly
+	void GradientBlock(unsigned char rgba[64])
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int t = (i * 7) % 16;
+			int noise = (i * 5) % 3 - 1;
+			rgba[i * 4 + 0] = (unsigned char)(40 + t * 12 + noise);
+			rgba[i * 4 + 1] = (unsigned char)(200 - t * 9);
+			rgba[i * 4 + 2] = (unsigned char)(90 + t * 4 - noise);
+			rgba[i * 4 + 3] = (unsigned char)(255 - t * 3);
+		}
+	}
+
+	int MaxError(const unsigned char a[64], const unsigned char b[64], int firstChannel, int channelCount)
+	{
+		int error = 0;
+		for (int i = 0; i < 16; i++)
+			for (int c = firstChannel; c < firstChannel + channelCount; c++)
+				error = max(error, abs(a[i * 4 + c] - b[i * 4 + c]));
+		return error;
+	}
+}
+
+vector<string> BlockCompressionTests()
+{
+	vector<string> failures;
+
+	// A BC4 block built by hand: 8 value mode (red0 > red1) with every index used
+	unsigned char bc4[8] = { 255, 0 };
+	BitWriter bc4Writer = { bc4 + 2 };
+	for (int i = 0; i < 16; i++)
+		bc4Writer.Write(i % 8, 3);
+	unsigned char decoded[64] = {};
+	BlockCompression::DecompressBC4Block(bc4, 0, decoded);
+	for (int i = 0; i < 16; i++)
+	{
+		int index = i % 8;
+		int expected = index == 0 ? 255 : index == 1 ? 0 : (int)lround((8 - index) * 255.0 / 7.0);
+		if (decoded[i * 4] != expected)
+		{
+			failures.push_back("BC4 index " + to_string(index) + " decoded to " + to_string(decoded[i * 4]) + ", not " + to_string(expected));
+			break;
+		}
+	}
+
+	// A BC7 mode 6 block built by hand: 7-bit endpoints, a p-bit each, 4-bit indices
+	const int endpoints[2][4] = { { 100, 12, 127, 64 }, { 20, 90, 0, 127 } };
+	const int pbits[2] = { 1, 0 };
+	unsigned char bc7[16] = {};
+	BitWriter bc7Writer = { bc7 };
+	bc7Writer.Write(1 << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		bc7Writer.Write(endpoints[0][c], 7);
+		bc7Writer.Write(endpoints[1][c], 7);
+	}
+	bc7Writer.Write(pbits[0], 1);
+	bc7Writer.Write(pbits[1], 1);
+	for (int i = 0; i < 16; i++)
+		bc7Writer.Write(i, i == 0 ? 3 : 4);
+	if (!BlockCompression::DecompressBC7Block(bc7, decoded))
+		failures.push_back("A hand built BC7 mode 6 block didn't decode");
+	else
+	{
+		for (int i = 0; i < 16 && failures.empty(); i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				int e0 = endpoints[0][c] << 1 | pbits[0];
+				int e1 = endpoints[1][c] << 1 | pbits[1];
+				int expected = ((64 - SpecWeights[i]) * e0 + SpecWeights[i] * e1 + 32) >> 6;
+				if (decoded[i * 4 + c] != expected)
+				{
+					failures.push_back("BC7 texel " + to_string(i) + " channel " + to_string(c) + " decoded to " + to_string(decoded[i * 4 + c]) + ", not " + to_string(expected));
+					break;
+				}
+			}
+		}
+	}
+	bc7[0] = 1 << 5;
+	if (BlockCompression::DecompressBC7Block(bc7, decoded))
+		failures.push_back("A BC7 mode 5 block was decoded as mode 6");
+
+	// Compress and decompress single blocks
+	unsigned char source[64], block[16], roundTrip[64];
+	GradientBlock(source);
+	BlockCompression::CompressBC7Block(source, block);
+	if ((block[0] & 0x7F) != 1 << 6 || !BlockCompression::DecompressBC7Block(block, roundTrip) || MaxError(source, roundTrip, 0, 4) > 3)
+		failures.push_back("A BC7 block didn't round trip through mode 6");
+	// Green spans 135 values, so BC4's 8 entry palette is within 10 of every texel
+	memcpy(roundTrip, source, sizeof(source));
+	BlockCompression::CompressBC4Block(source, 1, block);
+	BlockCompression::DecompressBC4Block(block, 1, roundTrip);
+	if (MaxError(source, roundTrip, 1, 1) > 10 || MaxError(source, roundTrip, 0, 1) != 0)
+		failures.push_back("A BC4 block didn't round trip through the green channel");
+
+	// Whole images: the sample material's maps, against a PSNR floor per format
+	// (a couple of dB under what the encoders manage today).  Throughput depends
+	// on the machine and build, so it's only reported.
+	DecodedImage albedo, roughness;
+	string error;
+	if (!PngDecoder::DecodeFile(AssetPath(L"Textures/cobblestone/albedo.png"), albedo, &error) ||
+		!PngDecoder::DecodeFile(AssetPath(L"Textures/cobblestone/roughness.png"), roughness, &error))
+	{
+		failures.push_back("Couldn't load the sample textures: " + error);
+		return failures;
+	}
+
+	struct Floor { BlockFormat Format; const DecodedImage* Image; double Psnr; const char* Name; };
+	const Floor floors[] =
+	{
+		{ BlockFormat::BC1, &albedo, 38, "BC1" },
+		{ BlockFormat::BC7, &albedo, 48, "BC7" },
+		{ BlockFormat::BC5, &albedo, 46, "BC5" },
+		{ BlockFormat::BC4, &roughness, 36, "BC4" },
+	};
+	for (const Floor& floor : floors)
+	{
+		CompressionResult result = BlockCompression::Measure(*floor.Image, floor.Format);
+		printf("  %s: %.1f dB PSNR, %.1f MP/s\n", floor.Name, result.Psnr, result.MegapixelsPerSecond);
+		if (result.Psnr < floor.Psnr)
+			failures.push_back(string(floor.Name) + " came out at " + to_string(result.Psnr) + " dB, under the " + to_string(floor.Psnr) + " dB floor");
+		if (!(result.MegapixelsPerSecond > 0))
+			failures.push_back(string(floor.Name) + " didn't report its throughput");
+	}
+
+	// And the DDS cache: a compressed chain comes back byte for byte
+	TextureData texture;
+	texture.Format = BlockCompression::GetDxgiFormat(BlockFormat::BC7);
+	DecodedImage corner;
+	corner.Width = corner.Height = 8;
+	for (unsigned int y = 0; y < 8; y++)
+		corner.Pixels.insert(corner.Pixels.end(), albedo.Pixels.begin() + (size_t)y * albedo.Width * 4, albedo.Pixels.begin() + ((size_t)y * albedo.Width + 8) * 4);
+	texture.Levels.push_back(BlockCompression::Compress(corner, BlockFormat::BC7));
+	corner.Width = corner.Height = 4;
+	corner.Pixels.resize(64);
+	texture.Levels.push_back(BlockCompression::Compress(corner, BlockFormat::BC7));
+
+	filesystem::path file = filesystem::temp_directory_path() / "BlockCompressionTest.dds";
+	TextureData loaded;
+	if (!DdsFile::Save(file.wstring(), texture) || !DdsFile::Load(file.wstring(), loaded))
+		failures.push_back("Couldn't save and load a DDS file");
+	else if (loaded.Format != texture.Format || loaded.Levels.size() != 2 ||
+		loaded.Levels[0].Bytes != texture.Levels[0].Bytes || loaded.Levels[1].Bytes != texture.Levels[1].Bytes ||
+		loaded.Levels[1].Width != 4 || loaded.Levels[0].RowPitch != texture.Levels[0].RowPitch)
+		failures.push_back("A BC7 chain didn't round trip through a DDS file");
+	filesystem::remove(file);
+	return failures;
+}
@@ -0,0 +1,346 @@
+#include "HeadlessTests.h"
+#include "CascadedShadows.h"
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	// The camera and lights the fit and culling are checked against
+	const XMFLOAT3 CameraPosition = XMFLOAT3(0, 5, -30);
+	const float CameraFov = XM_PIDIV4;
+	const float CameraAspect = 16.0f / 9.0f;
+
+	const XMFLOAT3 LightDirections[] = {
+		XMFLOAT3(0, -1, 0),					// Straight down (needs a different up vector)
+		XMFLOAT3(1, -1, 1),					// Diagonal, like the scene's main light
+		XMFLOAT3(-0.2f, -0.3f, -1.0f),		// Low, into the camera
+	};
+
+	XMFLOAT4X4 CameraView(XMFLOAT3 position, float yaw)
+	{
+		XMFLOAT4X4 view;
+		XMVECTOR forward = XMVector3Transform(XMVectorSet(0, 0, 1, 0), XMMatrixRotationRollPitchYaw(0, yaw, 0));
+		XMStoreFloat4x4(&view, XMMatrixLookToLH(XMLoadFloat3(&position), forward, XMVectorSet(0, 1, 0, 0)));
+		return view;
+	}
+
+	XMFLOAT4X4 PerspectiveProjection()
+	{
+		XMFLOAT4X4 projection;
+		XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(CameraFov, CameraAspect, 0.1f, 100.0f));
+		return projection;
+	}
+
+	// Same as Camera's orthographic projection
+	XMFLOAT4X4 OrthographicProjection()
+	{
+		XMFLOAT4X4 projection;
+		XMStoreFloat4x4(&projection, XMMatrixOrthographicLH(CameraAspect, 1, 0.1f, 100.0f));
+		return projection;
+	}
+
+	// A world point in a cascade's map: x and y in texels, z as depth
+	XMFLOAT3 ToTexels(const ShadowCascade& cascade, XMFLOAT3 point, unsigned int resolution)
+	{
+		XMFLOAT3 clip;
+		XMStoreFloat3(&clip, XMVector3TransformCoord(XMLoadFloat3(&point), XMLoadFloat4x4(&cascade.ViewProjection)));
+		return XMFLOAT3((clip.x * 0.5f + 0.5f) * resolution, (0.5f - clip.y * 0.5f) * resolution, clip.z);
+	}
+
+	float Fraction(float value)
+	{
+		return value - floorf(value);
+	}
+
+	// How far apart two texel fractions are, allowing for wrapping past a whole texel
+	float FractionDistance(float a, float b)
+	{
+		float distance = fabsf(Fraction(a) - Fraction(b));
+		return min(distance, 1.0f - distance);
+	}
+
+	// A small scene under the test camera, with the light straight down: a row of
+	// receivers on the ground, and casters placed to be kept or culled
+	enum SceneCaster { Overhead = 4, High, Aside, Below, BehindCamera };
+	const ShadowCaster Scene[] = {
+		{ XMFLOAT3(0, 0, -15), 1 },		// Receivers, 15 to 55 units from the camera
+		{ XMFLOAT3(0, 0, -5), 1 },
+		{ XMFLOAT3(0, 0, 10), 1 },
+		{ XMFLOAT3(0, 0, 25), 1 },
+		{ XMFLOAT3(0, 30, -15), 1 },	// Over the nearest receiver, out of view
+		{ XMFLOAT3(0, 200, 25), 1 },	// Far over the farthest, past CasterDistance
+		{ XMFLOAT3(200, 5, 10), 1 },	// Off to the side of everything
+		{ XMFLOAT3(0, -20, 10), 1 },	// Under a receiver, out of view
+		{ XMFLOAT3(0, 3, -40), 1 },		// Behind the camera
+	};
+
+	vector<ShadowCascade> CullScene(XMFLOAT3 cameraPosition, XMFLOAT3 lightDirection, const vector<ShadowCaster>& casters)
+	{
+		XMFLOAT4X4 view = CameraView(cameraPosition, 0);
+		XMFLOAT4X4 projection = PerspectiveProjection();
+		vector<ShadowCascade> cascades = CascadedShadows::Build(view, projection, lightDirection, CascadeSettings());
+		CascadedShadows::Cull(cascades, view, projection, casters);
+		return cascades;
+	}
+
+	bool Selected(const ShadowCascade& cascade, unsigned int caster)
+	{
+		return find(cascade.Casters.begin(), cascade.Casters.end(), caster) != cascade.Casters.end();
+	}
+
+	string Name(XMFLOAT3 direction)
+	{
+		return "(" + to_string(direction.x) + ", " + to_string(direction.y) + ", " + to_string(direction.z) + ")";
+	}
+}
+
+vector<string> CascadedShadowsTests()
+{
+	vector<string> failures;
+	CascadeSettings settings;
+
+	// Splits: lambda 0 is uniform, 1 is logarithmic, and they always run near to far
+	vector<float> uniform = CascadedShadows::SplitDistances(1, 101, 4, 0);
+	vector<float> logarithmic = CascadedShadows::SplitDistances(1, 10000, 4, 1);
+	for (int i = 0; i <= 4; i++)
+	{
+		if (fabsf(uniform[i] - (1 + 25.0f * i)) > 1e-4f)
+			failures.push_back("Uniform split " + to_string(i) + " was " + to_string(uniform[i]));
+		if (fabsf(logarithmic[i] - powf(10.0f, (float)i)) > powf(10.0f, (float)i) * 1e-4f)
+			failures.push_back("Logarithmic split " + to_string(i) + " was " + to_string(logarithmic[i]));
+	}
+	vector<float> practical = CascadedShadows::SplitDistances(0.1f, 60, 4, settings.Lambda);
+	for (int i = 0; i < 4; i++)
+	{
+		if (practical[i + 1] <= practical[i])
+			failures.push_back("Practical splits don't increase");
+	}
+	if (!(practical[1] > CascadedShadows::SplitDistances(0.1f, 60, 4, 1)[1] && practical[1] < CascadedShadows::SplitDistances(0.1f, 60, 4, 0)[1]))
+		failures.push_back("Practical split isn't between uniform and logarithmic");
+
+	// The depth range comes back out of both kinds of projection
+	XMFLOAT4X4 perspective = PerspectiveProjection();
+	XMFLOAT4X4 orthographic = OrthographicProjection();
+	for (const XMFLOAT4X4* projection : { &perspective, &orthographic })
+	{
+		float nearPlane, farPlane;
+		CascadedShadows::DepthRange(*projection, nearPlane, farPlane);
+		if (fabsf(nearPlane - 0.1f) > 1e-4f || fabsf(farPlane - 100.0f) > 1e-2f)
+			failures.push_back("Depth range came back " + to_string(nearPlane) + " to " + to_string(farPlane));
+	}
+
+	XMFLOAT4X4 view = CameraView(CameraPosition, 0);
+	for (XMFLOAT3 lightDirection : LightDirections)
+	{
+		XMVECTOR toLight = -XMVector3Normalize(XMLoadFloat3(&lightDirection));
+		for (const XMFLOAT4X4* projection : { &perspective, &orthographic })
+		{
+			string setup = (projection == &perspective ? "Perspective" : "Orthographic") + string(" camera, light ") + Name(lightDirection);
+			vector<ShadowCascade> cascades = CascadedShadows::Build(view, *projection, lightDirection, settings);
+			if (cascades.size() != settings.Count)
+			{
+				failures.push_back(setup + ": built " + to_string(cascades.size()) + " cascades");
+				continue;
+			}
+
+			// Slices run on from each other, out to the shadow distance
+			if (fabsf(cascades[0].Near - 0.1f) > 1e-4f || fabsf(cascades.back().Far - settings.ShadowDistance) > 1e-3f)
+				failures.push_back(setup + ": cascades cover " + to_string(cascades[0].Near) + " to " + to_string(cascades.back().Far));
+			for (size_t i = 1; i < cascades.size(); i++)
+			{
+				if (cascades[i].Near != cascades[i - 1].Far)
+					failures.push_back(setup + ": cascade " + to_string(i) + " doesn't start where the last ended");
+				if (cascades[i].TexelSize <= cascades[i - 1].TexelSize)
+					failures.push_back(setup + ": cascade " + to_string(i) + " isn't coarser than the last");
+			}
+
+			for (size_t i = 0; i < cascades.size(); i++)
+			{
+				XMFLOAT3 corners[8];
+				CascadedShadows::SliceCorners(view, *projection, cascades[i].Near, cascades[i].Far, corners);
+				for (int c = 0; c < 8; c++)
+				{
+					// Every corner of the slice lands inside the cascade's map (written
+					// so a NaN from a degenerate light view fails too)...
+					XMFLOAT3 receiver = ToTexels(cascades[i], corners[c], settings.Resolution);
+					if (!(receiver.x >= 0 && receiver.x <= settings.Resolution && receiver.y >= 0 && receiver.y <= settings.Resolution && receiver.z > 0 && receiver.z < 1))
+					{
+						failures.push_back(setup + ": corner " + to_string(c) + " is outside cascade " + to_string(i));
+						break;
+					}
+
+					// ...and something between it and the light is nearer, still in the map
+					XMFLOAT3 casterPosition;
+					XMStoreFloat3(&casterPosition, XMLoadFloat3(&corners[c]) + toLight * 20.0f);
+					XMFLOAT3 caster = ToTexels(cascades[i], casterPosition, settings.Resolution);
+					if (!(caster.z >= 0 && caster.z < receiver.z))
+					{
+						failures.push_back(setup + ": a caster above corner " + to_string(c) + " doesn't shadow it in cascade " + to_string(i));
+						break;
+					}
+				}
+			}
+		}
+
+		// Moving the camera by less than a texel slides the map by whole texels
+		vector<ShadowCascade> start = CascadedShadows::Build(view, perspective, lightDirection, settings);
+		XMFLOAT3 probe = start[0].Center;
+		XMFLOAT3 probeTexel = ToTexels(start[0], probe, settings.Resolution);
+		for (int step = 1; step <= 8; step++)
+		{
+			XMFLOAT3 moved = CameraPosition;
+			moved.x += start[0].TexelSize * 0.37f * step;
+			moved.z += start[0].TexelSize * 0.21f * step;
+			vector<ShadowCascade> cascades = CascadedShadows::Build(CameraView(moved, 0), perspective, lightDirection, settings);
+
+			XMFLOAT3 texel = ToTexels(cascades[0], probe, settings.Resolution);
+			if (cascades[0].TexelSize != start[0].TexelSize ||
+				FractionDistance(texel.x, probeTexel.x) > 0.02f || FractionDistance(texel.y, probeTexel.y) > 0.02f)
+			{
+				failures.push_back("Light " + Name(lightDirection) + ": the map shimmers as the camera moves");
+				break;
+			}
+		}
+
+		// Turning the camera never changes the texel size
+		for (float yaw : { 0.3f, 1.2f, 2.5f, -0.8f })
+		{
+			vector<ShadowCascade> cascades = CascadedShadows::Build(CameraView(CameraPosition, yaw), perspective, lightDirection, settings);
+			for (size_t i = 0; i < cascades.size(); i++)
+			{
+				if (cascades[i].TexelSize != start[i].TexelSize)
+				{
+					failures.push_back("Light " + Name(lightDirection) + ": cascade " + to_string(i) + " changed size as the camera turned");
+					break;
+				}
+			}
+		}
+	}
+
+	// Caster selection: only what lies between the light and something visible
+	vector<ShadowCaster> scene(begin(Scene), end(Scene));
+	XMFLOAT3 down = LightDirections[0];
+	vector<ShadowCascade> culled = CullScene(CameraPosition, down, scene);
+	for (int i = 0; i < 2; i++)
+	{
+		if (culled[i].Receivers != 0 || !culled[i].Casters.empty())
+			failures.push_back("Cascade " + to_string(i) + " sees no ground, but kept " + to_string(culled[i].Casters.size()) + " casters");
+	}
+	if (!Selected(culled[2], 0) || !Selected(culled[2], Overhead))
+		failures.push_back("A caster out of view, over a visible receiver, was culled");
+	if (!Selected(culled[3], 2) || !Selected(culled[3], 3) || !Selected(culled[3], High))
+		failures.push_back("A caster far above a visible receiver was culled");
+	for (auto& cascade : culled)
+	{
+		for (unsigned int culledCaster : { (unsigned int)Aside, (unsigned int)Below, (unsigned int)BehindCamera })
+		{
+			if (Selected(cascade, culledCaster))
+				failures.push_back("Caster " + to_string(culledCaster) + " can't shadow anything visible, but was kept");
+		}
+
+		// Every kept caster fits the depth range, top to bottom
+		XMVECTOR toLight = -XMVector3Normalize(XMLoadFloat3(&down));
+		for (unsigned int caster : cascade.Casters)
+		{
+			XMVECTOR center = XMLoadFloat3(&scene[caster].Center);
+			for (float side : { -1.0f, 1.0f })
+			{
+				XMFLOAT3 point;
+				XMStoreFloat3(&point, center + toLight * (side * scene[caster].Radius));
+				float depth = ToTexels(cascade, point, settings.Resolution).z;
+				if (!(depth >= -1e-4f && depth <= 1.0001f))
+					failures.push_back("Caster " + to_string(caster) + " is outside its cascade's depth range");
+			}
+		}
+	}
+
+	// Anything over a visible receiver (a random scene, checked pair by pair) is kept
+	unsigned int seed = 12345;
+	auto random = [&](float low, float high) { seed = seed * 1664525u + 1013904223u; return low + (high - low) * (seed >> 8) / 16777216.0f; };
+	vector<ShadowCaster> randomScene(300);
+	for (auto& caster : randomScene)
+		caster = { XMFLOAT3(random(-40, 40), random(-5, 40), random(-40, 80)), random(0.2f, 3.0f) };
+	for (XMFLOAT3 lightDirection : LightDirections)
+	{
+		XMFLOAT4X4 view = CameraView(CameraPosition, 0);
+		XMFLOAT4X4 projection = PerspectiveProjection();
+		vector<ShadowCascade> cascades = CullScene(CameraPosition, lightDirection, randomScene);
+		Frustum frustum = Frustum::FromViewProjection(view, projection);
+		XMMATRIX lightView = XMLoadFloat4x4(&cascades[0].View);
+		unsigned int missed = 0;
+		for (auto& cascade : cascades)
+		{
+			for (size_t r = 0; r < randomScene.size(); r++)
+			{
+				// A receiver in this slice, near the middle of the map (so it can't straddle the edge)
+				XMFLOAT3 receiver, viewReceiver;
+				XMStoreFloat3(&receiver, XMVector3TransformCoord(XMLoadFloat3(&randomScene[r].Center), lightView));
+				XMStoreFloat3(&viewReceiver, XMVector3TransformCoord(XMLoadFloat3(&randomScene[r].Center), XMLoadFloat4x4(&view)));
+				if (!frustum.IntersectsSphere(randomScene[r].Center, randomScene[r].Radius) || viewReceiver.z < cascade.Near || viewReceiver.z > cascade.Far)
+					continue;
+
+				for (size_t c = 0; c < randomScene.size(); c++)
+				{
+					XMFLOAT3 caster;
+					XMStoreFloat3(&caster, XMVector3TransformCoord(XMLoadFloat3(&randomScene[c].Center), lightView));
+					float reach = randomScene[r].Radius + randomScene[c].Radius;
+					if (fabsf(caster.x - receiver.x) < reach && fabsf(caster.y - receiver.y) < reach && caster.z < receiver.z && !Selected(cascade, (unsigned int)c))
+						missed++;
+				}
+			}
+		}
+		if (missed > 0)
+			failures.push_back("Light " + Name(lightDirection) + ": " + to_string(missed) + " casters over visible receivers were culled");
+	}
+
+	// The map is only redrawn when its projection or its casters change
+	vector<bool> still(scene.size(), false);
+	vector<ShadowCascade> again = CullScene(CameraPosition, down, scene);
+	XMFLOAT3 nudged = CameraPosition;
+	nudged.z += 0.001f;
+	vector<ShadowCascade> nudgedCascades = CullScene(nudged, down, scene);
+	vector<bool> asideMoved = still;
+	asideMoved[Aside] = true;
+	vector<bool> overheadMoved = still;
+	overheadMoved[Overhead] = true;
+	for (size_t i = 0; i < culled.size(); i++)
+	{
+		if (CascadedShadows::NeedsRedraw(culled[i], again[i], still))
+			failures.push_back("Cascade " + to_string(i) + " redrawn with nothing changed");
+		if (CascadedShadows::NeedsRedraw(culled[i], nudgedCascades[i], still))
+			failures.push_back("Cascade " + to_string(i) + " redrawn after the camera moved less than a texel");
+		if (CascadedShadows::NeedsRedraw(culled[i], again[i], asideMoved))
+			failures.push_back("Cascade " + to_string(i) + " redrawn for a culled caster moving");
+		if (CascadedShadows::NeedsRedraw(culled[i], again[i], overheadMoved) != (i == 2))
+			failures.push_back("Cascade " + to_string(i) + (i == 2 ? " not redrawn when its caster moved" : " redrawn for another cascade's caster"));
+	}
+
+	vector<ShadowCaster> shifted = scene;
+	shifted[Overhead].Center.x += 50;
+	vector<ShadowCascade> shiftedCascades = CullScene(CameraPosition, down, shifted);
+	if (!CascadedShadows::NeedsRedraw(culled[2], shiftedCascades[2], overheadMoved) || Selected(shiftedCascades[2], Overhead))
+		failures.push_back("A caster moving out of a cascade didn't redraw it");
+	ShadowCascade stale = culled[2];
+	stale.Casters.push_back(Aside);
+	if (!CascadedShadows::NeedsRedraw(stale, again[2], still))
+		failures.push_back("A cascade drawn with different casters wasn't redrawn");
+	vector<ShadowCascade> turned = CullScene(CameraPosition, XMFLOAT3(0.05f, -1, 0), scene);
+	if (!CascadedShadows::NeedsRedraw(culled[2], turned[2], still) || !CascadedShadows::NeedsRedraw(culled[3], turned[3], still))
+		failures.push_back("Turning the light didn't redraw the cascades");
+
+	// Packing fills every slot, so the shader's selection never reads past the count
+	CascadeSettings two = settings;
+	two.Count = 2;
+	vector<ShadowCascade> cascades = CascadedShadows::Build(view, perspective, LightDirections[1], two);
+	ShadowCascadeData data = CascadedShadows::Pack(cascades);
+	if (data.Count != 2 || data.Ends.x != cascades[0].Far || data.Ends.y != cascades[1].Far || data.Ends.w != cascades[1].Far)
+		failures.push_back("Packed cascade ends are wrong");
+	if (sizeof(ShadowCascadeData) != 16 * 4 * 4 + 16 + 4)
+		failures.push_back("ShadowCascadeData doesn't match the shader's layout");
+	return failures;
+}
@@ -0,0 +1,117 @@
+#include "HeadlessTests.h"
+#include "CommandListSubmitter.h"
+
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+	// Writes down what happens to each context.  A context is only ever used
+	// by one thread at a time, so its log needs no lock of its own.
+	class RecordingBackend : public ICommandListBackend
+	{
+	public:
+		struct Context
+		{
+			vector<int> Events;		// -1 for BeginList, -2 for EndList, otherwise a draw
+			thread::id RecordedOn;
+			bool SameThread = true;
+		};
+
+		vector<Context> Contexts;
+		vector<unsigned int> Executed;
+		thread::id SubmittingThread = this_thread::get_id();
+		bool ExecutedOffThread = false;
+
+		RecordingBackend(unsigned int contextCount) : Contexts(contextCount) {}
+
+		unsigned int GetContextCount() override { return (unsigned int)Contexts.size(); }
+		void BeginList(unsigned int context) override
+		{
+			Contexts[context].RecordedOn = this_thread::get_id();
+			Contexts[context].Events.push_back(-1);
+		}
+		void EndList(unsigned int context) override { Log(context, -2); }
+		void ExecuteList(unsigned int context) override
+		{
+			Executed.push_back(context);
+			ExecutedOffThread = ExecutedOffThread || this_thread::get_id() != SubmittingThread;
+		}
+
+		void Log(unsigned int context, int event)
+		{
+			Contexts[context].SameThread = Contexts[context].SameThread && Contexts[context].RecordedOn == this_thread::get_id();
+			Contexts[context].Events.push_back(event);
+		}
+	};
+
+	string Describe(const vector<SubmissionChunk>& chunks)
+	{
+		string description;
+		for (const SubmissionChunk& chunk : chunks)
+			description += (description.empty() ? "" : ", ") + to_string(chunk.First) + "+" + to_string(chunk.Count);
+		return "[" + description + "]";
+	}
+}
+
+vector<string> CommandListSubmitterTests()
+{
+	vector<string> failures;
+	auto expectPartition = [&](unsigned int draws, unsigned int maxLists, unsigned int minDraws, const string& expected) {
+		string actual = Describe(ParallelSubmitter::Partition(draws, maxLists, minDraws));
+		if (actual != expected)
+			failures.push_back(to_string(draws) + " draws over " + to_string(maxLists) + " lists of " + to_string(minDraws) + "+: got " + actual + ", expected " + expected);
+	};
+
+	// Partitioning: contiguous, within one draw of each other, remainder first
+	expectPartition(10, 4, 1, "[0+3, 3+3, 6+2, 8+2]");
+	expectPartition(12, 4, 1, "[0+3, 3+3, 6+3, 9+3]");
+	expectPartition(10, 4, 4, "[0+5, 5+5]");
+	expectPartition(3, 4, 8, "[0+3]");
+	expectPartition(2, 8, 1, "[0+1, 1+1]");
+	expectPartition(0, 4, 1, "[]");
+	expectPartition(5, 0, 1, "[]");
+	expectPartition(7, 3, 0, "[0+3, 3+2, 5+2]");
+
+	// Submitting: every draw recorded once, in order, on its chunk's context
+	// and thread, then every list executed in chunk order on this thread
+	for (unsigned int threads : { 0u, 1u, 3u })
+	{
+		ParallelSubmitter submitter(threads);
+		for (int repeat = 0; repeat < 3; repeat++)
+		{
+			const unsigned int drawCount = 1003;
+			RecordingBackend backend(4);
+			SubmissionStats stats = submitter.Submit(backend, drawCount, [&](unsigned int context, unsigned int draw) { backend.Log(context, (int)draw); }, 16);
+
+			string run = to_string(threads) + " threads, run " + to_string(repeat) + ": ";
+			vector<SubmissionChunk> chunks = ParallelSubmitter::Partition(drawCount, 4, 16);
+			if (stats.Draws != drawCount || stats.Lists != chunks.size() || stats.Threads < 1 || stats.Threads > threads + 1)
+				failures.push_back(run + "stats report " + to_string(stats.Draws) + " draws, " + to_string(stats.Lists) + " lists, " + to_string(stats.Threads) + " threads");
+
+			for (unsigned int i = 0; i < chunks.size(); i++)
+			{
+				vector<int> expected = { -1 };
+				for (unsigned int d = 0; d < chunks[i].Count; d++)
+					expected.push_back((int)(chunks[i].First + d));
+				expected.push_back(-2);
+				if (backend.Contexts[i].Events != expected)
+					failures.push_back(run + "context " + to_string(i) + " didn't record chunk " + to_string(i) + " in order");
+				if (!backend.Contexts[i].SameThread)
+					failures.push_back(run + "context " + to_string(i) + " was recorded on more than one thread");
+			}
+			if (backend.Executed != vector<unsigned int>{ 0, 1, 2, 3 } || backend.ExecutedOffThread)
+				failures.push_back(run + "lists weren't executed in chunk order on the submitting thread");
+		}
+	}
+
+	// Nothing to draw records and executes nothing
+	ParallelSubmitter submitter(2);
+	RecordingBackend backend(4);
+	SubmissionStats stats = submitter.Submit(backend, 0, [](unsigned int, unsigned int) {});
+	if (stats.Lists != 0 || !backend.Executed.empty() || !backend.Contexts[0].Events.empty())
+		failures.push_back("An empty submission recorded something");
+	return failures;
+}
@@ -0,0 +1,83 @@
+#include "HeadlessTests.h"
+#include "DualFilterBlur.h"
+#include "GaussianBlur.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+vector<string> DualFilterBlurTests()
+{
+	vector<string> failures;
+
+	// The chain's sizes round down but never reach zero
+	if (DualFilterBlur::LevelSize(1280, 0) != 1280 || DualFilterBlur::LevelSize(1280, 3) != 160 ||
+		DualFilterBlur::LevelSize(101, 1) != 50 || DualFilterBlur::LevelSize(3, 3) != 1)
+		failures.push_back("LevelSize doesn't halve down the chain");
+
+	// Wider radii never use fewer levels, and never more than the chain has
+	unsigned int previousLevels = 0;
+	for (float radius = 1; radius <= 64; radius *= 2)
+	{
+		DualFilterSettings settings = DualFilterBlur::SettingsForRadius(radius);
+		if (settings.Levels < previousLevels || settings.Levels < 1 || settings.Levels > DualFilterBlur::MaxLevels || !(settings.Offset > 0))
+			failures.push_back("Radius " + to_string(radius) + " got " + to_string(settings.Levels) + " levels at offset " + to_string(settings.Offset));
+		previousLevels = settings.Levels;
+	}
+
+	// Both kernels are normalized, so a flat image stays flat at every level
+	const unsigned int width = 37, height = 23;
+	vector<float> flat((size_t)width * height * 4, 0.25f), blurred(flat.size());
+	for (unsigned int levels = 1; levels <= DualFilterBlur::MaxLevels; levels++)
+	{
+		DualFilterSettings settings;
+		settings.Levels = levels;
+		settings.Offset = 1.5f;
+		DualFilterBlur::Blur(flat.data(), width, height, blurred.data(), settings);
+		if (DualFilterBlur::Compare(flat.data(), blurred.data(), flat.size()).MaxDifference > 1e-5f)
+			failures.push_back("A flat image changed through " + to_string(levels) + " levels");
+	}
+
+	// The image diff: the dual filter against the Gaussian it stands in for, on the
+	// sample albedo.  It only approximates the Gaussian, so the floor is a PSNR
+	// (a few dB under the 50-60 it manages today).
+	DecodedImage image;
+	string error;
+	if (!PngDecoder::DecodeFile(AssetPath(L"Textures/cobblestone/albedo.png"), image, &error))
+	{
+		failures.push_back("Couldn't load the sample albedo: " + error);
+		return failures;
+	}
+
+	size_t count = (size_t)image.Width * image.Height * 4;
+	vector<float> source(count), temporary(count), gaussian(count), dual(count);
+	for (size_t i = 0; i < count; i++)
+		source[i] = image.Pixels[i] / 255.0f;
+
+	auto milliseconds = [](chrono::steady_clock::time_point start) {
+		return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	};
+
+	for (float radius : { 4.0f, 16.0f })
+	{
+		vector<GaussianTap> taps = GaussianBlur::LinearTaps(radius);
+		auto start = chrono::steady_clock::now();
+		GaussianBlur::BlurPassLinear(source.data(), image.Width, image.Height, temporary.data(), taps, false);
+		GaussianBlur::BlurPassLinear(temporary.data(), image.Width, image.Height, gaussian.data(), taps, true);
+		double gaussianMilliseconds = milliseconds(start);
+
+		DualFilterSettings settings = DualFilterBlur::SettingsForRadius(radius);
+		start = chrono::steady_clock::now();
+		DualFilterBlur::Blur(source.data(), image.Width, image.Height, dual.data(), settings);
+		double dualMilliseconds = milliseconds(start);
+
+		ImageDifference difference = DualFilterBlur::Compare(gaussian.data(), dual.data(), count);
+		printf("  Radius %.0f: %u levels, %.1f dB PSNR, max difference %.3f, dual filter %.1f ms, Gaussian %.1f ms\n",
+			radius, settings.Levels, difference.PeakSignalToNoise, difference.MaxDifference, dualMilliseconds, gaussianMilliseconds);
+		if (difference.PeakSignalToNoise < 45)
+			failures.push_back("At radius " + to_string(radius) + " the dual filter is " + to_string(difference.PeakSignalToNoise) + " dB from the Gaussian");
+	}
+	return failures;
+}
@@ -0,0 +1,133 @@
+#include "HeadlessTests.h"
+#include "GaussianBlur.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+namespace
+{
+	// Smooth gradients with noise and a hard edge, so both wide and narrow
+	// kernels have something to do, and an alpha channel that isn't constant
+	vector<float> TestImage(unsigned int width, unsigned int height)
+	{
+		mt19937 random(41);
+		uniform_real_distribution<float> noise(0, 0.25f);
+		vector<float> image((size_t)width * height * 4);
+		for (unsigned int y = 0; y < height; y++)
+		{
+			for (unsigned int x = 0; x < width; x++)
+			{
+				float* texel = &image[((size_t)y * width + x) * 4];
+				texel[0] = (float)x / width + noise(random);
+				texel[1] = (float)y / height;
+				texel[2] = x < width / 2 ? 1.0f : 0.0f;
+				texel[3] = noise(random) * 4;
+			}
+		}
+		return image;
+	}
+
+	// The full 2D kernel, one weighted read per texel in the square - what the
+	// separable passes are meant to be equivalent to
+	void Reference(const float* src, unsigned int width, unsigned int height, float* dst, const vector<float>& weights)
+	{
+		int extent = (int)weights.size() - 1;
+		for (int y = 0; y < (int)height; y++)
+		{
+			for (int x = 0; x < (int)width; x++)
+			{
+				double total[4] = {};
+				for (int dy = -extent; dy <= extent; dy++)
+				{
+					for (int dx = -extent; dx <= extent; dx++)
+					{
+						int sx = min(max(x + dx, 0), (int)width - 1);
+						int sy = min(max(y + dy, 0), (int)height - 1);
+						const float* texel = src + ((size_t)sy * width + sx) * 4;
+						double weight = (double)weights[abs(dx)] * weights[abs(dy)];
+						for (int c = 0; c < 4; c++)
+							total[c] += texel[c] * weight;
+					}
+				}
+
+				float* out = dst + ((size_t)y * width + x) * 4;
+				for (int c = 0; c < 4; c++)
+					out[c] = (float)total[c];
+			}
+		}
+	}
+
+	float MaxDifference(const vector<float>& a, const vector<float>& b)
+	{
+		float difference = 0;
+		for (size_t i = 0; i < a.size(); i++)
+			difference = max(difference, fabsf(a[i] - b[i]));
+		return difference;
+	}
+}
+
+vector<string> GaussianBlurTests()
+{
+	vector<string> failures;
+
+	// Weights (mirrored) and merged taps each add up to 1, within the shader's tap limit
+	for (float radius : { 0.0f, 0.5f, 1.0f, 2.5f, 4.0f, 10.0f, 64.0f })
+	{
+		vector<float> weights = GaussianBlur::Weights(radius);
+		double total = weights[0];
+		for (size_t i = 1; i < weights.size(); i++)
+			total += 2.0 * weights[i];
+		if (fabs(total - 1) > 1e-5)
+			failures.push_back("At radius " + to_string(radius) + " the weights add up to " + to_string(total));
+
+		vector<GaussianTap> taps = GaussianBlur::LinearTaps(radius);
+		double tapTotal = taps[0].Weight;
+		for (size_t i = 1; i < taps.size(); i++)
+			tapTotal += 2.0 * taps[i].Weight;
+		if (fabs(tapTotal - 1) > 1e-5 || taps.size() > GaussianBlur::MaxTaps || taps[0].Offset != 0)
+			failures.push_back("At radius " + to_string(radius) + " the merged taps add up to " + to_string(tapTotal) + " over " + to_string(taps.size()) + " taps");
+	}
+
+	// Horizontal then vertical matches the 2D kernel, and merged bilinear taps match both
+	const unsigned int width = 61, height = 37;
+	vector<float> image = TestImage(width, height);
+	size_t count = image.size();
+	for (float radius : { 1.0f, 3.0f, 7.5f })
+	{
+		vector<float> weights = GaussianBlur::Weights(radius);
+		vector<float> reference(count), temporary(count), separable(count), linear(count);
+		Reference(image.data(), width, height, reference.data(), weights);
+
+		GaussianBlur::BlurPass(image.data(), width, height, temporary.data(), weights, false);
+		GaussianBlur::BlurPass(temporary.data(), width, height, separable.data(), weights, true);
+		float separableDifference = MaxDifference(separable, reference);
+		if (separableDifference > 1e-5f)
+			failures.push_back("At radius " + to_string(radius) + " the separable blur is " + to_string(separableDifference) + " from the 2D kernel");
+
+		vector<GaussianTap> taps = GaussianBlur::LinearTaps(radius);
+		GaussianBlur::BlurPassLinear(image.data(), width, height, temporary.data(), taps, false);
+		GaussianBlur::BlurPassLinear(temporary.data(), width, height, linear.data(), taps, true);
+		float linearDifference = MaxDifference(linear, reference);
+		if (linearDifference > 1e-4f)
+			failures.push_back("At radius " + to_string(radius) + " the merged taps are " + to_string(linearDifference) + " from the 2D kernel");
+	}
+
+	// Radius 0 is a single weight of 1, and leaves the image exactly as it was
+	{
+		if (GaussianBlur::Weights(0) != vector<float>{ 1.0f })
+			failures.push_back("Radius 0 isn't a single weight of 1");
+
+		vector<float> temporary(count), blurred(count), linear(count);
+		GaussianBlur::BlurPass(image.data(), width, height, temporary.data(), GaussianBlur::Weights(0), false);
+		GaussianBlur::BlurPass(temporary.data(), width, height, blurred.data(), GaussianBlur::Weights(0), true);
+		GaussianBlur::BlurPassLinear(image.data(), width, height, temporary.data(), GaussianBlur::LinearTaps(0), false);
+		GaussianBlur::BlurPassLinear(temporary.data(), width, height, linear.data(), GaussianBlur::LinearTaps(0), true);
+		if (blurred != image || linear != image)
+			failures.push_back("Radius 0 changed the image");
+	}
+
+	return failures;
+}
@@ -0,0 +1,184 @@
+#include "HeadlessTests.h"
+#include "GpuTimerRing.h"
+
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+	// --------------------------------------------------------
+	// A pretend GPU.  The test advances its clock to stand for
+	// work, and a slot's results come back Latency frames after
+	// it was closed.  It also notes anything a real query set
+	// wouldn't allow, like reusing a slot still in flight.
+	// --------------------------------------------------------
+	class ScriptedQuerySource : public IGpuQuerySource
+	{
+	public:
+		static const uint64_t Frequency = 1000000;	// Microsecond ticks
+
+		unsigned int Latency = 0;
+		bool NextFrameDisjoint = false;
+		uint64_t Clock = 0;
+		vector<string> Misuse;
+
+		ScriptedQuerySource(unsigned int slotCount, unsigned int timestampsPerSlot) :
+			slots(slotCount), timestampsPerSlot(timestampsPerSlot) {}
+
+		void Advance(uint64_t ticks) { Clock += ticks; }
+
+		void BeginFrame(unsigned int slot) override
+		{
+			if (slots[slot].State != SlotState::Idle)
+				Misuse.push_back("Began slot " + to_string(slot) + " while it was still in use");
+			slots[slot] = QuerySlot();
+			slots[slot].State = SlotState::Recording;
+			slots[slot].Disjoint = NextFrameDisjoint;
+			slots[slot].Timestamps.assign(timestampsPerSlot, 0);
+			NextFrameDisjoint = false;
+		}
+
+		void Timestamp(unsigned int slot, unsigned int index) override
+		{
+			if (slots[slot].State != SlotState::Recording || index >= timestampsPerSlot)
+				Misuse.push_back("Timestamp " + to_string(index) + " on slot " + to_string(slot) + " outside a frame or past the end");
+			else
+				slots[slot].Timestamps[index] = Clock;
+		}
+
+		void EndFrame(unsigned int slot) override
+		{
+			if (slots[slot].State != SlotState::Recording)
+				Misuse.push_back("Ended slot " + to_string(slot) + " without beginning it");
+			slots[slot].State = SlotState::InFlight;
+			slots[slot].EndedAt = ++framesEnded;
+		}
+
+		bool Read(unsigned int slot, unsigned int timestampCount, GpuQueryFrame& frame) override
+		{
+			if (slots[slot].State != SlotState::InFlight)
+			{
+				Misuse.push_back("Read slot " + to_string(slot) + " with nothing in flight");
+				return false;
+			}
+			if (framesEnded - slots[slot].EndedAt < Latency)
+				return false;
+
+			slots[slot].State = SlotState::Idle;
+			frame.Disjoint = slots[slot].Disjoint;
+			frame.Frequency = Frequency;
+			frame.Timestamps.assign(slots[slot].Timestamps.begin(), slots[slot].Timestamps.begin() + min(timestampCount, timestampsPerSlot));
+			return true;
+		}
+
+	private:
+		enum class SlotState { Idle, Recording, InFlight };
+		struct QuerySlot
+		{
+			SlotState State = SlotState::Idle;
+			bool Disjoint = false;
+			uint64_t EndedAt = 0;
+			vector<uint64_t> Timestamps;
+		};
+
+		vector<QuerySlot> slots;
+		unsigned int timestampsPerSlot;
+		uint64_t framesEnded = 0;
+	};
+
+	// A typical frame: shadows, then the scene with the sky nested inside it
+	void RunFrame(GpuTimerRing& ring, ScriptedQuerySource& gpu)
+	{
+		ring.BeginFrame();
+		{
+			ScopedGpuPass shadows(ring, "Shadows");
+			gpu.Advance(2000);
+		}
+		gpu.Advance(500);
+		{
+			ScopedGpuPass scene(ring, "Scene");
+			gpu.Advance(3000);
+			ScopedGpuPass sky(ring, "Sky");
+			gpu.Advance(1000);
+		}
+		ring.EndFrame();
+	}
+
+	bool Near(double a, double b) { return fabs(a - b) < 1e-9; }
+}
+
+vector<string> GpuTimerRingTests()
+{
+	vector<string> failures;
+	const unsigned int slotCount = 3, maxPasses = 4;
+
+	// Steady state: results arrive two frames late, nothing is skipped
+	ScriptedQuerySource gpu(slotCount, GpuTimerRing::TimestampsPerSlot(maxPasses));
+	gpu.Latency = 2;
+	GpuTimerRing ring(&gpu, slotCount, maxPasses);
+	RunFrame(ring, gpu);
+	RunFrame(ring, gpu);
+	if (ring.GetStats().FramesResolved != 0 || !ring.GetLatest().Passes.empty())
+		failures.push_back("Results came back before the GPU had them");
+	for (int i = 0; i < 8; i++)
+		RunFrame(ring, gpu);
+
+	const GpuTimerStats& stats = ring.GetStats();
+	const GpuFrameTimings& latest = ring.GetLatest();
+	if (stats.FramesResolved != 8 || stats.FramesSkipped != 0 || stats.Latency != 2 || latest.Frame != 8)
+		failures.push_back("Steady state resolved " + to_string(stats.FramesResolved) + " frames (latest " + to_string(latest.Frame) +
+			"), skipped " + to_string(stats.FramesSkipped) + ", latency " + to_string(stats.Latency));
+	if (latest.Passes.size() != 3 ||
+		latest.Passes[0].Name != "Shadows" || latest.Passes[0].Depth != 0 || !Near(latest.Passes[0].Milliseconds, 2.0) ||
+		latest.Passes[1].Name != "Scene" || latest.Passes[1].Depth != 0 || !Near(latest.Passes[1].Milliseconds, 4.0) ||
+		latest.Passes[2].Name != "Sky" || latest.Passes[2].Depth != 1 || !Near(latest.Passes[2].Milliseconds, 1.0) ||
+		!Near(latest.Milliseconds, 6.5))
+		failures.push_back("The passes weren't timed as scripted");
+	if (ring.GetHistory().size() != 8)
+		failures.push_back("History holds " + to_string(ring.GetHistory().size()) + " frames, not 8");
+
+	// A GPU stall: once every slot is in flight, frames go untimed instead of waiting
+	gpu.Latency = 100;
+	for (int i = 0; i < 10; i++)
+		RunFrame(ring, gpu);
+	if (stats.FramesSkipped < 7 || stats.FramesResolved != 8)
+		failures.push_back("A stalled GPU skipped " + to_string(stats.FramesSkipped) + " frames and resolved " + to_string(stats.FramesResolved));
+
+	// And recovers once it catches up
+	gpu.Latency = 0;
+	RunFrame(ring, gpu);
+	RunFrame(ring, gpu);
+	if (stats.FramesResolved < 10 || ring.GetLatest().Frame != 22 || stats.Latency != 0)
+		failures.push_back("The ring didn't recover after a stall (latest frame " + to_string(ring.GetLatest().Frame) + ")");
+
+	// A disjoint frame is counted but never shown
+	uint64_t resolved = stats.FramesResolved;
+	gpu.NextFrameDisjoint = true;
+	RunFrame(ring, gpu);
+	if (stats.FramesDisjoint != 1 || stats.FramesResolved != resolved || ring.GetLatest().Frame != 22)
+		failures.push_back("A disjoint frame's timings were used");
+
+	// Passes over the limit are dropped without touching the queries
+	ring.BeginFrame();
+	for (int i = 0; i < 6; i++)
+	{
+		ScopedGpuPass pass(ring, "Many");
+		gpu.Advance(100);
+	}
+	ring.EndFrame();
+	if (stats.PassesDropped != 2 || ring.GetLatest().Passes.size() != maxPasses)
+		failures.push_back("Passes over the limit weren't dropped cleanly");
+
+	// Passes outside a frame are ignored, and history can be shortened
+	{
+		ScopedGpuPass outside(ring, "Outside");
+	}
+	ring.SetHistoryLength(3);
+	if (ring.GetHistory().size() != 3 || ring.GetHistory().back().Frame != ring.GetLatest().Frame)
+		failures.push_back("Shortening the history didn't keep the newest frames");
+
+	for (const string& misuse : gpu.Misuse)
+		failures.push_back("Query misuse: " + misuse);
+	return failures;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// The headless tests - one function per module, each
+// returning what failed (nothing if it all passed).
+// TestMain.cpp runs them, and the HeadlessTests target in
+// CMakeLists.txt builds them with the D3D-free sources
+// they cover.
+// --------------------------------------------------------
+std::wstring AssetPath(const std::wstring& relativeFilePath);
+
+std::vector<std::string> ShaderReflectionCacheTests();
+std::vector<std::string> ShaderIncludeGraphTests();
+std::vector<std::string> MipGeneratorTests();
+std::vector<std::string> BlockCompressionTests();
+std::vector<std::string> OrmPackerTests();
+std::vector<std::string> RenderStateCacheTests();
+std::vector<std::string> CommandListSubmitterTests();
+std::vector<std::string> ProfilerTests();
+std::vector<std::string> GpuTimerRingTests();
+std::vector<std::string> DualFilterBlurTests();
+std::vector<std::string> TiledPostProcessTests();
+std::vector<std::string> PostEffectsTests();
+std::vector<std::string> AutoExposureTests();
+std::vector<std::string> CascadedShadowsTests();
+std::vector<std::string> ShadowCacheTests();
+std::vector<std::string> ShadowAtlasTests();
+std::vector<std::string> LocalShadowsTests();
+std::vector<std::string> StreamingPolicyTests();
+std::vector<std::string> BindingTableTests();
+std::vector<std::string> MaterialRegistryTests();
+std::vector<std::string> GaussianBlurTests();
+std::vector<std::string> PostProcessGraphTests();
@@ -0,0 +1,198 @@
+#include "HeadlessTests.h"
+#include "LocalShadows.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	XMFLOAT4X4 TestView(XMFLOAT3 position, XMFLOAT3 direction)
+	{
+		XMFLOAT4X4 view;
+		XMStoreFloat4x4(&view, XMMatrixLookToLH(XMLoadFloat3(&position), XMLoadFloat3(&direction), XMVectorSet(0, 1, 0, 0)));
+		return view;
+	}
+
+	XMFLOAT4X4 TestProjection()
+	{
+		XMFLOAT4X4 projection;
+		XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f));
+		return projection;
+	}
+
+	Light PointLight(XMFLOAT3 position, float range)
+	{
+		Light light = {};
+		light.type = LIGHT_TYPE_POINT;
+		light.position = position;
+		light.range = range;
+		return light;
+	}
+
+	Light SpotLight(XMFLOAT3 position, XMFLOAT3 direction, float range, float angle)
+	{
+		Light light = PointLight(position, range);
+		light.type = LIGHT_TYPE_SPOT;
+		light.direction = direction;
+		light.spotAngle = angle;
+		return light;
+	}
+
+	// Where a world point lands in a face: x and y in [-1, 1] and z in [0, 1] when it's inside
+	XMFLOAT3 Project(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, XMFLOAT3 point)
+	{
+		XMFLOAT3 projected;
+		XMStoreFloat3(&projected, XMVector3TransformCoord(XMLoadFloat3(&point), XMLoadFloat4x4(&view) * XMLoadFloat4x4(&projection)));
+		return projected;
+	}
+
+	bool Inside(XMFLOAT3 projected)
+	{
+		return fabsf(projected.x) <= 1.0001f && fabsf(projected.y) <= 1.0001f && projected.z >= 0 && projected.z <= 1;
+	}
+}
+
+vector<string> LocalShadowsTests()
+{
+	vector<string> failures;
+	XMFLOAT4X4 projection = TestProjection();
+	XMFLOAT4X4 view = TestView(XMFLOAT3(0, 0, -20), XMFLOAT3(0, 0, 1));
+
+	// Importance: nearer, bigger and inside count for more, and off screen is nothing
+	Light ahead = PointLight(XMFLOAT3(0, 0, 0), 4);
+	float importance = LocalShadows::Importance(ahead, view, projection);
+	if (importance <= 0 || importance >= 1)
+		failures.push_back("A light ahead of the camera got an importance of " + to_string(importance));
+	if (LocalShadows::Importance(PointLight(XMFLOAT3(0, 0, 20), 4), view, projection) >= importance)
+		failures.push_back("A light further away wasn't less important");
+	if (LocalShadows::Importance(PointLight(XMFLOAT3(0, 0, 0), 8), view, projection) <= importance)
+		failures.push_back("A light reaching further wasn't more important");
+	if (LocalShadows::Importance(PointLight(XMFLOAT3(0, 0, -40), 4), view, projection) != 0)
+		failures.push_back("A light behind the camera had some importance");
+	if (LocalShadows::Importance(PointLight(XMFLOAT3(0, 0, -18), 4), view, projection) != 1)
+		failures.push_back("A light around the camera wasn't as important as can be");
+	Light sun = ahead;
+	sun.type = LIGHT_TYPE_DIRECTIONAL;
+	if (LocalShadows::Importance(sun, view, projection) != 0 || LocalShadows::Requests({ sun, ahead }, view, projection).size() != 1)
+		failures.push_back("A directional light asked for a local shadow");
+
+	// How much of the screen it covers: a sphere filling the view's height is 1
+	float fill = 4.0f / sinf(XM_PIDIV4 * 0.5f);
+	float filling = LocalShadows::Importance(PointLight(XMFLOAT3(0, 0, fill - 20), 4), view, projection);
+	if (fabsf(filling - 1.0f) > 0.01f)
+		failures.push_back("A light just filling the screen's height got an importance of " + to_string(filling));
+	float half = LocalShadows::Importance(PointLight(XMFLOAT3(0, 0, 2 * fill - 20), 4), view, projection);
+	if (fabsf(half - 0.5f) > 0.05f)
+		failures.push_back("A light twice as far got an importance of " + to_string(half));
+
+	// A spot light only counts where its cone points
+	Light down = SpotLight(XMFLOAT3(0, 10, 0), XMFLOAT3(0, -1, 0), 8, XM_PIDIV4);
+	Light up = SpotLight(XMFLOAT3(0, 10, 0), XMFLOAT3(0, 1, 0), 8, XM_PIDIV4);
+	if (LocalShadows::Importance(down, view, projection) <= 0 || LocalShadows::Importance(up, view, projection) != 0)
+		failures.push_back("A spot light's importance didn't follow its cone");
+
+	// Bounds hold the whole cone, narrow or wide
+	for (float angle : { 0.3f, XM_PIDIV2, 2.5f })
+	{
+		Light spot = SpotLight(XMFLOAT3(1, 2, 3), XMFLOAT3(1, -1, 0.5f), 6, angle);
+		XMFLOAT3 center;
+		float radius;
+		LocalShadows::Bounds(spot, center, radius);
+		XMVECTOR axis = XMVector3Normalize(XMLoadFloat3(&spot.direction));
+		XMVECTOR side = XMVector3Normalize(XMVector3Cross(axis, XMVectorSet(0, 1, 0, 0)));
+		float edge = angle * 0.5f;
+		XMVECTOR points[3] = { XMLoadFloat3(&spot.position), XMLoadFloat3(&spot.position) + axis * spot.range,
+			XMLoadFloat3(&spot.position) + (axis * cosf(edge) + side * sinf(edge)) * spot.range };
+		for (XMVECTOR point : points)
+		{
+			if (XMVectorGetX(XMVector3Length(point - XMLoadFloat3(&center))) > radius * 1.001f)
+				failures.push_back("Spot bounds at " + to_string(angle) + " radians miss part of the cone");
+		}
+		if (radius > spot.range * 1.0001f)
+			failures.push_back("Spot bounds at " + to_string(angle) + " radians are bigger than the light's range");
+	}
+
+	// Cube faces: every direction lands inside the face the shader would pick for it, nearer is shallower
+	Light point = PointLight(XMFLOAT3(2, -3, 1), 10);
+	XMFLOAT4X4 faceViews[6], faceProjections[6];
+	for (unsigned int f = 0; f < 6; f++)
+		LocalShadows::FaceMatrices(point, f, faceViews[f], faceProjections[f]);
+	int missed = 0, deeper = 0;
+	for (int i = 0; i < 500; i++)
+	{
+		// Spread over the sphere, edges and corners included
+		float a = i * 2.399963f;
+		float y = 1.0f - 2.0f * (i + 0.5f) / 500;
+		float r = sqrtf(1 - y * y);
+		XMFLOAT3 direction = i < 8 ? XMFLOAT3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f) : XMFLOAT3(cosf(a) * r, y, sinf(a) * r);
+		unsigned int face = LocalShadows::CubeFace(direction);
+		XMVECTOR unit = XMVector3Normalize(XMLoadFloat3(&direction));
+		XMFLOAT3 nearPoint, farPoint;
+		XMStoreFloat3(&nearPoint, XMLoadFloat3(&point.position) + unit * 2.0f);
+		XMStoreFloat3(&farPoint, XMLoadFloat3(&point.position) + unit * 9.0f);
+		XMFLOAT3 nearProjected = Project(faceViews[face], faceProjections[face], nearPoint);
+		XMFLOAT3 farProjected = Project(faceViews[face], faceProjections[face], farPoint);
+		missed += Inside(nearProjected) && Inside(farProjected) ? 0 : 1;
+		deeper += nearProjected.z < farProjected.z ? 0 : 1;
+	}
+	if (missed > 0)
+		failures.push_back(to_string(missed) + " directions fell outside the cube face the shader picks");
+	if (deeper > 0)
+		failures.push_back(to_string(deeper) + " directions got deeper nearer the light");
+
+	// Spot face: inside the cone is on the map, well outside isn't
+	Light spot = SpotLight(XMFLOAT3(0, 5, 0), XMFLOAT3(0.2f, -1, 0.1f), 10, 0.8f);
+	XMFLOAT4X4 spotView, spotProjection;
+	LocalShadows::FaceMatrices(spot, 0, spotView, spotProjection);
+	XMVECTOR axis = XMVector3Normalize(XMLoadFloat3(&spot.direction));
+	XMVECTOR side = XMVector3Normalize(XMVector3Cross(axis, XMVectorSet(1, 0, 0, 0)));
+	for (float angle : { 0.0f, 0.39f, 0.6f })
+	{
+		XMFLOAT3 target;
+		XMStoreFloat3(&target, XMLoadFloat3(&spot.position) + (axis * cosf(angle) + side * sinf(angle)) * 5.0f);
+		if (Inside(Project(spotView, spotProjection, target)) != (angle < 0.4f))
+			failures.push_back("A point " + to_string(angle) + " radians off the spot's axis was " + (angle < 0.4f ? "off" : "on") + " its map");
+	}
+
+	// Casters: each face only draws what's on its side of the light, within range
+	vector<ShadowCaster> casters = {
+		{ XMFLOAT3(7, -3, 1), 1 },		// +X of the point light
+		{ XMFLOAT3(2, -3, -4), 1 },		// -Z
+		{ XMFLOAT3(2, -3, 40), 1 },		// +Z, out of range
+		{ XMFLOAT3(2, -3, 1), 0.5f },	// Around the light itself
+	};
+	vector<Light> lights = { sun, point, spot };
+	vector<ShadowRequest> requests = LocalShadows::Requests(lights, view, projection);
+	vector<ShadowAllocation> allocations(requests.size());
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		allocations[i].Size = 128;
+		for (unsigned int f = 0; f < requests[i].Faces; f++)
+			allocations[i].Tiles.push_back({ 128 * (unsigned int)(i * 6 + f), 0, 128 });
+	}
+	vector<LocalShadowFace> faces = LocalShadows::Faces(lights, requests, allocations, casters);
+	if (faces.size() != 7)
+		failures.push_back("The point and spot lights didn't get 7 faces between them");
+	for (auto& face : faces)
+	{
+		if (face.Light != 1)
+			continue;
+		bool plusX = find(face.Casters.begin(), face.Casters.end(), 0u) != face.Casters.end();
+		bool minusZ = find(face.Casters.begin(), face.Casters.end(), 1u) != face.Casters.end();
+		bool outOfRange = find(face.Casters.begin(), face.Casters.end(), 2u) != face.Casters.end();
+		bool around = find(face.Casters.begin(), face.Casters.end(), 3u) != face.Casters.end();
+		if (plusX != (face.Face == 0) || minusZ != (face.Face == 5) || outOfRange || !around)
+			failures.push_back("Cube face " + to_string(face.Face) + " drew the wrong casters");
+	}
+
+	// Packing: each light finds its run of faces and their tiles
+	LocalShadowData data = LocalShadows::Pack(faces, 2048);
+	if (data.LightTiles[0].y != 0 || data.LightTiles[1].x != 0 || data.LightTiles[1].y != 6 || data.LightTiles[2].x != 6 || data.LightTiles[2].y != 1)
+		failures.push_back("Lights don't point at their own faces");
+	if (data.Tiles[6].x != 768.0f / 2048 || data.Tiles[6].z != 128.0f / 2048)
+		failures.push_back("The spot's tile isn't where it was put in the atlas");
+	return failures;
+}
@@ -0,0 +1,146 @@
+#include "HeadlessTests.h"
+#include "MaterialRegistry.h"
+
+#include <random>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	// Stand-ins for shader and resource identity - only the addresses matter
+	int VertexShader, PixelShader;
+	int Albedo, OtherAlbedo, Normals, Sampler;
+
+	MaterialKey TestKey()
+	{
+		MaterialKey key;
+		key.ColorTint = XMFLOAT4(1, 0.5f, 0.25f, 1);
+		key.Roughness = 0.5f;
+		key.VertexShader = &VertexShader;
+		key.PixelShader = &PixelShader;
+		key.Textures = { { "SurfaceTexture", &Albedo }, { "NormalMap", &Normals } };
+		key.Samplers = { { "BasicSampler", &Sampler } };
+		key.Normalize();
+		return key;
+	}
+
+	// What Intern(shared_ptr) needs from a Material, without D3D
+	struct TestMaterial
+	{
+		MaterialKey Key;
+		unsigned int Id = MaterialRegistry::InvalidId;
+
+		MaterialKey GetKey() const { return Key; }
+		void SetId(unsigned int id) { Id = id; }
+	};
+}
+
+vector<string> MaterialRegistryTests()
+{
+	vector<string> failures;
+
+	// Equal content interns to one ID, whatever order resources were added in
+	{
+		MaterialRegistry registry;
+		MaterialKey key = TestKey();
+		MaterialKey reordered = key;
+		reordered.Textures = { { "NormalMap", &Normals }, { "SurfaceTexture", &Albedo } };
+		reordered.Normalize();
+
+		unsigned int first = registry.Intern(key);
+		unsigned int second = registry.Intern(reordered);
+		if (first != 0 || second != first)
+			failures.push_back("Equal materials got IDs " + to_string(first) + " and " + to_string(second));
+		if (registry.Count() != 1 || registry.GetHitCount() != 1)
+			failures.push_back("Interning the same content twice didn't register one material with one hit");
+	}
+
+	// Any difference in textures, tint or the rest gets a new ID, and IDs never move
+	{
+		MaterialRegistry registry;
+		vector<MaterialKey> keys(6, TestKey());
+		keys[1].Textures[1].second = &OtherAlbedo;	// SurfaceTexture sorts after NormalMap
+		keys[2].ColorTint.w = 0.5f;
+		keys[3].Roughness = 1;
+		keys[4].PixelShader = &VertexShader;
+		keys[5].Samplers.clear();
+
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			unsigned int id = registry.Intern(keys[i]);
+			if (id != i)
+				failures.push_back("Material " + to_string(i) + " differs from the others but got ID " + to_string(id));
+		}
+		for (size_t i = keys.size(); i-- > 0;)
+		{
+			if (registry.Intern(keys[i]) != i)
+				failures.push_back("Material " + to_string(i) + " got a different ID when interned again");
+		}
+		if (registry.Count() != keys.size() || registry.GetHitCount() != (int)keys.size())
+			failures.push_back("Re-interning known materials added new ones");
+	}
+
+	// Instances collapse to the first one registered with the same content
+	{
+		MaterialRegistry registry;
+		auto a = make_shared<TestMaterial>();
+		auto b = make_shared<TestMaterial>();
+		auto c = make_shared<TestMaterial>();
+		a->Key = b->Key = c->Key = TestKey();
+		c->Key.Roughness = 0;
+
+		auto sharedA = registry.Intern(a);
+		auto sharedB = registry.Intern(b);
+		auto sharedC = registry.Intern(c);
+		if (sharedA != a || sharedB != a || sharedC != c)
+			failures.push_back("Interning instances didn't share the first one with the same content");
+		if (a->Id != 0 || c->Id != 1 || b->Id != MaterialRegistry::InvalidId)
+			failures.push_back("Interned instances didn't have their IDs set");
+	}
+
+	// Sorting groups draws by material, keeps each group's original order,
+	// and counts the binds before and after
+	{
+		mt19937 random(7);
+		vector<MaterialDrawItem> items(200);
+		for (int i = 0; i < (int)items.size(); i++)
+			items[i] = { (unsigned int)(random() % 5), i };
+
+		vector<MaterialDrawItem> sorted = items;
+		MaterialBatchStats stats = MaterialBatching::Sort(sorted);
+
+		for (size_t i = 1; i < sorted.size(); i++)
+		{
+			if (sorted[i].MaterialId < sorted[i - 1].MaterialId)
+			{
+				failures.push_back("Sorted draws aren't grouped by material at " + to_string(i));
+				break;
+			}
+			if (sorted[i].MaterialId == sorted[i - 1].MaterialId && sorted[i].Index < sorted[i - 1].Index)
+			{
+				failures.push_back("Draws within material " + to_string(sorted[i].MaterialId) + " lost their original order");
+				break;
+			}
+		}
+
+		if (stats.Draws != 200 || stats.DistinctMaterials != 5 || stats.Transitions != 5)
+			failures.push_back("Sorting 200 draws over 5 materials reported " + to_string(stats.Draws) + " draws, " +
+				to_string(stats.DistinctMaterials) + " materials and " + to_string(stats.Transitions) + " transitions");
+		if (stats.UnsortedTransitions != MaterialBatching::CountTransitions(items))
+			failures.push_back("The unsorted transition count doesn't match the original order");
+
+		vector<MaterialDrawItem> alternating = { { 0, 0 }, { 1, 1 }, { 0, 2 }, { 1, 3 }, { 1, 4 } };
+		if (MaterialBatching::CountTransitions(alternating) != 4)
+			failures.push_back("Walking 0 1 0 1 1 should count 4 material changes");
+		if (MaterialBatching::Sort(alternating).Transitions != 2)
+			failures.push_back("Sorting 0 1 0 1 1 should leave 2 material changes");
+
+		vector<MaterialDrawItem> none;
+		MaterialBatchStats empty = MaterialBatching::Sort(none);
+		if (empty.Draws != 0 || empty.Transitions != 0 || empty.UnsortedTransitions != 0)
+			failures.push_back("Sorting no draws reported work");
+	}
+
+	return failures;
+}
@@ -0,0 +1,209 @@
+#include "HeadlessTests.h"
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+	// --------------------------------------------------------
+	// The reference: a direct, double precision mip chain with
+	// pow-based sRGB conversions and none of MipGenerator's
+	// tables, thresholds or SSE.  Like MipGenerator, each level
+	// is built from the previous level's unrounded values.
+	// --------------------------------------------------------
+	double DecodeSrgb(double v) { return v <= 0.04045 ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4); }
+	double EncodeSrgb(double v) { return v <= 0.0031308 ? v * 12.92 : 1.055 * pow(v, 1.0 / 2.4) - 0.055; }
+
+	double ToCodeValue(double v) { return min(max(v, 0.0), 1.0) * 255.0; }
+	int ToCode(double v) { return (int)floor(ToCodeValue(v) + 0.5); }
+
+	// Each level holds the unrounded code values, 0 to 255
+	struct ReferenceLevel
+	{
+		unsigned int Width;
+		unsigned int Height;
+		vector<double> Codes;
+	};
+
+	vector<ReferenceLevel> ReferenceChain(const DecodedImage& image, MipColorSpace colorSpace)
+	{
+		unsigned int width = image.Width;
+		unsigned int height = image.Height;
+		vector<double> level(image.Pixels.size());
+		for (size_t i = 0; i < level.size(); i++)
+		{
+			double v = image.Pixels[i] / 255.0;
+			bool color = i % 4 != 3;
+			if (color && colorSpace == MipColorSpace::SRGB) v = DecodeSrgb(v);
+			if (color && colorSpace == MipColorSpace::Normal) v = v * 2 - 1;
+			level[i] = v;
+		}
+
+		vector<ReferenceLevel> chain;
+		while (width > 1 || height > 1)
+		{
+			// Destination texel d averages source texels 2d and 2d + 1 on each axis
+			// that has more than one (a trailing odd row or column is dropped)
+			unsigned int nextWidth = max(1u, width / 2);
+			unsigned int nextHeight = max(1u, height / 2);
+			vector<double> next((size_t)nextWidth * nextHeight * 4);
+			for (unsigned int y = 0; y < nextHeight; y++)
+			{
+				for (unsigned int x = 0; x < nextWidth; x++)
+				{
+					unsigned int xs[2] = { width > 1 ? x * 2 : 0, width > 1 ? x * 2 + 1 : 0 };
+					unsigned int ys[2] = { height > 1 ? y * 2 : 0, height > 1 ? y * 2 + 1 : 0 };
+					double* out = &next[((size_t)y * nextWidth + x) * 4];
+					for (int c = 0; c < 4; c++)
+					{
+						double total = 0;
+						for (unsigned int sy : ys)
+							for (unsigned int sx : xs)
+								total += level[((size_t)sy * width + sx) * 4 + c];
+						out[c] = total / 4;
+					}
+
+					if (colorSpace == MipColorSpace::Normal)
+					{
+						double length = sqrt(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+						for (int c = 0; c < 3; c++)
+							out[c] = length > 1e-6 ? out[c] / length : (c == 2 ? 1 : 0);
+					}
+				}
+			}
+
+			ReferenceLevel mip = { nextWidth, nextHeight, {} };
+			for (size_t i = 0; i < next.size(); i++)
+			{
+				double v = next[i];
+				bool color = i % 4 != 3;
+				if (color && colorSpace == MipColorSpace::SRGB) v = EncodeSrgb(v);
+				if (color && colorSpace == MipColorSpace::Normal) v = v * 0.5 + 0.5;
+				mip.Codes.push_back(ToCodeValue(v));
+			}
+			chain.push_back(mip);
+
+			level.swap(next);
+			width = nextWidth;
+			height = nextHeight;
+		}
+		return chain;
+	}
+
+	// Deterministic noise, so every run tests the same pixels
+	DecodedImage NoiseImage(unsigned int width, unsigned int height, unsigned int seed)
+	{
+		DecodedImage image;
+		image.Width = width;
+		image.Height = height;
+		image.Pixels.resize((size_t)width * height * 4);
+		for (unsigned char& p : image.Pixels)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			p = (unsigned char)(seed >> 24);
+		}
+		return image;
+	}
+
+	// Compares a generated chain to the reference.  Every code must match, except
+	// where the reference sits right on a rounding boundary (averaging four bytes
+	// often lands on one) and float and double may round either way.
+	void Compare(const char* name, const DecodedImage& image, MipColorSpace colorSpace, vector<string>& failures)
+	{
+		vector<DecodedImage> chain = MipGenerator::Generate(image, colorSpace);
+		vector<ReferenceLevel> reference = ReferenceChain(image, colorSpace);
+		if (chain.size() != reference.size() + 1 || chain.size() != MipGenerator::MipCount(image.Width, image.Height))
+		{
+			failures.push_back(string(name) + ": " + to_string(chain.size()) + " levels, expected " + to_string(reference.size() + 1));
+			return;
+		}
+
+		for (size_t level = 0; level < reference.size(); level++)
+		{
+			const DecodedImage& mip = chain[level + 1];
+			const ReferenceLevel& expected = reference[level];
+			if (mip.Width != expected.Width || mip.Height != expected.Height || mip.Pixels.size() != expected.Codes.size())
+			{
+				failures.push_back(string(name) + ": level " + to_string(level + 1) + " is the wrong size");
+				return;
+			}
+			for (size_t i = 0; i < mip.Pixels.size(); i++)
+			{
+				double code = expected.Codes[i];
+				double nearest = floor(code + 0.5);
+				bool onBoundary = fabs(code - floor(code) - 0.5) < 0.01;
+				if (mip.Pixels[i] != nearest && !(onBoundary && fabs(mip.Pixels[i] - code) < 0.51))
+				{
+					failures.push_back(string(name) + ": level " + to_string(level + 1) + " texel " + to_string(i / 4) +
+						" is " + to_string(mip.Pixels[i]) + ", the reference " + to_string(code));
+					return;
+				}
+			}
+		}
+	}
+}
+
+vector<string> MipGeneratorTests()
+{
+	vector<string> failures;
+
+	// Whole chains against the reference, square and not, odd and even
+	Compare("sRGB 64x64", NoiseImage(64, 64, 1), MipColorSpace::SRGB, failures);
+	Compare("sRGB 37x20", NoiseImage(37, 20, 2), MipColorSpace::SRGB, failures);
+	Compare("Linear 50x3", NoiseImage(50, 3, 3), MipColorSpace::Linear, failures);
+	Compare("Normal 32x16", NoiseImage(32, 16, 4), MipColorSpace::Normal, failures);
+
+	// Averaging happens in linear light: black and white make sRGB 188, not 128
+	DecodedImage checker;
+	checker.Width = checker.Height = 2;
+	checker.Pixels = { 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255 };
+	vector<DecodedImage> checkerChain = MipGenerator::Generate(checker, MipColorSpace::SRGB);
+	if (checkerChain.size() != 2 || checkerChain[1].Pixels[0] != ToCode(EncodeSrgb(0.5)) || checkerChain[1].Pixels[3] != 255)
+		failures.push_back("A black and white checker didn't average to linear grey");
+	vector<DecodedImage> linearChecker = MipGenerator::Generate(checker, MipColorSpace::Linear);
+	if (linearChecker.size() != 2 || linearChecker[1].Pixels[0] != 128)
+		failures.push_back("A linear black and white checker didn't average to 128");
+
+	// The float kernels on their own: the SSE and scalar boxes both average
+	// each 2x2 square, and every kernel leaves a flat image flat
+	const unsigned int width = 9, height = 6;
+	vector<float> source(width * height * 4);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = (float)((i * 37) % 101) / 100.0f;
+	vector<float> box((width / 2) * (height / 2) * 4), scalar(box.size());
+	MipGenerator::DownsampleBox(source.data(), width, height, box.data(), true);
+	MipGenerator::DownsampleBoxScalar(source.data(), width, height, scalar.data(), false);
+	for (unsigned int y = 0; y < height / 2; y++)
+	{
+		for (unsigned int x = 0; x < width / 2; x++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				auto at = [&](unsigned int sx, unsigned int sy) { return (double)source[((size_t)sy * width + sx) * 4 + c]; };
+				double expected = (at(x * 2, y * 2) + at(x * 2 + 1, y * 2) + at(x * 2, y * 2 + 1) + at(x * 2 + 1, y * 2 + 1)) / 4;
+				size_t i = ((size_t)y * (width / 2) + x) * 4 + c;
+				if (fabs(box[i] - expected) > 1e-6 || fabs(scalar[i] - expected) > 1e-6)
+				{
+					failures.push_back("The box kernels don't average texel " + to_string(x) + ", " + to_string(y));
+					y = height;
+					break;
+				}
+			}
+		}
+	}
+
+	vector<float> flat(width * height * 4, 0.7f), kaiser(box.size());
+	MipGenerator::DownsampleKaiser(flat.data(), width, height, kaiser.data(), false);
+	for (float v : kaiser)
+	{
+		if (fabsf(v - 0.7f) > 1e-5f)
+		{
+			failures.push_back("The Kaiser kernel changed a flat image");
+			break;
+		}
+	}
+	return failures;
+}
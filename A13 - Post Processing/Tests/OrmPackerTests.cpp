@@ -0,0 +1,104 @@
+#include "HeadlessTests.h"
+#include "OrmPacker.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+	// Checks every texel of a packed image against its sources and returns how
+	// many channel values are out of place.  Works per texel in normalized
+	// coordinates rather than the packer's integer stepping, so the two can't
+	// share a bug.
+	size_t Misplaced(const DecodedImage& packed, const DecodedImage* occlusion, const DecodedImage* roughness, const DecodedImage* metalness)
+	{
+		const DecodedImage* sources[4] = { occlusion, roughness, metalness, 0 };
+		const unsigned char fallbacks[4] = { OrmPacker::DefaultOcclusion, OrmPacker::DefaultRoughness, OrmPacker::DefaultMetalness, 255 };
+
+		size_t expectedBytes = (size_t)packed.Width * packed.Height * 4;
+		if (packed.Pixels.size() != expectedBytes)
+			return expectedBytes;
+
+		size_t mismatches = 0;
+		for (unsigned int y = 0; y < packed.Height; y++)
+		{
+			for (unsigned int x = 0; x < packed.Width; x++)
+			{
+				double u = (x + 0.5) / packed.Width;
+				double v = (y + 0.5) / packed.Height;
+				for (int c = 0; c < 4; c++)
+				{
+					unsigned char expected = fallbacks[c];
+					if (const DecodedImage* source = sources[c])
+					{
+						unsigned int sx = min(source->Width - 1, (unsigned int)floor(u * source->Width));
+						unsigned int sy = min(source->Height - 1, (unsigned int)floor(v * source->Height));
+						expected = source->Pixels[((size_t)sy * source->Width + sx) * 4];
+					}
+
+					if (packed.Pixels[((size_t)y * packed.Width + x) * 4 + c] != expected)
+						mismatches++;
+				}
+			}
+		}
+		return mismatches;
+	}
+
+	// A grayscale map whose every texel is different, so a misplaced one shows
+	DecodedImage Gradient(unsigned int width, unsigned int height, int seed)
+	{
+		DecodedImage image;
+		image.Width = width;
+		image.Height = height;
+		for (unsigned int i = 0; i < width * height; i++)
+		{
+			unsigned char value = (unsigned char)(i * 7 + seed);
+			image.Pixels.insert(image.Pixels.end(), { value, value, value, 255 });
+		}
+		return image;
+	}
+}
+
+vector<string> OrmPackerTests()
+{
+	vector<string> failures;
+	DecodedImage packed;
+	string error;
+
+	// The sample material's maps land in the channels the shader reads
+	DecodedImage roughness, metalness;
+	if (!PngDecoder::DecodeFile(AssetPath(L"Textures/cobblestone/roughness.png"), roughness, &error) ||
+		!PngDecoder::DecodeFile(AssetPath(L"Textures/cobblestone/metal.png"), metalness, &error) ||
+		!OrmPacker::Pack(0, &roughness, &metalness, packed, &error))
+		failures.push_back("Couldn't pack the sample maps: " + error);
+	else
+	{
+		if (size_t misplaced = Misplaced(packed, 0, &roughness, &metalness))
+			failures.push_back("The sample maps packed with " + to_string(misplaced) + " misplaced values");
+		if (Misplaced(packed, 0, &metalness, &roughness) == 0)
+			failures.push_back("Swapping roughness and metalness went unnoticed");
+	}
+
+	// Sizes that don't divide evenly are point sampled up to the largest map
+	DecodedImage occlusion = Gradient(7, 5, 1), smallRoughness = Gradient(3, 3, 50), mask = Gradient(1, 2, 100);
+	if (!OrmPacker::Pack(&occlusion, &smallRoughness, &mask, packed, &error))
+		failures.push_back("Couldn't pack maps of different sizes: " + error);
+	else if (packed.Width != 7 || packed.Height != 5)
+		failures.push_back("Maps of different sizes packed to " + to_string(packed.Width) + "x" + to_string(packed.Height) + ", not 7x5");
+	else if (size_t misplaced = Misplaced(packed, &occlusion, &smallRoughness, &mask))
+		failures.push_back("Maps of different sizes packed with " + to_string(misplaced) + " misplaced values");
+
+	// Missing maps get neutral values
+	if (!OrmPacker::Pack(0, 0, &mask, packed, &error) || Misplaced(packed, 0, 0, &mask) != 0)
+		failures.push_back("Missing maps weren't filled with their defaults");
+
+	// And nothing to pack, or an empty map, is an error
+	if (OrmPacker::Pack(0, 0, 0, packed, &error))
+		failures.push_back("Packing no maps succeeded");
+	DecodedImage empty;
+	if (OrmPacker::Pack(&occlusion, &empty, 0, packed, &error))
+		failures.push_back("Packing an empty map succeeded");
+	return failures;
+}
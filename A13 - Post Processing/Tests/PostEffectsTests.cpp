@@ -0,0 +1,80 @@
+#include "HeadlessTests.h"
+#include "PostEffects.h"
+
+#include <bitset>
+#include <cmath>
+
+using namespace std;
+
+vector<string> PostEffectsTests()
+{
+	vector<string> failures;
+	unsigned int permutations = 1u << PostEffectCount;
+
+	// Every key survives a trip through its defines, and no two keys share a set
+	for (unsigned int key = 0; key < permutations; key++)
+	{
+		if (PostPermutations::KeyFromDefines(PostPermutations::Defines(key)) != key)
+			failures.push_back("Key " + to_string(key) + " doesn't round trip through its defines");
+		if (PostPermutations::Defines(key).size() != bitset<PostEffectCount>(key).count())
+			failures.push_back("Key " + to_string(key) + " has the wrong number of defines");
+	}
+
+	// Enabled-but-neutral effects stay out of the key, leaving just the encode
+	PostEffectSettings neutral;
+	neutral.Tonemap = neutral.Invert = false;
+	neutral.ColorGrade = neutral.Tint = neutral.Gamma = neutral.Vignette = true;
+	neutral.VignetteStrength = 0;
+	if (PostPermutations::BuildKey(neutral) != PostEffectEncode)
+		failures.push_back("Neutral settings built key " + PostPermutations::Describe(PostPermutations::BuildKey(neutral)) + ", not Encode");
+
+	PostEffectSettings all;
+	all.ColorGrade = all.Tint = all.Gamma = all.Vignette = all.Invert = true;
+	all.Exposure = 1.5f;
+	all.Saturation = 0.6f;
+	all.Contrast = 1.2f;
+	all.TintColor = { 1.0f, 0.9f, 0.7f };
+	all.GammaValue = 2.2f;
+	all.VignetteStrength = 0.8f;
+	if (PostPermutations::BuildKey(all) != permutations - 1)
+		failures.push_back("Every effect on built key " + PostPermutations::Describe(PostPermutations::BuildKey(all)));
+
+	// Key 0 leaves a color alone, and every effect on its own changes it
+	const float sample[4] = { 0.2f, 0.5f, 0.8f, 1.0f };
+	for (int i = -1; i < PostEffectCount; i++)
+	{
+		unsigned int key = i < 0 ? 0 : 1u << i;
+		float color[4] = { sample[0], sample[1], sample[2], sample[3] };
+		PostPermutations::Apply(key, all, 0.9f, 0.1f, color);
+
+		bool changed = false;
+		for (int c = 0; c < 4; c++)
+			changed = changed || fabsf(color[c] - sample[c]) > 1e-4f;
+		if (changed != (key != 0))
+			failures.push_back(PostPermutations::Describe(key) + (key ? " left the color unchanged" : " changed the color"));
+	}
+
+	// The names the shader's #ifdefs use, and the readable names, in bit order
+	if (PostPermutations::Defines(PostEffectTonemap | PostEffectInvert) != vector<pair<string, string>>{ { "POST_TONEMAP", "1" }, { "POST_INVERT", "1" } })
+		failures.push_back("Tonemap + Invert has the wrong defines");
+	if (PostPermutations::KeyFromDefines({ { "POST_GAMMA", "0" }, { "POST_VIGNETTE", "1" }, { "UNRELATED", "1" } }) != PostEffectVignette)
+		failures.push_back("KeyFromDefines took a define that's off, or one that isn't an effect");
+	if (PostPermutations::Describe(PostEffectEncode | PostEffectGamma | PostEffectInvert) != "Encode + Gamma + Invert")
+		failures.push_back("Describe gave \"" + PostPermutations::Describe(PostEffectEncode | PostEffectGamma | PostEffectInvert) + "\"");
+
+	// The filmic curve starts at black, never goes down, and rolls off below white
+	float previous = PostPermutations::Filmic(0);
+	if (fabsf(previous) > 1e-3f || PostPermutations::Filmic(100.0f) > 1.0f || PostPermutations::Filmic(100.0f) < 0.95f)
+		failures.push_back("The filmic curve doesn't map 0 to black and bright values just under white");
+	for (float value = 0.01f; value < 20.0f; value *= 1.1f)
+	{
+		float mapped = PostPermutations::Filmic(value);
+		if (mapped < previous)
+		{
+			failures.push_back("The filmic curve goes down at " + to_string(value));
+			break;
+		}
+		previous = mapped;
+	}
+	return failures;
+}
@@ -0,0 +1,195 @@
+#include "HeadlessTests.h"
+#include "PostProcessGraph.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	// Hands out fake views (never dereferenced, only compared) and
+	// records every allocation the graph asks for
+	class RecordingPool : public IPostTargetPool
+	{
+	public:
+		vector<vector<PostTargetSize>> Allocations;
+
+		void Allocate(const vector<PostTargetSize>& targets) override { Allocations.push_back(targets); }
+		ID3D11RenderTargetView* GetRenderTarget(int slot) override { return (ID3D11RenderTargetView*)(renderTargets + slot); }
+		ID3D11ShaderResourceView* GetShaderResource(int slot) override { return (ID3D11ShaderResourceView*)(shaderResources + slot); }
+
+	private:
+		char renderTargets[64] = {};
+		char shaderResources[64] = {};
+	};
+
+	// Every pass run, in order, with what it was given
+	struct PassLog
+	{
+		vector<string> Names;
+		vector<PostPassContext> Contexts;
+
+		PostProcessGraph::PassFunction Record()
+		{
+			return [this](const PostPassContext& pass) {
+				Names.push_back(pass.Name);
+				Contexts.push_back(pass);
+			};
+		}
+	};
+
+	// Fake import views, distinct from anything the pool hands out
+	char sceneView, backBufferTarget;
+}
+
+vector<string> PostProcessGraphTests()
+{
+	vector<string> failures;
+
+	// A pass whose output nothing reads is culled, and never runs
+	{
+		PostProcessGraph graph;
+		PassLog log;
+		int scene = graph.Import("Scene");
+		int backBuffer = graph.Import("Back Buffer");
+		int blurred = graph.Create("Blurred");
+		int debug = graph.Create("Debug View");
+		graph.AddPass("Blur", { scene }, blurred, log.Record());
+		int debugPass = graph.AddPass("Debug", { scene }, debug, log.Record());
+		graph.AddPass("Composite", { blurred }, backBuffer, log.Record());
+
+		RecordingPool pool;
+		if (!graph.Execute(pool, 1280, 720))
+			failures.push_back("A valid graph didn't run: " + graph.GetError());
+		if (graph.GetPlan().Culled != vector<int>{ debugPass } || log.Names != vector<string>{ "Blur", "Composite" })
+			failures.push_back("The unread Debug pass wasn't culled");
+		if (graph.GetPlan().PoolSlot[debug] != -1)
+			failures.push_back("A culled pass's output still got a pool texture");
+	}
+
+	// Reading something nothing writes is an error naming the resource, and nothing runs
+	{
+		PostProcessGraph graph;
+		PassLog log;
+		int scene = graph.Import("Scene");
+		int backBuffer = graph.Import("Back Buffer");
+		int bloom = graph.Create("Bloom");
+		graph.AddPass("Composite", { scene, bloom }, backBuffer, log.Record());
+
+		RecordingPool pool;
+		if (graph.Execute(pool, 1280, 720) || graph.GetError().find("'Bloom'") == string::npos)
+			failures.push_back("Reading an unwritten transient didn't fail with an error naming it (got '" + graph.GetError() + "')");
+		if (!log.Names.empty() || !pool.Allocations.empty())
+			failures.push_back("A graph that failed to compile still allocated or ran passes");
+
+		// Fixing the graph clears the error
+		graph.AddPass("Bloom", { scene }, bloom, log.Record());
+		if (!graph.Execute(pool, 1280, 720) || !graph.GetError().empty())
+			failures.push_back("Adding the missing writer didn't clear the error");
+	}
+
+	// Passes run after what they read, whatever order they were declared in,
+	// and each reads the texture its input was written to
+	{
+		PostProcessGraph graph;
+		PassLog log;
+		int scene = graph.Import("Scene");
+		int backBuffer = graph.Import("Back Buffer");
+		int first = graph.Create("First");
+		int second = graph.Create("Second");
+		graph.AddPass("Final", { second }, backBuffer, log.Record());
+		graph.AddPass("Second", { first, scene }, second, log.Record());
+		graph.AddPass("First", { scene }, first, log.Record());
+		graph.SetImport(scene, (ID3D11ShaderResourceView*)&sceneView, 0);
+		graph.SetImport(backBuffer, 0, (ID3D11RenderTargetView*)&backBufferTarget);
+
+		RecordingPool pool;
+		graph.Execute(pool, 1280, 720);
+		if (log.Names != vector<string>{ "First", "Second", "Final" })
+			failures.push_back("Passes declared out of order didn't run in dependency order");
+		else
+		{
+			const PostGraphPlan& plan = graph.GetPlan();
+			if (log.Contexts[0].Output != pool.GetRenderTarget(plan.PoolSlot[first]) ||
+				log.Contexts[1].Inputs != vector<ID3D11ShaderResourceView*>{ pool.GetShaderResource(plan.PoolSlot[first]), (ID3D11ShaderResourceView*)&sceneView } ||
+				log.Contexts[2].Output != (ID3D11RenderTargetView*)&backBufferTarget)
+				failures.push_back("Passes weren't handed the views their resources live in");
+		}
+
+		// A cycle can't be ordered at all
+		PostProcessGraph cycle;
+		int a = cycle.Create("A");
+		int b = cycle.Create("B");
+		int out = cycle.Import("Back Buffer");
+		cycle.AddPass("To A", { b }, a, log.Record());
+		cycle.AddPass("To B", { a }, b, log.Record());
+		cycle.AddPass("Out", { b }, out, log.Record());
+		if (cycle.Compile(1280, 720) || cycle.GetError().empty())
+			failures.push_back("A cycle compiled");
+	}
+
+	// Transients share a texture only when one is done being read before the other is written
+	{
+		PostProcessGraph graph;
+		PassLog log;
+		int scene = graph.Import("Scene");
+		int backBuffer = graph.Import("Back Buffer");
+		vector<int> chain;
+		int previous = scene;
+		for (int i = 0; i < 5; i++)
+		{
+			chain.push_back(graph.Create("Chain " + to_string(i)));
+			graph.AddPass("Chain " + to_string(i), { previous }, chain.back(), log.Record());
+			previous = chain.back();
+		}
+		graph.AddPass("Out", { previous }, backBuffer, log.Record());
+
+		RecordingPool pool;
+		graph.Execute(pool, 1280, 720);
+		const PostGraphPlan& plan = graph.GetPlan();
+		if (plan.Targets.size() != 2)
+			failures.push_back("A chain of 5 same-sized passes used " + to_string(plan.Targets.size()) + " textures rather than 2");
+		for (size_t i = 1; i < chain.size(); i++)
+		{
+			if (plan.PoolSlot[chain[i]] == plan.PoolSlot[chain[i - 1]])
+				failures.push_back("'Chain " + to_string(i) + "' shares a texture with the pass it reads");
+		}
+
+		// Keeping the first link alive to the end takes it out of the rotation,
+		// and a half-size target never shares with a full-size one
+		PostProcessGraph held;
+		scene = held.Import("Scene");
+		backBuffer = held.Import("Back Buffer");
+		int early = held.Create("Early");
+		int middle = held.Create("Middle");
+		int late = held.Create("Late");
+		PostTargetDesc half;
+		half.Level = 1;
+		int small = held.Create("Small", half);
+		held.AddPass("Early", { scene }, early, log.Record());
+		held.AddPass("Middle", { early }, middle, log.Record());
+		held.AddPass("Small", { middle }, small, log.Record());
+		held.AddPass("Late", { small }, late, log.Record());
+		held.AddPass("Out", { early, late }, backBuffer, log.Record());
+
+		held.Execute(pool, 1280, 720);
+		const PostGraphPlan& heldPlan = held.GetPlan();
+		if (heldPlan.PoolSlot[early] == heldPlan.PoolSlot[middle] || heldPlan.PoolSlot[early] == heldPlan.PoolSlot[late])
+			failures.push_back("A transient still being read shared its texture");
+		if (heldPlan.PoolSlot[late] != heldPlan.PoolSlot[middle])
+			failures.push_back("'Late' didn't reuse the texture 'Middle' was finished with");
+		if (heldPlan.Targets[heldPlan.PoolSlot[small]] != held.GetSize(small) || held.GetSize(small).Width != 640 || heldPlan.Targets.size() != 3)
+			failures.push_back("The half-size target didn't get a texture of its own");
+
+		// The pool is only refitted when the plan changes
+		size_t allocations = pool.Allocations.size();
+		held.Execute(pool, 1280, 720);
+		if (pool.Allocations.size() != allocations)
+			failures.push_back("Running an unchanged graph reallocated the pool");
+		held.Execute(pool, 1920, 1080);
+		if (pool.Allocations.size() != allocations + 1 || pool.Allocations.back()[heldPlan.PoolSlot[small]].Width != 960)
+			failures.push_back("Resizing the output didn't refit the pool");
+	}
+
+	return failures;
+}
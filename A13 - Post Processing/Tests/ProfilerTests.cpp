@@ -0,0 +1,167 @@
+#include "HeadlessTests.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+	const ProfileThread* FindThread(const vector<ProfileThread>& threads, const string& name)
+	{
+		for (const ProfileThread& thread : threads)
+			if (thread.Name == name) return &thread;
+		return 0;
+	}
+
+	// Best of several runs, so a descheduled thread doesn't count against the profiler
+	double Fastest(double (*measure)(unsigned int))
+	{
+		double fastest = measure(200000);
+		for (int run = 1; run < 5; run++)
+			fastest = min(fastest, measure(200000));
+		return fastest;
+	}
+
+	size_t CountOf(const string& text, const string& pattern)
+	{
+		size_t count = 0;
+		for (size_t at = text.find(pattern); at != string::npos; at = text.find(pattern, at + 1))
+			count++;
+		return count;
+	}
+}
+
+vector<string> ProfilerTests()
+{
+	vector<string> failures;
+	Profiler::SetEnabled(true);
+
+	// Nested zones on two threads at once, each into its own ring
+	uint64_t start = Profiler::Now();
+	auto nested = [](const char* name) {
+		Profiler::SetThreadName(name);
+		PROFILE_ZONE("Outer");
+		for (int i = 0; i < 2; i++)
+		{
+			PROFILE_ZONE("Inner");
+			PROFILE_ZONE("Innermost");
+		}
+	};
+	thread first(nested, "Profiler Test \"A\"");
+	thread second(nested, "Profiler Test B");
+	first.join();
+	second.join();
+	vector<ProfileThread> capture = Profiler::Capture(start, Profiler::Now());
+
+	for (const char* name : { "Profiler Test \"A\"", "Profiler Test B" })
+	{
+		const ProfileThread* thread = FindThread(capture, name);
+		const char* expectedNames[] = { "Innermost", "Inner", "Innermost", "Inner", "Outer" };
+		const unsigned int expectedDepths[] = { 2, 1, 2, 1, 0 };
+		if (!thread || thread->Events.size() != 5)
+		{
+			failures.push_back(string(name) + " didn't record its 5 zones");
+			continue;
+		}
+
+		// Zones finish inside out, and each sits within its parent
+		const vector<ProfileEvent>& events = thread->Events;
+		for (size_t i = 0; i < 5; i++)
+		{
+			if (strcmp(events[i].Name, expectedNames[i]) != 0 || events[i].Depth != expectedDepths[i] || events[i].End < events[i].Start)
+				failures.push_back(string(name) + " recorded zone " + to_string(i) + " as " + events[i].Name + " at depth " + to_string(events[i].Depth));
+		}
+		if (events[0].Start < events[1].Start || events[0].End > events[1].End || events[1].Start < events[4].Start || events[3].End > events[4].End)
+			failures.push_back(string(name) + "'s zones don't nest");
+	}
+
+	// The trace has every zone, and escapes the thread name
+	string trace = Profiler::ToChromeTrace(capture);
+	size_t zones = 0;
+	for (const ProfileThread& thread : capture)
+		zones += thread.Events.size();
+	if (CountOf(trace, "\"ph\":\"X\"") != zones || CountOf(trace, "\"ph\":\"M\"") != capture.size() ||
+		trace.find("Profiler Test \\\"A\\\"") == string::npos || trace.rfind("]}") == string::npos)
+		failures.push_back("The Chrome trace doesn't match the capture");
+
+	// Once a ring is full it keeps only the newest zones
+	start = Profiler::Now();
+	thread wrapping([]() {
+		Profiler::SetThreadName("Profiler Test Wrap");
+		for (unsigned int i = 0; i < Profiler::EventsPerThread + 100; i++)
+		{
+			PROFILE_ZONE(i < 100 ? "Overwritten" : "Kept");
+		}
+	});
+	wrapping.join();
+	capture = Profiler::Capture(start, Profiler::Now());
+	const ProfileThread* wrapped = FindThread(capture, "Profiler Test Wrap");
+	if (!wrapped || wrapped->Events.size() != Profiler::EventsPerThread)
+		failures.push_back("A wrapped ring didn't hold exactly EventsPerThread zones");
+	else
+	{
+		for (const ProfileEvent& e : wrapped->Events)
+		{
+			if (strcmp(e.Name, "Kept") != 0)
+			{
+				failures.push_back("A wrapped ring kept an overwritten zone");
+				break;
+			}
+		}
+	}
+
+	// Zones deeper than MaxDepth are dropped without unbalancing the rest,
+	// and nothing is recorded while the profiler is off
+	start = Profiler::Now();
+	thread deep([]() {
+		Profiler::SetThreadName("Profiler Test Deep");
+		for (unsigned int i = 0; i < Profiler::MaxDepth + 10; i++)
+			Profiler::BeginZone("Deep");
+		for (unsigned int i = 0; i < Profiler::MaxDepth + 10; i++)
+			Profiler::EndZone();
+		PROFILE_ZONE("After");
+		Profiler::SetEnabled(false);
+		PROFILE_ZONE("Disabled");
+	});
+	deep.join();
+	Profiler::SetEnabled(true);
+	capture = Profiler::Capture(start, Profiler::Now());
+	const ProfileThread* deepThread = FindThread(capture, "Profiler Test Deep");
+	if (!deepThread || deepThread->Events.size() != Profiler::MaxDepth + 1 ||
+		strcmp(deepThread->Events.back().Name, "After") != 0 || deepThread->Events.back().Depth != 0)
+		failures.push_back("Zones past MaxDepth or while disabled weren't handled");
+
+	// Frame markers
+	uint64_t frameStart, frameEnd;
+	Profiler::MarkFrame();
+	Profiler::MarkFrame();
+	if (!Profiler::GetLastFrame(frameStart, frameEnd) || frameEnd <= frameStart)
+		failures.push_back("Two frame markers didn't make a frame");
+
+	// The overhead microbenchmark.  The target is 50ns a zone, but the two clock
+	// reads in every zone take ~15ns on bare metal and 45ns or more on VMs that
+	// virtualize the TSC (like CI's).  So what the profiler itself adds is held
+	// to half the target everywhere, and the whole zone to 50ns where the clock
+	// is cheap enough to allow it
+	const double TargetNanoseconds = 50;
+	const double BookkeepingNanoseconds = 25;
+	double enabledNanoseconds = Fastest(Profiler::MeasureZoneOverhead);
+	double clockNanoseconds = Fastest(Profiler::MeasureClockOverhead);
+	Profiler::SetEnabled(false);
+	double disabledNanoseconds = Fastest(Profiler::MeasureZoneOverhead);
+	Profiler::SetEnabled(true);
+	double bookkeepingNanoseconds = enabledNanoseconds - 2 * clockNanoseconds;
+	printf("  Zone overhead: %.1f ns enabled (%.1f ns reading the clock twice), %.1f ns disabled\n",
+		enabledNanoseconds, 2 * clockNanoseconds, disabledNanoseconds);
+	if (!(enabledNanoseconds > 0) || bookkeepingNanoseconds > BookkeepingNanoseconds)
+		failures.push_back("A zone costs " + to_string(enabledNanoseconds) + "ns, " + to_string(bookkeepingNanoseconds) + "ns of it beyond reading the clock");
+	else if (2 * clockNanoseconds < TargetNanoseconds - BookkeepingNanoseconds && enabledNanoseconds > TargetNanoseconds)
+		failures.push_back("A zone costs " + to_string(enabledNanoseconds) + "ns, over the " + to_string((int)TargetNanoseconds) + "ns target");
+	if (disabledNanoseconds > 10)
+		failures.push_back("A disabled zone costs " + to_string(disabledNanoseconds) + "ns");
+	return failures;
+}
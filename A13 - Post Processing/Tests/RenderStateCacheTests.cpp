@@ -0,0 +1,143 @@
+#include "HeadlessTests.h"
+#include "RenderStateCache.h"
+
+#include <cstdint>
+
+using namespace std;
+
+namespace
+{
+	// Fake objects - the cache only ever compares their addresses
+	template<typename T> T* Fake(uintptr_t id) { return (T*)(id * 16); }
+	template<typename T> uintptr_t Id(T* object) { return (uintptr_t)object / 16; }
+
+	// Writes down every call that reaches the "device", e.g. "PSSetShaderResources 2 [3, 4]"
+	class RecordingContext : public IRenderContext
+	{
+	public:
+		vector<string> Calls;
+
+		void IASetInputLayout(ID3D11InputLayout* layout) override { Record("IASetInputLayout", Id(layout)); }
+		void VSSetShader(ID3D11VertexShader* shader) override { Record("VSSetShader", Id(shader)); }
+		void PSSetShader(ID3D11PixelShader* shader) override { Record("PSSetShader", Id(shader)); }
+		void VSSetConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers) override { RecordRange("VSSetConstantBuffers", startSlot, count, buffers); }
+		void PSSetConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers) override { RecordRange("PSSetConstantBuffers", startSlot, count, buffers); }
+		void PSSetShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views) override { RecordRange("PSSetShaderResources", startSlot, count, views); }
+		void PSSetSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers) override { RecordRange("PSSetSamplers", startSlot, count, samplers); }
+		void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthView) override
+		{
+			RecordRange("OMSetRenderTargets", 0, count, views);
+			Calls.back() += " depth " + to_string(Id(depthView));
+		}
+		void RSSetState(ID3D11RasterizerState* state) override { Record("RSSetState", Id(state)); }
+		void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) override { Calls.push_back("OMSetDepthStencilState " + to_string(Id(state)) + " ref " + to_string(stencilRef)); }
+		void RSSetViewports(unsigned int count, const RenderViewport* viewports) override { Calls.push_back("RSSetViewports " + to_string(count) + " width " + to_string((int)viewports[0].Width)); }
+
+		vector<string> Take() { vector<string> calls; calls.swap(Calls); return calls; }
+
+	private:
+		void Record(const char* name, uintptr_t id) { Calls.push_back(string(name) + " " + to_string(id)); }
+
+		template<typename T>
+		void RecordRange(const char* name, unsigned int startSlot, unsigned int count, T* const* values)
+		{
+			string call = string(name) + " " + to_string(startSlot) + " [";
+			for (unsigned int i = 0; i < count; i++)
+				call += (i ? ", " : "") + to_string(values ? Id(values[i]) : 0);
+			Calls.push_back(call + "]");
+		}
+	};
+
+	string Join(const vector<string>& calls)
+	{
+		string joined;
+		for (const string& call : calls)
+			joined += (joined.empty() ? "" : "; ") + call;
+		return "{" + joined + "}";
+	}
+}
+
+vector<string> RenderStateCacheTests()
+{
+	vector<string> failures;
+	RecordingContext context;
+	RenderStateCache cache(&context);
+	auto expect = [&](const string& what, const vector<string>& expected) {
+		vector<string> calls = context.Take();
+		if (calls != expected)
+			failures.push_back(what + ": got " + Join(calls) + ", expected " + Join(expected));
+	};
+
+	ID3D11ShaderResourceView* textures[] = { Fake<ID3D11ShaderResourceView>(3), Fake<ID3D11ShaderResourceView>(4) };
+	ID3D11ShaderResourceView* otherTextures[] = { Fake<ID3D11ShaderResourceView>(3), Fake<ID3D11ShaderResourceView>(5) };
+	ID3D11Buffer* buffers[] = { Fake<ID3D11Buffer>(6), Fake<ID3D11Buffer>(7), Fake<ID3D11Buffer>(8) };
+	ID3D11SamplerState* sampler = Fake<ID3D11SamplerState>(9);
+	ID3D11RenderTargetView* backBuffer = Fake<ID3D11RenderTargetView>(10);
+	ID3D11DepthStencilView* depth = Fake<ID3D11DepthStencilView>(11);
+	RenderViewport viewport;
+	viewport.Width = 1280;
+	viewport.Height = 720;
+
+	// A frame's worth of state, as drawing two entities with one material would set it
+	auto drawFrame = [&]() {
+		cache.SetRenderTargets(1, &backBuffer, depth);
+		cache.SetViewports(1, &viewport);
+		for (int entity = 0; entity < 2; entity++)
+		{
+			cache.SetInputLayout(Fake<ID3D11InputLayout>(1));
+			cache.SetVertexShader(Fake<ID3D11VertexShader>(1));
+			cache.SetPixelShader(Fake<ID3D11PixelShader>(2));
+			cache.SetVertexConstantBuffers(0, 1, buffers);
+			cache.SetPixelShaderResources(2, 2, textures);
+			cache.SetPixelSamplers(0, 1, &sampler);
+			cache.SetRasterizerState(0);
+			cache.SetDepthStencilState(0);
+		}
+	};
+
+	// Everything goes through the first time, and nothing repeats
+	drawFrame();
+	const vector<string> firstFrame = {
+		"OMSetRenderTargets 0 [10] depth 11", "RSSetViewports 1 width 1280",
+		"IASetInputLayout 1", "VSSetShader 1", "PSSetShader 2", "VSSetConstantBuffers 0 [6]",
+		"PSSetShaderResources 2 [3, 4]", "PSSetSamplers 0 [9]", "RSSetState 0", "OMSetDepthStencilState 0 ref 0" };
+	expect("First frame", firstFrame);
+	RenderStateCounters counters = cache.GetCounters();
+	if (counters.TotalRequested() != 18 || counters.TotalForwarded() != 10)
+		failures.push_back("Counted " + to_string(counters.TotalForwarded()) + " of " + to_string(counters.TotalRequested()) + " calls forwarded, not 10 of 18");
+
+	// The same frame again is entirely redundant
+	cache.ResetCounters();
+	drawFrame();
+	expect("Repeated frame", {});
+	if (cache.GetCounters().TotalForwarded() != 0)
+		failures.push_back("Counted forwarded calls on a redundant frame");
+
+	// Ranges are trimmed to the slots that differ
+	cache.SetPixelShaderResources(2, 2, otherTextures);
+	cache.SetPixelConstantBuffers(0, 3, buffers);
+	cache.SetPixelConstantBuffers(0, 3, buffers);
+	ID3D11Buffer* middleChanged[] = { buffers[0], Fake<ID3D11Buffer>(12), buffers[2] };
+	cache.SetPixelConstantBuffers(0, 3, middleChanged);
+	cache.SetDepthStencilState(0, 1);
+	expect("Partial ranges", { "PSSetShaderResources 3 [5]", "PSSetConstantBuffers 0 [6, 7, 8]", "PSSetConstantBuffers 1 [12]", "OMSetDepthStencilState 0 ref 1" });
+
+	// Present unbinds the render targets behind the cache's back, so they must be set again...
+	cache.InvalidateRenderTargets();
+	drawFrame();
+	cache.SetDepthStencilState(0, 1);
+	cache.SetPixelShaderResources(2, 2, otherTextures);
+	expect("After Present", { "OMSetRenderTargets 0 [10] depth 11", "PSSetShaderResources 3 [4]", "OMSetDepthStencilState 0 ref 0", "OMSetDepthStencilState 0 ref 1", "PSSetShaderResources 3 [5]" });
+
+	// ...while a full invalidation (after a resize, say) sends everything again
+	cache.Invalidate();
+	drawFrame();
+	expect("After Invalidate", firstFrame);
+
+	// Unbinding is a change like any other, and a null array unbinds the range
+	cache.SetRenderTargets(0, 0, 0);
+	cache.SetPixelShaderResources(2, 2, 0);
+	cache.SetPixelShaderResources(2, 2, 0);
+	expect("Unbinding", { "OMSetRenderTargets 0 [] depth 0", "PSSetShaderResources 2 [0, 0]" });
+	return failures;
+}
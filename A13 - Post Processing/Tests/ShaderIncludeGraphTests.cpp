@@ -0,0 +1,92 @@
+#include "HeadlessTests.h"
+#include "ShaderIncludeGraph.h"
+
+using namespace std;
+
+namespace
+{
+	string Join(const vector<string>& names)
+	{
+		string joined;
+		for (const string& name : names)
+			joined += (joined.empty() ? "" : ", ") + name;
+		return "[" + joined + "]";
+	}
+}
+
+vector<string> ShaderIncludeGraphTests()
+{
+	vector<string> failures;
+	auto expect = [&](const string& what, const vector<string>& actual, const vector<string>& expected) {
+		if (actual != expected)
+			failures.push_back(what + ": got " + Join(actual) + ", expected " + Join(expected));
+	};
+
+	// Parsing: quoted includes only, normalized, and nothing from inside comments
+	expect("Parsed includes", ShaderIncludeGraph::ParseIncludes(
+		"#include \"ShaderIncludes.hlsli\"\n"
+		"  #  include \"Shared\\Lighting.HLSLI\"\n"
+		"#include <system.h>\n"
+		"// #include \"Commented.hlsli\"\n"
+		"/* #include \"Block.hlsli\"\n"
+		"#include \"StillBlock.hlsli\" */\n"
+		"#define INCLUDE 1\n"
+		"#include \"PostEffects.hlsli\" // trailing comment\n"),
+		{ "shaderincludes.hlsli", "shared/lighting.hlsli", "posteffects.hlsli" });
+	expect("No includes", ShaderIncludeGraph::ParseIncludes("float4 main() : SV_TARGET { return 0; }"), {});
+
+	// The graph: a diamond through Lighting.hlsli, and a chain through PostEffects.hlsli
+	ShaderIncludeGraph graph;
+	graph.SetFile("ShaderIncludes.hlsli", "struct VertexToPixel { float4 position : SV_POSITION; };");
+	graph.SetFile("Lighting.hlsli", "#include \"ShaderIncludes.hlsli\"");
+	graph.SetFile("PixelShader.hlsl", "#include \"ShaderIncludes.hlsli\"\n#include \"Lighting.hlsli\"");
+	graph.SetFile("VertexShader.hlsl", "#include \"ShaderIncludes.hlsli\"");
+	graph.SetFile("PostEffects.hlsli", "");
+	graph.SetFile("PixelShaderPostOutput.hlsl", "#include \"PostEffects.hlsli\"");
+	graph.SetFile("ComputeShaderPostProcess.hlsl", "#define POST_TONEMAP 1\n#include \"PostEffects.hlsli\"");
+	if (graph.FileCount() != 7)
+		failures.push_back("The graph holds " + to_string(graph.FileCount()) + " files, not 7");
+
+	expect("Shared include changed", graph.GetAffectedShaders("ShaderIncludes.hlsli"), { "pixelshader.hlsl", "vertexshader.hlsl" });
+	expect("Nested include changed", graph.GetAffectedShaders("LIGHTING.hlsli"), { "pixelshader.hlsl" });
+	expect("Post effects changed", graph.GetAffectedShaders("PostEffects.hlsli"), { "computeshaderpostprocess.hlsl", "pixelshaderpostoutput.hlsl" });
+	expect("Shader changed", graph.GetAffectedShaders("VertexShader.hlsl"), { "vertexshader.hlsl" });
+	expect("Unknown file changed", graph.GetAffectedShaders("Unknown.hlsli"), {});
+
+	// Editing a file replaces its edges, and removing one drops them
+	graph.SetFile("PixelShader.hlsl", "#include \"ShaderIncludes.hlsli\"");
+	expect("Include dropped", graph.GetAffectedShaders("Lighting.hlsli"), {});
+	const vector<string>* includes = graph.GetIncludes("pixelshader.HLSL");
+	if (!includes || *includes != vector<string>{ "shaderincludes.hlsli" })
+		failures.push_back("The edited shader's includes weren't replaced");
+	graph.RemoveFile("VertexShader.hlsl");
+	expect("Shader removed", graph.GetAffectedShaders("ShaderIncludes.hlsli"), { "pixelshader.hlsl" });
+	if (graph.GetIncludes("VertexShader.hlsl"))
+		failures.push_back("A removed file still has includes");
+
+	// Include cycles don't loop forever
+	graph.SetFile("A.hlsli", "#include \"B.hlsli\"");
+	graph.SetFile("B.hlsli", "#include \"A.hlsli\"");
+	graph.SetFile("Cycle.hlsl", "#include \"A.hlsli\"");
+	expect("Cycle", graph.GetAffectedShaders("B.hlsli"), { "cycle.hlsl" });
+
+	// Debouncing: a burst of writes is one change, once it's been quiet long enough
+	ChangeDebouncer debouncer(0.2);
+	debouncer.Notify("PixelShader.hlsl", 0.0);
+	debouncer.Notify("pixelshader.hlsl", 0.05);
+	debouncer.Notify("PixelShader.hlsl", 0.1);
+	debouncer.Notify("Lighting.hlsli", 0.2);
+	expect("Still writing", debouncer.CollectReady(0.25), {});
+	expect("First settled", debouncer.CollectReady(0.35), { "pixelshader.hlsl" });
+	expect("Already collected", debouncer.CollectReady(0.38), {});
+	if (!debouncer.HasPending())
+		failures.push_back("The debouncer lost a file that hadn't settled");
+	expect("Second settled", debouncer.CollectReady(0.5), { "lighting.hlsli" });
+	if (debouncer.HasPending())
+		failures.push_back("The debouncer still has files after collecting them all");
+
+	debouncer.Notify("B.hlsli", 1.0);
+	debouncer.Notify("A.hlsli", 1.0);
+	expect("Settled together", debouncer.CollectReady(2.0), { "a.hlsli", "b.hlsli" });
+	return failures;
+}
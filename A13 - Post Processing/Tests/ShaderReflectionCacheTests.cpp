@@ -0,0 +1,176 @@
+#include "HeadlessTests.h"
+#include "ShaderReflectionCache.h"
+
+#include <filesystem>
+
+using namespace std;
+
+namespace
+{
+	// What a vertex shader like VertexShader.hlsl reflects as
+	ShaderReflectionData VertexReflection()
+	{
+		ShaderReflectionData data;
+		ReflectedConstantBuffer buffer;
+		buffer.Name = "ExternalData";
+		buffer.Size = 272;
+		buffer.Variables = { { "world", 0, 64 }, { "worldInverseTranspose", 64, 64 }, { "view", 128, 64 }, { "projection", 192, 64 }, { "lightSpace", 256, 16 } };
+		data.ConstantBuffers.push_back(buffer);
+		data.InputParameters = { { "POSITION", 0, 7, 3 }, { "NORMAL", 0, 7, 3 }, { "TEXCOORD", 0, 3, 3 }, { "TANGENT", 0, 7, 3 } };
+		return data;
+	}
+
+	// And a compute shader, with everything but vertex inputs
+	ShaderReflectionData ComputeReflection()
+	{
+		ShaderReflectionData data;
+		ReflectedConstantBuffer buffer;
+		buffer.Name = "externalData";
+		buffer.Size = 144;
+		buffer.BindIndex = 2;
+		buffer.Variables = { { "apron", 0, 4 }, { "weights", 16, 128 } };
+		data.ConstantBuffers.push_back(buffer);
+		ReflectedConstantBuffer empty;
+		empty.Name = "";
+		empty.Type = 1;
+		data.ConstantBuffers.push_back(empty);
+		data.ShaderResourceViews = { { "Pixels", 0 }, { "AdaptedExposure", 1 } };
+		data.Samplers = { { "ClampSampler", 3 } };
+		data.UnorderedAccessViews = { { "Output", 0 } };
+		data.ThreadGroupSize[0] = 16;
+		data.ThreadGroupSize[1] = 16;
+		data.ThreadGroupSize[2] = 1;
+		return data;
+	}
+
+	// Field by field, so the test doesn't lean on the serializer it's testing
+	bool Same(const ShaderReflectionData& a, const ShaderReflectionData& b)
+	{
+		auto sameResources = [](const vector<ReflectedResource>& x, const vector<ReflectedResource>& y) {
+			if (x.size() != y.size()) return false;
+			for (size_t i = 0; i < x.size(); i++)
+				if (x[i].Name != y[i].Name || x[i].BindIndex != y[i].BindIndex) return false;
+			return true;
+		};
+
+		if (a.ConstantBuffers.size() != b.ConstantBuffers.size() || a.InputParameters.size() != b.InputParameters.size())
+			return false;
+		for (size_t i = 0; i < a.ConstantBuffers.size(); i++)
+		{
+			const ReflectedConstantBuffer& x = a.ConstantBuffers[i];
+			const ReflectedConstantBuffer& y = b.ConstantBuffers[i];
+			if (x.Name != y.Name || x.Type != y.Type || x.Size != y.Size || x.BindIndex != y.BindIndex || x.Variables.size() != y.Variables.size())
+				return false;
+			for (size_t v = 0; v < x.Variables.size(); v++)
+			{
+				if (x.Variables[v].Name != y.Variables[v].Name || x.Variables[v].ByteOffset != y.Variables[v].ByteOffset || x.Variables[v].Size != y.Variables[v].Size)
+					return false;
+			}
+		}
+		for (size_t i = 0; i < a.InputParameters.size(); i++)
+		{
+			const ReflectedInputParameter& x = a.InputParameters[i];
+			const ReflectedInputParameter& y = b.InputParameters[i];
+			if (x.SemanticName != y.SemanticName || x.SemanticIndex != y.SemanticIndex || x.Mask != y.Mask || x.ComponentType != y.ComponentType)
+				return false;
+		}
+		for (int i = 0; i < 3; i++)
+			if (a.ThreadGroupSize[i] != b.ThreadGroupSize[i]) return false;
+
+		return sameResources(a.ShaderResourceViews, b.ShaderResourceViews) &&
+			sameResources(a.Samplers, b.Samplers) &&
+			sameResources(a.UnorderedAccessViews, b.UnorderedAccessViews);
+	}
+
+	void WriteUInt(vector<unsigned char>& bytes, size_t at, unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+			bytes[at + i] = (unsigned char)(value >> (i * 8));
+	}
+}
+
+vector<string> ShaderReflectionCacheTests()
+{
+	vector<string> failures;
+	const unsigned char vertexCode[] = { 'D', 'X', 'B', 'C', 1, 2, 3 };
+	const unsigned char computeCode[] = { 'D', 'X', 'B', 'C', 1, 2, 4 };
+	unsigned long long vertexHash = ShaderReflectionCache::HashBytecode(vertexCode, sizeof(vertexCode));
+	unsigned long long computeHash = ShaderReflectionCache::HashBytecode(computeCode, sizeof(computeCode));
+	if (vertexHash == computeHash)
+		failures.push_back("Bytecode differing in one byte hashed the same");
+
+	// Round trip: serialize two entries, clear, read them back
+	ShaderReflectionCache::Clear();
+	ShaderReflectionCache::Insert(vertexHash, VertexReflection());
+	ShaderReflectionCache::Insert(computeHash, ComputeReflection());
+	vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(bytes);
+
+	ShaderReflectionCache::Clear();
+	ShaderReflectionData found;
+	if (ShaderReflectionCache::Find(vertexHash, found))
+		failures.push_back("Clear left an entry behind");
+	if (!ShaderReflectionCache::Deserialize(bytes.data(), bytes.size()))
+		failures.push_back("The serialized cache didn't deserialize");
+	if (ShaderReflectionCache::Count() != 2)
+		failures.push_back("Deserialized " + to_string(ShaderReflectionCache::Count()) + " entries, not 2");
+	if (!ShaderReflectionCache::Find(vertexHash, found) || !Same(found, VertexReflection()))
+		failures.push_back("The vertex shader's reflection didn't round trip");
+	if (!ShaderReflectionCache::Find(computeHash, found) || !Same(found, ComputeReflection()))
+		failures.push_back("The compute shader's reflection didn't round trip");
+	if (!(VertexReflection() == VertexReflection()) || VertexReflection() == ComputeReflection())
+		failures.push_back("operator== disagrees with a field by field comparison");
+
+	// Entries come out in whatever order the map holds them, so only the size has to match
+	vector<unsigned char> again;
+	ShaderReflectionCache::Serialize(again);
+	if (again.size() != bytes.size())
+		failures.push_back("Serializing the deserialized cache gave a different size");
+
+	// Every truncation fails cleanly and leaves nothing behind
+	for (size_t size = 0; size < bytes.size(); size++)
+	{
+		if (ShaderReflectionCache::Deserialize(bytes.data(), size) || ShaderReflectionCache::Count() != 0)
+		{
+			failures.push_back("A cache cut to " + to_string(size) + " of " + to_string(bytes.size()) + " bytes was accepted");
+			break;
+		}
+	}
+
+	// A huge count is rejected before anything is allocated for it -
+	// the first entry's constant buffer count follows the header and its hash
+	vector<unsigned char> corrupt = bytes;
+	WriteUInt(corrupt, 20, 0xFFFFFFF0);
+	try
+	{
+		if (ShaderReflectionCache::Deserialize(corrupt.data(), corrupt.size()))
+			failures.push_back("A cache with a corrupt count was accepted");
+	}
+	catch (...)
+	{
+		failures.push_back("A cache with a corrupt count threw instead of failing");
+	}
+
+	// As are other magic numbers and versions
+	corrupt = bytes;
+	corrupt[0] ^= 1;
+	if (ShaderReflectionCache::Deserialize(corrupt.data(), corrupt.size()))
+		failures.push_back("A cache with the wrong magic number was accepted");
+	corrupt = bytes;
+	WriteUInt(corrupt, 4, 2);
+	if (ShaderReflectionCache::Deserialize(corrupt.data(), corrupt.size()))
+		failures.push_back("A cache from another version was accepted");
+
+	// And through a file
+	filesystem::path file = filesystem::temp_directory_path() / "ShaderReflectionCacheTest.cache";
+	ShaderReflectionCache::Deserialize(bytes.data(), bytes.size());
+	if (!ShaderReflectionCache::Save(file.wstring()) || ShaderReflectionCache::IsDirty())
+		failures.push_back("Couldn't save the cache");
+	ShaderReflectionCache::Clear();
+	if (!ShaderReflectionCache::Load(file.wstring()) || !ShaderReflectionCache::Find(computeHash, found) || !Same(found, ComputeReflection()))
+		failures.push_back("The cache didn't round trip through a file");
+	filesystem::remove(file);
+
+	ShaderReflectionCache::Clear();
+	return failures;
+}
@@ -0,0 +1,238 @@
+#include "HeadlessTests.h"
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace std;
+
+namespace
+{
+	bool Overlap(const ShadowTile& a, const ShadowTile& b)
+	{
+		return a.X < b.X + b.Size && b.X < a.X + a.Size && a.Y < b.Y + b.Size && b.Y < a.Y + a.Size;
+	}
+
+	bool SameTiles(const vector<ShadowTile>& a, const vector<ShadowTile>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++)
+			if (a[i].X != b[i].X || a[i].Y != b[i].Y || a[i].Size != b[i].Size) return false;
+		return true;
+	}
+
+	// Every tile is in the atlas, on its own, and the counts add up - returns what's wrong
+	string Check(const ShadowAtlas& atlas, const vector<ShadowRequest>& requests, const vector<ShadowAllocation>& allocations)
+	{
+		if (allocations.size() != requests.size())
+			return "There isn't an allocation per request";
+
+		vector<ShadowTile> tiles;
+		unsigned int area = 0;
+		for (size_t i = 0; i < allocations.size(); i++)
+		{
+			const ShadowAllocation& allocation = allocations[i];
+			if (!allocation.Tiles.empty() && allocation.Tiles.size() != requests[i].Faces)
+				return "Light " + to_string(requests[i].Light) + " got " + to_string(allocation.Tiles.size()) + " of its " + to_string(requests[i].Faces) + " faces";
+			for (auto& tile : allocation.Tiles)
+			{
+				if (tile.Size != allocation.Size)
+					return "Light " + to_string(requests[i].Light) + "'s faces aren't all the same size";
+				if (tile.X % tile.Size != 0 || tile.Y % tile.Size != 0)
+					return "A tile isn't aligned to its size";
+				if (tile.X + tile.Size > atlas.GetSettings().Size || tile.Y + tile.Size > atlas.GetSettings().Size)
+					return "A tile runs off the atlas";
+				for (auto& other : tiles)
+					if (Overlap(tile, other)) return "Two tiles overlap";
+				tiles.push_back(tile);
+				area += tile.Size * tile.Size;
+			}
+		}
+		if (tiles.size() > ShadowAtlas::MaxTiles)
+			return "More tiles than the shader takes";
+		if (area != atlas.GetStats().UsedArea)
+			return "The used area doesn't add up";
+		return "";
+	}
+}
+
+vector<string> ShadowAtlasTests()
+{
+	vector<string> failures;
+	ShadowAtlasSettings settings;
+	auto fail = [&](const string& when, const string& what) {
+		if (!what.empty()) failures.push_back(when + ": " + what);
+	};
+
+	// Sizing: the screen's worth of light gets the largest tile, and a light
+	// near a boundary only moves once it's well past it
+	{
+		ShadowAtlas atlas(settings);
+		if (atlas.TileSize(1.0f, 0) != settings.MaxTileSize || atlas.TileSize(0.0001f, 0) != settings.MinTileSize || atlas.TileSize(0, 0) != 0)
+			failures.push_back("Tile sizes don't span the settings");
+		if (atlas.TileSize(0.5f, 0) != settings.MaxTileSize / 2)
+			failures.push_back("Half the screen isn't half the largest tile");
+		unsigned int middle = settings.MaxTileSize / 4;
+		float boundary = 1.5f * middle / settings.MaxTileSize;
+		if (atlas.TileSize(boundary * 1.1f, middle) != middle || atlas.TileSize(boundary / 1.1f, middle * 2) != middle * 2)
+			failures.push_back("Tiles change size as soon as they cross a boundary");
+		if (atlas.TileSize(boundary * 1.5f, middle) != middle * 2 || atlas.TileSize(boundary / 1.5f, middle * 2) != middle)
+			failures.push_back("Tiles never change size");
+		float previous = 0;
+		for (float importance = 0.001f; importance <= 1.0f; importance *= 1.1f)
+		{
+			float size = (float)atlas.TileSize(importance, 0);
+			if (size < previous)
+				failures.push_back("More important lights got smaller tiles");
+			previous = size;
+		}
+	}
+
+	// Two point lights and two spots: everyone gets what they want, and it stays put
+	vector<ShadowRequest> requests = { { 1, 1.0f, 6 }, { 2, 0.3f, 1 }, { 3, 0.05f, 6 }, { 4, 0.6f, 1 } };
+	ShadowAtlas atlas(settings);
+	vector<ShadowAllocation> first = atlas.Allocate(requests);
+	fail("First frame", Check(atlas, requests, first));
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		if (first[i].Size != atlas.TileSize(requests[i].Importance, 0))
+			failures.push_back("First frame: light " + to_string(requests[i].Light) + " didn't get the size it wanted");
+	}
+	if (atlas.GetStats().Placed != 4 || atlas.GetStats().Repacked)
+		failures.push_back("First frame: didn't just place everyone");
+
+	const vector<ShadowAllocation>& again = atlas.Allocate(requests);
+	fail("Same again", Check(atlas, requests, again));
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		if (again[i].Changed || !SameTiles(again[i].Tiles, first[i].Tiles))
+			failures.push_back("Same again: light " + to_string(requests[i].Light) + " moved");
+	}
+	if (atlas.GetStats().Kept != 4)
+		failures.push_back("Same again: not every light was kept");
+
+	// Importance wobbling as the camera moves doesn't move anything
+	for (int frame = 0; frame < 20; frame++)
+	{
+		vector<ShadowRequest> wobbled = requests;
+		for (auto& request : wobbled)
+			request.Importance *= frame % 2 ? 1.15f : 0.87f;
+		const vector<ShadowAllocation>& allocations = atlas.Allocate(wobbled);
+		fail("Wobbling", Check(atlas, wobbled, allocations));
+		for (size_t i = 0; i < allocations.size(); i++)
+			if (allocations[i].Changed) failures.push_back("Wobbling: light " + to_string(requests[i].Light) + " moved");
+	}
+
+	// A new light goes in a gap, and one light growing only moves that light
+	vector<ShadowRequest> added = requests;
+	added.push_back({ 5, 0.2f, 1 });
+	const vector<ShadowAllocation>& withNew = atlas.Allocate(added);
+	fail("New light", Check(atlas, added, withNew));
+	for (size_t i = 0; i < requests.size(); i++)
+		if (withNew[i].Changed) failures.push_back("New light: light " + to_string(requests[i].Light) + " moved for it");
+	if (withNew.back().Tiles.empty() || atlas.GetStats().Repacked)
+		failures.push_back("New light: didn't just go in a gap");
+
+	added[1].Importance = 0.9f;
+	const vector<ShadowAllocation>& grown = atlas.Allocate(added);
+	fail("Grown", Check(atlas, added, grown));
+	if (grown[1].Size != settings.MaxTileSize)
+		failures.push_back("Grown: the spot didn't get bigger");
+	for (size_t i = 0; i < added.size(); i++)
+		if (i != 1 && grown[i].Changed && !atlas.GetStats().Repacked) failures.push_back("Grown: light " + to_string(added[i].Light) + " moved");
+
+	// Lights leaving give back everything they had
+	atlas.Allocate({});
+	if (atlas.GetStats().UsedArea != 0 || atlas.LargestFree() != settings.Size)
+		failures.push_back("The atlas didn't merge back into one square when emptied");
+
+	// Too much to fit: the most important lights keep their size, the rest
+	// shrink or go without, and a more important light never ends up smaller
+	{
+		ShadowAtlasSettings small = settings;
+		small.Size = settings.MaxTileSize * 2;
+		ShadowAtlas crowded(small);
+		vector<ShadowRequest> crowd = { { 1, 0.9f, 6 }, { 2, 1.0f, 1 }, { 3, 0.8f, 1 }, { 4, 0.7f, 6 }, { 5, 0.75f, 1 } };
+		const vector<ShadowAllocation>& packed = crowded.Allocate(crowd);
+		fail("Crowded", Check(crowded, crowd, packed));
+		if (packed[1].Size != small.MaxTileSize)
+			failures.push_back("Crowded: the most important light was squeezed");
+		for (size_t a = 0; a < crowd.size(); a++)
+		{
+			for (size_t b = 0; b < crowd.size(); b++)
+			{
+				if (crowd[a].Importance > crowd[b].Importance && packed[a].Size < packed[b].Size)
+					failures.push_back("Crowded: light " + to_string(crowd[a].Light) + " got less than the less important light " + to_string(crowd[b].Light));
+			}
+		}
+
+		// Once the biggest two go, the ones that were squeezed get their size back
+		crowd.erase(crowd.begin(), crowd.begin() + 2);
+		const vector<ShadowAllocation>& roomier = crowded.Allocate(crowd);
+		fail("Uncrowded", Check(crowded, crowd, roomier));
+		for (size_t i = 0; i < crowd.size(); i++)
+		{
+			if (roomier[i].Size != crowded.TileSize(crowd[i].Importance, 0))
+				failures.push_back("Uncrowded: light " + to_string(crowd[i].Light) + " is still squeezed");
+		}
+
+		// Sixteen tiles at most, wherever the space is - the least important go without
+		vector<ShadowRequest> many;
+		for (unsigned int i = 0; i < 5; i++)
+			many.push_back({ 10 + i, 0.01f * (5 - i), 6 });
+		const vector<ShadowAllocation>& capped = crowded.Allocate(many);
+		fail("Capped", Check(crowded, many, capped));
+		if (capped[0].Tiles.empty() || capped[1].Tiles.empty() || !capped[2].Tiles.empty() || crowded.GetStats().Dropped != 3)
+			failures.push_back("Capped: the wrong lights went without");
+	}
+
+	// Filled with small lights, then left with one in each of the big squares,
+	// a big light still finds room (and the small ones keep theirs)
+	{
+		ShadowAtlasSettings small = settings;
+		small.Size = settings.MaxTileSize * 2;
+		ShadowAtlas fragmented(small);
+		vector<ShadowRequest> smalls;
+		for (unsigned int i = 0; i < ShadowAtlas::MaxTiles; i++)
+			smalls.push_back({ i, 0.5f, 1 });
+		fail("Filled", Check(fragmented, smalls, fragmented.Allocate(smalls)));
+		if (fragmented.GetStats().UsedArea != small.Size * small.Size)
+			failures.push_back("Filled: the small lights didn't fill the atlas");
+		vector<ShadowRequest> scattered;
+		for (unsigned int i = 0; i < ShadowAtlas::MaxTiles; i += 4)
+			scattered.push_back(smalls[i]);
+		fragmented.Allocate(scattered);
+		scattered.push_back({ 100, 1.0f, 1 });
+		const vector<ShadowAllocation>& big = fragmented.Allocate(scattered);
+		fail("Fragmented", Check(fragmented, scattered, big));
+		if (big.back().Size != small.MaxTileSize || !fragmented.GetStats().Repacked)
+			failures.push_back("Fragmented: the big light didn't get its size");
+		for (size_t i = 0; i + 1 < big.size(); i++)
+			if (big[i].Size != small.MaxTileSize / 2) failures.push_back("Fragmented: a small light lost its size");
+	}
+
+	// Random lights coming, going and changing importance - nothing ever overlaps
+	{
+		ShadowAtlas random(settings);
+		mt19937 generator(7);
+		uniform_real_distribution<float> unit(0.0f, 1.0f);
+		vector<ShadowRequest> live;
+		string problem;
+		for (int frame = 0; frame < 500 && problem.empty(); frame++)
+		{
+			if (unit(generator) < 0.2f && live.size() < 8)
+				live.push_back({ (unsigned int)frame, unit(generator) * unit(generator), unit(generator) < 0.5f ? 6u : 1u });
+			if (unit(generator) < 0.15f && !live.empty())
+				live.erase(live.begin() + (size_t)(unit(generator) * live.size()) % live.size());
+			for (auto& request : live)
+				request.Importance = min(max(request.Importance * (0.8f + 0.4f * unit(generator)), 0.0f), 1.0f);
+			problem = Check(random, live, random.Allocate(live));
+		}
+		fail("Random", problem);
+		random.Allocate({});
+		if (random.GetStats().UsedArea != 0 || random.LargestFree() != settings.Size)
+			failures.push_back("Random: the atlas didn't merge back into one square when emptied");
+	}
+	return failures;
+}
@@ -0,0 +1,127 @@
+#include "HeadlessTests.h"
+#include "ShadowCache.h"
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	// Like Game's scene: a floor, static props on it and two spinning dynamic casters
+	enum TestCaster { Floor, Cube, Sphere, Donut, Helix, TestCasterCount };
+	const ShadowCaster TestScene[] = {
+		{ XMFLOAT3(0, -12, 0), 14.2f },
+		{ XMFLOAT3(-3, -8, 0), 1.8f },
+		{ XMFLOAT3(3, -8, 0), 1.0f },
+		{ XMFLOAT3(-6, -8, 0), 1.5f },
+		{ XMFLOAT3(6, -8, 0), 2.0f },
+	};
+
+	vector<ShadowCascade> Cascades(const vector<ShadowCaster>& casters, XMFLOAT3 lightDirection)
+	{
+		XMFLOAT4X4 view, projection;
+		XMStoreFloat4x4(&view, XMMatrixLookToLH(XMVectorSet(0, 0, -20, 1), XMVectorSet(0, -0.3f, 1, 0), XMVectorSet(0, 1, 0, 0)));
+		XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f));
+		vector<ShadowCascade> cascades = CascadedShadows::Build(view, projection, lightDirection, CascadeSettings());
+		CascadedShadows::Cull(cascades, view, projection, casters);
+		return cascades;
+	}
+
+	bool Holds(const vector<unsigned int>& casters, unsigned int caster)
+	{
+		for (unsigned int held : casters)
+			if (held == caster) return true;
+		return false;
+	}
+}
+
+vector<string> ShadowCacheTests()
+{
+	vector<string> failures;
+	ShadowCache cache;
+	vector<ShadowCaster> scene(begin(TestScene), end(TestScene));
+	vector<bool> dynamic(TestCasterCount, false);
+	dynamic[Donut] = dynamic[Helix] = true;
+	vector<bool> still(TestCasterCount, false);
+	XMFLOAT3 light = XMFLOAT3(1, -1, 1);
+
+	// Runs one frame, returning each cascade's action
+	auto frame = [&](const vector<ShadowCascade>& cascades, const vector<bool>& moved, bool force = false) {
+		vector<ShadowCacheAction> actions;
+		for (unsigned int i = 0; i < cascades.size(); i++)
+		{
+			const ShadowCachePlan& plan = cache.Plan(i, cascades[i], dynamic, moved, force);
+			actions.push_back(plan.Action);
+
+			// Every caster lands in exactly one list, the right one
+			if (plan.StaticCasters.size() + plan.DynamicCasters.size() != cascades[i].Casters.size())
+				failures.push_back("Cascade " + to_string(i) + "'s casters weren't all split");
+			for (unsigned int caster : plan.StaticCasters)
+				if (dynamic[caster]) failures.push_back("A dynamic caster was put in the static cache");
+			for (unsigned int caster : plan.DynamicCasters)
+				if (!dynamic[caster]) failures.push_back("A static caster was drawn every frame");
+		}
+		return actions;
+	};
+	auto expect = [&](const char* name, const vector<ShadowCacheAction>& actions, const vector<ShadowCascade>& cascades, ShadowCacheAction withCaster, ShadowCacheAction without, int caster) {
+		for (size_t i = 0; i < actions.size(); i++)
+		{
+			ShadowCacheAction expected = caster >= 0 && Holds(cascades[i].Casters, caster) ? withCaster : without;
+			if (actions[i] != expected)
+				failures.push_back(string(name) + ": cascade " + to_string(i) + " did " + to_string((int)actions[i]) + ", not " + to_string((int)expected));
+		}
+	};
+
+	// The first frame builds everything, then a still frame does nothing
+	vector<ShadowCascade> cascades = Cascades(scene, light);
+	expect("First frame", frame(cascades, still), cascades, ShadowCacheAction::Rebuild, ShadowCacheAction::Rebuild, -1);
+	expect("Nothing moved", frame(cascades, still), cascades, ShadowCacheAction::Keep, ShadowCacheAction::Keep, -1);
+
+	// The donut turning only overlays where it casts, and the cache stays
+	bool donutCasts = false;
+	for (auto& cascade : cascades)
+		donutCasts = donutCasts || Holds(cascade.Casters, Donut);
+	if (!donutCasts)
+		failures.push_back("The test scene's donut doesn't cast into any cascade");
+	vector<bool> donutMoved = still;
+	donutMoved[Donut] = true;
+	expect("Donut turned", frame(cascades, donutMoved), cascades, ShadowCacheAction::Overlay, ShadowCacheAction::Keep, Donut);
+	expect("Donut stopped", frame(cascades, still), cascades, ShadowCacheAction::Keep, ShadowCacheAction::Keep, -1);
+
+	// A static prop being edited rebuilds the cache it's in
+	vector<bool> cubeMoved = still;
+	cubeMoved[Cube] = true;
+	expect("Cube moved", frame(cascades, cubeMoved), cascades, ShadowCacheAction::Rebuild, ShadowCacheAction::Keep, Cube);
+
+	// The light turning rebuilds every cascade with anything in it
+	vector<ShadowCascade> turned = Cascades(scene, XMFLOAT3(1.2f, -1, 1));
+	expect("Light turned", frame(turned, still), turned, ShadowCacheAction::Rebuild, ShadowCacheAction::Rebuild, -1);
+	frame(turned, still);
+
+	// A dynamic caster leaving a cascade has to be drawn out of it - an overlay, not a rebuild
+	vector<ShadowCaster> gone = scene;
+	gone[Helix].Center.y = -100;
+	vector<ShadowCascade> helixGone = Cascades(gone, XMFLOAT3(1.2f, -1, 1));
+	vector<bool> helixMoved = still;
+	helixMoved[Helix] = true;
+	vector<ShadowCacheAction> actions = frame(helixGone, helixMoved);
+	for (size_t i = 0; i < actions.size(); i++)
+	{
+		bool held = Holds(turned[i].Casters, Helix);
+		if (Holds(helixGone[i].Casters, Helix))
+			failures.push_back("The helix is still cast into cascade " + to_string(i) + " from under the floor");
+		else if (held && actions[i] != ShadowCacheAction::Overlay)
+			failures.push_back("The helix left cascade " + to_string(i) + " without an overlay");
+		else if (!held && actions[i] != ShadowCacheAction::Keep)
+			failures.push_back("Cascade " + to_string(i) + " changed when the helix left another");
+	}
+
+	// Forcing and invalidating both rebuild, and each plan is counted once
+	expect("Forced", frame(helixGone, still, true), helixGone, ShadowCacheAction::Rebuild, ShadowCacheAction::Rebuild, -1);
+	cache.Invalidate();
+	cache.ResetStats();
+	expect("Invalidated", frame(helixGone, still), helixGone, ShadowCacheAction::Rebuild, ShadowCacheAction::Rebuild, -1);
+	frame(helixGone, still);
+	if (cache.GetStats().Rebuilt != helixGone.size() || cache.GetStats().Kept != helixGone.size() || cache.GetStats().Overlaid != 0)
+		failures.push_back("The cache's counts don't match its plans");
+	return failures;
+}
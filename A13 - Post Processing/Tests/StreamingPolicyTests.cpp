@@ -0,0 +1,202 @@
+#include "HeadlessTests.h"
+#include "StreamingPolicy.h"
+#include "CameraPath.h"
+#include "Transform.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const unsigned int TextureWidth = 1024;
+	const int MipCount = 11;
+	const unsigned int TailSize = 64;
+
+	// A full RGBA8 chain with only its tail resident, like a freshly
+	// registered TextureStreamer entry
+	StreamingTexture TestTexture()
+	{
+		StreamingTexture texture;
+		texture.Width = TextureWidth;
+		for (int mip = 0; mip < MipCount; mip++)
+		{
+			size_t size = max(TextureWidth >> mip, 1u);
+			texture.MipBytes.push_back(size * size * 4);
+		}
+		texture.TailMip = StreamingPolicy::TailMipFor(TextureWidth, MipCount, TailSize);
+		texture.ResidentMip = texture.TailMip;
+		return texture;
+	}
+
+	size_t TailBytes(const vector<StreamingTexture>& textures)
+	{
+		size_t bytes = 0;
+		for (auto& texture : textures)
+			for (int mip = texture.TailMip; mip < (int)texture.MipBytes.size(); mip++)
+				bytes += texture.MipBytes[mip];
+		return bytes;
+	}
+
+	StreamingObject TestObject(XMFLOAT3 center, float radius, int texture)
+	{
+		StreamingObject object;
+		object.Center = center;
+		object.Radius = radius;
+		object.WorldUnitsPerUv = 4;
+		object.Textures.push_back(texture);
+		return object;
+	}
+
+	// The same view Game::GetStreamingCamera builds from a Camera
+	StreamingCamera ToStreamingCamera(const CameraKey& key)
+	{
+		Transform transform;
+		transform.SetPosition(key.Position);
+		transform.SetRotation(key.Rotation);
+
+		StreamingCamera camera;
+		camera.Position = transform.GetPosition();
+		camera.Forward = transform.GetForward();
+		camera.VerticalFov = key.Fov;
+		camera.IsOrthographic = key.IsOrthographic;
+		return camera;
+	}
+
+	// Objects at increasing distance straight ahead of a camera at the origin,
+	// so index order is priority order
+	vector<StreamingObject> ObjectsAhead(const vector<float>& distances)
+	{
+		vector<StreamingObject> objects;
+		for (size_t i = 0; i < distances.size(); i++)
+			objects.push_back(TestObject(XMFLOAT3(0, 0, distances[i]), 1, (int)i));
+		return objects;
+	}
+}
+
+vector<string> StreamingPolicyTests()
+{
+	vector<string> failures;
+
+	// Along the scene's camera path the plan never goes over budget, tails
+	// are never given up, and more needed textures are never served worse
+	{
+		vector<StreamingObject> objects;
+		for (int x = -2; x <= 2; x++)
+			for (int z = 0; z < 3; z++)
+				objects.push_back(TestObject(XMFLOAT3(x * 3.0f, -2.0f, z * 8.0f), 1.5f, (int)objects.size()));
+		vector<StreamingTexture> textures(objects.size(), TestTexture());
+
+		vector<CameraKey> keys = CameraPath::SceneCameras();
+		vector<StreamingCamera> path;
+		for (int frame = 0; frame < 180; frame++)
+			path.push_back(ToStreamingCamera(CameraPath::Sample(keys, frame / 30.0f, 2.0f)));
+
+		size_t budget = TailBytes(textures) + 3 * 1024 * 1024;
+
+		vector<StreamingTexture> replay = textures;
+		for (size_t frame = 0; frame < path.size(); frame++)
+		{
+			StreamingPlan plan = StreamingPolicy::Plan(replay, objects, path[frame], budget);
+			if (plan.TargetBytes > budget)
+			{
+				failures.push_back("Frame " + to_string(frame) + " planned " + to_string(plan.TargetBytes) + " bytes against a budget of " + to_string(budget));
+				break;
+			}
+			for (size_t t = 0; t < replay.size(); t++)
+			{
+				if (plan.TargetMip[t] > replay[t].TailMip)
+				{
+					failures.push_back("Frame " + to_string(frame) + " dropped texture " + to_string(t) + " below its mip tail");
+					break;
+				}
+				replay[t].ResidentMip = plan.TargetMip[t];
+			}
+		}
+
+		StreamingSimulationResult result = StreamingPolicy::Simulate(textures, objects, path, budget);
+		printf("  %d frames: peak %zu of %zu bytes, %d uploads, %d evictions, %.2f average mip deficit\n",
+			result.Frames, result.PeakBytes, budget, result.Uploads, result.Evictions, result.AverageMipDeficit);
+		if (result.FramesOverBudget > 0 || result.PeakBytes > budget)
+			failures.push_back("Simulating the camera path went over budget on " + to_string(result.FramesOverBudget) + " frames");
+		if (result.Inversions > 0)
+			failures.push_back("Simulating the camera path served a less needed texture first on " + to_string(result.Inversions) + " frames");
+		if (result.Uploads == 0 || result.Evictions == 0)
+			failures.push_back("The camera path never streamed anything in and out, so it isn't testing the budget");
+	}
+
+	// Nearer objects get detail first, and never end up coarser than farther ones
+	{
+		vector<StreamingObject> objects = ObjectsAhead({ 4, 8, 16, 32 });
+		vector<StreamingTexture> textures(objects.size(), TestTexture());
+		StreamingCamera camera;
+
+		StreamingPlan plan = StreamingPolicy::Plan(textures, objects, camera, TailBytes(textures) + 1024 * 1024);
+		if (plan.UploadOrder.empty() || plan.UploadOrder[0] != 0)
+			failures.push_back("The nearest object's texture wasn't the first upload");
+		for (size_t t = 1; t < textures.size(); t++)
+		{
+			if (plan.TargetMip[t] < plan.TargetMip[t - 1])
+				failures.push_back("The object at distance " + to_string((int)objects[t].Center.z) + " got finer mips than a nearer one");
+		}
+		if (plan.TargetMip.front() >= plan.TargetMip.back())
+			failures.push_back("A tight budget didn't favour the nearest object over the farthest");
+	}
+
+	// When distance doesn't separate them, the object covering more of the screen goes first
+	{
+		vector<StreamingObject> objects = { TestObject(XMFLOAT3(-4, 0, 10), 1, 0), TestObject(XMFLOAT3(4, 0, 10), 3, 1) };
+		vector<StreamingTexture> textures(objects.size(), TestTexture());
+		StreamingCamera camera;
+		camera.IsOrthographic = true;
+		camera.OrthographicHeight = 8;
+
+		const StreamingTexture& texture = textures[0];
+		StreamingPlan plan = StreamingPolicy::Plan(textures, objects, camera, TailBytes(textures) + texture.MipBytes[texture.TailMip - 1]);
+		if (plan.UploadOrder.size() != 1 || plan.UploadOrder[0] != 1 || plan.TargetMip[1] >= plan.TargetMip[0])
+			failures.push_back("Room for one more level didn't go to the object covering more of the screen");
+	}
+
+	// Shrinking the budget evicts the least needed levels first and leaves every tail
+	{
+		vector<StreamingObject> objects = ObjectsAhead({ 4, 8, 16 });
+		objects.push_back(TestObject(XMFLOAT3(0, 0, -10), 1, 3));	// Behind the camera
+		vector<StreamingTexture> textures(objects.size(), TestTexture());
+		for (auto& texture : textures)
+			texture.ResidentMip = 0;
+		StreamingCamera camera;
+
+		// With everything resident, the first level to go is the unseen texture's finest
+		StreamingPlan full = StreamingPolicy::Plan(textures, objects, camera, SIZE_MAX);
+		StreamingPlan first = StreamingPolicy::Plan(textures, objects, camera, full.TargetBytes - 1);
+		if (first.TargetMip != vector<int>{ 0, 0, 0, 1 })
+			failures.push_back("Running one byte short didn't evict the unseen texture's finest level first");
+
+		for (size_t budget = full.TargetBytes; ; budget = budget * 3 / 4)
+		{
+			StreamingPlan plan = StreamingPolicy::Plan(textures, objects, camera, budget);
+			for (size_t t = 0; t < textures.size(); t++)
+			{
+				if (plan.TargetMip[t] > textures[t].TailMip)
+					failures.push_back("A budget of " + to_string(budget) + " evicted part of texture " + to_string(t) + "'s mip tail");
+			}
+			if (plan.TargetBytes > max(budget, TailBytes(textures)))
+				failures.push_back("Evicting down to a budget of " + to_string(budget) + " still kept " + to_string(plan.TargetBytes) + " bytes");
+			for (size_t t = 1; t < 3; t++)
+			{
+				if (plan.TargetMip[t] < plan.TargetMip[t - 1])
+					failures.push_back("A budget of " + to_string(budget) + " kept more of a farther object's texture than a nearer one's");
+			}
+			if (!failures.empty() || plan.TargetBytes <= TailBytes(textures))
+				break;
+		}
+		// Tails stay even when they alone don't fit
+		StreamingPlan none = StreamingPolicy::Plan(textures, objects, camera, 0);
+		if (none.TargetMip != vector<int>(textures.size(), textures[0].TailMip))
+			failures.push_back("A budget too small for the tails didn't leave exactly the tails resident");
+	}
+
+	return failures;
+}
@@ -0,0 +1,74 @@
+#include "HeadlessTests.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+using namespace std;
+
+namespace
+{
+	struct HeadlessTest
+	{
+		const char* Name;
+		vector<string> (*Run)();
+	};
+
+	const HeadlessTest tests[] =
+	{
+		{ "ShaderReflectionCache", ShaderReflectionCacheTests },
+		{ "ShaderIncludeGraph", ShaderIncludeGraphTests },
+		{ "MipGenerator", MipGeneratorTests },
+		{ "BlockCompression", BlockCompressionTests },
+		{ "OrmPacker", OrmPackerTests },
+		{ "RenderStateCache", RenderStateCacheTests },
+		{ "CommandListSubmitter", CommandListSubmitterTests },
+		{ "Profiler", ProfilerTests },
+		{ "GpuTimerRing", GpuTimerRingTests },
+		{ "DualFilterBlur", DualFilterBlurTests },
+		{ "TiledPostProcess", TiledPostProcessTests },
+		{ "PostEffects", PostEffectsTests },
+		{ "AutoExposure", AutoExposureTests },
+		{ "CascadedShadows", CascadedShadowsTests },
+		{ "ShadowCache", ShadowCacheTests },
+		{ "ShadowAtlas", ShadowAtlasTests },
+		{ "LocalShadows", LocalShadowsTests },
+		{ "StreamingPolicy", StreamingPolicyTests },
+		{ "BindingTable", BindingTableTests },
+		{ "MaterialRegistry", MaterialRegistryTests },
+		{ "GaussianBlur", GaussianBlurTests },
+		{ "PostProcessGraph", PostProcessGraphTests },
+	};
+}
+
+// --------------------------------------------------------
+// Gets a path to a file in the project's Assets folder,
+// which CMakeLists.txt passes in as ASSET_DIRECTORY
+// --------------------------------------------------------
+wstring AssetPath(const wstring& relativeFilePath)
+{
+	return (filesystem::path(ASSET_DIRECTORY) / relativeFilePath).wstring();
+}
+
+// --------------------------------------------------------
+// Runs every test, or just the ones named on the command
+// line, and returns how many failed
+// --------------------------------------------------------
+int main(int argc, char** argv)
+{
+	int failed = 0;
+	for (const HeadlessTest& test : tests)
+	{
+		bool named = argc < 2;
+		for (int i = 1; i < argc; i++)
+			named = named || strcmp(argv[i], test.Name) == 0;
+		if (!named) continue;
+
+		vector<string> failures = test.Run();
+		printf("%s: %s\n", test.Name, failures.empty() ? "passed" : "FAILED");
+		for (const string& failure : failures)
+			printf("  %s\n", failure.c_str());
+		if (!failures.empty()) failed++;
+	}
+	return failed;
+}
@@ -0,0 +1,89 @@
+#include "HeadlessTests.h"
+#include "TiledPostProcess.h"
+#include "DualFilterBlur.h"
+#include "GaussianBlur.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+using namespace std;
+
+vector<string> TiledPostProcessTests()
+{
+	vector<string> failures;
+
+	// The widest apron has to fit in D3D11's 32KB of groupshared memory
+	if (TiledPostProcess::SharedBytes(TiledPostProcess::MaxApron) > 32768)
+		failures.push_back("A group at the widest apron needs " + to_string(TiledPostProcess::SharedBytes(TiledPostProcess::MaxApron)) + " bytes of shared memory");
+	if ((int)GaussianBlur::Weights(64).size() - 1 > TiledPostProcess::MaxApron)
+		failures.push_back("GaussianBlur's widest kernel needs more apron than MaxApron");
+
+	// The dispatch emulated tile by tile against the pixel shader passes, on a
+	// corner of the sample albedo that isn't a whole number of tiles either way
+	DecodedImage image;
+	string error;
+	if (!PngDecoder::DecodeFile(AssetPath(L"Textures/cobblestone/albedo.png"), image, &error))
+	{
+		failures.push_back("Couldn't load the sample albedo: " + error);
+		return failures;
+	}
+
+	// The image stands in for the HDR scene as is (alpha 1, like the scene's,
+	// since the packing doesn't keep it)
+	const unsigned int width = min(image.Width, 200u), height = min(image.Height, 150u);
+	size_t count = (size_t)width * height * 4;
+	vector<float> source(count), tiled(count), reference(count);
+	for (unsigned int y = 0; y < height; y++)
+		for (unsigned int x = 0; x < width * 4; x++)
+			source[(size_t)y * width * 4 + x] = (x % 4 == 3) ? 1.0f : image.Pixels[(size_t)y * image.Width * 4 + x] / 255.0f;
+
+	auto milliseconds = [](chrono::steady_clock::time_point start) {
+		return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	};
+
+	// Just the tonemap, the default effects (inverted) and every effect at once
+	PostEffectSettings tonemapOnly, defaults, everything;
+	tonemapOnly.Invert = false;
+	everything.ColorGrade = true;
+	everything.Saturation = 1.4f;
+	everything.Contrast = 1.2f;
+	everything.Tint = true;
+	everything.TintColor = { 1.0f, 0.8f, 0.6f };
+	everything.Gamma = true;
+	everything.GammaValue = 1.6f;
+	everything.Vignette = true;
+	everything.VignetteStrength = 0.7f;
+	everything.VignetteRadius = 0.3f;
+	struct Case { const char* Name; PostEffectSettings Effects; };
+	const Case cases[] = { { "tonemap only", tonemapOnly }, { "defaults", defaults }, { "every effect", everything } };
+	if (PostPermutations::BuildKey(everything) != (1u << PostEffectCount) - 1)
+		failures.push_back("The every effect case doesn't turn every effect on");
+
+	for (float radius : { 1.0f, 6.0f, 64.0f })
+	{
+		for (const Case& test : cases)
+		{
+			const PostEffectSettings& effects = test.Effects;
+
+			auto start = chrono::steady_clock::now();
+			TiledPostProcess::Reference(source.data(), width, height, reference.data(), radius, effects);
+			double referenceMilliseconds = milliseconds(start);
+			start = chrono::steady_clock::now();
+			TiledPostProcess::Run(source.data(), width, height, tiled.data(), GaussianBlur::Weights(radius), effects);
+			double tiledMilliseconds = milliseconds(start);
+
+			// Shared memory holds R11G11B10 (5 or 6 mantissa bits) and the pixel passes
+			// a 16 bit float target, and the encode stretches dark values, so the two
+			// can round a few codes apart - but rarely
+			ImageDifference difference = DualFilterBlur::Compare(reference.data(), tiled.data(), count);
+			if (&test == &cases[1])
+				printf("  Radius %.0f: max difference %.0f/255, %.1f dB PSNR, tiled %.1f ms, pixel passes %.1f ms\n",
+					radius, difference.MaxDifference * 255.0f, difference.PeakSignalToNoise, tiledMilliseconds, referenceMilliseconds);
+			if (difference.MaxDifference * 255.0f > 3.5f || difference.PeakSignalToNoise < 46)
+				failures.push_back("At radius " + to_string(radius) + ", " + test.Name + ", the tiled path is " +
+					to_string(difference.MaxDifference * 255.0f) + "/255 (" + to_string(difference.PeakSignalToNoise) + " dB) off the pixel passes");
+		}
+	}
+	return failures;
+}
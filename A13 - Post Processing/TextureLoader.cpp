@@ -0,0 +1,597 @@
+#include "TextureLoader.h"
+#include "Graphics.h"
+#include "PngDecoder.h"
+#include "DdsFile.h"
+#include "OrmPacker.h"
+#include "TextureStreamer.h"
+#include "PathHelpers.h"
+#include "WICTextureLoader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+using namespace DirectX;
+using namespace std;
+
+AsyncTexture::AsyncTexture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> placeholder) :
+	srv(placeholder),
+	ready(false)
+{
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AsyncTexture::GetSRV() const { return srv; }
+bool AsyncTexture::IsReady() const { return ready; }
+
+void AsyncTexture::Resolve(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+{
+	this->srv = srv;
+	ready = true;
+}
+
+namespace TextureLoader
+{
+	// Annonymous namespace to hold the pool and the queues
+	// passing work between it and the main thread
+	namespace
+	{
+		// One queued load - a single 2D texture, all six faces of a cube,
+		// or the three maps baked into one ORM texture
+		struct LoadRequest
+		{
+			vector<wstring> files;
+			vector<TextureData> data;	// Full mip chain per file (just one for ORM)
+			vector<char> decoded;	// Not vector<bool>, as each face is written by a different worker
+			atomic<int> remaining;
+			bool isCube = false;
+			bool isOrm = false;
+			MipColorSpace colorSpace = MipColorSpace::Linear;
+			BlockFormat format = BlockFormat::None;
+			unsigned int placeholderColor = 0;
+			shared_ptr<AsyncTexture> texture;
+		};
+
+		// Worker pool
+		vector<thread> workers;
+		deque<function<void()>> jobs;
+		mutex jobMutex;
+		condition_variable jobAvailable;
+		bool stopping = false;
+
+		// Decoded requests waiting for the main thread
+		deque<shared_ptr<LoadRequest>> completed;
+		mutex completedMutex;
+		condition_variable completedAvailable;
+
+		// Where compressed chains are cached - set before any loads are queued
+		wstring cacheDirectory;
+
+		// Bump to invalidate every cached file when the compressors change
+		const unsigned int CacheVersion = 1;
+
+		// Failures, from the workers and the main thread, for the UI
+		vector<string> errors;
+		mutex errorMutex;
+
+		void ReportError(const string& error)
+		{
+			lock_guard<mutex> lock(errorMutex);
+			errors.push_back(error);
+		}
+
+		// Main thread only
+		int pendingCount = 0;
+		unordered_map<unsigned int, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> placeholders;
+		unordered_map<unsigned int, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> cubePlaceholders;
+
+		void WorkerLoop()
+		{
+			while (true)
+			{
+				function<void()> job;
+				{
+					unique_lock<mutex> lock(jobMutex);
+					jobAvailable.wait(lock, [] { return stopping || !jobs.empty(); });
+					if (stopping && jobs.empty()) return;
+
+					job = move(jobs.front());
+					jobs.pop_front();
+				}
+				job();
+			}
+		}
+
+		// Runs inline if the pool was never started, so loading still works (just not in parallel)
+		void Enqueue(function<void()> job)
+		{
+			if (workers.empty())
+			{
+				job();
+				return;
+			}
+
+			{
+				lock_guard<mutex> lock(jobMutex);
+				jobs.push_back(move(job));
+			}
+			jobAvailable.notify_one();
+		}
+
+		// --------------------------------------------------------
+		// Cache files are named by a hash of everything that affects
+		// their contents, so an edited source (or different settings)
+		// simply misses instead of needing to be invalidated
+		// --------------------------------------------------------
+		wstring CacheFile(const wstring* files, int count, MipColorSpace colorSpace, BlockFormat format)
+		{
+			if (cacheDirectory.empty() || format == BlockFormat::None)
+				return L"";
+
+			unsigned long long hash = 14695981039346656037ull;
+			auto mix = [&](const void* data, size_t bytes) {
+				for (size_t i = 0; i < bytes; i++)
+				{
+					hash ^= ((const unsigned char*)data)[i];
+					hash *= 1099511628211ull;
+				}
+			};
+
+			// Empty paths are skipped ORM maps, which still change the result
+			for (int i = 0; i < count; i++)
+			{
+				const wstring& file = files[i];
+				mix(file.data(), file.size() * sizeof(wchar_t));
+				mix(&i, sizeof(i));
+				if (file.empty()) continue;
+
+				error_code error;
+				unsigned long long size = filesystem::file_size(file, error);
+				if (error) return L"";
+				long long time = filesystem::last_write_time(file, error).time_since_epoch().count();
+				if (error) return L"";
+				mix(&size, sizeof(size));
+				mix(&time, sizeof(time));
+			}
+			mix(&colorSpace, sizeof(colorSpace));
+			mix(&format, sizeof(format));
+			mix(&CacheVersion, sizeof(CacheVersion));
+
+			wchar_t name[32];
+			swprintf(name, 32, L"%016llx.dds", hash);
+			return cacheDirectory + name;
+		}
+
+		// Compresses every level of a chain, or passes it through as RGBA8 if
+		// compression is off or the top level isn't a whole number of blocks
+		TextureData BuildTexture(vector<DecodedImage>& chain, BlockFormat format)
+		{
+			if (chain[0].Width % 4 != 0 || chain[0].Height % 4 != 0)
+				format = BlockFormat::None;
+
+			TextureData texture;
+			texture.Format = BlockCompression::GetDxgiFormat(format);
+			for (auto& image : chain)
+			{
+				if (format != BlockFormat::None)
+				{
+					texture.Levels.push_back(BlockCompression::Compress(image, format));
+					continue;
+				}
+
+				TextureLevel level;
+				level.Width = image.Width;
+				level.Height = image.Height;
+				level.RowPitch = image.Width * 4;
+				level.Bytes = move(image.Pixels);
+				texture.Levels.push_back(move(level));
+			}
+			return texture;
+		}
+
+		// A chain of a single color, matching another texture's layout.
+		// One block is encoded and then repeated, as every block is the same
+		TextureData SolidTexture(unsigned int color, const TextureData& match, BlockFormat format)
+		{
+			DecodedImage block;
+			block.Width = 4;
+			block.Height = 4;
+			block.Pixels.resize(64);
+			for (int i = 0; i < 16; i++)
+				memcpy(&block.Pixels[i * 4], &color, 4);
+
+			bool compressed = match.Format != DXGI_FORMAT_R8G8B8A8_UNORM;
+			vector<unsigned char> unit = compressed ? BlockCompression::Compress(block, format).Bytes : vector<unsigned char>(block.Pixels.begin(), block.Pixels.begin() + 4);
+
+			TextureData texture;
+			texture.Format = match.Format;
+			for (auto& m : match.Levels)
+			{
+				TextureLevel level;
+				level.Width = m.Width;
+				level.Height = m.Height;
+				level.RowPitch = m.RowPitch;
+				level.Bytes.resize(m.Bytes.size());
+				for (size_t offset = 0; offset < level.Bytes.size(); offset += unit.size())
+					memcpy(&level.Bytes[offset], unit.data(), unit.size());
+				texture.Levels.push_back(move(level));
+			}
+			return texture;
+		}
+
+		// Gives a cube's missing (or mismatched) faces a solid color, so
+		// the upload never has to deal with holes.  The first good face
+		// sets the size and format the rest must match
+		void FinishCube(LoadRequest& request)
+		{
+			int first = -1;
+			for (int i = 0; i < 6 && first < 0; i++)
+				if (request.decoded[i]) first = i;
+			if (first < 0)
+				return;
+
+			const TextureData& reference = request.data[first];
+			for (int face = 0; face < 6; face++)
+			{
+				const TextureData& data = request.data[face];
+				bool usable = request.decoded[face] &&
+					data.Format == reference.Format &&
+					data.Levels.size() == reference.Levels.size() &&
+					data.Levels[0].Width == reference.Levels[0].Width &&
+					data.Levels[0].Height == reference.Levels[0].Height;
+				if (usable) continue;
+
+				ReportError("Cube face " + WideToNarrow(request.files[face]) + " is missing or doesn't match the others, using a solid color");
+				request.data[face] = SolidTexture(request.placeholderColor, reference, request.format);
+				request.decoded[face] = 1;
+			}
+		}
+
+		// --------------------------------------------------------
+		// Loads a single image of a request: straight from the DDS
+		// cache if possible, otherwise decode, build mips, compress
+		// and write the cache.  The request goes to the main thread
+		// once its last image is finished.
+		// --------------------------------------------------------
+		void LoadJob(shared_ptr<LoadRequest> request, int index)
+		{
+			const wstring& file = request->files[index];
+			wstring cacheFile = request->isOrm ?
+				CacheFile(request->files.data(), 3, request->colorSpace, request->format) :
+				CacheFile(&file, 1, request->colorSpace, request->format);
+
+			if (!cacheFile.empty() && DdsFile::Load(cacheFile, request->data[index]))
+			{
+				request->decoded[index] = 1;
+			}
+			else
+			{
+				// ORM maps are baked into one image before anything else happens
+				DecodedImage image;
+				string error;
+				bool decoded = request->isOrm ?
+					OrmPacker::PackFiles(request->files[0], request->files[1], request->files[2], image, &error) :
+					PngDecoder::DecodeFile(file, image);
+				if (request->isOrm && !decoded)
+					ReportError("Failed to bake ORM texture: " + error);
+
+				if (decoded)
+				{
+					// Cube faces clamp, as their edges meet other faces rather than wrapping
+					vector<DecodedImage> chain = MipGenerator::Generate(move(image), request->colorSpace, MipFilter::Box, !request->isCube);
+					request->data[index] = BuildTexture(chain, request->format);
+					request->decoded[index] = 1;
+
+					if (!cacheFile.empty() && request->data[index].Format != DXGI_FORMAT_R8G8B8A8_UNORM)
+						DdsFile::Save(cacheFile, request->data[index]);
+				}
+			}
+
+			if (--request->remaining == 0)
+			{
+				if (request->isCube)
+					FinishCube(*request);
+
+				{
+					lock_guard<mutex> lock(completedMutex);
+					completed.push_back(request);
+				}
+				completedAvailable.notify_all();
+			}
+		}
+
+		shared_ptr<LoadRequest> Submit(const wstring* files, int count, bool isCube, bool isOrm, MipColorSpace colorSpace, BlockFormat format, unsigned int placeholderColor, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> placeholder)
+		{
+			// The three ORM maps make a single texture, so they're one job
+			int jobs = isOrm ? 1 : count;
+
+			shared_ptr<LoadRequest> request = make_shared<LoadRequest>();
+			request->files.assign(files, files + count);
+			request->data.resize(jobs);
+			request->decoded.resize(jobs, 0);
+			request->remaining = jobs;
+			request->isCube = isCube;
+			request->isOrm = isOrm;
+			request->colorSpace = colorSpace;
+			request->format = format;
+			request->placeholderColor = placeholderColor;
+			request->texture = make_shared<AsyncTexture>(placeholder);
+			pendingCount++;
+
+			for (int i = 0; i < jobs; i++)
+				Enqueue([request, i]() { LoadJob(request, i); });
+
+			return request;
+		}
+
+		// 1x1 texture (or cube) filled with a single color, shared by every load using that color
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetPlaceholder(unsigned int color, bool isCube)
+		{
+			auto& cache = isCube ? cubePlaceholders : placeholders;
+			auto it = cache.find(color);
+			if (it != cache.end())
+				return it->second;
+
+			D3D11_TEXTURE2D_DESC desc = {};
+			desc.Width = 1;
+			desc.Height = 1;
+			desc.MipLevels = 1;
+			desc.ArraySize = isCube ? 6 : 1;
+			desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			desc.SampleDesc.Count = 1;
+			desc.Usage = D3D11_USAGE_IMMUTABLE;
+			desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+			desc.MiscFlags = isCube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+			D3D11_SUBRESOURCE_DATA data[6] = {};
+			for (int i = 0; i < 6; i++)
+			{
+				data[i].pSysMem = &color;
+				data[i].SysMemPitch = sizeof(color);
+			}
+
+			Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+			Graphics::Device->CreateTexture2D(&desc, data, texture.GetAddressOf());
+			if (texture)
+			{
+				// A default view of a 6 element array is a Texture2DArray, so cubes need to ask
+				D3D11_SHADER_RESOURCE_VIEW_DESC cubeDesc = {};
+				cubeDesc.Format = desc.Format;
+				cubeDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+				cubeDesc.TextureCube.MipLevels = 1;
+				Graphics::Device->CreateShaderResourceView(texture.Get(), isCube ? &cubeDesc : 0, srv.GetAddressOf());
+			}
+
+			cache.insert({ color, srv });
+			return srv;
+		}
+
+		// Builds the cube from all six faces (and all their mips) at once.
+		// FinishCube has already made sure every face matches
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> UploadCube(const LoadRequest& request)
+		{
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+			if (!request.decoded[0])
+				return srv;
+
+			const TextureData& reference = request.data[0];
+			unsigned int mips = (unsigned int)reference.Levels.size();
+
+			vector<D3D11_SUBRESOURCE_DATA> data((size_t)6 * mips);
+			for (int face = 0; face < 6; face++)
+			{
+				for (unsigned int mip = 0; mip < mips; mip++)
+				{
+					const TextureLevel& level = request.data[face].Levels[mip];
+					D3D11_SUBRESOURCE_DATA& d = data[D3D11CalcSubresource(mip, face, mips)];
+					d.pSysMem = level.Bytes.data();
+					d.SysMemPitch = level.RowPitch;
+				}
+			}
+
+			D3D11_TEXTURE2D_DESC desc = {};
+			desc.Width = reference.Levels[0].Width;
+			desc.Height = reference.Levels[0].Height;
+			desc.MipLevels = mips;
+			desc.ArraySize = 6;
+			desc.Format = reference.Format;
+			desc.SampleDesc.Count = 1;
+			desc.Usage = D3D11_USAGE_IMMUTABLE;
+			desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+			desc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+
+			Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+			if (FAILED(Graphics::Device->CreateTexture2D(&desc, data.data(), texture.GetAddressOf())))
+				return srv;
+
+			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+			srvDesc.Format = desc.Format;
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+			srvDesc.TextureCube.MipLevels = mips;
+			srvDesc.TextureCube.MostDetailedMip = 0;
+			Graphics::Device->CreateShaderResourceView(texture.Get(), &srvDesc, srv.GetAddressOf());
+			return srv;
+		}
+
+		size_t UploadSize(const LoadRequest& request)
+		{
+			size_t bytes = 0;
+			for (auto& texture : request.data)
+				for (auto& level : texture.Levels)
+					bytes += level.Bytes.size();
+			return bytes;
+		}
+	}
+}
+
+void TextureLoader::Initialize(unsigned int threadCount)
+{
+	if (!workers.empty()) return;
+
+	if (threadCount == 0)
+	{
+		unsigned int cores = thread::hardware_concurrency();
+		threadCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	stopping = false;
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.push_back(thread(WorkerLoop));
+}
+
+void TextureLoader::ShutDown()
+{
+	{
+		lock_guard<mutex> lock(jobMutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+
+	for (auto& w : workers)
+		w.join();
+	workers.clear();
+
+	// Anything still waiting would be uploaded to a device that's going away
+	completed.clear();
+	pendingCount = 0;
+	placeholders.clear();
+	cubePlaceholders.clear();
+}
+
+unsigned int TextureLoader::ThreadCount() { return (unsigned int)workers.size(); }
+int TextureLoader::PendingCount() { return pendingCount; }
+
+void TextureLoader::SetCacheDirectory(const wstring& directory)
+{
+	cacheDirectory = directory;
+	if (cacheDirectory.empty()) return;
+
+	error_code error;
+	filesystem::create_directories(cacheDirectory, error);
+	if (cacheDirectory.back() != L'/' && cacheDirectory.back() != L'\\')
+		cacheDirectory += L'/';
+}
+
+shared_ptr<AsyncTexture> TextureLoader::LoadTexture(const wstring& path, MipColorSpace colorSpace, BlockFormat format, unsigned int placeholderColor)
+{
+	return Submit(&path, 1, false, false, colorSpace, format, placeholderColor, GetPlaceholder(placeholderColor, false))->texture;
+}
+
+shared_ptr<AsyncTexture> TextureLoader::LoadOrmTexture(const wstring& occlusion, const wstring& roughness, const wstring& metalness, BlockFormat format, unsigned int placeholderColor)
+{
+	wstring files[3] = { occlusion, roughness, metalness };
+	return Submit(files, 3, false, true, MipColorSpace::Linear, format, placeholderColor, GetPlaceholder(placeholderColor, false))->texture;
+}
+
+shared_ptr<AsyncTexture> TextureLoader::LoadCubemap(const wstring faces[6], MipColorSpace colorSpace, BlockFormat format, unsigned int placeholderColor)
+{
+	return Submit(faces, 6, true, false, colorSpace, format, placeholderColor, GetPlaceholder(placeholderColor, true))->texture;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> TextureLoader::CreateTexture(const TextureData& texture, unsigned int firstMip)
+{
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	if (firstMip >= texture.Levels.size())
+		return srv;
+
+	unsigned int mips = (unsigned int)texture.Levels.size() - firstMip;
+	vector<D3D11_SUBRESOURCE_DATA> data(mips);
+	for (unsigned int mip = 0; mip < mips; mip++)
+	{
+		data[mip].pSysMem = texture.Levels[firstMip + mip].Bytes.data();
+		data[mip].SysMemPitch = texture.Levels[firstMip + mip].RowPitch;
+	}
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = texture.Levels[firstMip].Width;
+	desc.Height = texture.Levels[firstMip].Height;
+	desc.MipLevels = mips;
+	desc.ArraySize = 1;
+	desc.Format = texture.Format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> resource;
+	if (FAILED(Graphics::Device->CreateTexture2D(&desc, data.data(), resource.GetAddressOf())))
+		return srv;
+
+	Graphics::Device->CreateShaderResourceView(resource.Get(), 0, srv.GetAddressOf());
+	return srv;
+}
+
+int TextureLoader::ProcessUploads(size_t byteBudget)
+{
+	int finished = 0;
+	size_t uploaded = 0;
+
+	while (finished == 0 || uploaded < byteBudget)
+	{
+		shared_ptr<LoadRequest> request;
+		{
+			lock_guard<mutex> lock(completedMutex);
+			if (completed.empty()) break;
+			request = completed.front();
+			completed.pop_front();
+		}
+
+		// Counted up front, as the streamer takes the data
+		uploaded += UploadSize(*request);
+
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+		if (request->isCube)
+		{
+			srv = UploadCube(*request);
+		}
+		else if (request->decoded[0] && TextureStreamer::IsEnabled())
+		{
+			// Only the mip tail goes up now - the streamer brings in the rest as the view needs it
+			srv = TextureStreamer::Add(request->texture, move(request->data[0]));
+		}
+		else if (request->decoded[0])
+		{
+			srv = CreateTexture(request->data[0]);
+		}
+		else if (!request->isOrm)
+		{
+			// Not something the embedded decoder handles - let WIC try
+			CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(), request->files[0].c_str(), 0, srv.GetAddressOf());
+		}
+
+		if (srv)
+			request->texture->Resolve(srv);
+		else
+			ReportError("Failed to load texture " + WideToNarrow(request->files[request->isOrm ? 1 : 0]) + ", keeping its placeholder");
+
+		pendingCount--;
+		finished++;
+	}
+
+	return finished;
+}
+
+void TextureLoader::Flush()
+{
+	while (true)
+	{
+		ProcessUploads();
+		if (pendingCount <= 0) return;
+
+		unique_lock<mutex> lock(completedMutex);
+		completedAvailable.wait(lock, [] { return !completed.empty(); });
+	}
+}
+
+vector<string> TextureLoader::Errors()
+{
+	lock_guard<mutex> lock(errorMutex);
+	return errors;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "BlockCompression.h"
+#include "MipGenerator.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// A texture that may still be loading.  Until its pixels
+// have been decoded and uploaded, GetSRV() hands back a 1x1
+// placeholder, so it can be bound like any other texture
+// from the very first frame.
+// --------------------------------------------------------
+class AsyncTexture
+{
+public:
+	AsyncTexture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> placeholder);
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetSRV() const;
+	bool IsReady() const;
+
+	// Main thread only - swaps in the real texture (or, when streamed,
+	// a new view whenever the resident mips change)
+	void Resolve(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	bool ready;
+};
+
+// --------------------------------------------------------
+// Loads textures on a pool of worker threads.  Workers read
+// and decode files (see PngDecoder), build their full mip
+// chains (see MipGenerator) and block compress them (see
+// BlockCompression) - every D3D call happens on the main
+// thread inside ProcessUploads(), which should be called
+// once per frame.
+//
+// Compressed chains are written to a DDS cache, so later
+// runs skip straight to the upload.
+//
+// Files the embedded decoder can't handle (JPEG, interlaced
+// PNG, etc.) fall back to WIC on the main thread.
+// --------------------------------------------------------
+namespace TextureLoader
+{
+	// Placeholder colors, packed as 0xAABBGGRR (R8G8B8A8 byte order)
+	const unsigned int PlaceholderWhite = 0xFFFFFFFF;
+	const unsigned int PlaceholderBlack = 0xFF000000;
+	const unsigned int PlaceholderGrey = 0xFF808080;
+	const unsigned int PlaceholderFlatNormal = 0xFFFF8080;
+	const unsigned int PlaceholderOrm = 0xFF00FFFF;	// Unoccluded, fully rough, not metal
+
+	// Pool setup - zero threads means "one less than the core count"
+	void Initialize(unsigned int threadCount = 0);
+	void ShutDown();
+	unsigned int ThreadCount();
+
+	// Folder for the DDS cache (created if needed), empty to disable it
+	void SetCacheDirectory(const std::wstring& directory);
+
+	// Queues a load and immediately returns a usable handle.  The
+	// color space decides how the mips are filtered
+	std::shared_ptr<AsyncTexture> LoadTexture(const std::wstring& path, MipColorSpace colorSpace, BlockFormat format = BlockFormat::None, unsigned int placeholderColor = PlaceholderWhite);
+
+	// Bakes separate occlusion/roughness/metalness maps into one ORM
+	// texture (see OrmPacker) on a worker.  Empty paths use neutral values
+	std::shared_ptr<AsyncTexture> LoadOrmTexture(const std::wstring& occlusion, const std::wstring& roughness, const std::wstring& metalness, BlockFormat format = BlockFormat::None, unsigned int placeholderColor = PlaceholderOrm);
+
+	// Six faces in +X, -X, +Y, -Y, +Z, -Z order.  Faces are decoded
+	// in parallel and the cube is uploaded once all six are done
+	std::shared_ptr<AsyncTexture> LoadCubemap(const std::wstring faces[6], MipColorSpace colorSpace = MipColorSpace::SRGB, BlockFormat format = BlockFormat::None, unsigned int placeholderColor = PlaceholderBlack);
+
+	// Main thread only - uploads decoded textures, stopping once roughly
+	// byteBudget bytes have been uploaded (at least one is always done).
+	// Returns the number of textures that finished this call
+	int ProcessUploads(size_t byteBudget = SIZE_MAX);
+
+	// Main thread only - immutable texture from the chain's levels, starting
+	// at firstMip (so a partially resident chain is just a smaller texture)
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateTexture(const TextureData& texture, unsigned int firstMip = 0);
+
+	// Loads that haven't been uploaded yet
+	int PendingCount();
+
+	// Blocks until every queued load has been decoded and uploaded
+	void Flush();
+
+	// What's gone wrong so far - files that kept their placeholder, cube
+	// faces filled with a solid color and ORM maps that wouldn't bake
+	std::vector<std::string> Errors();
+}
@@ -0,0 +1,150 @@
+#include "TextureStreamer.h"
+
+#include <unordered_map>
+
+using namespace std;
+
+namespace TextureStreamer
+{
+	// Annonymous namespace to hold every streamed texture
+	namespace
+	{
+		struct StreamedTexture
+		{
+			shared_ptr<AsyncTexture> handle;
+			TextureData data;
+			StreamingTexture state;
+		};
+
+		bool enabled = false;
+		size_t budget = 0;
+		size_t uploadCap = 0;
+		unsigned int tail = 64;
+
+		vector<StreamedTexture> textures;
+		unordered_map<const AsyncTexture*, int> lookup;
+		StreamingStats stats;
+
+		size_t ResidentSize(const StreamedTexture& texture)
+		{
+			size_t bytes = 0;
+			for (size_t mip = texture.state.ResidentMip; mip < texture.state.MipBytes.size(); mip++)
+				bytes += texture.state.MipBytes[mip];
+			return bytes;
+		}
+
+		// Rebuilds the GPU texture from a new finest level and hands out the new view
+		bool SetResidency(StreamedTexture& texture, int firstMip)
+		{
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv = TextureLoader::CreateTexture(texture.data, firstMip);
+			if (!srv)
+				return false;
+
+			texture.state.ResidentMip = firstMip;
+			texture.handle->Resolve(srv);
+			return true;
+		}
+	}
+}
+
+void TextureStreamer::Initialize(size_t budgetBytes, size_t uploadBytesPerUpdate, unsigned int tailSize)
+{
+	enabled = true;
+	budget = budgetBytes;
+	uploadCap = uploadBytesPerUpdate;
+	tail = tailSize;
+}
+
+void TextureStreamer::ShutDown()
+{
+	textures.clear();
+	lookup.clear();
+	stats = StreamingStats();
+	enabled = false;
+}
+
+bool TextureStreamer::IsEnabled() { return enabled; }
+void TextureStreamer::SetBudget(size_t budgetBytes) { budget = budgetBytes; }
+size_t TextureStreamer::GetBudget() { return budget; }
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> TextureStreamer::Add(shared_ptr<AsyncTexture> texture, TextureData data)
+{
+	StreamedTexture streamed;
+	streamed.handle = texture;
+	streamed.data = move(data);
+	streamed.state.Width = streamed.data.Levels[0].Width;
+	for (auto& level : streamed.data.Levels)
+		streamed.state.MipBytes.push_back(level.Bytes.size());
+	streamed.state.TailMip = StreamingPolicy::TailMipFor(streamed.state.Width, (int)streamed.state.MipBytes.size(), tail);
+	streamed.state.ResidentMip = streamed.state.TailMip;
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv = TextureLoader::CreateTexture(streamed.data, streamed.state.TailMip);
+	if (!srv)
+		return srv;
+
+	lookup[texture.get()] = (int)textures.size();
+	textures.push_back(move(streamed));
+	return srv;
+}
+
+int TextureStreamer::Find(const AsyncTexture* texture)
+{
+	auto it = lookup.find(texture);
+	return it == lookup.end() ? -1 : it->second;
+}
+
+void TextureStreamer::Update(const StreamingCamera& camera, const vector<StreamingObject>& objects)
+{
+	stats.UploadsLastUpdate = 0;
+	stats.EvictionsLastUpdate = 0;
+	stats.PendingUploads = 0;
+
+	StreamingPlan plan = StreamingPolicy::Plan(GetTextures(), objects, camera, budget);
+
+	// Evictions first, so the memory is free before anything new arrives
+	for (size_t t = 0; t < textures.size(); t++)
+	{
+		if (plan.TargetMip[t] > textures[t].state.ResidentMip && SetResidency(textures[t], plan.TargetMip[t]))
+			stats.EvictionsLastUpdate++;
+	}
+
+	// Then upgrades, most needed first.  At least one always goes, so a
+	// cap smaller than a single texture can't stall streaming entirely
+	size_t uploaded = 0;
+	for (int t : plan.UploadOrder)
+	{
+		StreamedTexture& texture = textures[t];
+		if (uploaded > 0 && uploaded >= uploadCap)
+		{
+			stats.PendingUploads++;
+			continue;
+		}
+
+		int previous = texture.state.ResidentMip;
+		if (SetResidency(texture, plan.TargetMip[t]))
+		{
+			for (int mip = plan.TargetMip[t]; mip < previous; mip++)
+				uploaded += texture.state.MipBytes[mip];
+			stats.UploadsLastUpdate++;
+		}
+	}
+}
+
+StreamingStats TextureStreamer::GetStats()
+{
+	stats.TextureCount = (int)textures.size();
+	stats.BudgetBytes = budget;
+	stats.ResidentBytes = 0;
+	for (auto& texture : textures)
+		stats.ResidentBytes += ResidentSize(texture);
+	return stats;
+}
+
+vector<StreamingTexture> TextureStreamer::GetTextures()
+{
+	vector<StreamingTexture> states;
+	states.reserve(textures.size());
+	for (auto& texture : textures)
+		states.push_back(texture.state);
+	return states;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "StreamingPolicy.h"
+#include "TextureLoader.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include <memory>
+#include <vector>
+
+// Current state of the streamer, for display
+struct StreamingStats
+{
+	int TextureCount = 0;
+	size_t ResidentBytes = 0;
+	size_t BudgetBytes = 0;
+	int UploadsLastUpdate = 0;
+	int EvictionsLastUpdate = 0;
+	int PendingUploads = 0;		// Planned upgrades held back by the per-update upload cap
+};
+
+// --------------------------------------------------------
+// Keeps only the mips the view needs of each 2D texture on
+// the GPU.  The TextureLoader hands every finished chain to
+// Add(), which uploads just its mip tail; Update() then asks
+// the StreamingPolicy which levels each texture should have
+// and recreates textures whose residency changed, swapping
+// the new view into the texture's AsyncTexture.
+//
+// Full chains stay in system memory, so raising a texture's
+// residency never touches the disk.
+// --------------------------------------------------------
+namespace TextureStreamer
+{
+	// budgetBytes caps resident GPU memory (mip tails excepted).  Levels
+	// no wider than tailSize are uploaded immediately and never evicted
+	void Initialize(size_t budgetBytes, size_t uploadBytesPerUpdate = 8 * 1024 * 1024, unsigned int tailSize = 64);
+	void ShutDown();
+	bool IsEnabled();
+
+	void SetBudget(size_t budgetBytes);
+	size_t GetBudget();
+
+	// Takes ownership of a decoded chain and returns the view of its tail
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Add(std::shared_ptr<AsyncTexture> texture, TextureData data);
+
+	// Index to use in StreamingObject::Textures, or -1 if the texture isn't streamed (yet)
+	int Find(const AsyncTexture* texture);
+
+	// Main thread, once per frame - evicts right away, then uploads the
+	// most needed upgrades up to the per-update byte cap
+	void Update(const StreamingCamera& camera, const std::vector<StreamingObject>& objects);
+
+	StreamingStats GetStats();
+
+	// Snapshot of every streamed texture, for feeding StreamingPolicy::Simulate
+	std::vector<StreamingTexture> GetTextures();
+}
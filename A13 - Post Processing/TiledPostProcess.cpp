@@ -0,0 +1,182 @@
+#include "TiledPostProcess.h"
+#include "GaussianBlur.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+	// What a float stored to an 8 bit UNORM channel reads back as
+	float Quantize(float value)
+	{
+		return floorf(min(max(value, 0.0f), 1.0f) * 255.0f + 0.5f) / 255.0f;
+	}
+
+	// f32tof16 - rounds to the nearest even half (positive, finite values only)
+	unsigned int FloatToHalf(float value)
+	{
+		unsigned int bits;
+		memcpy(&bits, &value, sizeof(bits));
+		int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+		unsigned int mantissa = (bits & 0x7FFFFF) | 0x800000;
+		if (exponent >= 31)
+			return 0x7C00;
+
+		// Denormal halves lose the bits the exponent can't hold
+		int shift = exponent > 0 ? 13 : 14 - exponent;
+		if (shift > 24)
+			return 0;
+		unsigned int half = mantissa >> shift;
+		unsigned int remainder = mantissa & ((1u << shift) - 1);
+		unsigned int halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+			half++;
+
+		// A normal's implicit bit lands on the exponent's lowest bit, hence the - 1
+		return exponent > 0 ? (((unsigned int)(exponent - 1) << 10) + half) : half;
+	}
+
+	// f16tof32
+	float HalfToFloat(unsigned int half)
+	{
+		unsigned int exponent = (half >> 10) & 0x1F;
+		unsigned int mantissa = half & 0x3FF;
+		if (exponent == 0)
+			return ldexpf((float)mantissa, -24);
+		return ldexpf((float)(mantissa | 0x400), (int)exponent - 25);
+	}
+
+	// What a float stored to a 16 bit float channel reads back as
+	void QuantizeHalfImage(float* pixels, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			pixels[i] = HalfToFloat(FloatToHalf(max(pixels[i], 0.0f)));
+	}
+
+	// One group's shared memory, packed to R11G11B10 like the shader's -
+	// halves with the low mantissa bits cut off, and alpha always 1
+	struct Texel { float C[4]; };
+	Texel Pack(const float* color)
+	{
+		Texel texel;
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned int dropped = c < 2 ? 4 : 5;
+			texel.C[c] = HalfToFloat((FloatToHalf(max(color[c], 0.0f)) >> dropped) << dropped);
+		}
+		texel.C[3] = 1.0f;
+		return texel;
+	}
+
+	// The pointwise effects, then the write to the 8 bit output
+	void WritePixel(float* out, float* color, unsigned int key, const PostEffectSettings& effects, float u, float v)
+	{
+		PostPermutations::Apply(key, effects, u, v, color);
+		for (int c = 0; c < 4; c++)
+			out[c] = Quantize(color[c]);
+	}
+}
+
+unsigned int TiledPostProcess::SharedBytes(int apron)
+{
+	// The loaded tile, plus the horizontal results (one uint per texel each)
+	unsigned int side = TileSize + 2 * apron;
+	return (side * side + side * TileSize) * 4;
+}
+
+void TiledPostProcess::Run(const float* src, unsigned int width, unsigned int height, float* dst, const vector<float>& weights, const PostEffectSettings& effects)
+{
+	unsigned int key = PostPermutations::BuildKey(effects);
+	int apron = min((int)weights.size() - 1, MaxApron);
+	int side = TileSize + 2 * apron;
+	int threads = TileSize * TileSize;
+	vector<Texel> tile(side * side);
+	vector<Texel> rows(side * TileSize);
+
+	unsigned int groupsX = (width + TileSize - 1) / TileSize;
+	unsigned int groupsY = (height + TileSize - 1) / TileSize;
+	for (unsigned int groupY = 0; groupY < groupsY; groupY++)
+	{
+		for (unsigned int groupX = 0; groupX < groupsX; groupX++)
+		{
+			int originX = (int)groupX * TileSize - apron;
+			int originY = (int)groupY * TileSize - apron;
+
+			// Each "thread" loads every 256th texel, starting from its own index
+			for (int thread = 0; thread < threads; thread++)
+			{
+				for (int i = thread; i < side * side; i += threads)
+				{
+					int x = min(max(originX + i % side, 0), (int)width - 1);
+					int y = min(max(originY + i / side, 0), (int)height - 1);
+					tile[i] = Pack(src + ((size_t)y * width + x) * 4);
+				}
+			}
+
+			// Barrier, then horizontal for the tile's columns on every loaded row
+			for (int thread = 0; thread < threads; thread++)
+			{
+				for (int i = thread; i < side * TileSize; i += threads)
+				{
+					int row = i / TileSize;
+					int column = i % TileSize + apron;
+					float total[4];
+					for (int c = 0; c < 4; c++)
+						total[c] = tile[row * side + column].C[c] * weights[0];
+					for (int k = 1; k <= apron; k++)
+					{
+						for (int c = 0; c < 4; c++)
+							total[c] += (tile[row * side + column - k].C[c] + tile[row * side + column + k].C[c]) * weights[k];
+					}
+					rows[i] = Pack(total);
+				}
+			}
+
+			// Barrier, then vertical and the pointwise effects, one pixel per thread
+			for (int thread = 0; thread < threads; thread++)
+			{
+				int threadX = thread % TileSize;
+				int threadY = thread / TileSize;
+				unsigned int x = groupX * TileSize + threadX;
+				unsigned int y = groupY * TileSize + threadY;
+				if (x >= width || y >= height)
+					continue;
+
+				float total[4];
+				for (int c = 0; c < 4; c++)
+					total[c] = rows[(threadY + apron) * TileSize + threadX].C[c] * weights[0];
+				for (int k = 1; k <= apron; k++)
+				{
+					for (int c = 0; c < 4; c++)
+						total[c] += (rows[(threadY + apron - k) * TileSize + threadX].C[c] + rows[(threadY + apron + k) * TileSize + threadX].C[c]) * weights[k];
+				}
+
+				WritePixel(dst + ((size_t)y * width + x) * 4, total, key, effects, (x + 0.5f) / width, (y + 0.5f) / height);
+			}
+		}
+	}
+}
+
+void TiledPostProcess::Reference(const float* src, unsigned int width, unsigned int height, float* dst, float radius, const PostEffectSettings& effects)
+{
+	size_t count = (size_t)width * height * 4;
+	vector<float> pass(count);
+	vector<GaussianTap> taps = GaussianBlur::LinearTaps(radius);
+	GaussianBlur::BlurPassLinear(src, width, height, pass.data(), taps, false);
+	QuantizeHalfImage(pass.data(), count);
+	GaussianBlur::BlurPassLinear(pass.data(), width, height, dst, taps, true);
+
+	// The vertical pass applies the effects itself, before it writes
+	unsigned int key = PostPermutations::BuildKey(effects);
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			float* pixel = dst + ((size_t)y * width + x) * 4;
+			WritePixel(pixel, pixel, key, effects, (x + 0.5f) / width, (y + 0.5f) / height);
+		}
+	}
+}
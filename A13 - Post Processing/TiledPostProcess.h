@@ -0,0 +1,38 @@
+#pragma once
+
+#include "PostEffects.h"
+
+#include <vector>
+
+// --------------------------------------------------------
+// The post process as one compute dispatch, in the order
+// ComputeShaderPostProcess.hlsl runs it: each 16x16 group
+// loads its tile plus an apron into groupshared memory,
+// blurs horizontally from there into a second shared
+// array, then vertically into the output with the post
+// effects (PostPermutations) applied on the way out.  The full-screen
+// passes become one, and the blur never goes back to memory
+// between directions.
+//
+// Run() emulates the dispatch group by group on the CPU -
+// same indexing, same R11G11B10 packing of shared memory -
+// and Reference() does what the pixel shader passes do, so
+// the two can be compared without a GPU.  Images are linear
+// float RGBA, with clamped edges.
+// --------------------------------------------------------
+namespace TiledPostProcess
+{
+	const int TileSize = 16;		// Must match TILE_SIZE in ComputeShaderPostProcess.hlsl
+	const int MaxApron = 30;		// Must match MAX_APRON (GaussianBlur's widest kernel)
+	const int MaxWeights = 32;		// Room for MaxApron + 1 weights, in whole float4s
+
+	// Groupshared bytes a group uses at this apron
+	unsigned int SharedBytes(int apron);
+
+	// The compute shader - weights are GaussianBlur::Weights()
+	void Run(const float* src, unsigned int width, unsigned int height, float* dst, const std::vector<float>& weights, const PostEffectSettings& effects);
+
+	// The pixel shader passes: blur horizontally, then vertically with the
+	// effects fused in, rounding to the 16 bit float target in between
+	void Reference(const float* src, unsigned int width, unsigned int height, float* dst, float radius, const PostEffectSettings& effects);
+}
@@ -6,8 +6,6 @@ cbuffer ExternalData : register(b0)
 	matrix worldInverseTranspose;
 	matrix view;
 	matrix projection;
-    matrix lightView;
-    matrix lightProjection;
 }
 
 // --------------------------------------------------------
@@ -31,11 +29,10 @@ VertexToPixel main( VertexShaderInput input )
 	//   which we're leaving at 1.0 for now (this is more useful when dealing with 
 	//   a perspective projection matrix, which we'll get to in the future).
 	matrix wvp = mul(projection, mul(view, world));
-    matrix shadowWVP = mul(lightProjection, mul(lightView, world));
 	output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
-    output.shadowMapPos = mul(shadowWVP, float4(input.localPosition, 1.0f));
     output.normal = mul((float3x3)worldInverseTranspose, input.normal);
 	output.worldPosition = mul(world, float4(input.localPosition, 1.0f)).xyz;
+    output.viewDepth = mul(view, float4(output.worldPosition, 1.0f)).z;
     output.tangent = mul((float3x3)world, input.tangent);
 	output.uv = input.uv;
 